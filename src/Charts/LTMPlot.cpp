@@ -26,6 +26,7 @@
 #include "LTMWindow.h"
 #include "RideMetric.h"
 #include "RideCache.h"
+#include "RideCacheColumns.h"
 #include "RideFileCache.h"
 #include "Settings.h"
 #include "Colors.h"
@@ -2648,10 +2649,22 @@ LTMPlot::createMetricData(Context *context, LTMSettings *settings, MetricDetail
     //
     double ymean_prev=0.0;
 
-    foreach (RideItem *ride, context->athlete->rideCache->rides()) { 
+    // the rides that pass and the metric for all of them
+    RideCache *cache = context->athlete->rideCache;
+    MetricHandle metric;
+    if (metricDetail.type != METRIC_META) metric = MetricHandle(metricDetail.symbol, context->athlete->useMetricUnits);
+    QBitArray rides = cache->columns()->select(spec);
+    QVector<double> values, counts;
+    if (metric.isValid()) {
+        values = cache->columns()->values(metric.index());
+        counts = cache->columns()->counts(metric.index());
+    }
+
+    for (int i=0; i<rides.count(); i++) {
 
         // filter out unwanted stuff
-        if (!spec.pass(ride)) continue;
+        if (!rides.testBit(i)) continue;
+        RideItem *ride = cache->rides()[i];
 
         // day we are on
         int currentDay = groupForDate(ride->dateTime.date(), settings->groupBy);
@@ -2661,7 +2674,7 @@ LTMPlot::createMetricData(Context *context, LTMSettings *settings, MetricDetail
         if (metricDetail.type == METRIC_META)
             value = ride->getText(metricDetail.name, "0.0").toDouble();
         else
-            value = ride->getForSymbol(metricDetail.symbol);
+            value = i < values.count() ? values[i] : 0;
 
         // check values are bounded to stop QWT going berserk
         if (std::isnan(value) || std::isinf(value)) value = 0;
@@ -2677,10 +2690,7 @@ LTMPlot::createMetricData(Context *context, LTMSettings *settings, MetricDetail
 
         if (metricDetail.metric) {
             // convert from stored metric value to imperial
-            if (context->athlete->useMetricUnits == false) {
-                value *= metricDetail.metric->conversion();
-                value += metricDetail.metric->conversionSum();
-            }
+            if (metric.isValid()) value = metric.value(value);
 
             // convert seconds to hours
             if (metricDetail.metric->units(true) == "seconds" ||
@@ -2688,7 +2698,8 @@ LTMPlot::createMetricData(Context *context, LTMSettings *settings, MetricDetail
         }
 
         if (value || wantZero) {
-            unsigned long seconds = metricDetail.metric ? ride->getCountForSymbol(metricDetail.metric->symbol()) : 1;
+            // never zero, as getCountForSymbol()
+            unsigned long seconds = (metricDetail.metric && i < counts.count() && counts[i]) ? counts[i] : 1;
             if (currentDay > lastDay) {
                 if (lastDay && wantZero) {
                     while (lastDay<currentDay && n<=maxdays) {
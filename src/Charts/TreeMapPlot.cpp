@@ -22,6 +22,7 @@
 #include "LTMTool.h"
 #include "TreeMapWindow.h"
 #include "RideCache.h"
+#include "RideCacheColumns.h"
 #include "RideMetric.h"
 #include "Settings.h"
 #include "Colors.h"
@@ -62,12 +63,19 @@ TreeMapPlot::setData(TMSettings *settings)
 {
     root->clear();
 
-    foreach (RideItem *item, context->athlete->rideCache->rides()) {
+    // the rides that pass and the metric for all of them
+    RideCache *cache = context->athlete->rideCache;
+    const RideMetric *metric = RideMetricFactory::instance().rideMetric(settings->symbol);
+    QBitArray rides = cache->columns()->select(settings->specification);
+    QVector<double> values = metric ? cache->columns()->values(metric->index()) : QVector<double>();
+
+    for (int i=0; i<rides.count(); i++) {
 
         // don't plot if filtered
-        if (!settings->specification.pass(item)) continue;
+        if (!rides.testBit(i)) continue;
 
-        double value = item->getForSymbol(settings->symbol);
+        RideItem *item = cache->rides()[i];
+        double value = i < values.count() ? values[i] : 0;
         QString text1 = item->getText(settings->field1, tr("(unknown)"));
         QString text2 = item->getText(settings->field2, tr("(unknown)"));
         if (text1 == "") text1 = tr("(unknown)");
@@ -1343,7 +1343,7 @@ CloudServiceSyncDialog::syncNext()
     progressLabel->setText(QString(tr("Processed %1 of %2 successfully")).arg(successful).arg(downloadtotal));
 
     // save the ride cache, we don't want to lose that if we crash etc.
-    context->athlete->rideCache->save();
+    context->athlete->rideCache->save(true);
 
     return false;
 }
@@ -1397,7 +1397,7 @@ CloudServiceSyncDialog::downloadNext()
     progressLabel->setText(QString(tr("Downloaded %1 of %2 successfully")).arg(successful).arg(downloadtotal));
 
     // save the ride cache, we don't want to lose that if we crash etc.
-    context->athlete->rideCache->save();
+    context->athlete->rideCache->save(true);
 
     return false;
 }
@@ -25,6 +25,7 @@
 #include "RideMetadata.h"
 #include "RideCache.h"
 #include "RideFileCache.h"
+#include "RideFileCacheIndex.h"
 #include "RideMetric.h"
 #include "Settings.h"
 #include "TimeUtils.h"
@@ -191,6 +192,7 @@ Athlete::Athlete(Context *context, const QDir &homeDir)
     connect(context, SIGNAL(refreshEnd()), cloudAutoDownload, SLOT(autoDownload()));
 
     // now most dependencies are in get cache
+    cpxIndex = new RideFileCacheIndex(context);
     rideCache = new RideCache(context);
 
     // read athlete's charts.xml and translate etc, it needs to be
@@ -239,6 +241,7 @@ Athlete::~Athlete()
 {
     // close the ride cache down first
     delete rideCache;
+    delete cpxIndex;
 
     // save those preset charts
     LTMSettings reader;
@@ -305,6 +308,9 @@ Athlete::checkCPX(RideItem*ride)
             newList.append(p);
     }
     cpxCache = newList;
+
+    // and the weeks, months and years it is in
+    cpxIndex->invalidate(ride->dateTime.date());
 }
 
 void
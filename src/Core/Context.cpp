@@ -93,6 +93,10 @@ Context::notifyConfigChanged(qint32 state)
     //if (state & CONFIG_NOTECOLOR) qDebug()<<"Note color config changed!";
     //if (state & CONFIG_FIELDS) qDebug()<<"Metadata config changed!";
     if (state & CONFIG_USERMETRICS) userMetricsConfigChanged();
+    if (state & CONFIG_UNITS) {
+        MetricHandle::unitsChanged();
+        UserMetric::resolveMetrics();
+    }
     configChanged(state);
 }
 
@@ -132,6 +136,7 @@ Context::userMetricsConfigChanged()
         foreach(UserMetricSettings m, _userMetrics) {
             RideMetricFactory::instance().addMetric(UserMetric(this, m));
         }
+        UserMetric::resolveMetrics();
 
         // tell eveyone else to compute metrics...
         foreach(Context *x, _contexts)
@@ -170,6 +170,7 @@ class Context : public QObject
         void notifyVideoSyncChanged() { emit VideoSyncChanged(); }
 
         void notifyRideSelected(RideItem*x) { ride=x; rideSelected(x); }
+        void notifyDateRangeChanged(DateRange x) { dr_=x; dateRangeChanged(x); }
         void notifyRideAdded(RideItem *x) { ride=x; rideAdded(x); }
         void notifyRideDeleted(RideItem *x) { ride=x; rideDeleted(x); }
         void notifyRideChanged(RideItem *x) { rideChanged(x); }
@@ -237,6 +238,7 @@ class Context : public QObject
         void autoDownloadProgress(QString, double, int, int);
 
         void rideSelected(RideItem*);
+        void dateRangeChanged(DateRange);
 
         // we added/deleted/changed an item
         void rideAdded(RideItem *);
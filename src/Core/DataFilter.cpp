@@ -1013,6 +1013,13 @@ void Leaf::validateFilter(Context *context, DataFilterRuntime *df, Leaf *leaf)
             // a lookup at execution time
             QString symbol = *(leaf->lvalue.n);
             QString lookup = df->lookupMap.value(symbol, "");
+
+            // metrics are looked up now rather than for every ride
+            if (lookup != "" && df->lookupType.value(symbol)) {
+                leaf->metric = MetricHandle(lookup);
+                df->metricLeaves << leaf;
+            } else leaf->metric = MetricHandle();
+
             if (lookup == "") {
 
                 // isRun isa special, we may add more later (e.g. date)
@@ -1486,6 +1493,7 @@ DataFilter::DataFilter(QObject *parent, Context *context, QString formula) : QOb
     DataFilterparse();
     DataFilter_clearString();
     treeRoot = DataFilterroot;
+    rt.metricLeaves.clear();
 
     // if it parsed (syntax) then check logic (semantics)
     if (treeRoot && DataFiltererrors.count() == 0)
@@ -1540,6 +1548,7 @@ QStringList DataFilter::check(QString query)
 
     // save away the results
     treeRoot = DataFilterroot;
+    rt.metricLeaves.clear();
 
     // if it passed syntax lets check semantics
     if (treeRoot && DataFiltererrors.count() == 0) treeRoot->validateFilter(context, &rt, treeRoot);
@@ -1581,6 +1590,7 @@ QStringList DataFilter::parseFilter(Context *context, QString query, QStringList
 
     // save away the results
     treeRoot = DataFilterroot;
+    rt.metricLeaves.clear();
 
     // if it passed syntax lets check semantics
     if (treeRoot && DataFiltererrors.count() == 0) treeRoot->validateFilter(context, &rt, treeRoot);
@@ -1651,6 +1661,7 @@ void DataFilter::clearFilter()
         treeRoot->clear(treeRoot);
         treeRoot = NULL;
     }
+    rt.metricLeaves.clear();
     rt.isdynamic = false;
     sig = "";
 }
@@ -1687,9 +1698,19 @@ void DataFilter::configChanged(qint32)
 
     // sample date series
     rt.dataSeriesSymbols = RideFile::symbols();
+
+    // user metrics may have changed
+    resolveMetrics();
+}
+
+void
+DataFilter::resolveMetrics()
+{
+    foreach(Leaf *leaf, rt.metricLeaves)
+        if (leaf->metric.isStale()) leaf->metric = MetricHandle(leaf->metric.symbol(), leaf->metric.useMetricUnits());
 }
 
-Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, RideFilePoint *p, const QHash<QString,RideMetric*> *c)
+Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, RideFilePoint *p, const RideMetricDeps *c)
 {
     // if error state all bets are off
     //if (inerror) return Result(0);
@@ -1892,6 +1913,7 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, RideF
                     if (df->lookupType.value(*(leaf->lvalue.l->lvalue.n)) == true) {
                         // numeric
                         if (c) duration = RideMetric::getForSymbol(rename=df->lookupMap.value(*(leaf->lvalue.l->lvalue.n),""), c);
+                        else if (leaf->lvalue.l->metric.isValid()) duration = m->getForSymbol(leaf->lvalue.l->metric);
                         else duration = m->getForSymbol(rename=df->lookupMap.value(*(leaf->lvalue.l->lvalue.n),""));
                     } else if (*(leaf->lvalue.l->lvalue.n) == "x") {
                         duration = x;
@@ -2553,7 +2575,8 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, float x, RideItem *m, RideF
             QString meta = m->getText(rename=df->lookupMap.value(symbol,""), "unknown");
             if (meta == "unknown")
                 if (c) lhsdouble = RideMetric::getForSymbol(rename=df->lookupMap.value(symbol,""), c);
-                else lhsdouble = m->getForSymbol(rename=df->lookupMap.value(symbol,""));
+                else if (leaf->metric.isValid()) lhsdouble = m->getForSymbol(leaf->metric);
+                else lhsdouble = m->getForSymbol(rename);
             else
                 lhsdouble = meta.toDouble();
             lhsisNumber = true;
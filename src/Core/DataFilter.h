@@ -29,6 +29,7 @@
 #include <QTextDocument>
 #include "RideCache.h"
 #include "RideFile.h" //for SeriesType
+#include "RideMetric.h" // for MetricHandle
 
 class Context;
 class RideItem;
@@ -69,7 +70,7 @@ class Leaf {
         // Search/Filter - using symbols from RideItem *m
         // User Metric - using symbols from QHash<..> (RideItem + Interval)
         //
-        Result eval(DataFilterRuntime *df, Leaf *, float x, RideItem *m, RideFilePoint *p = NULL, const QHash<QString,RideMetric*> *metrics=NULL);
+        Result eval(DataFilterRuntime *df, Leaf *, float x, RideItem *m, RideFilePoint *p = NULL, const RideMetricDeps *metrics=NULL);
 
         // tree traversal etc
         void print(Leaf *, int level, DataFilterRuntime*);  // print leaf and all children
@@ -100,6 +101,7 @@ class Leaf {
         QList<Leaf*> fparms; // passed parameters
 
         Leaf *series; // is a symbol
+        MetricHandle metric; // when the symbol is a metric, see validateFilter()
         bool dynamic;
         RideFile::SeriesType seriesType; // for ridefilecache
         int loc, leng;
@@ -139,6 +141,9 @@ public:
 
     QHash<Leaf*, int> indexes;
 
+    // the symbols that are metrics, see DataFilter::resolveMetrics()
+    QList<Leaf*> metricLeaves;
+
     // pd models for estimates
     QList <PDModel*>models;
 };
@@ -169,6 +174,10 @@ class DataFilter : public QObject
 
         static QStringList builtins(); // return list of functions supported
 
+        // look the metrics up again after metrics were added or
+        // removed, on the gui thread so not while being evaluated
+        void resolveMetrics();
+
         int refcount; // used by user metrics
 
     public slots:
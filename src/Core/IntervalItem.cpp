@@ -88,37 +88,32 @@ IntervalItem::setValues(QString name, double duration1, double duration2,
 
 void
 IntervalItem::refresh()
+{
+    refresh(RideMetricFactory::instance().allMetrics());
+}
+
+void
+IntervalItem::refresh(const QStringList &symbols)
 {
     // don't open on our account - we should be called with a ride available
-    RideFile *f = rideItem_->ride_;
+    RideFile *f = rideItem_->ride(false);
     if (!f) return;
 
     // metrics
     const RideMetricFactory &factory = RideMetricFactory::instance();
 
-    // resize and set to zero
-    metrics_.fill(0, factory.metricCount());
-    count_.fill(0, factory.metricCount());
-
-    // ok, lets collect the metrics
-    QHash<QString,RideMetricPtr> computed=RideMetric::computeMetrics(rideItem_, Specification(this, f->recIntSecs()), factory.allMetrics());
-    // take a deep copy, quick before the thread exits.
-    //XXXcomputed.detach();
-
-    // snaffle away all the computed values into the array
-    QHashIterator<QString, RideMetricPtr> i(computed);
-    while (i.hasNext()) {
-        i.next();
-        metrics_[i.value()->index()] = i.value()->value();
-        count_[i.value()->index()] = i.value()->count();
-        double stdmean = i.value()->stdmean();
-        double stdvariance = i.value()->stdvariance();
-        if (stdmean || stdvariance) {
-            stdmean_.insert(i.value()->index(), stdmean);
-            stdvariance_.insert(i.value()->index(), stdvariance);
-        }
+    // resize and set to zero, unless just some are being updated
+    // and the rest are already there
+    bool all = &symbols == &factory.allMetrics() || metrics_.count() != factory.metricCount();
+    if (all) {
+        metrics_.fill(0, factory.metricCount());
+        count_.fill(0, factory.metricCount());
     }
 
+    // ok, lets collect the metrics, straight into the array
+    RideMetric::computeMetrics(rideItem_, Specification(this, f->recIntSecs()),
+                               all ? factory.allMetrics() : symbols, metrics_, count_, stdmean_, stdvariance_);
+
     // clean any bad values
     for(int j=0; j<factory.metricCount(); j++)
         if (std::isinf(metrics_[j]) || std::isnan(metrics_[j])) {
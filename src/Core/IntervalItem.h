@@ -68,8 +68,9 @@ class IntervalItem
         // order to show on plot
         void setDisplaySequence(int seq) { displaySequence = seq; }
 
-        // precomputed metrics
+        // precomputed metrics, all or just some of them
         void refresh();
+        void refresh(const QStringList &symbols);
         QVector<double> metrics_;
         QVector<double> count_;
         QMap <int, double>stdmean_;
@@ -21,6 +21,10 @@
 #include "Context.h"
 #include "Athlete.h"
 #include "RideFileCache.h"
+#include "PDEstimateStore.h"
+#include "RideDBBinary.h"
+#include "RideCacheRefresh.h"
+#include "RideCacheColumns.h"
 #include "RideCacheModel.h"
 #include "Specification.h"
 #include "DataProcessor.h"
@@ -45,7 +49,6 @@
 #include <QXmlSimpleReader>
 
 // for sorting
-bool rideCacheGreaterThan(const RideItem *a, const RideItem *b) { return a->dateTime > b->dateTime; }
 bool rideCacheLessThan(const RideItem *a, const RideItem *b) { return a->dateTime < b->dateTime; }
 
 RideCache::RideCache(Context *context) : context(context)
@@ -54,8 +57,25 @@ RideCache::RideCache(Context *context) : context(context)
     plannedDirectory = context->athlete->home->planned();
 
     progress_ = 100;
+    throughput_ = 0;
+    scanTime_ = 0;
     refreshingEstimates = false;
     exiting = false;
+    estimates = new PDEstimateStore(context);
+    rideDBBinary = new RideDBBinary(context, this);
+    refresher = new RideCacheRefresh(context);
+    columns_ = new RideCacheColumns(this);
+
+    // refresh watching
+    connect(refresher, SIGNAL(finished()), this, SLOT(refreshFinished()));
+    connect(refresher, SIGNAL(finished()), this, SLOT(garbageCollect()));
+    connect(refresher, SIGNAL(finished()), this, SLOT(save()));
+    connect(refresher, SIGNAL(finished()), context, SLOT(notifyRefreshEnd()));
+    connect(refresher, SIGNAL(progress(int,int,QDate)), this, SLOT(progressing(int,int,QDate)));
+
+    // what we're looking at gets refreshed first
+    connect(context, SIGNAL(rideSelected(RideItem*)), refresher, SLOT(prioritise()));
+    connect(context, SIGNAL(dateRangeChanged(DateRange)), refresher, SLOT(prioritise()));
 
     // initial load of user defined metrics - do once we have an initial context
     // but before we refresh or check metrics for the first time
@@ -83,6 +103,7 @@ RideCache::RideCache(Context *context) : context(context)
             foreach(UserMetricSettings m, _userMetrics) {
                 RideMetricFactory::instance().addMetric(UserMetric(context, m));
             }
+            UserMetric::resolveMetrics();
         }
     }
 
@@ -128,18 +149,14 @@ RideCache::RideCache(Context *context) : context(context)
     // set model once we have the basics
     model_ = new RideCacheModel(context, this);
 
+    // size the cpx pool before any refresh uses it
+    RideFileCacheTasks::configure();
+
     // now refresh just in case.
     refresh();
 
     // do we have any stale items ?
     connect(context, SIGNAL(configChanged(qint32)), this, SLOT(configChanged(qint32)));
-
-    // future watching
-    connect(&watcher, SIGNAL(finished()), this, SLOT(garbageCollect()));
-    connect(&watcher, SIGNAL(finished()), this, SLOT(save()));
-    connect(&watcher, SIGNAL(finished()), context, SLOT(notifyRefreshEnd()));
-    connect(&watcher, SIGNAL(started()), context, SLOT(notifyRefreshStart()));
-    connect(&watcher, SIGNAL(progressValueChanged(int)), this, SLOT(progressing(int)));
 }
 
 RideCache::~RideCache()
@@ -149,8 +166,13 @@ RideCache::~RideCache()
     // cancel any refresh that may be running
     cancel();
 
-    // save to store
-    save();
+    // save to store, with the json for the API and older versions
+    save(true);
+
+    delete refresher;
+    delete columns_;
+    delete rideDBBinary;
+    delete estimates;
 }
 
 void
@@ -165,10 +187,13 @@ RideCache::garbageCollect()
 void
 RideCache::configChanged(qint32 what)
 {
+    // the number of refresh threads may have changed
+    if (what & CONFIG_GENERAL) RideFileCacheTasks::configure();
+
     // if the wbal formula changed invalidate all cached values
     if (what & CONFIG_WBAL) {
         foreach(RideItem *item, rides()) {
-            if (item->isOpen()) item->ride()->wstale=true;
+            if (item->isOpen()) item->ride()->invalidateWprime();
         }
     }
 
@@ -176,6 +201,7 @@ RideCache::configChanged(qint32 what)
     if (what & CONFIG_FIELDS) {
         foreach(RideItem *item, rides()) {
             item->metadata_.insert("Calendar Text", context->athlete->rideMetadata()->calendarText(item));
+            item->unsaved = true;
         }
     }
 
@@ -235,6 +261,7 @@ RideCache::addRide(QString name, bool dosignal, bool select, bool useTempActivit
     bool added = false;
     for (int index=0; index < rides_.count(); index++) {
         if (rides_[index]->fileName == last->fileName) {
+            refresher->remove(rides_[index]);
             rides_[index] = last;
             added = true;
             break;
@@ -310,6 +337,7 @@ RideCache::removeCurrentRide()
     // any aggregating functions no longer see it, when recalculating
     // during aride deleted operation
     // but model needs to know about this!
+    refresher->remove(todelete);
     model_->startRemove(index);
     rides_.remove(index, 1);
     delete_<<todelete;
@@ -333,7 +361,7 @@ RideCache::removeCurrentRide()
 
     // remove any other derived/additional files; notes, cpi etc (they can only exist in /cache )
     QStringList extras;
-    extras << "notes" << "cpi" << "cpx";
+    extras << "notes" << "cpi" << "cpx" << "gcb";
     foreach (QString extension, extras) {
 
         QString deleteMe = QFileInfo(strOldFileName).baseName() + "." + extension;
@@ -418,42 +446,55 @@ RideCache::writeAsCSV(QString filename)
     file.close();
 }
 
+// the file part of the staleness check, see refresh()
 void
-itemRefresh(RideItem *&item)
+itemCheckFiles(RideItem *&item)
 {
-    // need parser to be reentrant !item->refresh();
-    if (item->isstale) {
-        item->refresh();
-
-        // and trap changes during refresh to current ride
-        if (item == item->context->currentRideItem())
-            item->context->notifyRideChanged(item);
-
-#ifdef SLOW_REFRESH
-        sleep(1);
-#endif
-    }
+    item->checkFilesStale();
 }
 
 void
-RideCache::progressing(int value)
+RideCache::progressing(int done, int total, QDate date)
 {
     // we're working away, notfy everyone where we got
-    progress_ = 100.0f * (double(value) / double(watcher.progressMaximum()));
-    if (value) {
-        QDate here = reverse_.at(value-1)->dateTime.date();
-        context->notifyRefreshUpdate(here);
-    }
+    progress_ = 100.0f * (double(done) / double(total));
+    throughput_ = refresher->rate();
+    context->notifyRefreshUpdate(date);
 }
 
-// cancel the refresh map, we're about to exit !
+// how quickly did we get through them ?
+void
+RideCache::refreshFinished()
+{
+    progress_ = 100;
+    if (refresher->isCanceled() || refresher->total() == 0) return;
+
+    throughput_ = refresher->rate();
+}
+
+bool
+RideCache::isRunning()
+{
+    return refresher->isRunning();
+}
+
+double
+RideCache::remaining()
+{
+    return refresher->remaining();
+}
+
+// cancel the refresh, we're about to exit !
 void
 RideCache::cancel()
 {
-    if (future.isRunning()) {
-        future.cancel();
-        future.waitForFinished();
-    }
+    refresher->cancel();
+}
+
+void
+RideCache::cancel(RideItem *item)
+{
+    refresher->requeue(item);
 }
 
 // check if we need to refresh the metrics then start the thread if needed
@@ -461,25 +502,34 @@ void
 RideCache::refresh()
 {
     // already on it !
-    if (future.isRunning()) return;
+    if (refresher->isRunning()) return;
 
-    // how many need refreshing ?
-    int staleCount = 0;
+    QTime scan;
+    scan.start();
 
-    foreach(RideItem *item, rides_) {
+    // ok set stale so we refresh, the config is looked up once and
+    // checked here, then the files of those that pass, or are only
+    // stale for the config so far, are checked in parallel since that
+    // means a stat and maybe a crc of each
+    RideItemStaleCheck check(context);
+    QVector<RideItem*> files;
+    foreach(RideItem *item, rides_)
+        if (!item->checkStale(check) || item->staleconfig) files << item;
+    QtConcurrent::blockingMap(files, itemCheckFiles);
 
-        // ok set stale so we refresh
-        if (item->checkStale())
-            staleCount++;
-    }
+    // how many need refreshing ?
+    QVector<RideItem*> stale;
+    foreach(RideItem *item, rides_) if (item->isstale) stale << item;
 
-    // start if there is work to do
-    // and future watcher can notify of updates
-    if (staleCount)  {
-        reverse_ = rides_;
-        qSort(reverse_.begin(), reverse_.end(), rideCacheGreaterThan);
-        future = QtConcurrent::map(reverse_, itemRefresh);
-        watcher.setFuture(future);
+    // shown with the refresh progress
+    scanTime_ = scan.elapsed() / 1000.0;
+
+    // start if there is work to do, the selected ride
+    // and the date range being looked at first
+    if (stale.count())  {
+        progress_ = 0;
+        context->notifyRefreshStart();
+        refresher->start(stale);
     } else {
 
         // nothing to do, notify its started and done immediately
@@ -500,82 +550,23 @@ RideCache::getAggregate(QString name, Specification spec, bool useMetricUnits, b
         return QString("%1 unknown").arg(name);
     }
 
-    // what we will return
-    double rvalue = 0;
-    double rcount = 0; // using double to avoid rounding issues with int when dividing
+    // from the columns, over the rides that pass
+    double rvalue = columns_->aggregate(metric, columns_->select(spec));
 
-    // loop through and aggregate
-    foreach (RideItem *item, rides()) {
-
-        // skip filtered rides
-        if (!spec.pass(item)) continue;
+    // formatted by our own copy, the shared one is being
+    // copied by the threads refreshing in the background
+    RideMetric *formatter = metric->clone();
+    formatter->setValue(rvalue);
 
-        // get this value
-        double value = item->getForSymbol(name);
-        double count = item->getForSymbol("workout_time"); // for averaging
-
-        // check values are bounded, just in case
-        if (std::isnan(value) || std::isinf(value)) value = 0;
-
-        // do we aggregate zero values ?
-        bool aggZero = metric->aggregateZero();
-
-        // set aggZero to false and value to zero if is temperature and -255
-        if (metric->symbol() == "average_temp" && value == RideFile::NA) {
-            value = 0;
-            aggZero = false;
-        }
-
-        switch (metric->type()) {
-        case RideMetric::RunningTotal:
-        case RideMetric::Total:
-            rvalue += value;
-            break;
-        default:
-        case RideMetric::Average:
-            {
-            // average should be calculated taking into account
-            // the duration of the ride, otherwise high value but
-            // short rides will skew the overall average
-            if (value || aggZero) {
-                rvalue += value*count;
-                rcount += count;
-            }
-            break;
-            }
-        case RideMetric::Low:
-            {
-            if (value < rvalue) rvalue = value;
-            break;
-            }
-        case RideMetric::Peak:
-            {
-            if (value > rvalue) rvalue = value;
-            break;
-            }
-        case RideMetric::MeanSquareRoot:
-            {
-                rvalue = sqrt((pow(rvalue*rcount, 2) + pow(value*count,2))/(rcount + count));
-                rcount += count;
-                break;
-            }
-        }
-    }
-
-    // now compute the average
-    if (metric->type() == RideMetric::Average) {
-        if (rcount) rvalue = rvalue / rcount;
-    }
-
-    const_cast<RideMetric*>(metric)->setValue(rvalue);
     // Format appropriately
     QString result;
     if (metric->units(useMetricUnits) == "seconds" ||
         metric->units(useMetricUnits) == tr("seconds")) {
         if (nofmt) result = QString("%1").arg(rvalue);
-        else result = metric->toString(useMetricUnits);
+        else result = formatter->toString(useMetricUnits);
 
-    } else result = metric->toString(useMetricUnits);
+    } else result = formatter->toString(useMetricUnits);
+    delete formatter;
 
     // 0 temp from aggregate means no values
     if ((metric->symbol() == "average_temp" || metric->symbol() == "max_temp") && result == "0.0") result = "-";
@@ -601,6 +592,12 @@ RideCache::getBests(QString symbol, int n, Specification specification, bool use
     const RideMetric *metric = RideMetricFactory::instance().rideMetric(symbol);
     if (!metric) return results;
 
+    // looked up once, not for every ride
+    MetricHandle handle(metric, true);
+
+    // formatted by our own copy, not the shared one, see getAggregate()
+    RideMetric *formatter = metric->clone();
+
     // loop through and aggregate
     foreach (RideItem *ride, rides_) {
 
@@ -609,15 +606,16 @@ RideCache::getBests(QString symbol, int n, Specification specification, bool use
 
         // get this value
         AthleteBest add;
-        add.nvalue = ride->getForSymbol(symbol, true);
+        add.nvalue = ride->getForSymbol(handle);
         add.date = ride->dateTime.date();
 
-        const_cast<RideMetric*>(metric)->setValue(add.nvalue);
-        add.value = metric->toString(useMetricUnits);
+        formatter->setValue(add.nvalue);
+        add.value = formatter->toString(useMetricUnits);
 
         // nil values are not needed
         if (add.nvalue < 0 || add.nvalue > 0) results << add;
     }
+    delete formatter;
 
     // now sort
     qStableSort(results.begin(), results.end(), metric->isLowerBetter() ?
@@ -682,15 +680,122 @@ class RollingBests {
         }
 };
 
+// the models fitted for the estimates, in the order they are listed
+static PDModel *estimateModel(Context *context, int index)
+{
+    switch (index) {
+    case 0: return new CP2Model(context);
+    case 1: return new CP3Model(context);
+    case 2: return new MultiModel(context);
+    case 3: return new ExtendedModel(context);
+    default:
+    case 4: return new WSModel(context);
+    }
+}
+static const int estimateModels = 5;
+
+// a 12 week window of bests to fit the models to
+class PDEstimateWindow
+{
+    public:
+        QDate begin, end;
+        QVector<float> bests, wpk;
+        QList<PDEstimate> estimates;
+};
+
+// fits one model to the power or wpk bests of one window. Each has a
+// model instance of its own, and it is created on the thread it is used
+// on, so the dataChanged() signal that fits it is delivered directly.
+// PDModel::setData(), deriveCPParameters() and the fitting each model
+// does in onDataChanged() (e.g. ExtendedModel::deriveExtCPParameters())
+// only use the instance and what they are passed, no statics or
+// settings, so they are re-entrant and all the fits can run at once on
+// the shared pool. Keep them that way.
+class PDEstimateFit : public QRunnable
+{
+    public:
+        PDEstimateFit(Context *context, int model, bool wpk, const PDEstimateWindow *window, PDEstimate *into, bool *keep) :
+            context(context), model(model), wpk(wpk), window(window), into(into), keep(keep) {}
+
+        void run() {
+
+            PDModel *fit = estimateModel(context, model);
+            PDEstimate &add = *into;
+
+            // set the data
+            fit->setData(wpk ? window->wpk : window->bests);
+            fit->saveParameters(add.parameters); // save the computed parms
+
+            add.wpk = wpk;
+            add.from = window->begin;
+            add.to = window->end;
+            add.model = fit->code();
+            add.WPrime = fit->hasWPrime() ? fit->WPrime() : 0;
+            add.CP = fit->hasCP() ? fit->CP() : 0;
+            add.PMax = fit->hasPMax() ? fit->PMax() : 0;
+            add.FTP = fit->hasFTP() ? fit->FTP() : 0;
+
+            if (add.CP && add.WPrime) add.EI = add.WPrime / add.CP ;
+
+            // so long as the important model derived values are sensible ...
+            if (wpk == false) {
+                *keep = add.WPrime > 1000 && add.CP > 100;
+            } else {
+                *keep = (!fit->hasWPrime() || add.WPrime > 10.0f) &&
+                        (!fit->hasCP() || add.CP > 1.0f) &&
+                        (!fit->hasPMax() || add.PMax > 1.0f) &&
+                        (!fit->hasFTP() || add.FTP > 1.0f);
+            }
+
+            //qDebug()<<add.from<<fit->code()<<add.wpk<< "W'="<< add.WPrime <<"CP="<< add.CP <<"pMax="<<add.PMax;
+            delete fit;
+        }
+
+    private:
+        Context *context;
+        int model;
+        bool wpk;
+        const PDEstimateWindow *window;
+        PDEstimate *into;
+        bool *keep;
+};
+
+// fit every model to every window, for power and wpk, in parallel
+static void fitEstimates(Context *context, QVector<PDEstimateWindow> &windows)
+{
+    int count = windows.count() * estimateModels * 2;
+    QVector<PDEstimate> results(count);
+    QVector<bool> keep(count);
+
+    RideFileCacheTasks tasks;
+    for (int i=0, n=0; i<windows.count(); i++)
+        for (int model=0; model<estimateModels; model++)
+            for (int wpk=0; wpk<2; wpk++, n++)
+                tasks.add(new PDEstimateFit(context, model, wpk, &windows[i], &results[n], &keep[n]));
+    tasks.run();
+
+    // same order as they were fitted one at a time
+    for (int i=0, n=0; i<windows.count(); i++)
+        for (int j=0; j<estimateModels * 2; j++, n++)
+            if (keep[n]) windows[i].estimates << results[n];
+}
+
+quint32
+RideCache::fingerprint(const QList<RideItem*> &rides)
+{
+    QString print;
+    foreach(RideItem *item, rides)
+        print += QString("%1:%2:%3:%4:%5;").arg(item->fileName).arg(item->crc).arg(item->timestamp)
+                                           .arg(item->fingerprint).arg(item->weight);
+    return qHash(print);
+}
+
 void
 RideCache::refreshCPModelMetrics()
 {
     // we're refreshing, so away
     if (refreshingEstimates == true) return;
-
-    // need to lock
     refreshingEstimates = true;
-    context->athlete->lock.lock();
 
     // this needs to be done once all the other metrics
     // Calculate a *monthly* estimate of CP, W' etc using
@@ -698,8 +803,9 @@ RideCache::refreshCPModelMetrics()
     RollingBests bests(12);
     RollingBests bestsWPK(12);
 
-    // clear any previous calculations
-    context->athlete->PDEstimates_.clear();
+    // the new estimates are worked out without holding the
+    // athlete lock and replace the old ones when we're done
+    QList<PDEstimate> returning;
 
     // we do this by aggregating power data into bests
     // for each month, and having a rolling set of 3 aggregates
@@ -728,105 +834,108 @@ RideCache::refreshCPModelMetrics()
 
     // if we don't have 2 rides or more then skip this but add a blank estimate
     if (from == to || to == QDate()) {
+        context->athlete->lock.lock();
+        context->athlete->PDEstimates_.clear();
         context->athlete->PDEstimates_ << PDEstimate();
         context->athlete->lock.unlock();
         refreshingEstimates = false;
         return;
     }
 
-    // set up the models we support
-    CP2Model p2model(context);
-    CP3Model p3model(context);
-    WSModel wsmodel(context);
-    MultiModel multimodel(context);
-    ExtendedModel extmodel(context);
-
-    QList <PDModel *> models;
-    models << &p2model;
-    models << &p3model;
-    models << &multimodel;
-    models << &extmodel;
-    models << &wsmodel;
-
-
     // from has first ride with Power data / looking at the next 7 days of data with Power
     // calculate Estimates for all data per week including the week of the last Power recording
-    QDate date = from;
-    while (date < to) {
+    int nweeks = (from.daysTo(to) + 6) / 7;
 
-        QDate begin = date;
-        QDate end = date.addDays(6);
+    // the rides in each week, they are in date order so one pass will do
+    // don't include RUNS
+    QVector<QList<RideItem*> > weekRides(nweeks);
+    foreach(RideItem *item, rides()) {
+        if (item->isRun) continue;
+        int days = from.daysTo(item->dateTime.date());
+        if (days < 0 || days / 7 >= nweeks) continue;
+        weekRides[days / 7] << item;
+    }
 
-        // let others know where we got to...
-        emit modelProgress(date.year(), date.month());
+    // weeks that haven't changed since last time come from the store, and
+    // their estimates too if none of the weeks in the window changed
+    QMap<QDate, PDEstimateStore::Week> refreshed;
+    QVector<quint32> prints(nweeks);
 
-        // months is a rolling 3 months sets of bests
-        QVector<float> wpk; // for getting the wpk values
+    // windows waiting to be fitted, a batch at a time to limit the memory used
+    QVector<PDEstimateWindow> fitting;
 
-        // don't include RUNS ..................................................vvvvv
-        bests.addBests(RideFileCache::meanMaxPowerFor(context, wpk, begin, end, false));
-        bestsWPK.addBests(wpk);
+    for (int i=0; i<nweeks; i++) {
 
-        // we now have the data
-        foreach(PDModel *model, models) {
-
-            PDEstimate add;
+        QDate begin = from.addDays(i * 7);
+        QDate end = begin.addDays(6);
 
-            // set the data
-            model->setData(bests.aggregate());
-            model->saveParameters(add.parameters); // save the computed parms
-
-            add.wpk = false;
-            add.from = begin;
-            add.to = end;
-            add.model = model->code();
-            add.WPrime = model->hasWPrime() ? model->WPrime() : 0;
-            add.CP = model->hasCP() ? model->CP() : 0;
-            add.PMax = model->hasPMax() ? model->PMax() : 0;
-            add.FTP = model->hasFTP() ? model->FTP() : 0;
+        // let others know where we got to...
+        emit modelProgress(begin.year(), begin.month());
+
+        PDEstimateStore::Week week;
+        quint32 print = fingerprint(weekRides[i]);
+        if (estimates->find(begin, print, week) == false) {
+
+            // read the bests from the .cpx files, if any were missing
+            // we'll need to read them again next time
+            bool complete;
+            week = PDEstimateStore::Week();
+            week.bests = RideFileCache::meanMaxPowerFor(context, week.wpk, weekRides[i], &complete);
+            week.print = complete ? print : 0;
+        }
+        prints[i] = week.print;
 
-            if (add.CP && add.WPrime) add.EI = add.WPrime / add.CP ;
+        // months is a rolling 3 months sets of bests
+        bests.addBests(week.bests);
+        bestsWPK.addBests(week.wpk);
+
+        // the weeks in the rolling window, it can't be reused if any were incomplete
+        QString windowprint;
+        bool complete = true;
+        for (int j=i-11; j<=i; j++) {
+            if (j < 0) continue;
+            if (prints[j] == 0) complete = false;
+            windowprint += QString("%1;").arg(prints[j]);
+        }
+        quint32 window = complete ? qHash(windowprint) : 0;
 
-            // so long as the important model derived values are sensible ...
-            if (add.WPrime > 1000 && add.CP > 100)
-                context->athlete->PDEstimates_ << add;
-
-            //qDebug()<<add.to<<add.from<<model->code()<< "W'="<< model->WPrime() <<"CP="<< model->CP() <<"pMax="<<model->PMax();
-
-            // set the wpk data
-            model->setData(bestsWPK.aggregate());
-            model->saveParameters(add.parameters); // save the computed parms
-
-            add.wpk = true;
-            add.from = begin;
-            add.to = end;
-            add.model = model->code();
-            add.WPrime = model->hasWPrime() ? model->WPrime() : 0;
-            add.CP = model->hasCP() ? model->CP() : 0;
-            add.PMax = model->hasPMax() ? model->PMax() : 0;
-            add.FTP = model->hasFTP() ? model->FTP() : 0;
-            if (add.CP && add.WPrime) add.EI = add.WPrime / add.CP ;
+        // estimates need refitting
+        if (window == 0 || window != week.window) {
 
-            // so long as the model derived values are sensible ...
-            if ((!model->hasWPrime() || add.WPrime > 10.0f) &&
-                (!model->hasCP() || add.CP > 1.0f) &&
-                (!model->hasPMax() || add.PMax > 1.0f) &&
-                (!model->hasFTP() || add.FTP > 1.0f))
-                context->athlete->PDEstimates_ << add;
+            week.window = window;
+            week.estimates.clear();
 
-            //qDebug()<<add.from<<model->code()<< "KG W'="<< model->WPrime() <<"CP="<< model->CP() <<"pMax="<<model->PMax();
+            PDEstimateWindow add;
+            add.begin = begin;
+            add.end = end;
+            add.bests = bests.aggregate();
+            add.wpk = bestsWPK.aggregate();
+            fitting << add;
         }
+        refreshed.insert(begin, week);
 
-        // go forward a week
-        date = date.addDays(7);
+        // we now have the data
+        if (fitting.count() == 32 || (i == nweeks-1 && fitting.count())) {
+            fitEstimates(context, fitting);
+            foreach(const PDEstimateWindow &fitted, fitting)
+                refreshed[fitted.begin].estimates = fitted.estimates;
+            fitting.clear();
+        }
     }
 
+    // in date order
+    foreach(const PDEstimateStore::Week &week, refreshed)
+        returning << week.estimates;
+
+    // weeks no longer used are dropped
+    estimates->update(refreshed);
+
     // add a dummy entry if we have no estimates to stop constantly trying to refresh
-    if (context->athlete->PDEstimates_.count() == 0) {
-        context->athlete->PDEstimates_ << PDEstimate();
-    }
+    if (returning.count() == 0) returning << PDEstimate();
 
-    // unlock
+    // only need the lock to replace them
+    context->athlete->lock.lock();
+    context->athlete->PDEstimates_ = returning;
     context->athlete->lock.unlock();
     refreshingEstimates = false;
 
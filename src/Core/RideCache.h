@@ -27,6 +27,7 @@
 
 #include <QVector>
 #include <QThread>
+#include <QTime>
 
 #include <QFuture>
 #include <QFutureWatcher>
@@ -41,6 +42,10 @@ class RideCacheBackgroundRefresh;
 class Specification;
 class AthleteBest;
 class RideCacheModel;
+class PDEstimateStore;
+class RideDBBinary;
+class RideCacheRefresh;
+class RideCacheColumns;
 
 class RideCache : public QObject
 {
@@ -81,11 +86,14 @@ class RideCache : public QObject
                                       SportRestriction sport=AnySport);
 
         // is running ?
-        bool isRunning() { return future.isRunning(); }
+        bool isRunning();
 
         // the ride list
 	    QVector<RideItem*>&rides() { return rides_; } 
 
+        // the metrics of the rides above, a column at a time
+        RideCacheColumns *columns() { return columns_; }
+
         // add/remove a ride to the list
         void addRide(QString name, bool dosignal, bool select, bool useTempActivities, bool planned);
         void removeCurrentRide();
@@ -93,28 +101,42 @@ class RideCache : public QObject
         // export metrics in CSV format
         void writeAsCSV(QString filename);
 
+        // the cache as json, as in cache/rideDB.json
+        static void saveJSON(QIODevice &device, const QList<RideItem*> &rides);
+
+        // changes when any of the rides, or the config they were
+        // computed with, changes; for anything saved from them
+        static quint32 fingerprint(const QList<RideItem*> &rides);
+
         // the background refresher !
         void refresh();
         double progress() { return progress_; }
+        double throughput() { return throughput_; } // rides/sec of the last refresh, or so far
+        double remaining(); // estimated secs until the refresh is done
+        double scanTime() { return scanTime_; } // secs to find the stale rides
 
         // PD Model refreshing (temporary move)
         void refreshCPModelMetrics();
 
     public slots:
 
-        // restore / dump cache to disk (json)
+        // restore / dump cache to disk
         void load();
-        void save();
+        void save(bool json=false); // json too, at exit or after a sync
 
         // user updated options/preferences
         void configChanged(qint32);
 
         // background refresh progress update
-        void progressing(int);
+        void progressing(int done, int total, QDate date);
+        void refreshFinished();
 
         // cancel background processing because about to exit
         void cancel();
 
+        // stop refreshing this one in the background, e.g. it's being edited
+        void cancel(RideItem *item);
+
         // item telling us it changed
         void itemChanged();
 
@@ -135,14 +157,20 @@ class RideCache : public QObject
         Context *context;
         QDir directory, plannedDirectory;
 
-        QVector<RideItem*> rides_, reverse_, delete_;
+        QVector<RideItem*> rides_, delete_;
         RideCacheModel *model_;
         bool exiting;
         bool refreshingEstimates;
+        PDEstimateStore *estimates; // weekly bests and the estimates fitted to them
+        RideDBBinary *rideDBBinary; // cache/rideDB.bin and its journal
 	    double progress_; // percent
 
-        QFuture<void> future;
-        QFutureWatcher<void> watcher;
+        // refresh throughput
+        double throughput_; // rides per second
+        double scanTime_; // secs the last staleness check took
+
+        RideCacheRefresh *refresher;
+        RideCacheColumns *columns_;
 
 };
 
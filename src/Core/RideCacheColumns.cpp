@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideCacheColumns.h"
+#include "RideCache.h"
+#include "RideItem.h"
+#include "RideFile.h"
+#include "RideMetric.h"
+
+#include <QtAlgorithms>
+#include <cmath>
+
+// bad values are counted as zero, as they always have been
+static inline double clean(double value)
+{
+    return (std::isnan(value) || std::isinf(value)) ? 0 : value;
+}
+
+RideCacheColumns::RideCacheColumns(RideCache *cache) :
+    cache(cache), generation(-1), metrics(0), revision(-1), sorted(true), duration(-1)
+{
+}
+
+void
+RideCacheColumns::sync()
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+    const QVector<RideItem*> &rides = cache->rides();
+
+    // read before looking at the rides, so any that change
+    // whilst we do are looked at again next time
+    int latest = RideItem::metricsRevisions();
+
+    if (generation != factory.generation() || metrics != factory.metricCount() || rides_ != rides) {
+
+        // start again
+        generation = factory.generation();
+        metrics = factory.metricCount();
+        rides_ = rides;
+        revisions_.fill(-1, rides_.count());
+        dates_.resize(rides_.count());
+
+        built.fill(false, metrics);
+        values_.fill(QVector<double>(), metrics);
+        counts_.fill(QVector<double>(), metrics);
+
+        const RideMetric *m = factory.rideMetric("workout_time");
+        duration = m ? m->index() : -1;
+
+    } else if (latest == revision) return; // no metrics changed
+
+    revision = latest;
+
+    // copy the rides that changed into the columns we have
+    for (int i=0; i<rides_.count(); i++) {
+
+        RideItem *item = rides_[i];
+        int now = item->metricsRevision();
+        if (now == revisions_[i]) continue;
+
+        revisions_[i] = now;
+        dates_[i] = item->dateTime.date();
+
+        bool valid = item->metrics().count() == metrics && item->counts().count() == metrics;
+        for (int j=0; j<metrics; j++) {
+            if (!built.testBit(j)) continue;
+            values_[j][i] = valid ? item->metrics()[j] : 0;
+            counts_[j][i] = valid ? item->counts()[j] : 0;
+        }
+    }
+
+    // rides are kept in date order, but check
+    sorted = true;
+    for (int i=1; i<dates_.count() && sorted; i++)
+        if (dates_[i] < dates_[i-1]) sorted = false;
+}
+
+const QVector<double> &
+RideCacheColumns::column(int index)
+{
+    static const QVector<double> none;
+    if (index < 0 || index >= metrics) return none;
+
+    if (!built.testBit(index)) {
+
+        QVector<double> &values = values_[index];
+        QVector<double> &counts = counts_[index];
+        values.fill(0, rides_.count());
+        counts.fill(0, rides_.count());
+
+        for (int i=0; i<rides_.count(); i++) {
+            RideItem *item = rides_[i];
+            if (item->metrics().count() != metrics || item->counts().count() != metrics) continue;
+            values[i] = item->metrics()[index];
+            counts[i] = item->counts()[index];
+        }
+        built.setBit(index);
+    }
+    return values_[index];
+}
+
+QBitArray
+RideCacheColumns::select(Specification spec)
+{
+    QMutexLocker locker(&mutex);
+    sync();
+
+    int n = rides_.count();
+    QBitArray rides(n);
+
+    // the rides in the date range
+    DateRange range = spec.dateRange();
+    int from = 0, to = n;
+    if (sorted) {
+        if (range.from.isValid()) from = qLowerBound(dates_.begin(), dates_.end(), range.from) - dates_.begin();
+        if (range.to.isValid()) to = qUpperBound(dates_.begin(), dates_.end(), range.to) - dates_.begin();
+    }
+
+    // and that pass the filters
+    for (int i=from; i<to; i++) {
+        if (!sorted && !range.pass(dates_[i])) continue;
+        if (spec.isFiltered() && !spec.pass(rides_[i])) continue;
+        rides.setBit(i);
+    }
+    return rides;
+}
+
+QVector<double>
+RideCacheColumns::values(int index)
+{
+    QMutexLocker locker(&mutex);
+    sync();
+    return column(index);
+}
+
+QVector<double>
+RideCacheColumns::counts(int index)
+{
+    QMutexLocker locker(&mutex);
+    sync();
+    column(index);
+    return index >= 0 && index < metrics ? counts_[index] : QVector<double>();
+}
+
+double
+RideCacheColumns::sum(int index, const QBitArray &rides)
+{
+    QMutexLocker locker(&mutex);
+    sync();
+
+    const QVector<double> &values = column(index);
+    const double *v = values.constData();
+    int n = qMin(values.count(), rides.count());
+
+    double total = 0;
+    for (int i=0; i<n; i++) if (rides.testBit(i)) total += clean(v[i]);
+    return total;
+}
+
+void
+RideCacheColumns::weighted(int index, const QBitArray &rides, bool zeroes, bool na,
+                           double &total, double &weight)
+{
+    total = weight = 0;
+
+    const QVector<double> &values = column(index);
+    const QVector<double> &durations = column(duration);
+    const double *v = values.constData();
+    const double *w = durations.constData();
+    int n = qMin(qMin(values.count(), durations.count()), rides.count());
+
+    for (int i=0; i<n; i++) {
+        if (!rides.testBit(i)) continue;
+
+        double value = clean(v[i]);
+        if (na && value == RideFile::NA) continue;
+
+        // long rides count for more than short ones
+        if (value || zeroes) {
+            total += value * w[i];
+            weight += w[i];
+        }
+    }
+}
+
+double
+RideCacheColumns::mean(int index, const QBitArray &rides, bool zeroes)
+{
+    QMutexLocker locker(&mutex);
+    sync();
+
+    double total, weight;
+    weighted(index, rides, zeroes, false, total, weight);
+    return weight ? total / weight : total;
+}
+
+double
+RideCacheColumns::min(int index, const QBitArray &rides)
+{
+    QMutexLocker locker(&mutex);
+    sync();
+
+    const QVector<double> &values = column(index);
+    const double *v = values.constData();
+    int n = qMin(values.count(), rides.count());
+
+    bool first = true;
+    double low = 0;
+    for (int i=0; i<n; i++) {
+        if (!rides.testBit(i)) continue;
+        double value = clean(v[i]);
+        if (first || value < low) low = value;
+        first = false;
+    }
+    return low;
+}
+
+double
+RideCacheColumns::max(int index, const QBitArray &rides)
+{
+    QMutexLocker locker(&mutex);
+    sync();
+
+    const QVector<double> &values = column(index);
+    const double *v = values.constData();
+    int n = qMin(values.count(), rides.count());
+
+    bool first = true;
+    double high = 0;
+    for (int i=0; i<n; i++) {
+        if (!rides.testBit(i)) continue;
+        double value = clean(v[i]);
+        if (first || value > high) high = value;
+        first = false;
+    }
+    return high;
+}
+
+double
+RideCacheColumns::rms(int index, const QBitArray &rides)
+{
+    QMutexLocker locker(&mutex);
+    sync();
+
+    const QVector<double> &values = column(index);
+    const QVector<double> &durations = column(duration);
+    const double *v = values.constData();
+    const double *w = durations.constData();
+    int n = qMin(qMin(values.count(), durations.count()), rides.count());
+
+    // running, in ride order, as the aggregate always has been
+    double rvalue = 0, rcount = 0;
+    for (int i=0; i<n; i++) {
+        if (!rides.testBit(i)) continue;
+        double value = clean(v[i]);
+        rvalue = sqrt((pow(rvalue*rcount, 2) + pow(value*w[i], 2)) / (rcount + w[i]));
+        rcount += w[i];
+    }
+    return rvalue;
+}
+
+double
+RideCacheColumns::aggregate(const RideMetric *metric, const QBitArray &rides)
+{
+    if (!metric) return 0;
+
+    switch (metric->type()) {
+    case RideMetric::RunningTotal:
+    case RideMetric::Total:
+        return sum(metric->index(), rides);
+
+    case RideMetric::Low:
+        return qMin(0.0, min(metric->index(), rides));
+
+    case RideMetric::Peak:
+        return qMax(0.0, max(metric->index(), rides));
+
+    case RideMetric::MeanSquareRoot:
+        return rms(metric->index(), rides);
+
+    default:
+    case RideMetric::Average:
+        {
+        QMutexLocker locker(&mutex);
+        sync();
+
+        // temperature is -255 when there wasn't any
+        bool na = metric->symbol() == "average_temp";
+
+        double total, weight;
+        weighted(metric->index(), rides, metric->aggregateZero(), na, total, weight);
+
+        // only averages are divided out, anything else is left as the total
+        if (metric->type() == RideMetric::Average && weight) return total / weight;
+        return total;
+        }
+    }
+}
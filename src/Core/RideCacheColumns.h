@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideCacheColumns_h
+#define _GC_RideCacheColumns_h 1
+#include "GoldenCheetah.h"
+
+#include <QVector>
+#include <QBitArray>
+#include <QDate>
+#include <QMutex>
+
+#include "Specification.h"
+
+class RideCache;
+class RideItem;
+class RideMetric;
+
+//
+// The metrics of every ride held a column at a time, one value per ride
+// in the same order as RideCache::rides(), so summing a metric over a
+// season walks one array instead of looking it up ride by ride.
+//
+// The rides wanted are selected once as a bitmap, using the date order
+// of the rides to find the date range, then any of the kernels can be
+// run over it. The values are as stored, i.e. in metric units.
+//
+// A column is only copied from the rides the first time it is asked for,
+// after that just the rides whose metrics changed are copied again, see
+// RideItem::metricsRevision(). Everything is thrown away when rides are
+// added or removed, or the metrics are redefined.
+//
+class RideCacheColumns
+{
+    public:
+        RideCacheColumns(RideCache *cache);
+
+        // the rides that pass, by ordinal in RideCache::rides()
+        QBitArray select(Specification spec);
+
+        // metric by RideMetric::index(), one for each ride
+        QVector<double> values(int index);
+        QVector<double> counts(int index);
+
+        // kernels over the rides selected, nan and inf count as zero
+        double sum(int index, const QBitArray &rides);
+        double mean(int index, const QBitArray &rides, bool zeroes=true); // weighted by workout_time
+        double min(int index, const QBitArray &rides); // zero if none
+        double max(int index, const QBitArray &rides); // zero if none
+        double rms(int index, const QBitArray &rides); // weighted by workout_time
+
+        // as RideCache::getAggregate() before it is formatted
+        double aggregate(const RideMetric *metric, const QBitArray &rides);
+
+    private:
+
+        void sync(); // with the rides, holding the mutex
+        const QVector<double> &column(int index); // built if need be
+        void weighted(int index, const QBitArray &rides, bool zeroes, bool na,
+                      double &total, double &weight);
+
+        RideCache *cache;
+        QMutex mutex;
+
+        // what the columns were taken from
+        int generation, metrics, revision;
+        QVector<RideItem*> rides_;
+        QVector<int> revisions_;  // of each ride's metrics when last copied
+        QVector<QDate> dates_;
+        bool sorted;              // dates_, so date ranges can be searched
+
+        QBitArray built;
+        QVector<QVector<double> > values_, counts_;
+        int duration;             // index of workout_time
+};
+
+#endif // _GC_RideCacheColumns_h
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideCacheRefresh.h"
+#include "RideItem.h"
+#include "Context.h"
+#include "RideFileCache.h"
+
+#include <QRunnable>
+#include <QtAlgorithms>
+
+#ifdef SLOW_REFRESH
+#include "unistd.h"
+#endif
+
+// sorts the most urgent last, so they can be taken off the end
+class RideCacheRefreshOrder
+{
+    public:
+        RideCacheRefreshOrder(Context *context) :
+            ride(context->ride), from(context->currentDateRange().from), to(context->currentDateRange().to) {}
+
+        int priority(RideItem *item) const {
+            if (item == ride) return 0;
+
+            QDate date = item->dateTime.date();
+            if ((from.isValid() || to.isValid()) &&
+                (!from.isValid() || date >= from) && (!to.isValid() || date <= to)) return 1;
+
+            return 2;
+        }
+
+        bool operator()(RideItem *a, RideItem *b) const {
+            int pa = priority(a), pb = priority(b);
+            if (pa != pb) return pa > pb;
+            return a->dateTime < b->dateTime; // newest first
+        }
+
+    private:
+        RideItem *ride;
+        QDate from, to;
+};
+
+// each worker refreshes rides until there are none left
+class RideCacheRefreshWorker : public QRunnable
+{
+    public:
+        RideCacheRefreshWorker(RideCacheRefresh *refresh, int run) : refresh(refresh), run(run) {}
+
+        void run() {
+            RideItem *item;
+            while ((item = refresh->next()) != NULL) {
+
+                // need parser to be reentrant !item->refresh();
+                if (item->isstale) {
+                    item->refresh();
+
+                    // and trap changes during refresh to current ride
+                    if (refresh->wanted(item) && item == item->context->currentRideItem())
+                        item->context->notifyRideChanged(item);
+
+#ifdef SLOW_REFRESH
+                    sleep(1);
+#endif
+                }
+                refresh->refreshed(run, item);
+            }
+            refresh->exited(run);
+        }
+
+    private:
+        RideCacheRefresh *refresh;
+        int run;
+};
+
+RideCacheRefresh::RideCacheRefresh(Context *context) :
+    context(context), workers(0), done_(0), total_(0), run(0), canceled(false)
+{
+    // to the gui thread, where stale runs are dropped
+    connect(this, SIGNAL(workerProgress(int,int,int,QDate)), this, SLOT(progressed(int,int,int,QDate)), Qt::QueuedConnection);
+    connect(this, SIGNAL(workerFinished(int)), this, SLOT(runFinished(int)), Qt::QueuedConnection);
+}
+
+RideCacheRefresh::~RideCacheRefresh()
+{
+    cancel();
+}
+
+void
+RideCacheRefresh::start(QVector<RideItem*> items)
+{
+    if (isRunning()) return;
+
+    int threads = RideFileCacheTasks::threads();
+    pool.setMaxThreadCount(threads);
+
+    mutex.lock();
+    queue = items.toList();
+    qSort(queue.begin(), queue.end(), RideCacheRefreshOrder(context));
+    running.clear();
+    removed.clear();
+    again.clear();
+    done_ = 0;
+    total_ = queue.count();
+    canceled = false;
+    time.start();
+    run++;
+
+    // no more workers than rides, the cpx pool gets the rest
+    workers = qMin(threads, total_);
+    RideFileCacheTasks::reserve(workers);
+    for (int i=0; i<workers; i++) pool.start(new RideCacheRefreshWorker(this, run));
+    mutex.unlock();
+}
+
+bool
+RideCacheRefresh::isRunning()
+{
+    QMutexLocker locker(&mutex);
+    return workers > 0;
+}
+
+void
+RideCacheRefresh::prioritise()
+{
+    // looks at the selection, so on the gui thread
+    RideCacheRefreshOrder order(context);
+
+    QMutexLocker locker(&mutex);
+    qSort(queue.begin(), queue.end(), order);
+}
+
+void
+RideCacheRefresh::remove(RideItem *item)
+{
+    QMutexLocker locker(&mutex);
+    queue.removeAll(item);
+    if (running.contains(item)) removed.insert(item);
+}
+
+void
+RideCacheRefresh::requeue(RideItem *item)
+{
+    QMutexLocker locker(&mutex);
+    queue.removeAll(item);
+    if (running.contains(item)) again.insert(item);
+}
+
+bool
+RideCacheRefresh::wanted(RideItem *item)
+{
+    QMutexLocker locker(&mutex);
+    return !removed.contains(item) && !again.contains(item);
+}
+
+void
+RideCacheRefresh::cancel()
+{
+    mutex.lock();
+    canceled = workers > 0 || canceled;
+    queue.clear();
+    mutex.unlock();
+
+    // the rides being refreshed finish
+    pool.waitForDone();
+    RideFileCacheTasks::reserve(0);
+}
+
+int
+RideCacheRefresh::done()
+{
+    QMutexLocker locker(&mutex);
+    return done_;
+}
+
+int
+RideCacheRefresh::total()
+{
+    QMutexLocker locker(&mutex);
+    return total_;
+}
+
+double
+RideCacheRefresh::rate()
+{
+    QMutexLocker locker(&mutex);
+    double secs = time.elapsed() / 1000.0;
+    return secs > 0 ? done_ / secs : 0;
+}
+
+double
+RideCacheRefresh::remaining()
+{
+    double persec = rate();
+    return persec > 0 ? (total() - done()) / persec : 0;
+}
+
+RideItem *
+RideCacheRefresh::next()
+{
+    QMutexLocker locker(&mutex);
+    if (queue.isEmpty()) return NULL;
+
+    RideItem *item = queue.takeLast();
+    running.insert(item);
+    return item;
+}
+
+void
+RideCacheRefresh::refreshed(int run, RideItem *item)
+{
+    mutex.lock();
+    running.remove(item);
+    removed.remove(item);
+
+    // changed while we refreshed it, so it is out of date
+    // again, refreshed before anything else still queued
+    if (again.remove(item)) {
+        item->isstale = true;
+        item->staleconfig = 0;
+        queue.append(item);
+        mutex.unlock();
+        return;
+    }
+    int now = ++done_;
+    int total = total_;
+    mutex.unlock();
+
+    emit workerProgress(run, now, total, item->dateTime.date());
+}
+
+void
+RideCacheRefresh::exited(int run)
+{
+    mutex.lock();
+    bool last = --workers == 0;
+    mutex.unlock();
+
+    if (last) emit workerFinished(run);
+}
+
+void
+RideCacheRefresh::progressed(int run, int done, int total, QDate date)
+{
+    if (run == this->run) emit progress(done, total, date);
+}
+
+void
+RideCacheRefresh::runFinished(int run)
+{
+    if (run != this->run) return;
+
+    RideFileCacheTasks::reserve(0);
+    emit finished();
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideCacheRefresh_h
+#define _GC_RideCacheRefresh_h 1
+#include "GoldenCheetah.h"
+
+#include <QObject>
+#include <QVector>
+#include <QList>
+#include <QSet>
+#include <QDate>
+#include <QTime>
+#include <QMutex>
+#include <QThreadPool>
+
+class Context;
+class RideItem;
+class RideCacheRefreshWorker;
+
+//
+// Refreshes the stale rides in the background. A pool of workers each
+// take the most urgent ride left in turn, so a worker that gets through
+// quick rides just takes more of them:
+//
+//   the ride that is selected
+//   the rides in the date range being looked at
+//   then the rest, newest first
+//
+// So after a zone change the charts being looked at are right first. The
+// order is worked out again when the ride selected or the date range
+// changes. A ride can be taken out when it is deleted or edited, and it
+// can all be cancelled. Nothing waits for a ride being refreshed right
+// now; a deleted one has its refresh ignored, an edited one is refreshed
+// again once done, as what it was refreshed from is out of date.
+//
+// The number of workers is GC_REFRESH_THREADS, or one per core if not set,
+// and the cpx pool gets whatever they leave (see RideFileCacheTasks).
+//
+// Each run has a generation, so when a run is cancelled and another one
+// started the progress and finish of the old one, which are queued to
+// the gui thread, are dropped rather than taken for the new one's.
+//
+class RideCacheRefresh : public QObject
+{
+    Q_OBJECT
+
+    public:
+        RideCacheRefresh(Context *context);
+        ~RideCacheRefresh(); // cancels
+
+        // refresh these, unless already running
+        void start(QVector<RideItem*> items);
+
+        bool isRunning();
+        bool isCanceled() { return canceled; }
+
+        // take it out, e.g. it is being deleted
+        void remove(RideItem *item);
+
+        // take it out, it changed and is refreshed on the gui thread,
+        // if being refreshed right now it is refreshed again when done
+        void requeue(RideItem *item);
+
+        // stop, waits for the rides being refreshed to finish
+        void cancel();
+
+        // progress
+        int done();
+        int total();
+        double rate(); // rides per second so far
+        double remaining(); // estimated seconds to go
+
+    public slots:
+
+        // selection or date range changed
+        void prioritise();
+
+    signals:
+
+        // on the gui thread, for the current run only
+        void progress(int done, int total, QDate date);
+        void finished();
+
+        // these come from the workers
+        void workerProgress(int run, int done, int total, QDate date);
+        void workerFinished(int run);
+
+    private slots:
+
+        void progressed(int run, int done, int total, QDate date);
+        void runFinished(int run);
+
+    protected:
+
+        friend class ::RideCacheRefreshWorker;
+
+        RideItem *next(); // NULL when there are none left
+        bool wanted(RideItem *item); // not removed or requeued since taken
+        void refreshed(int run, RideItem *item);
+        void exited(int run);
+
+    private:
+        Context *context;
+        QThreadPool pool;
+
+        QMutex mutex;
+        QList<RideItem*> queue;  // the most urgent last
+        QSet<RideItem*> running; // being refreshed right now
+        QSet<RideItem*> removed; // of those, deleted since
+        QSet<RideItem*> again;   // of those, changed since
+        int workers, done_, total_;
+        int run; // generation, changed on the gui thread only
+        bool canceled;
+        QTime time;
+};
+
+#endif // _GC_RideCacheRefresh_h
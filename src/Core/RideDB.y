@@ -18,6 +18,7 @@
  */
 
 #include "RideDB.h"
+#include "RideDBBinary.h"
 #ifdef GC_WANT_HTTP
 #include "APIWebService.h"
 #endif
@@ -124,6 +125,7 @@ ride: '{' rideelement_list '}'                                  {
                                                                     jc->interval.route = QUuid();
                                                                     jc->item.clearIntervals();
                                                                     jc->item.overrides_.clear();
+                                                                    jc->item.configprints.clear();
                                                                     jc->item.fileName = "";
                                                                     jc->count = "";
                                                                     jc->value = "";
@@ -147,7 +149,14 @@ rideelement: ride_tuple
 ride_tuple: string ':' string                                   { 
                                                                      if ($1 == "filename") jc->item.fileName = $3;
                                                                      else if ($1 == "fingerprint") jc->item.fingerprint = $3.toULongLong();
+                                                                     else if ($1 == "configprints") {
+                                                                         jc->item.configprints.clear();
+                                                                         foreach(QString print, $3.split(",")) jc->item.configprints << print.toULong();
+                                                                     }
                                                                      else if ($1 == "crc") jc->item.crc = $3.toULongLong();
+                                                                     else if ($1 == "filesize") jc->item.fileSize = $3.toULongLong();
+                                                                     else if ($1 == "filemodified") jc->item.fileModified = $3.toLongLong();
+                                                                     else if ($1 == "fileinode") jc->item.fileInode = $3.toULongLong();
                                                                      else if ($1 == "metacrc") jc->item.metacrc = $3.toULongLong();
                                                                      else if ($1 == "timestamp") jc->item.timestamp = $3.toULongLong();
                                                                      else if ($1 == "dbversion") jc->item.dbversion = $3.toInt();
@@ -327,6 +336,9 @@ string: STRING                                               { jc->JsonString =
 void 
 RideCache::load()
 {
+    // the binary copy is much quicker to load, if its up to date
+    if (rideDBBinary->load()) return;
+
     // only load if it exists !
     QFile rideDB(QString("%1/%2").arg(context->athlete->home->cache().canonicalPath()).arg("rideDB.json"));
     if (rideDB.exists() && rideDB.open(QFile::ReadOnly)) {
@@ -401,18 +413,24 @@ static QString protect(const QString string)
     return s;
 }
 
-// save cache to disk, "cache/rideDB.json"
-void RideCache::save()
+// save cache to disk, "cache/rideDB.bin" and its journal, see RideDBBinary.h
+void RideCache::save(bool json)
 {
+    rideDBBinary->save(json);
+}
 
-    // now save data away
-    QFile rideDB(QString("%1/%2").arg(context->athlete->home->cache().canonicalPath()).arg("rideDB.json"));
-    if (rideDB.open(QFile::WriteOnly)) {
+// the cache as json, "cache/rideDB.json" is written with this whenever the
+// rideDB is compacted, in the background so only from the rides passed
+void RideCache::saveJSON(QIODevice &device, const QList<RideItem*> &rides)
+{
+
+    // only if it can be written
+    if (device.isWritable()) {
 
         const RideMetricFactory &factory = RideMetricFactory::instance();
 
         // ok, lets write out the cache
-        QTextStream stream(&rideDB);
+        QTextStream stream(&device);
         stream.setCodec("UTF-8");
         stream.setGenerateByteOrderMark(true);
 
@@ -421,7 +439,7 @@ void RideCache::save()
         stream << "\n  \"RIDES\":[\n";
 
         bool firstRide = true;
-        foreach(RideItem *item, rides()) {
+        foreach(RideItem *item, rides) {
 
             // skip if not loaded/refreshed, a special case
             // if saving during an initial refresh
@@ -439,7 +457,15 @@ void RideCache::save()
             stream << "\t\t\"filename\":\"" <<item->fileName <<"\",\n";
             stream << "\t\t\"date\":\"" <<item->dateTime.toUTC().toString(DATETIME_FORMAT) << "\",\n";
             stream << "\t\t\"fingerprint\":\"" <<item->fingerprint <<"\",\n";
+            if (item->configprints.count()) {
+                QStringList prints;
+                foreach(unsigned long print, item->configprints) prints << QString::number(print);
+                stream << "\t\t\"configprints\":\"" <<prints.join(",") <<"\",\n";
+            }
             stream << "\t\t\"crc\":\"" <<item->crc <<"\",\n";
+            stream << "\t\t\"filesize\":\"" <<item->fileSize <<"\",\n";
+            stream << "\t\t\"filemodified\":\"" <<item->fileModified <<"\",\n";
+            stream << "\t\t\"fileinode\":\"" <<item->fileInode <<"\",\n";
             stream << "\t\t\"metacrc\":\"" <<item->metacrc <<"\",\n";
             stream << "\t\t\"timestamp\":\"" <<item->timestamp <<"\",\n";
             stream << "\t\t\"dbversion\":\"" <<item->dbversion <<"\",\n";
@@ -622,8 +648,6 @@ void RideCache::save()
         }
 
         stream << "\n  ]\n}";
-
-        rideDB.close();
     }
 }
 
@@ -0,0 +1,683 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideDBBinary.h"
+#include "RideDBJournal.h"
+#include "RideDB.h"
+#include "RideMetric.h"
+#include "MainWindow.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QBuffer>
+#include <QHash>
+#include <string.h>
+
+#if QT_VERSION > 0x050000
+#include <QtConcurrent>
+#else
+#include <QtConcurrentRun>
+#endif
+
+// bump when the layout below changes
+static const quint32 binaryVersion = 6;
+
+// compact the journal once it is bigger than this
+static const qint64 journalLimit = 8 * 1024 * 1024;
+
+// all offsets are from the start of the image, the
+// structures are written as they are held in memory
+struct RideDBBinaryHeader {
+    char magic[4];          // "GCDB"
+    quint32 layout;         // binaryVersion
+    char ridedb[8];         // RIDEDB_VERSION
+    quint32 metrics, rides; // columns and records
+    quint64 symbols;        // metrics x string
+    quint64 records;        // rides x RideDBBinaryRide
+    quint64 values;         // rides x metrics x 2 doubles
+    quint64 extra;          // variable length data
+    quint64 strings;        // string table
+    quint64 size;           // of the whole image, to spot a truncated one
+    quint64 generation;     // see RideDBBinary.h
+    quint64 json;           // size of the rideDB.json written with it
+    qint64 jsonModified;    // and when, msecs since the epoch
+};
+
+struct RideDBBinaryRide {
+    qint64 date; // msecs since the epoch
+    quint64 fingerprint, crc, metacrc, timestamp;
+    quint64 configprints[RideMetric::ConfigInputCount]; // if configprintsFlag
+    quint64 fileSize;
+    qint64 fileModified;    // msecs since the epoch
+    double weight;
+    qint32 dbversion, udbversion;
+    qint32 zoneRange, hrZoneRange, paceZoneRange;
+    quint32 color;          // QRgb
+    quint32 flags;          // see below
+    quint32 fileName, present, overrides; // strings
+    quint32 extra, extraSize; // from the start of extra
+};
+
+enum { isRunFlag = 1, isSwimFlag = 2, samplesFlag = 4, configprintsFlag = 8 };
+
+//
+// WRITING
+//
+class RideDBBinaryWriter
+{
+    public:
+        RideDBBinaryWriter() { add(strings, quint32(0)); } // the empty string
+
+        // strings are a quint32 length and then the UTF-16, each
+        // is stored once and padded to 4 bytes, 0 is the empty string
+        quint32 string(const QString &string) {
+            if (string.isEmpty()) return 0;
+            QHash<QString, quint32>::const_iterator it = stored.constFind(string);
+            if (it != stored.constEnd()) return it.value();
+
+            quint32 offset = strings.size();
+            add(strings, quint32(string.length()));
+            strings.append(reinterpret_cast<const char*>(string.constData()), string.length() * sizeof(QChar));
+            while (strings.size() % 4) strings.append('\0');
+
+            stored.insert(string, offset);
+            return offset;
+        }
+
+        // to the extra data
+        void u32(quint32 value) { add(extra, value); }
+        void f64(double value) { add(extra, value); }
+        void str(const QString &value) { add(extra, string(value)); }
+
+        // the std means and variances for a ride or interval
+        void stdmeans(QMap<int,double> &means, QMap<int,double> &variances) {
+            u32(means.count());
+            QMap<int,double>::const_iterator i = means.constBegin();
+            for (; i != means.constEnd(); ++i) {
+                u32(i.key());
+                f64(i.value());
+                f64(variances.value(i.key(), 0.0f));
+            }
+        }
+
+        template<typename T> static void add(QByteArray &to, T value) {
+            to.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        QByteArray extra, strings;
+
+    private:
+        QHash<QString, quint32> stored;
+};
+
+// the rides we save, as for the json
+static bool saveable(RideItem *item)
+{
+    // skip if not loaded/refreshed, or changes were discarded
+    return item->metrics().count() && item->skipsave == false;
+}
+
+static QByteArray image(const QList<RideItem*> &rides, quint64 generation)
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+    int metrics = factory.metricCount();
+
+    RideDBBinaryWriter writer;
+    QByteArray symbols, records, values;
+
+    // the symbol for each column, the columns are the metric indexes
+    QVector<QString> symbol(metrics);
+    for (int i=0; i<factory.metricCount(); i++) {
+        QString name = factory.metricName(i);
+        symbol[factory.rideMetric(name)->index()] = name;
+    }
+    foreach(QString name, symbol) RideDBBinaryWriter::add(symbols, writer.string(name));
+    if (symbols.size() % 8) RideDBBinaryWriter::add(symbols, quint32(0)); // keep the doubles aligned
+
+    foreach(RideItem *item, rides) {
+
+        RideDBBinaryRide ride;
+        memset(&ride, 0, sizeof(ride));
+        ride.date = item->dateTime.toMSecsSinceEpoch();
+        ride.fingerprint = item->fingerprint;
+        ride.crc = item->crc;
+        ride.fileSize = item->fileSize;
+        ride.fileModified = item->fileModified;
+        ride.metacrc = item->metacrc;
+        ride.timestamp = item->timestamp;
+        ride.weight = item->weight;
+        ride.dbversion = item->dbversion;
+        ride.udbversion = item->udbversion;
+        ride.zoneRange = item->zoneRange;
+        ride.hrZoneRange = item->hrZoneRange;
+        ride.paceZoneRange = item->paceZoneRange;
+        ride.color = item->color.rgba();
+        ride.flags = (item->isRun ? isRunFlag : 0) | (item->isSwim ? isSwimFlag : 0) | (item->samples ? samplesFlag : 0);
+        if (item->configprints.count() == RideMetric::ConfigInputCount) {
+            for (int i=0; i<RideMetric::ConfigInputCount; i++) ride.configprints[i] = item->configprints[i];
+            ride.flags |= configprintsFlag;
+        }
+        ride.fileName = writer.string(item->fileName);
+        ride.present = writer.string(item->present);
+        ride.overrides = writer.string(item->overrides_.join(","));
+        ride.extra = writer.extra.size();
+
+        // the metrics block, values then counts
+        for (int i=0; i<metrics; i++) RideDBBinaryWriter::add(values, i < item->metrics().count() ? item->metrics()[i] : 0.0);
+        for (int i=0; i<metrics; i++) RideDBBinaryWriter::add(values, i < item->counts().count() ? item->counts()[i] : 0.0);
+
+        writer.stdmeans(item->stdmeans(), item->stdvariances());
+
+        // metadata
+        writer.u32(item->metadata().count());
+        QMap<QString,QString>::const_iterator m = item->metadata().constBegin();
+        for (; m != item->metadata().constEnd(); ++m) {
+            writer.str(m.key());
+            writer.str(m.value());
+        }
+
+        // xdata definitions
+        writer.u32(item->xdata().count());
+        QMap<QString,QStringList>::const_iterator x = item->xdata().constBegin();
+        for (; x != item->xdata().constEnd(); ++x) {
+            writer.str(x.key());
+            writer.u32(x.value().count());
+            foreach(QString series, x.value()) writer.str(series);
+        }
+
+        // intervals, only the non-zero metrics
+        writer.u32(item->intervals().count());
+        foreach(IntervalItem *interval, item->intervals()) {
+            writer.str(interval->name);
+            writer.f64(interval->start);
+            writer.f64(interval->stop);
+            writer.f64(interval->startKM);
+            writer.f64(interval->stopKM);
+            writer.u32(static_cast<int>(interval->type));
+            writer.u32(interval->color.rgba());
+            writer.u32(interval->displaySequence);
+            writer.str(interval->type == RideFileInterval::ROUTE ? interval->route.toString() : QString());
+
+            int nonzero = 0;
+            for (int i=0; i<interval->metrics().count(); i++) if (interval->metrics()[i]) nonzero++;
+            writer.u32(nonzero);
+            for (int i=0; i<interval->metrics().count(); i++) {
+                if (interval->metrics()[i] == 0) continue;
+                writer.u32(i);
+                writer.f64(interval->metrics()[i]);
+                writer.f64(i < interval->counts().count() ? interval->counts()[i] : 0.0);
+            }
+            writer.stdmeans(interval->stdmeans(), interval->stdvariances());
+        }
+
+        ride.extraSize = writer.extra.size() - ride.extra;
+        RideDBBinaryWriter::add(records, ride);
+    }
+
+    RideDBBinaryHeader head;
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, "GCDB", 4);
+    head.layout = binaryVersion;
+    strncpy(head.ridedb, RIDEDB_VERSION, sizeof(head.ridedb));
+    head.metrics = metrics;
+    head.rides = rides.count();
+    head.symbols = sizeof(head);
+    head.records = head.symbols + symbols.size();
+    head.values = head.records + records.size();
+    head.extra = head.values + values.size();
+    head.strings = head.extra + writer.extra.size();
+    head.size = head.strings + writer.strings.size();
+    head.generation = generation;
+
+    QByteArray returning;
+    returning.reserve(head.size);
+    RideDBBinaryWriter::add(returning, head);
+    returning.append(symbols);
+    returning.append(records);
+    returning.append(values);
+    returning.append(writer.extra);
+    returning.append(writer.strings);
+    return returning;
+}
+
+//
+// READING
+//
+class RideDBBinaryReader
+{
+    public:
+        RideDBBinaryReader(const uchar *strings, quint64 size) : strings(strings), size(size), p(NULL), e(NULL), ok(true) {}
+
+        // strings are shared between the items that use them
+        QString string(quint32 offset) {
+            if (offset == 0) return QString();
+            QHash<quint32, QString>::const_iterator it = loaded.constFind(offset);
+            if (it != loaded.constEnd()) return it.value();
+
+            quint32 length;
+            if (quint64(offset) + sizeof(length) > size) { ok = false; return QString(); }
+            memcpy(&length, strings + offset, sizeof(length));
+            if (quint64(offset) + sizeof(length) + quint64(length) * sizeof(QChar) > size) { ok = false; return QString(); }
+
+            QString returning(reinterpret_cast<const QChar*>(strings + offset + sizeof(length)), length);
+            loaded.insert(offset, returning);
+            return returning;
+        }
+
+        // the extra data for a ride
+        void setExtra(const uchar *from, const uchar *to) { p = from; e = to; }
+
+        quint32 u32() { quint32 v = 0; get(&v, sizeof(v)); return v; }
+        double f64() { double v = 0; get(&v, sizeof(v)); return v; }
+        QString str() { return string(u32()); }
+
+        void stdmeans(QMap<int,double> &means, QMap<int,double> &variances, const QVector<int> &index) {
+            means.clear();
+            variances.clear();
+            quint32 count = u32();
+            for (quint32 i=0; i<count && ok; i++) {
+                quint32 column = u32();
+                double mean = f64(), variance = f64();
+                if (column < quint32(index.count()) && index[column] >= 0) {
+                    means.insert(index[column], mean);
+                    variances.insert(index[column], variance);
+                }
+            }
+        }
+
+        const uchar *strings;
+        quint64 size;
+        const uchar *p, *e;
+        bool ok;
+
+    private:
+        void get(void *into, size_t bytes) {
+            if (!ok || bytes > size_t(e - p)) { ok = false; return; }
+            memcpy(into, p, bytes);
+            p += bytes;
+        }
+
+        QHash<quint32, QString> loaded;
+};
+
+// check it is one of ours, and all there
+static bool check(const uchar *data, quint64 size, RideDBBinaryHeader &head)
+{
+    if (size < sizeof(head)) return false;
+    memcpy(&head, data, sizeof(head));
+
+    char ridedb[sizeof(head.ridedb)];
+    memset(ridedb, 0, sizeof(ridedb));
+    strncpy(ridedb, RIDEDB_VERSION, sizeof(ridedb));
+
+    return !memcmp(head.magic, "GCDB", 4) && head.layout == binaryVersion && !memcmp(head.ridedb, ridedb, sizeof(ridedb)) &&
+           head.size == size && head.symbols == sizeof(head) &&
+           head.records == head.symbols + (quint64(head.metrics) * sizeof(quint32) + 7) / 8 * 8 &&
+           head.values == head.records + quint64(head.rides) * sizeof(RideDBBinaryRide) &&
+           head.extra == head.values + quint64(head.rides) * head.metrics * 2 * sizeof(double) &&
+           head.strings >= head.extra && head.strings <= size;
+}
+
+// copy the rides in an image to the items with the same filename, if
+// created is passed any not in items are created and added to both.
+// context is passed to show progress as the rides are loaded
+static bool apply(const uchar *data, quint64 size, QHash<QString, RideItem*> &items,
+                  QList<RideItem*> *created = NULL, Context *context = NULL)
+{
+    RideDBBinaryHeader head;
+    if (!check(data, size, head)) return false;
+
+    RideDBBinaryReader reader(data + head.strings, size - head.strings);
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+
+    // match the columns to the metrics we have now
+    QVector<int> index(head.metrics);
+    bool same = int(head.metrics) == factory.metricCount();
+    for (quint32 i=0; i<head.metrics; i++) {
+        quint32 offset;
+        memcpy(&offset, data + head.symbols + i * sizeof(quint32), sizeof(offset));
+        const RideMetric *m = factory.rideMetric(reader.string(offset));
+        index[i] = m ? m->index() : -1;
+        if (index[i] != int(i)) same = false;
+    }
+
+    QString percent;
+    for (quint32 r=0; r<head.rides && reader.ok; r++) {
+
+        RideDBBinaryRide ride;
+        memcpy(&ride, data + head.records + r * sizeof(ride), sizeof(ride));
+
+        QString fileName = reader.string(ride.fileName);
+        RideItem *item = items.value(fileName, NULL);
+        if (item == NULL && created) {
+            item = new RideItem();
+            item->fileName = fileName;
+            items.insert(fileName, item);
+            *created << item;
+        }
+        if (item == NULL) {
+            qDebug()<<"unable to load:"<<fileName<<QDateTime::fromMSecsSinceEpoch(ride.date)<<ride.weight;
+            continue;
+        }
+
+        // progress update
+        if (context && context->mainWindow->progress) {
+            QString m = QString("%1%").arg(double(context->mainWindow->loading++) / double(items.count()) * 100.0f, 0, 'f', 0);
+            if (m != percent) {
+                context->mainWindow->progress->setText(percent = m);
+                QApplication::processEvents();
+            }
+        }
+
+        // straight into the item, as setFrom() would for a json item
+        item->isdirty = item->isstale = item->isedit = item->unsaved = false;
+        item->staleconfig = 0;
+        item->dateTime = QDateTime::fromMSecsSinceEpoch(ride.date);
+        item->fingerprint = ride.fingerprint;
+        item->crc = ride.crc;
+        item->fileSize = ride.fileSize;
+        item->fileModified = ride.fileModified;
+        item->metacrc = ride.metacrc;
+        item->timestamp = ride.timestamp;
+        item->weight = ride.weight;
+        item->dbversion = ride.dbversion;
+        item->udbversion = ride.udbversion;
+        item->zoneRange = ride.zoneRange;
+        item->hrZoneRange = ride.hrZoneRange;
+        item->paceZoneRange = ride.paceZoneRange;
+        item->color = QColor::fromRgba(ride.color);
+        item->isRun = ride.flags & isRunFlag;
+        item->isSwim = ride.flags & isSwimFlag;
+        item->samples = ride.flags & samplesFlag;
+        item->configprints.clear();
+        if (ride.flags & configprintsFlag)
+            for (int i=0; i<RideMetric::ConfigInputCount; i++) item->configprints << ride.configprints[i];
+        item->present = reader.string(ride.present);
+        QString overrides = reader.string(ride.overrides);
+        item->overrides_ = overrides.isEmpty() ? QStringList() : overrides.split(",");
+
+        // the metrics block
+        const uchar *values = data + head.values + quint64(r) * head.metrics * 2 * sizeof(double);
+        const uchar *counts = values + head.metrics * sizeof(double);
+        if (same) {
+            memcpy(item->metrics().data(), values, head.metrics * sizeof(double));
+            memcpy(item->counts().data(), counts, head.metrics * sizeof(double));
+        } else {
+            item->metrics().fill(0.0f);
+            item->counts().fill(0.0f);
+            for (quint32 i=0; i<head.metrics; i++) {
+                if (index[i] < 0) continue;
+                memcpy(&item->metrics()[index[i]], values + i * sizeof(double), sizeof(double));
+                memcpy(&item->counts()[index[i]], counts + i * sizeof(double), sizeof(double));
+            }
+        }
+        item->metricsChanged();
+
+        if (quint64(ride.extra) + ride.extraSize > head.strings - head.extra) { reader.ok = false; item->isstale = true; break; }
+        reader.setExtra(data + head.extra + ride.extra, data + head.extra + ride.extra + ride.extraSize);
+
+        reader.stdmeans(item->stdmeans(), item->stdvariances(), index);
+
+        item->metadata().clear();
+        quint32 count = reader.u32();
+        for (quint32 i=0; i<count && reader.ok; i++) {
+            QString key = reader.str();
+            item->metadata().insert(key, reader.str());
+        }
+
+        item->xdata().clear();
+        count = reader.u32();
+        for (quint32 i=0; i<count && reader.ok; i++) {
+            QString name = reader.str();
+            QStringList series;
+            quint32 n = reader.u32();
+            for (quint32 j=0; j<n && reader.ok; j++) series << reader.str();
+            item->xdata().insert(name, series);
+        }
+
+        // replaces any from rideDB.bin or an earlier journal record
+        qDeleteAll(item->intervals());
+        item->clearIntervals();
+        count = reader.u32();
+        for (quint32 i=0; i<count && reader.ok; i++) {
+            IntervalItem interval;
+            interval.name = reader.str();
+            interval.start = reader.f64();
+            interval.stop = reader.f64();
+            interval.startKM = reader.f64();
+            interval.stopKM = reader.f64();
+            interval.type = static_cast<RideFileInterval::intervaltype>(reader.u32());
+            interval.color = QColor::fromRgba(reader.u32());
+            interval.displaySequence = reader.u32();
+            QString route = reader.str();
+            if (!route.isEmpty()) interval.route = QUuid(route);
+
+            quint32 n = reader.u32();
+            for (quint32 j=0; j<n && reader.ok; j++) {
+                quint32 column = reader.u32();
+                double value = reader.f64(), count = reader.f64();
+                if (column < head.metrics && index[column] >= 0) {
+                    interval.metrics()[index[column]] = value;
+                    interval.counts()[index[column]] = count;
+                }
+            }
+            reader.stdmeans(interval.stdmeans(), interval.stdvariances(), index);
+            item->addInterval(interval);
+        }
+
+        // refresh it if it wasn't all there
+        if (!reader.ok) item->isstale = true;
+    }
+
+    // anything we couldn't read will be refreshed
+    if (!reader.ok) qDebug()<<"rideDB image is damaged, activities not loaded will be refreshed";
+    return true;
+}
+
+// write to a temporary file and move it into place, so
+// a crash part way through leaves the old one intact
+static bool replace(QString name, const QByteArray &data)
+{
+    QFile file(name + ".tmp");
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) return false;
+    bool ok = file.write(data) == data.size() && file.flush();
+    file.close();
+
+    if (!ok) {
+        file.remove();
+        return false;
+    }
+    QFile::remove(name);
+    return file.rename(name);
+}
+
+//
+// RIDEDB
+//
+RideDBBinary::RideDBBinary(Context *context, RideCache *cache) :
+    context(context), cache(cache), current(false), generation(0), journalSize(0)
+{
+}
+
+RideDBBinary::~RideDBBinary()
+{
+    compaction.waitForFinished();
+}
+
+QString
+RideDBBinary::fileName(QString name)
+{
+    return QString("%1/%2").arg(context->athlete->home->cache().canonicalPath()).arg(name);
+}
+
+bool
+RideDBBinary::load()
+{
+    QFile file(fileName("rideDB.bin"));
+    if (!file.exists() || !file.open(QFile::ReadOnly)) return false;
+
+    uchar *data = file.map(0, file.size());
+    if (data == NULL) return false;
+
+    // an older version may have written the json since we wrote it
+    RideDBBinaryHeader head;
+    QFileInfo json(fileName("rideDB.json"));
+    if (!check(data, file.size(), head) || (json.exists() && (quint64(json.size()) != head.json ||
+        json.lastModified().toMSecsSinceEpoch() != head.jsonModified))) {
+        file.unmap(data);
+        return false;
+    }
+
+    // rides by filename, rather than searching for each
+    QHash<QString, RideItem*> items;
+    foreach(RideItem *item, cache->rides())
+        if (!items.contains(item->fileName)) items.insert(item->fileName, item);
+
+    apply(data, file.size(), items, NULL, context);
+    file.unmap(data);
+    file.close();
+
+    // then the changes since, a journal left by a compaction
+    // that didn't finish comes first
+    generation = head.generation;
+    bool damaged = false;
+    bool interrupted = replay(fileName("rideDB.journal.old"), items, damaged);
+    bool journaled = replay(fileName("rideDB.journal"), items, damaged);
+
+    // carry on with the journal, unless it isn't for this rideDB.bin,
+    // its end was lost so anything appended would be too, or a
+    // compaction was interrupted, then the first save will compact
+    current = !interrupted && !damaged && (journaled || !QFile::exists(fileName("rideDB.journal")));
+    journalSize = current ? QFileInfo(fileName("rideDB.journal")).size() : 0;
+    return true;
+}
+
+bool
+RideDBBinary::replay(QString name, QHash<QString, RideItem*> &items, bool &damaged)
+{
+    RideDBJournal journal(name);
+    if (!journal.open(generation)) return false;
+
+    // each record in turn, the journal stops at one that was only partly written
+    const uchar *record;
+    quint32 length;
+    bool ok = true;
+    while (ok && journal.next(record, length)) ok = apply(record, length, items);
+
+    if (!ok || journal.damaged()) damaged = true;
+    return true;
+}
+
+void
+RideDBBinary::save(bool json)
+{
+    // no rideDB.bin to journal against
+    if (!current) {
+        compact();
+        return;
+    }
+
+    QList<RideItem*> changed;
+    foreach(RideItem *item, cache->rides())
+        if (item->unsaved && saveable(item)) changed << item;
+
+    // the json is up to date unless something was journaled since
+    // it was written, these would be too
+    if (json && (journalSize > 0 || !changed.isEmpty())) {
+        compact();
+        return;
+    }
+    if (changed.isEmpty()) return;
+
+    QByteArray record = image(changed, generation);
+
+    // time to compact, these will be in it
+    if (journalSize + record.size() > journalLimit) {
+        compact();
+        return;
+    }
+
+    RideDBJournal journal(fileName("rideDB.journal"));
+    bool ok = journal.append(generation, record);
+    journalSize = journal.size();
+
+    // if it didn't go the next save will compact
+    if (!ok) {
+        current = false;
+        return;
+    }
+    foreach(RideItem *item, changed) item->unsaved = false;
+}
+
+void
+RideDBBinary::compact()
+{
+    // one at a time
+    compaction.waitForFinished();
+
+    QList<RideItem*> rides;
+    foreach(RideItem *item, cache->rides()) {
+        if (saveable(item)) rides << item;
+        item->unsaved = false;
+    }
+
+    // the journal so far will be in the new rideDB.bin, but keep it
+    // until that has been written in case we don't get that far
+    generation = qMax(generation + 1, quint64(QDateTime::currentMSecsSinceEpoch()));
+    QFile::remove(fileName("rideDB.journal.old"));
+    QFile::rename(fileName("rideDB.journal"), fileName("rideDB.journal.old"));
+    journalSize = 0;
+    current = true;
+
+    // the items can only be read here, the rest is done in the background
+    compaction = QtConcurrent::run(write, context->athlete->home->cache().canonicalPath(), image(rides, generation));
+}
+
+void
+RideDBBinary::write(QString cache, QByteArray image)
+{
+    // the json is made from the image, so we don't
+    // need to look at the items on this thread
+    QHash<QString, RideItem*> items;
+    QList<RideItem*> rides;
+    apply(reinterpret_cast<const uchar*>(image.constData()), image.size(), items, &rides);
+
+    QBuffer json;
+    json.open(QIODevice::WriteOnly);
+    RideCache::saveJSON(json, rides);
+    json.close();
+
+    foreach(RideItem *item, rides) {
+        qDeleteAll(item->intervals());
+        delete item;
+    }
+
+    // the json first, the rideDB.bin written with it records its size
+    if (!replace(cache + "/rideDB.json", json.data())) return;
+
+    RideDBBinaryHeader head;
+    memcpy(&head, image.constData(), sizeof(head));
+    QFileInfo written(cache + "/rideDB.json");
+    head.json = written.size();
+    head.jsonModified = written.lastModified().toMSecsSinceEpoch();
+    image.replace(0, sizeof(head), reinterpret_cast<const char*>(&head), sizeof(head));
+    if (!replace(cache + "/rideDB.bin", image)) return;
+
+    // and the journal it replaces
+    QFile::remove(cache + "/rideDB.journal.old");
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideDBBinary_h
+#define _GC_RideDBBinary_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+
+class Context;
+class RideCache;
+class RideItem;
+
+//
+// cache/rideDB.json is parsed at startup to restore the metrics,
+// metadata and intervals of every activity, and with a few thousand
+// activities that is most of the time taken to open an athlete. So the
+// same data is saved in cache/rideDB.bin too, laid out so the file can
+// be mapped into memory and copied straight into the RideItems:
+//
+//   header
+//   symbols   the metric symbol for each column, so the columns can be
+//             matched to the metrics we have if they have changed
+//   rides     a fixed size record for each activity
+//   metrics   a fixed size block for each activity, the value of every
+//             column followed by the count of every column, as doubles
+//   extra     the variable length data for each activity; the std means
+//             and variances, metadata, xdata and intervals
+//   strings   every string used, each stored once as UTF-16
+//
+// Rewriting all of that when one activity changed is wasteful, so once
+// it has been written the activities that change are appended to
+// cache/rideDB.journal instead, each save adding a record laid out as
+// above holding just the activities that changed. The records are
+// applied in turn after rideDB.bin when loading, a record that was only
+// partly written is ignored along with anything after it.
+//
+// When the journal gets too big it is compacted; rideDB.bin and the
+// JSON are written afresh in the background and the journal emptied.
+// Each compaction has a new generation number, held in rideDB.bin and
+// the journal, so a journal that has already been compacted into
+// rideDB.bin is not applied again.
+//
+// The JSON is written when compacting, for the API and for older
+// versions, so a save at exit or after a sync compacts if anything has
+// been journaled since. It is read instead if rideDB.bin is missing or
+// broken, is for a different RIDEDB_VERSION, or the JSON is not the one
+// written along with it (its size or time differ).
+//
+class RideDBBinary
+{
+    public:
+        RideDBBinary(Context *context, RideCache *cache);
+        ~RideDBBinary(); // waits for any compaction to finish
+
+        // returns false if the JSON should be read instead
+        bool load();
+
+        // journal the activities changed since they were last saved,
+        // or compact if there is nothing to journal against or the
+        // json is wanted and is behind
+        void save(bool json);
+
+        // write everything afresh and empty the journal
+        void compact();
+
+    private:
+        QString fileName(QString name);
+
+        // returns false if there is no journal for this rideDB.bin,
+        // damaged is set if any of it couldn't be read
+        bool replay(QString name, QHash<QString, RideItem*> &items, bool &damaged);
+
+        // in the background, from an image of all the activities
+        static void write(QString cache, QByteArray image);
+
+        Context *context;
+        RideCache *cache;
+
+        bool current;       // rideDB.bin and the journal are up to date
+        quint64 generation; // of rideDB.bin and the journal
+        qint64 journalSize;
+        QFuture<void> compaction;
+};
+
+#endif // _GC_RideDBBinary_h
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideDBJournal.h"
+
+#include <QFileInfo>
+#include <string.h>
+
+// bump when the framing changes
+static const quint32 journalVersion = 5;
+
+struct RideDBJournalHeader {
+    char magic[4];          // "GCJN"
+    quint32 layout;         // journalVersion
+    quint64 generation;     // of the rideDB.bin it follows
+};
+
+// CRC-32 (as zlib), qChecksum is only 16 bits so would miss
+// one in 65536 damaged records, and records can be large
+class RideDBJournalCrc
+{
+    public:
+        RideDBJournalCrc() {
+            for (quint32 i=0; i<256; i++) {
+                quint32 c = i;
+                for (int k=0; k<8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[i] = c;
+            }
+        }
+        quint32 table[256];
+};
+
+// built before main, so never while journals are being read
+static const RideDBJournalCrc crc;
+
+static quint32 checksum(const char *data, quint32 length)
+{
+    quint32 c = 0xFFFFFFFFu;
+    const uchar *p = reinterpret_cast<const uchar*>(data);
+    for (quint32 i=0; i<length; i++) c = crc.table[(c ^ p[i]) & 0xff] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+RideDBJournal::RideDBJournal(QString name) : file(name), data(NULL), mapped(0), offset(0), broken(false)
+{
+}
+
+RideDBJournal::~RideDBJournal()
+{
+    close();
+}
+
+bool
+RideDBJournal::open(quint64 generation)
+{
+    close();
+    if (!file.exists() || !file.open(QFile::ReadOnly)) return false;
+
+    mapped = file.size();
+    data = mapped ? file.map(0, mapped) : NULL;
+    if (data == NULL) {
+        close();
+        return false;
+    }
+
+    // already compacted into rideDB.bin
+    RideDBJournalHeader head;
+    if (mapped < sizeof(head)) { close(); return false; }
+    memcpy(&head, data, sizeof(head));
+    if (memcmp(head.magic, "GCJN", 4) || head.layout != journalVersion || head.generation < generation) {
+        close();
+        return false;
+    }
+
+    offset = sizeof(head);
+    return true;
+}
+
+void
+RideDBJournal::close()
+{
+    if (data) file.unmap(data);
+    file.close();
+    data = NULL;
+}
+
+bool
+RideDBJournal::next(const uchar *&record, quint32 &length)
+{
+    if (data == NULL || broken || offset == mapped) return false;
+
+    // stop at one that was only partly written
+    quint32 sum;
+    broken = true;
+    if (offset + 2 * sizeof(quint32) > mapped) return false;
+    memcpy(&length, data + offset, sizeof(length));
+    memcpy(&sum, data + offset + sizeof(length), sizeof(sum));
+    if (offset + 2 * sizeof(quint32) + length > mapped) return false;
+
+    record = data + offset + 2 * sizeof(quint32);
+    if (checksum(reinterpret_cast<const char*>(record), length) != sum) return false;
+
+    broken = false;
+    offset += 2 * sizeof(quint32) + length;
+    return true;
+}
+
+bool
+RideDBJournal::damaged() const
+{
+    return broken;
+}
+
+bool
+RideDBJournal::append(quint64 generation, const QByteArray &record)
+{
+    close();
+    if (!file.open(QFile::WriteOnly | QFile::Append)) return false;
+
+    // a new journal
+    bool ok = true;
+    if (file.size() == 0) {
+        RideDBJournalHeader head;
+        memset(&head, 0, sizeof(head));
+        memcpy(head.magic, "GCJN", 4);
+        head.layout = journalVersion;
+        head.generation = generation;
+        ok = file.write(reinterpret_cast<const char*>(&head), sizeof(head)) == sizeof(head);
+    }
+
+    quint32 prefix[2] = { quint32(record.size()), checksum(record.constData(), record.size()) };
+    ok = ok && file.write(reinterpret_cast<const char*>(prefix), sizeof(prefix)) == sizeof(prefix) &&
+         file.write(record) == record.size() && file.flush();
+    file.close();
+    return ok;
+}
+
+qint64
+RideDBJournal::size() const
+{
+    return QFileInfo(file.fileName()).size();
+}
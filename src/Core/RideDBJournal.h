@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideDBJournal_h
+#define _GC_RideDBJournal_h 1
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+
+//
+// The framing of cache/rideDB.journal, see RideDBBinary.h. The journal
+// starts with a header naming the generation of the rideDB.bin it
+// follows, then each record is a quint32 length and checksum followed
+// by the record itself, appended as activities are saved.
+//
+// A record that was only partly written, e.g. because we crashed, ends
+// the journal; it and anything after it are not read, and damaged()
+// says so, so the journal can be compacted rather than appended to.
+//
+class RideDBJournal
+{
+    public:
+        RideDBJournal(QString name);
+        ~RideDBJournal(); // closes
+
+        // map it to read, false if there isn't one or it
+        // is for an older rideDB.bin, so already compacted
+        bool open(quint64 generation);
+        void close();
+
+        // the next whole record, false when there are no more
+        bool next(const uchar *&record, quint32 &length);
+
+        // after reading to the end, were there bytes we couldn't use ?
+        bool damaged() const;
+
+        // add a record, starting the journal if there isn't one,
+        // false if it wasn't all written
+        bool append(quint64 generation, const QByteArray &record);
+
+        qint64 size() const; // on disk
+
+    private:
+        QFile file;
+        uchar *data;
+        quint64 mapped, offset;
+        bool broken;
+};
+
+#endif // _GC_RideDBJournal_h
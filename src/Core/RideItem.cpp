@@ -17,13 +17,16 @@
  */
 
 #include "RideItem.h"
+#include "RideCache.h"
 #include "RideMetric.h"
+#include "RideMetricSweep.h"
 #include "RideFile.h"
 #include "RideFileCache.h"
 #include "RideMetadata.h"
 #include "IntervalItem.h"
 #include "Route.h"
 #include "Context.h"
+#include "Athlete.h"
 #include "Zones.h"
 #include "HrZones.h"
 #include "PaceZones.h"
@@ -38,22 +41,24 @@
 #include <QMap>
 #include <QMapIterator>
 #include <QByteArray>
+#include <QAtomicInt>
+#include <QThreadStorage>
 
 // used to create a temporary ride item that is not in the cache and just
 // used to enable using the same calling semantics in things like the
 // merge wizard and interval navigator
 RideItem::RideItem() 
     : 
-    ride_(NULL), fileCache_(NULL), context(NULL), isdirty(false), isstale(true), isedit(false), skipsave(false), path(""), fileName(""),
-    color(QColor(1,1,1)), isRun(false), isSwim(false), samples(false), zoneRange(-1), hrZoneRange(-1), paceZoneRange(-1), fingerprint(0), metacrc(0), crc(0), timestamp(0), dbversion(0), udbversion(0), weight(0) {
+    ride_(NULL), fileCache_(NULL), metricIndex_(NULL), metricsRevision_(0), context(NULL), isdirty(false), isstale(true), staleconfig(0), isedit(false), skipsave(false), unsaved(false), path(""), fileName(""),
+    color(QColor(1,1,1)), isRun(false), isSwim(false), samples(false), zoneRange(-1), hrZoneRange(-1), paceZoneRange(-1), fingerprint(0), metacrc(0), crc(0), fileSize(0), fileModified(0), timestamp(0), dbversion(0), udbversion(0), weight(0) {
     metrics_.fill(0, RideMetricFactory::instance().metricCount());
     count_.fill(0, RideMetricFactory::instance().metricCount());
 }
 
 RideItem::RideItem(RideFile *ride, Context *context) 
     : 
-    ride_(ride), fileCache_(NULL), context(context), isdirty(false), isstale(true), isedit(false), skipsave(false), path(""), fileName(""),
-    color(QColor(1,1,1)), isRun(false), isSwim(false), samples(false), zoneRange(-1), hrZoneRange(-1), paceZoneRange(-1), fingerprint(0), metacrc(0), crc(0), timestamp(0), dbversion(0), udbversion(0), weight(0) 
+    ride_(ride), fileCache_(NULL), metricIndex_(NULL), metricsRevision_(0), context(context), isdirty(false), isstale(true), staleconfig(0), isedit(false), skipsave(false), unsaved(false), path(""), fileName(""),
+    color(QColor(1,1,1)), isRun(false), isSwim(false), samples(false), zoneRange(-1), hrZoneRange(-1), paceZoneRange(-1), fingerprint(0), metacrc(0), crc(0), fileSize(0), fileModified(0), timestamp(0), dbversion(0), udbversion(0), weight(0) 
 {
     metrics_.fill(0, RideMetricFactory::instance().metricCount());
     count_.fill(0, RideMetricFactory::instance().metricCount());
@@ -61,9 +66,9 @@ RideItem::RideItem(RideFile *ride, Context *context)
 
 RideItem::RideItem(QString path, QString fileName, QDateTime &dateTime, Context *context, bool planned)
     :
-    ride_(NULL), fileCache_(NULL), context(context), isdirty(false), isstale(true), isedit(false), skipsave(false), path(path), fileName(fileName),
+    ride_(NULL), fileCache_(NULL), metricIndex_(NULL), metricsRevision_(0), context(context), isdirty(false), isstale(true), staleconfig(0), isedit(false), skipsave(false), unsaved(false), path(path), fileName(fileName),
     dateTime(dateTime), color(QColor(1,1,1)), planned(planned), isRun(false), isSwim(false), samples(false), zoneRange(-1), hrZoneRange(-1), paceZoneRange(-1), fingerprint(0),
-    metacrc(0), crc(0), timestamp(0), dbversion(0), udbversion(0), weight(0) 
+    metacrc(0), crc(0), fileSize(0), fileModified(0), timestamp(0), dbversion(0), udbversion(0), weight(0) 
 {
     metrics_.fill(0, RideMetricFactory::instance().metricCount());
     count_.fill(0, RideMetricFactory::instance().metricCount());
@@ -73,8 +78,8 @@ RideItem::RideItem(QString path, QString fileName, QDateTime &dateTime, Context
 // pre-computed metrics and storing ride metadata
 RideItem::RideItem(RideFile *ride, QDateTime &dateTime, Context *context)
     :
-    ride_(ride), fileCache_(NULL), context(context), isdirty(true), isstale(true), isedit(false), skipsave(false), dateTime(dateTime),
-    zoneRange(-1), hrZoneRange(-1), paceZoneRange(-1), fingerprint(0), metacrc(0), crc(0), timestamp(0), dbversion(0), udbversion(0), weight(0)
+    ride_(ride), fileCache_(NULL), metricIndex_(NULL), metricsRevision_(0), context(context), isdirty(true), isstale(true), staleconfig(0), isedit(false), skipsave(false), unsaved(false), dateTime(dateTime),
+    zoneRange(-1), hrZoneRange(-1), paceZoneRange(-1), fingerprint(0), metacrc(0), crc(0), fileSize(0), fileModified(0), timestamp(0), dbversion(0), udbversion(0), weight(0)
 {
     metrics_.fill(0, RideMetricFactory::instance().metricCount());
     count_.fill(0, RideMetricFactory::instance().metricCount());
@@ -86,6 +91,7 @@ RideItem::setFrom(RideItem&here, bool temp) // used when loading cache/rideDB.js
 {
     ride_ = NULL;
     fileCache_ = NULL;
+    metricIndex_ = NULL;
     metrics_ = here.metrics_;
     count_ = here.count_;
     stdmean_ = here.stdmean_;
@@ -102,6 +108,7 @@ RideItem::setFrom(RideItem&here, bool temp) // used when loading cache/rideDB.js
 	context = here.context;
 	isdirty = here.isdirty;
     isstale = here.isstale;
+    staleconfig = here.staleconfig;
 	isedit = here.isedit;
 	skipsave = here.skipsave;
     if (planned == false)
@@ -112,8 +119,11 @@ RideItem::setFrom(RideItem&here, bool temp) // used when loading cache/rideDB.js
     hrZoneRange = here.hrZoneRange;
     paceZoneRange = here.paceZoneRange;
 	fingerprint = here.fingerprint;
+    configprints = here.configprints;
 	metacrc = here.metacrc;
     crc = here.crc;
+    fileSize = here.fileSize;
+    fileModified = here.fileModified;
 	timestamp = here.timestamp;
 	dbversion = here.dbversion;
 	udbversion = here.udbversion;
@@ -124,6 +134,7 @@ RideItem::setFrom(RideItem&here, bool temp) // used when loading cache/rideDB.js
 	weight = here.weight;
 	overrides_ = here.overrides_;
     samples = here.samples;
+    metricsChanged();
 }
 
 // set the metric array
@@ -142,6 +153,29 @@ RideItem::setFrom(QHash<QString, RideMetricPtr> computed)
             stdvariance_.insert(i.value()->index(), stdvariance);
         }
     }
+    metricsChanged();
+}
+
+// unique across all rides
+static QAtomicInt metricsRevisionCount;
+
+void
+RideItem::metricsChanged()
+{
+    metricsRevision_ = metricsRevisionCount.fetchAndAddOrdered(1) + 1;
+}
+
+int
+RideItem::metricsRevisions()
+{
+    return metricsRevisionCount.fetchAndAddOrdered(0);
+}
+
+void
+RideItem::clearPeaks()
+{
+    QMutexLocker locker(&peakLock);
+    peakCache.clear();
 }
 
 // calculate metadata crc
@@ -164,8 +198,18 @@ RideItem::metaCRC()
     return qChecksum(ba, ba.length());
 }
 
+// a ride refresh() opened with just the series it needs, it is only
+// handed to the metrics and intervals it computes on the same thread
+struct RideItemRefresh {
+    RideItemRefresh() : item(NULL), ride(NULL) {}
+    const RideItem *item;
+    RideFile *ride;
+};
+static QThreadStorage<RideItemRefresh*> refreshing;
+
 RideFile *RideItem::ride(bool open)
 {
+    if (refreshing.hasLocalData() && refreshing.localData()->item == this) return refreshing.localData()->ride;
     if (!open || ride_) return ride_;
 
     // open the ride file
@@ -173,6 +217,9 @@ RideFile *RideItem::ride(bool open)
     ride_ = RideFileFactory::instance().openRideFile(context, file, errors_);
     if (ride_ == NULL) return NULL; // failed to read ride
 
+    // charts and editors work with the data points directly
+    ride_->recalculateDerivedSeries();
+
     // update the overrides
     overrides_.clear();
     QMap<QString,QMap<QString, QString> >::const_iterator k;
@@ -236,18 +283,27 @@ RideItem::~RideItem()
     //qDebug()<<"deleting:"<<fileName;
     if (isOpen()) close();
     if (fileCache_) delete fileCache_;
+    if (metricIndex_) delete metricIndex_;
     //XXX need to consider what to do here for the intervalitem
     //XXX used by the RideDB parser - we don't want to wipe away
     //XXX the intervals we just passed into setFrom()
     //foreach(IntervalItem*x, intervals_) delete x;
 }
 
+RideMetricIndex *
+RideItem::metricIndex()
+{
+    QMutexLocker locker(&metricIndexLock);
+    if (metricIndex_ == NULL) metricIndex_ = new RideMetricIndex;
+    return metricIndex_;
+}
+
 RideFileCache *
 RideItem::fileCache()
 {
     if (!fileCache_) {
         fileCache_ = new RideFileCache(context, fileName, getWeight(), ride());
-        if (isDirty()) fileCache_->refresh(ride_); // refresh from what we have now !
+        if (isDirty()) fileCache_->refresh(ride(false)); // refresh from what we have now !
     }
     return fileCache_;
 }
@@ -343,14 +399,17 @@ void
 RideItem::notifyRideDataChanged()
 {
     // refresh the metrics
+    cancelRefresh();
     isstale=true;
+    staleconfig=0;
 
     // wipe user data
     userCache.clear();
+    clearPeaks();
 
     // force a recompute of derived data series
     if (ride_) {
-        ride_->wstale = true;
+        ride_->invalidateWprime();
         ride_->recalculateDerivedSeries(true);
     }
 
@@ -367,7 +426,9 @@ void
 RideItem::notifyRideMetadataChanged()
 {
     // refresh the metrics
+    cancelRefresh();
     isstale=true;
+    staleconfig=0;
     refresh();
 
     emit rideMetadataChanged();
@@ -382,8 +443,10 @@ RideItem::modified()
 void
 RideItem::saved()
 {
+    cancelRefresh();
     setDirty(false);
     isstale=true;
+    staleconfig=0;
     refresh(); // update !
     context->notifyRideSaved(this);
 }
@@ -391,8 +454,10 @@ RideItem::saved()
 void
 RideItem::reverted()
 {
+    cancelRefresh();
     setDirty(false);
     isstale=true;
+    staleconfig=0;
     refresh();
 }
 
@@ -413,12 +478,20 @@ RideItem::setDirty(bool val)
     }
 }
 
+void
+RideItem::cancelRefresh()
+{
+    if (context && context->athlete && context->athlete->rideCache)
+        context->athlete->rideCache->cancel(this);
+}
+
 // name gets changed when file is converted in save
 void
 RideItem::setFileName(QString path, QString fileName)
 {
     this->path = path;
     this->fileName = fileName;
+    unsaved = true;
 }
 
 bool
@@ -443,6 +516,12 @@ RideItem::close()
     	delete fileCache_;
 	fileCache_=NULL;
     }
+
+    // and the indexes of the samples
+    metricIndexLock.lock();
+    delete metricIndex_;
+    metricIndex_ = NULL;
+    metricIndexLock.unlock();
 }
 
 void
@@ -450,93 +529,217 @@ RideItem::setStartTime(QDateTime newDateTime)
 {
     dateTime = newDateTime;
     ride()->setStartTime(newDateTime);
+    unsaved = true;
+}
+
+// where a RideMetric::ConfigInput is kept in configprints
+static int configSlot(int input)
+{
+    int slot = 0;
+    while (input >>= 1) slot++;
+    return slot;
 }
 
 // check if we need to be refreshed
 bool
 RideItem::checkStale()
+{
+    RideItemStaleCheck check(context);
+    checkStale(check);
+    return checkFilesStale();
+}
+
+bool
+RideItem::checkStale(RideItemStaleCheck &check)
 {
     // if we're marked stale already then just return that !
-    if (isstale) return true;
+    if (isstale && staleconfig == 0) return true;
+
+    // stale for just some of the config so far, anything else that
+    // has changed since is added to it rather than being lost
+    int pending = isstale ? staleconfig : 0;
+    isstale = false;
 
     // just change it .. its as quick to change as it is to check !
-    color = context->athlete->colorEngine->colorFor(getText(context->athlete->rideMetadata()->getColorField(), ""));
+    QColor was = color;
+    color = context->athlete->colorEngine->colorFor(getText(check.colorField, ""));
+    if (color != was) unsaved = true;
 
     // upgraded metrics
+    int config = 0;
     if (udbversion != UserMetricSchemaVersion || dbversion != DBSchemaVersion) {
 
         isstale = true;
 
     } else {
 
-        // has weight changed?
+        // has weight, cp / zones, routes or hrv fingerprints changed ?
+        // note we now get the fingerprint from the zone range
+        // and not the entire config so that if you add a new
+        // range (e.g. set CP from today) but none of the other
+        // ranges change then there is no need to recompute the
+        // metrics for older rides !
         unsigned long prior  = 1000.0f * weight;
-        unsigned long now = 1000.0f * getWeight();
+        QVector<unsigned long> now = check.fingerprints(dateTime.date(), isRun, isSwim, getWeight(check));
 
-        if (prior != now) {
+        if (configprints.count() != now.count()) {
 
-            getWeight();
-            isstale = true;
+            // refreshed before they were kept for each input, so it
+            // is all or nothing, but they are the same from now on
+            if (prior != now[configSlot(RideMetric::WeightInput)] ||
+                fingerprint != check.fingerprint(dateTime.date(), isRun, isSwim)) {
+
+                isstale = true;
+
+            } else {
+
+                configprints = now;
+                unsaved = true;
+            }
 
         } else {
 
-            // or have cp / zones or routes fingerprints changed ?
-            // note we now get the fingerprint from the zone range
-            // and not the entire config so that if you add a new
-            // range (e.g. set CP from today) but none of the other
-            // ranges change then there is no need to recompute the
-            // metrics for older rides !
-            // HRV fingerprint added to detect changes on HRV Measures
-
-            // get the new zone configuration fingerprint that applies for the ride date
-            unsigned long rfingerprint = static_cast<unsigned long>(context->athlete->zones(isRun)->getFingerprint(dateTime.date()))
-                        + (appsettings->cvalue(context->athlete->cyclist, context->athlete->zones(isRun)->useCPforFTPSetting(), 0).toInt() ? 1 : 0)
-                        + static_cast<unsigned long>(context->athlete->paceZones(isSwim)->getFingerprint(dateTime.date()))
-                        + static_cast<unsigned long>(context->athlete->hrZones(isRun)->getFingerprint(dateTime.date()))
-                        + static_cast<unsigned long>(context->athlete->routes->getFingerprint())
-                        + static_cast<unsigned long>(getHrvFingerprint())
-                        + appsettings->cvalue(context->athlete->cyclist, GC_DISCOVERY, 57).toInt(); // 57 does not include search for PEAKS
-
-            if (fingerprint != rfingerprint) {
+            // just the metrics that read what changed are refreshed
+            for (int i=0; i<now.count(); i++)
+                if (configprints[i] != now[i]) config |= 1 << i;
 
-                isstale = true;
+            if (config) isstale = true;
+        }
 
-            } else {
+        // no intervals ?
+        if (!isstale && samples && intervals_.count() == 0)
+            isstale = true;
+    }
 
-                // or has file content changed ?
-                QString fullPath =  QString(context->athlete->home->activities().absolutePath()) + "/" + fileName;
-                QFile file(fullPath);
+    // we need to mark stale in case "special" fields may have changed (e.g. CP)
+    if (metacrc != metaCRC()) {
+        isstale = true;
+        config = 0;
+    }
 
-                // has timestamp changed ?
-                if (timestamp < QFileInfo(file).lastModified().toTime_t()) {
+    // all of it unless just the config changed
+    if (isstale && config) config |= pending;
+    else if (!isstale && pending) {
+        isstale = true;
+        config = pending;
+    }
+    staleconfig = config;
 
-                    // if timestamp has changed then check crc
-                    unsigned long fcrc = RideFile::computeFileCRC(fullPath);
+    return isstale;
+}
 
-                    if (crc == 0 || crc != fcrc) {
-                        crc = fcrc; // update as expensive to calculate
-                        isstale = true;
-                    }
-                }
+bool
+RideItem::checkFilesStale()
+{
+    // already know, no need to look, unless it's just the config
+    if (isstale && staleconfig == 0) return true;
 
+    // has file content changed ?
+    QString fullPath =  QString(context->athlete->home->activities().absolutePath()) + "/" + fileName;
 
-                // no intervals ?
-                if (samples && intervals_.count() == 0)
-                    isstale = true;
+    // the stat has changed since it was hashed, so check the hash
+    quint64 size;
+    qint64 modified;
+    if (!RideFile::statFile(fullPath, size, modified) || size != fileSize || modified != fileModified) {
 
-            }
+        quint64 hash = RideFile::computeFileHash(fullPath);
+        if (crc == 0 || crc != hash) {
+            isstale = true;
+            staleconfig = 0;
         }
-    }
 
-    // still reckon its clean? what about the cache ?
-    if (isstale == false) isstale = RideFileCache::checkStale(context, this);
+        // update as expensive to calculate
+        crc = hash;
+        fileSize = size;
+        fileModified = modified;
+        unsaved = true;
+    }
 
-    // we need to mark stale in case "special" fields may have changed (e.g. CP)
-    if (metacrc != metaCRC()) isstale = true;
+    // still reckon its clean? what about the cache ? it is brought up
+    // to date when refreshed for a change of weight anyway
+    if (!(staleconfig & RideMetric::WeightInput) && RideFileCache::checkStale(context, this)) {
+        isstale = true;
+        staleconfig = 0;
+    }
 
     return isstale;
 }
 
+RideItemStaleCheck::RideItemStaleCheck(Context *context) : context(context)
+{
+    colorField = context->athlete->rideMetadata()->getColorField();
+
+    // global options and if not set default to 75 kg, as getWeight()
+    weight = appsettings->cvalue(context->athlete->cyclist, GC_WEIGHT, "75.0").toString().toDouble();
+    if (weight <= 0.00) weight = 80.00;
+
+    routes = static_cast<unsigned long>(context->athlete->routes->getFingerprint());
+    discovery = appsettings->cvalue(context->athlete->cyclist, GC_DISCOVERY, 57).toInt(); // 57 does not include search for PEAKS
+    for (int run=0; run<2; run++)
+        cpforftp[run] = appsettings->cvalue(context->athlete->cyclist, context->athlete->zones(run)->useCPforFTPSetting(), 0).toInt() ? 1 : 0;
+
+    // the latest measure on each date, they are in date order
+    foreach(BodyMeasure x, context->athlete->bodyMeasures())
+        if (x.weightkg > 0) measures.insert(x.when.date(), x);
+    foreach(HrvMeasure x, context->athlete->hrvMeasures())
+        hrv.insert(x.when.date(), x.getFingerprint());
+    nohrv = HrvMeasure().getFingerprint();
+}
+
+unsigned long
+RideItemStaleCheck::fingerprint(QDate date, bool isRun, bool isSwim)
+{
+    // all but the weight, added up
+    unsigned long fingerprint = 0;
+    foreach(unsigned long print, fingerprints(date, isRun, isSwim, 0))
+        fingerprint += print;
+    return fingerprint;
+}
+
+QVector<unsigned long>
+RideItemStaleCheck::fingerprints(QDate date, bool isRun, bool isSwim, double weight)
+{
+    // the zone fingerprints only change with the range that applies
+    const Zones *power = context->athlete->zones(isRun);
+    const PaceZones *pace = context->athlete->paceZones(isSwim);
+    const HrZones *hr = context->athlete->hrZones(isRun);
+    QString ranges = QString("%1:%2:%3:%4:%5").arg(isRun).arg(isSwim).arg(power->whichRange(date))
+                                              .arg(pace->whichRange(date)).arg(hr->whichRange(date));
+
+    QHash<QString, QVector<unsigned long> >::const_iterator it = zones.constFind(ranges);
+    if (it == zones.constEnd()) {
+        QVector<unsigned long> prints(RideMetric::ConfigInputCount, 0);
+        prints[configSlot(RideMetric::PowerZonesInput)] = static_cast<unsigned long>(power->getFingerprint(date))
+                                                        + cpforftp[isRun ? 1 : 0];
+        prints[configSlot(RideMetric::PaceZonesInput)] = static_cast<unsigned long>(pace->getFingerprint(date));
+        prints[configSlot(RideMetric::HrZonesInput)] = static_cast<unsigned long>(hr->getFingerprint(date));
+        prints[configSlot(RideMetric::RoutesInput)] = routes;
+        prints[configSlot(RideMetric::DiscoveryInput)] = discovery;
+        it = zones.insert(ranges, prints);
+    }
+
+    QVector<unsigned long> prints = it.value();
+    prints[configSlot(RideMetric::HrvInput)] = static_cast<unsigned long>(hrvFingerprint(date));
+    prints[configSlot(RideMetric::WeightInput)] = 1000.0f * weight;
+    return prints;
+}
+
+void
+RideItemStaleCheck::bodyMeasure(QDate date, BodyMeasure &here)
+{
+    QMap<QDate, BodyMeasure>::const_iterator it = measures.upperBound(date);
+    if (it == measures.constBegin()) here = BodyMeasure();
+    else here = (--it).value();
+}
+
+unsigned short
+RideItemStaleCheck::hrvFingerprint(QDate date)
+{
+    QMap<QDate, unsigned short>::const_iterator it = hrv.upperBound(date);
+    if (it == hrv.constBegin()) return nohrv;
+    return (--it).value();
+}
+
 void
 RideItem::refresh()
 {
@@ -545,15 +748,63 @@ RideItem::refresh()
     // update current state coz we'll fix it below
     isstale = false;
 
+    // the ride data may have changed
+    clearPeaks();
+
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+
+    // when just some of the config changed only the metrics that read it
+    // are computed again, the intervals are only found again when they
+    // could be different and the cache when the weight changed
+    int config = metrics_.count() == factory.metricCount() ? staleconfig : 0;
+    staleconfig = 0;
+
+    QStringList reading;
+    if (config) reading = RideMetric::metricsReading(config);
+    const QStringList &symbols = config ? reading : factory.allMetrics();
+
+    bool rediscover = !config || (config & (RideMetric::PowerZonesInput | RideMetric::RoutesInput | RideMetric::DiscoveryInput));
+    bool recache = !config || (config & RideMetric::WeightInput);
+
+    // the file as it is now, it's only hashed again when this changes
+    if (!config) {
+        QString fullPath = QString(context->athlete->home->activities().absolutePath()) + "/" + fileName;
+        RideFile::statFile(fullPath, fileSize, fileModified);
+        crc = RideFile::computeFileHash(fullPath);
+    }
+
     // open ride file will extract details too, but only if not
     // already open since its a user entry point and will call
     // refresh when opened. We don't want a recursion here.
     // And if already open no need to close
     RideFile *f;
+    RideFile *partial = NULL;
     bool doclose = false;
     if (!isOpen()) { 
         doclose = true;
-        f = ride(); // will call us but isstale is false above
+
+        // we only need the series read by the metrics, the cpx and interval
+        // discovery so when they all say what they need, skip the rest. The
+        // intervals found again have all of their metrics computed
+        QList<RideFile::SeriesType> series;
+        QStringList xdata;
+        if (RideMetric::inputsFor(rediscover ? factory.allMetrics() : symbols, series, xdata)) {
+
+            if (recache) RideFileCache::inputs(series, xdata);
+            if (rediscover) discoveryInputs(series);
+
+            // not ride_, anyone else opening the ride whilst we
+            // work needs all of it, see ride() above
+            QFile file(path + "/" + fileName);
+            f = partial = RideFileFactory::instance().openRideFile(context, file, errors_, series, xdata);
+            if (partial) {
+                if (!refreshing.hasLocalData()) refreshing.setLocalData(new RideItemRefresh);
+                refreshing.localData()->item = this;
+                refreshing.localData()->ride = partial;
+            }
+
+        } else f = ride(); // will call us but isstale is false above
+
     } else f=ride_;
 
     if (f) {
@@ -574,7 +825,7 @@ RideItem::refresh()
         // overrides
         overrides_.clear();
         QMap<QString,QMap<QString, QString> >::const_iterator k;
-        for (k=ride_->metricOverrides.constBegin(); k != ride_->metricOverrides.constEnd(); k++) {
+        for (k=f->metricOverrides.constBegin(); k != f->metricOverrides.constEnd(); k++) {
             overrides_ << k.key();
         }
 
@@ -586,7 +837,7 @@ RideItem::refresh()
         isSwim = f->isSwim();
         color = context->athlete->colorEngine->colorFor(f->getTag(context->athlete->rideMetadata()->getColorField(), ""));
         present = f->getTag("Data", "");
-        samples = f->dataPoints().count() > 0;
+        samples = f->sampleCount() > 0;
 
         // zone ranges
         if (context->athlete->zones(isRun)) zoneRange = context->athlete->zones(isRun)->whichRange(dateTime.date());
@@ -598,31 +849,16 @@ RideItem::refresh()
         if (context->athlete->paceZones(isSwim)) paceZoneRange = context->athlete->paceZones(isSwim)->whichRange(dateTime.date());
         else paceZoneRange = -1;
 
-        // refresh metrics etc
-        const RideMetricFactory &factory = RideMetricFactory::instance();
-
         // ressize and initialize so we can store metric values at
         // RideMetric::index offsets into the metrics_ qvector
-        metrics_.fill(0, factory.metricCount());
-        count_.fill(0, factory.metricCount());
+        if (!config) {
+            metrics_.fill(0, factory.metricCount());
+            count_.fill(0, factory.metricCount());
+        }
 
         // we compute all with not specification (not an interval)
-        QHash<QString,RideMetricPtr> computed= RideMetric::computeMetrics(this, Specification(), factory.allMetrics());
-
-        // snaffle away all the computed values into the array
-        QHashIterator<QString, RideMetricPtr> i(computed);
-        while (i.hasNext()) {
-            i.next();
-            //DEBUG if (i.value()->isUser()) qDebug()<<dateTime.date()<<i.value()->symbol()<<i.value()->value();
-            metrics_[i.value()->index()] = i.value()->value();
-            count_[i.value()->index()] = i.value()->count();
-            double stdmean = i.value()->stdmean();
-            double stdvariance = i.value()->stdvariance();
-            if (stdmean || stdvariance) {
-                stdmean_.insert(i.value()->index(), stdmean);
-                stdvariance_.insert(i.value()->index(), stdvariance);
-            }
-        }
+        // straight into the array
+        RideMetric::computeMetrics(this, Specification(), symbols, metrics_, count_, stdmean_, stdvariance_);
 
         // clean any bad values
         for(int j=0; j<factory.metricCount(); j++)
@@ -632,38 +868,57 @@ RideItem::refresh()
             }
 
         // Update auto intervals AFTER ridefilecache as used for bests
-        updateIntervals();
+        // or if they are still the same just the metrics that changed
+        if (rediscover) updateIntervals();
+        else foreach(IntervalItem *interval, intervals_) interval->refresh(symbols);
+        metricsChanged();
 
-        // update fingerprints etc, crc done above
-        fingerprint = static_cast<unsigned long>(context->athlete->zones(isRun)->getFingerprint(dateTime.date()))
-                    + (appsettings->cvalue(context->athlete->cyclist, context->athlete->zones(isRun)->useCPforFTPSetting(), 0).toInt() ? 1 : 0)
-                    + static_cast<unsigned long>(context->athlete->paceZones(isSwim)->getFingerprint(dateTime.date()))
-                    + static_cast<unsigned long>(context->athlete->hrZones(isRun)->getFingerprint(dateTime.date()))
-                    + static_cast<unsigned long>(context->athlete->routes->getFingerprint()) +
-                    + static_cast<unsigned long>(getHrvFingerprint())
-                    + appsettings->cvalue(context->athlete->cyclist, GC_DISCOVERY, 57).toInt(); // 57 does not include search for PEAKS
+        // update fingerprints etc, of what was computed
+        updateFingerprints(config);
 
         dbversion = DBSchemaVersion;
         udbversion = UserMetricSchemaVersion;
         timestamp = QDateTime::currentDateTime().toTime_t();
 
         // RideFile cache needs refreshing possibly
-        RideFileCache updater(context, context->athlete->home->activities().canonicalPath() + "/" + fileName, getWeight(), ride_, true);
+        if (recache) {
+            RideFileCache updater(context, context->athlete->home->activities().canonicalPath() + "/" + fileName, getWeight(), f, true);
+        }
 
         // we now match
         metacrc = metaCRC();
+        unsaved = true;
 
         // Construct the summary text used on the calendar
         metadata_.insert("Calendar Text", context->athlete->rideMetadata()->calendarText(this));
 
         // close if we opened it
-        if (doclose) {
+        if (partial) {
+
+            // the intervals were linked to it, and the indexes built from
+            // it, but leave ride_ be if somebody opened it meanwhile
+            refreshing.localData()->item = NULL;
+            refreshing.localData()->ride = NULL;
+            foreach(IntervalItem *x, intervals()) x->rideInterval = NULL;
+            delete partial;
+
+            if (fileCache_) {
+                delete fileCache_;
+                fileCache_ = NULL;
+            }
+            metricIndexLock.lock();
+            delete metricIndex_;
+            metricIndex_ = NULL;
+            metricIndexLock.unlock();
+
+        } else if (doclose) {
             close();
         } else {
 
             // if it is open then recompute
             userCache.clear();
-            ride_->wstale = true;
+            clearPeaks();
+            ride_->invalidateWprime();
             ride_->recalculateDerivedSeries(true);
         }
 
@@ -674,6 +929,39 @@ RideItem::refresh()
     }
 }
 
+// the config the metrics were computed with, as checked in checkStale(),
+// just for the inputs that were computed again unless that was all of it
+// (config is 0), the rest are still to be done so keep what they were
+void
+RideItem::updateFingerprints(int config)
+{
+    if (config == 0 || configprints.count() != RideMetric::ConfigInputCount) {
+        config = RideMetric::AllConfigInputs;
+        configprints.fill(0, RideMetric::ConfigInputCount);
+    }
+
+    if (config & RideMetric::PowerZonesInput)
+        configprints[configSlot(RideMetric::PowerZonesInput)] = static_cast<unsigned long>(context->athlete->zones(isRun)->getFingerprint(dateTime.date()))
+                    + (appsettings->cvalue(context->athlete->cyclist, context->athlete->zones(isRun)->useCPforFTPSetting(), 0).toInt() ? 1 : 0);
+    if (config & RideMetric::PaceZonesInput)
+        configprints[configSlot(RideMetric::PaceZonesInput)] = static_cast<unsigned long>(context->athlete->paceZones(isSwim)->getFingerprint(dateTime.date()));
+    if (config & RideMetric::HrZonesInput)
+        configprints[configSlot(RideMetric::HrZonesInput)] = static_cast<unsigned long>(context->athlete->hrZones(isRun)->getFingerprint(dateTime.date()));
+    if (config & RideMetric::RoutesInput)
+        configprints[configSlot(RideMetric::RoutesInput)] = static_cast<unsigned long>(context->athlete->routes->getFingerprint());
+    if (config & RideMetric::HrvInput)
+        configprints[configSlot(RideMetric::HrvInput)] = static_cast<unsigned long>(getHrvFingerprint());
+    if (config & RideMetric::DiscoveryInput)
+        configprints[configSlot(RideMetric::DiscoveryInput)] = appsettings->cvalue(context->athlete->cyclist, GC_DISCOVERY, 57).toInt(); // 57 does not include search for PEAKS
+    if (config & RideMetric::WeightInput)
+        configprints[configSlot(RideMetric::WeightInput)] = 1000.0f * weight;
+
+    // and as one, all but the weight which is kept apart
+    fingerprint = 0;
+    for (int i=0; i<configprints.count(); i++)
+        if (i != configSlot(RideMetric::WeightInput)) fingerprint += configprints[i];
+}
+
 double
 RideItem::getWeight(int type)
 {
@@ -712,6 +1000,18 @@ RideItem::getWeight(int type)
     return weight;
 }
 
+// as above, with the measures and settings looked up already
+double
+RideItem::getWeight(RideItemStaleCheck &check)
+{
+    check.bodyMeasure(dateTime.date(), weightData);
+
+    weight = weightData.weightkg;
+    if (weight <= 0.00) weight = metadata_.value("Weight", "0.0").toDouble();
+    if (weight <= 0.00) weight = check.weight;
+    return weight;
+}
+
 double
 RideItem::getHrvMeasure(int type)
 {
@@ -731,18 +1031,19 @@ RideItem::getHrvFingerprint()
 double
 RideItem::getForSymbol(QString name, bool useMetricUnits)
 {
+    return getForSymbol(MetricHandle(name, useMetricUnits));
+}
+
+double
+RideItem::getForSymbol(const MetricHandle &metric)
+{
+    // metrics were added or removed since
+    if (metric.isStale()) return getForSymbol(MetricHandle(metric.symbol(), metric.useMetricUnits()));
+
     const RideMetricFactory &factory = RideMetricFactory::instance();
-    if (metrics_.size() && metrics_.size() == factory.metricCount()) {
+    if (metric.isValid() && metrics_.size() && metrics_.size() == factory.metricCount()) {
         // return the precomputed metric value
-        const RideMetric *m = factory.rideMetric(name);
-        if (m) {
-            if (useMetricUnits) return metrics_[m->index()];
-            else {
-                // little hack to set/get for conversion
-                const_cast<RideMetric*>(m)->setValue(metrics_[m->index()]);
-                return m->value(useMetricUnits);
-            }
-        }
+        return metric.value(metrics_[metric.index()]);
     }
     return 0.0f;
 }
@@ -750,15 +1051,19 @@ RideItem::getForSymbol(QString name, bool useMetricUnits)
 double
 RideItem::getCountForSymbol(QString name)
 {
+    return getCountForSymbol(MetricHandle(name));
+}
+
+double
+RideItem::getCountForSymbol(const MetricHandle &metric)
+{
+    if (metric.isStale()) return getCountForSymbol(MetricHandle(metric.symbol()));
+
     const RideMetricFactory &factory = RideMetricFactory::instance();
-    if (metrics_.size() && metrics_.size() == factory.metricCount()) {
-        // return the precomputed metric value
-        const RideMetric *m = factory.rideMetric(name);
-        if (m)  {
-            // don't return zero (!)
-            double returning = count_[m->index()];
-            return returning ? returning : 1;
-        }
+    if (metric.isValid() && metrics_.size() && metrics_.size() == factory.metricCount()) {
+        // don't return zero (!)
+        double returning = count_[metric.index()];
+        return returning ? returning : 1;
     }
     // don't return zero, thats impossible
     return 1.0f;
@@ -826,6 +1131,28 @@ static bool intervalGreaterThanZone(const IntervalItem *a, const IntervalItem *b
            const_cast<IntervalItem*>(b)->getForSymbol("power_zone"); 
 }
 
+// the series updateIntervals() reads for the intervals it discovers,
+// the time and distance are always there; keep the two in step
+void
+RideItem::discoveryInputs(QList<RideFile::SeriesType> &series) const
+{
+    int discovery = appsettings->cvalue(context->athlete->cyclist, GC_DISCOVERY, 57).toInt();
+
+    // peak powers, efforts and W' matches
+    if (discovery & (RideFileInterval::intervalTypeBits(RideFileInterval::PEAKPOWER) |
+                     RideFileInterval::intervalTypeBits(RideFileInterval::EFFORT)))
+        series << RideFile::watts;
+
+    if (discovery & RideFileInterval::intervalTypeBits(RideFileInterval::PEAKPACE))
+        series << RideFile::kph;
+
+    if (discovery & RideFileInterval::intervalTypeBits(RideFileInterval::CLIMB))
+        series << RideFile::alt;
+
+    if (discovery & RideFileInterval::intervalTypeBits(RideFileInterval::ROUTE))
+        series << RideFile::lat << RideFile::lon;
+}
+
 void
 RideItem::updateIntervals()
 {
@@ -833,7 +1160,7 @@ RideItem::updateIntervals()
     int discovery = appsettings->cvalue(context->athlete->cyclist, GC_DISCOVERY, 57).toInt(); // 57 does not include search for PEAKS
 
     // DO NOT USE ride() since it will call a refresh !
-    RideFile *f = ride_;
+    RideFile *f = ride(false);
 
     QList<IntervalItem*> deletelist = intervals_;
     intervals_.clear();
@@ -948,17 +1275,16 @@ RideItem::updateIntervals()
     
         for(int i=0; durations[i] != 0; i++) {
 
-            // go hunting for best peak
-            QList<AddIntervalDialog::AddedInterval> results;
-            AddIntervalDialog::findPeaks(context, true, f, Specification(), RideFile::watts, RideFile::original, durations[i], 1, results, "", "");
+            // go hunting for best peak, shared with the peak metrics
+            PeakFinder::Peak peak = PeakFinder::peak(this, Specification(), RideFile::watts, durations[i]);
 
             // did we get one ?
-            if (results.count() > 0 && results[0].avg > 0 && results[0].stop > 0) {
-                // qDebug()<<"found"<<names[i]<<"peak power"<<results[0].start<<"-"<<results[0].stop<<"of"<<results[0].avg<<"watts";
-                IntervalItem *intervalItem = new IntervalItem(this, QString(tr("%1 (%2 watts)")).arg(names[i]).arg(int(results[0].avg)),
-                                                            results[0].start, results[0].stop, 
-                                                            f->timeToDistance(results[0].start),
-                                                            f->timeToDistance(results[0].stop),
+            if (peak.found && peak.avg > 0 && peak.stop > 0) {
+                // qDebug()<<"found"<<names[i]<<"peak power"<<peak.start<<"-"<<peak.stop<<"of"<<peak.avg<<"watts";
+                IntervalItem *intervalItem = new IntervalItem(this, QString(tr("%1 (%2 watts)")).arg(names[i]).arg(int(peak.avg)),
+                                                            peak.start, peak.stop, 
+                                                            f->timeToDistance(peak.start),
+                                                            f->timeToDistance(peak.stop),
                                                             count++,
                                                             QColor(Qt::gray),
                                                             RideFileInterval::PEAKPOWER);
@@ -982,19 +1308,18 @@ RideItem::updateIntervals()
         bool metric = appsettings->value(this, context->athlete->paceZones(f->isSwim())->paceSetting(), true).toBool();
         for(int i=0; durations[i] != 0; i++) {
 
-            // go hunting for best peak
-            QList<AddIntervalDialog::AddedInterval> results;
-            AddIntervalDialog::findPeaks(context, true, f, Specification(), RideFile::kph, RideFile::original, durations[i], 1, results, "", "");
+            // go hunting for best peak, shared with the peak metrics
+            PeakFinder::Peak peak = PeakFinder::peak(this, Specification(), RideFile::kph, durations[i]);
 
             // did we get one ?
-            if (results.count() > 0 && results[0].avg > 0 && results[0].stop > 0) {
-                // qDebug()<<"found"<<names[i]<<"peak pace"<<results[0].start<<"-"<<results[0].stop<<"of"<<results[0].avg<<"kph";
+            if (peak.found && peak.avg > 0 && peak.stop > 0) {
+                // qDebug()<<"found"<<names[i]<<"peak pace"<<peak.start<<"-"<<peak.stop<<"of"<<peak.avg<<"kph";
                 IntervalItem *intervalItem = new IntervalItem(this, QString(tr("%1 (%2 %3)")).arg(names[i])
-                               .arg(context->athlete->paceZones(f->isSwim())->kphToPaceString(results[0].avg, metric))
+                               .arg(context->athlete->paceZones(f->isSwim())->kphToPaceString(peak.avg, metric))
                                .arg(context->athlete->paceZones(f->isSwim())->paceUnits(metric)),
-                                                            results[0].start, results[0].stop, 
-                                                            f->timeToDistance(results[0].start),
-                                                            f->timeToDistance(results[0].stop),
+                                                            peak.start, peak.stop, 
+                                                            f->timeToDistance(peak.start),
+                                                            f->timeToDistance(peak.stop),
                                                             count++,
                                                             QColor(Qt::gray),
                                                             RideFileInterval::PEAKPACE);
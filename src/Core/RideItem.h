@@ -24,10 +24,13 @@
 #include "RideMetric.h"
 #include "BodyMeasures.h"
 #include "HrvMeasures.h"
+#include "PeakFinder.h"
 
 #include <QString>
 #include <QMap>
+#include <QHash>
 #include <QVector>
+#include <QMutex>
 
 class RideFile;
 class RideFileCache;
@@ -38,6 +41,8 @@ class IntervalSummaryWindow;
 class Context;
 class UserData;
 class ComparePane;
+class RideItemStaleCheck;
+class RideMetricIndex;
 
 Q_DECLARE_METATYPE(RideItem*)
 
@@ -61,9 +66,14 @@ class RideItem : public QObject
         RideFile *ride_;
         RideFileCache *fileCache_;
 
+        // indexes of the samples for the interval metrics, see RideMetricSweep
+        RideMetricIndex *metricIndex_;
+        QMutex metricIndexLock;
+
         // precomputed metrics & user overrides
         QVector<double> metrics_;
         QVector<double> count_;
+        int metricsRevision_;
 
         // std deviation metrics need these to aggregate
         QMap<int, double> stdmean_;
@@ -82,6 +92,11 @@ class RideItem : public QObject
         // userdata cache
         QMap<QString, QVector<double> > userCache;
 
+        // peaks found for the peak metrics, see PeakFinder::peak()
+        QMap<QString, PeakFinder::Peak> peakCache;
+        QMutex peakLock;
+        void clearPeaks(); // takes the lock, the peaks may be being found
+
         unsigned long metaCRC();
 
     public slots:
@@ -100,8 +115,10 @@ class RideItem : public QObject
         Context *context; // to notify widgets when date/time changes
         bool isdirty;     // ride data has changed and needs saving
         bool isstale;     // metric data is out of date and needs recomputing
+        int staleconfig;  // or just for this config, see RideMetric::ConfigInput
         bool isedit;      // is being edited at the moment
         bool skipsave;    // on exit we don't save the state to force rebuild at startup
+        bool unsaved;     // changed since it was last written to the rideDB
 
         // set from another, e.g. during load of rideDB.json
         void setFrom(RideItem&, bool temp=false);
@@ -123,6 +140,10 @@ class RideItem : public QObject
         double getForSymbol(QString name, bool useMetricUnits=true);
         double getCountForSymbol(QString name);
 
+        // same, but looked up once for many rides
+        double getForSymbol(const MetricHandle &metric);
+        double getCountForSymbol(const MetricHandle &metric);
+
         // access the stdmean and stdvariance value
         double getStdMeanForSymbol(QString name);
         double getStdVarianceForSymbol(QString name);
@@ -149,7 +170,11 @@ class RideItem : public QObject
 
         // context the item was updated to
         unsigned long fingerprint; // zones
-        unsigned long metacrc, crc, timestamp; // file content
+        QVector<unsigned long> configprints; // for each RideMetric::ConfigInput, weight in grams
+        unsigned long metacrc, timestamp; // file content
+        quint64 crc; // RideFile::computeFileHash()
+        quint64 fileSize; // from RideFile::statFile() when last hashed
+        qint64 fileModified;
         int dbversion; // metric version
         int udbversion; // user metric version
         double weight; // what weight was used ?
@@ -158,12 +183,17 @@ class RideItem : public QObject
         BodyMeasure weightData;
         RideFile *ride(bool open=true);
         RideFileCache *fileCache();
+        RideMetricIndex *metricIndex(); // whilst open
         QVector<double> &metrics() { return metrics_; }
         QVector<double> &counts() { return count_; }
+        int metricsRevision() const { return metricsRevision_; } // changes when they do
+        static int metricsRevisions(); // the latest for any ride
+        void metricsChanged(); // after updating them, see RideCacheColumns
         QMap <int, double>&stdmeans() { return stdmean_; }
         QMap <int, double>&stdvariances() { return stdvariance_; }
         const QStringList errors() { return errors_; }
         double getWeight(int type=0);
+        double getWeight(RideItemStaleCheck &check); // in kilos, as above
         double getHrvMeasure(int type=HrvMeasure::RMSSD);
         unsigned short getHrvFingerprint();
 
@@ -203,6 +233,12 @@ class RideItem : public QObject
         void setDirty(bool);
         bool isDirty() { return isdirty; }
         bool checkStale(); // check if we need to refresh
+
+        // checkStale() in two parts when checking them all; the first
+        // looks at the config and runs on the gui thread, the second
+        // only looks at the files and can be run on any thread
+        bool checkStale(RideItemStaleCheck &check);
+        bool checkFilesStale();
         bool isStale() { return isstale; }
 
         // refresh when stale
@@ -219,6 +255,43 @@ class RideItem : public QObject
 
     private:
         void updateIntervals();
+        void discoveryInputs(QList<RideFile::SeriesType> &series) const; // what updateIntervals() reads
+        void updateFingerprints(int config); // 0 is all of it
+        void cancelRefresh(); // in the background, we're refreshing it here
+};
+
+//
+// Most of what decides if a ride is stale depends on its date; the zones,
+// body measures and HRV measures that apply then. Looking those up for
+// every ride means a few scans of each list and settings lookups per ride,
+// so when checking them all they are looked up once and shared.
+//
+class RideItemStaleCheck
+{
+    public:
+        RideItemStaleCheck(Context *context);
+
+        // the config fingerprint for a ride on the date, as set in refresh()
+        unsigned long fingerprint(QDate date, bool isRun, bool isSwim);
+
+        // and for each RideMetric::ConfigInput, with the weight that applies
+        QVector<unsigned long> fingerprints(QDate date, bool isRun, bool isSwim, double weight);
+
+        // as Athlete::getBodyMeasure and getHrvMeasure
+        void bodyMeasure(QDate date, BodyMeasure &here);
+        unsigned short hrvFingerprint(QDate date);
+
+        QString colorField;
+        double weight; // from the athlete settings
+
+    private:
+        Context *context;
+        unsigned long routes, discovery, cpforftp[2];
+
+        QHash<QString, QVector<unsigned long> > zones; // by the ranges that apply
+        QMap<QDate, BodyMeasure> measures;
+        QMap<QDate, unsigned short> hrv;
+        unsigned short nohrv;
 };
 
 #endif // _GC_RideItem_h
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "SeriesKernels.h"
+
+//
+// The loops below are deliberately kept simple; no function calls, no
+// pointer chasing and conditionals that can become selects, so they
+// vectorise. Only rollingMean and ewma carry a running value from one
+// sample to the next, and both keep that part as small as possible.
+//
+
+void
+SeriesKernels::rollingMean(const double *in, double *out, int n, int window)
+{
+    if (n <= 0 || window <= 0) return;
+
+    // running sum, whilst the window fills there is nothing to drop
+    double sum = 0;
+    int fill = n < window ? n : window;
+    for (int i=0; i<fill; i++) {
+        sum += in[i];
+        out[i] = sum;
+    }
+    for (int i=window; i<n; i++) {
+        sum += in[i];
+        sum -= in[i-window];
+        out[i] = sum;
+    }
+
+    // sums to means
+    for (int i=0; i<n; i++) out[i] /= window;
+}
+
+double
+SeriesKernels::ewma(const double *in, double *out, int n, double attenuation, double weight, double initial)
+{
+    // the weighted input does not depend on the previous value
+    // so do that in one pass and just the recurrence in another
+    for (int i=0; i<n; i++) out[i] = in[i] * weight;
+
+    double last = initial;
+    for (int i=0; i<n; i++) {
+        last = last * attenuation + out[i];
+        out[i] = last;
+    }
+    return last;
+}
+
+void
+SeriesKernels::firstDifference(const double *in, const double *x, double *out, int n)
+{
+    if (n <= 0) return;
+
+    out[0] = 0;
+    if (x) {
+        for (int i=1; i<n; i++) {
+            double dx = x[i] - x[i-1];
+            out[i] = dx > 0 ? (in[i] - in[i-1]) / dx : 0;
+        }
+    } else {
+        for (int i=1; i<n; i++) out[i] = in[i] - in[i-1];
+    }
+}
+
+void
+SeriesKernels::ratio(const double *num, const double *den, double *out, int n, double scale)
+{
+    for (int i=0; i<n; i++) out[i] = den[i] > 0 ? (num[i] / den[i]) * scale : 0;
+}
+
+void
+SeriesKernels::bandPass(double *data, int n, double lo, double hi)
+{
+    for (int i=0; i<n; i++) data[i] = (data[i] > lo && data[i] < hi) ? data[i] : 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_SeriesKernels_h
+#define _GC_SeriesKernels_h
+
+// Kernels for computing derived data series from contiguous arrays of
+// samples, e.g. the columns returned by RideFile::series(). They are
+// written as simple branch free loops over plain arrays so the compiler
+// can vectorise them, and are used by RideFile to derive NP, xPower,
+// aPower, slope and the delta series.
+//
+// In all cases n is the number of samples and out must have room for
+// n values. Unless noted out may be the same array as an input.
+
+namespace SeriesKernels
+{
+    // out[i] is the mean of the last window samples up to and including
+    // in[i], samples before the start of the array count as zero
+    // (out may not be the same array as in)
+    void rollingMean(const double *in, double *out, int n, int window);
+
+    // out[i] = out[i-1] * attenuation + in[i] * weight, with out[-1] being
+    // initial. Returns out[n-1] so a series can be processed in pieces
+    double ewma(const double *in, double *out, int n, double attenuation, double weight, double initial);
+
+    // out[i] = (in[i] - in[i-1]) / (x[i] - x[i-1]) or zero where x does not
+    // increase, if x is NULL the difference is per sample. out[0] is zero
+    // (out may not be the same array as in)
+    void firstDifference(const double *in, const double *x, double *out, int n);
+
+    // out[i] = scale * num[i] / den[i], or zero where den is not positive
+    void ratio(const double *num, const double *den, double *out, int n, double scale);
+
+    // zero any values that are not strictly between lo and hi
+    void bandPass(double *data, int n, double lo, double hi);
+};
+
+#endif
@@ -98,6 +98,7 @@
 #define GC_HOMEDIR                      "<system>homedirectory"
 #define GC_START_HTTP                   "<system>starthttp"
 #define GC_EMBED_R                      "<system>embedR"
+#define GC_REFRESH_THREADS              "<system>refreshThreads"        // threads refreshing rides and computing cpx, 0 is one per core
 
 #define GC_SETTINGS_LAST                "<system>mainwindow/lastOpened"
 #define GC_SETTINGS_MAIN_GEOM           "<system>mainwindow/geometry"
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "CpxCodec.h"
+
+#include <string.h> // for memcpy()
+
+// every mean max duration up to an hour is kept
+static const int exactSecs = 3600;
+
+// the next duration kept after i
+static inline int nextKept(int i, int count)
+{
+    int next = i < exactSecs ? i+1 : i + i/128;
+    if (next >= count && i < count-1) next = count-1; // always keep the last
+    return next;
+}
+
+static inline void writeVarint(QByteArray &out, quint64 value)
+{
+    while (value >= 0x80) {
+        out.append(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+static inline bool readVarint(const uchar *&p, const uchar *end, quint64 &value)
+{
+    value = 0;
+    for (int shift=0; p < end && shift < 64; shift += 7) {
+        uchar byte = *p++;
+        value |= quint64(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+// so small negative differences are small too
+static inline quint64 zigzag(qint64 value) { return (quint64(value) << 1) ^ quint64(value >> 63); }
+static inline qint64 unzigzag(quint64 value) { return qint64(value >> 1) ^ -qint64(value & 1); }
+
+QByteArray
+CpxCodec::encodeMeanMax(const QVector<float> &array)
+{
+    QByteArray out;
+    int count = array.size();
+    out.reserve(qMin(count, exactSecs) * 2 + 1024);
+
+    // the bits of positive floats are in the same order as
+    // their values, so a curve has small differences
+    qint64 last = 0;
+    for (int i=0; i<count; i=nextKept(i, count)) {
+        quint32 bits;
+        memcpy(&bits, &array[i], sizeof(bits));
+        writeVarint(out, zigzag(qint64(bits) - last));
+        last = bits;
+    }
+    return out;
+}
+
+bool
+CpxCodec::decodeMeanMax(const uchar *p, const uchar *end, int count, int upto, float *into)
+{
+    qint64 last = 0;
+    int prev = 0;
+    float prevValue = 0;
+
+    for (int i=0; i<count; i=nextKept(i, count)) {
+
+        quint64 value;
+        if (!readVarint(p, end, value)) return false;
+        last += unzigzag(value);
+
+        quint32 bits = quint32(last);
+        float kept;
+        memcpy(&kept, &bits, sizeof(kept));
+
+        // the durations in between lie on a straight line
+        for (int k=prev+1; k<i && k<=upto; k++)
+            into[k] = prevValue + (kept - prevValue) * double(k - prev) / double(i - prev);
+
+        if (i <= upto) into[i] = kept;
+        if (i >= upto) return true;
+
+        prev = i;
+        prevValue = kept;
+    }
+    return true;
+}
+
+QByteArray
+CpxCodec::encodeDistribution(const QVector<float> &array)
+{
+    QByteArray out;
+    int count = array.size();
+
+    int i = 0;
+    while (i < count) {
+
+        int zeros = 0;
+        while (i+zeros < count && array[i+zeros] == 0) zeros++;
+        i += zeros;
+
+        int values = 0;
+        while (i+values < count && array[i+values] != 0) values++;
+
+        writeVarint(out, zeros);
+        writeVarint(out, values);
+        out.append((const char*)(array.constData() + i), values * sizeof(float));
+        i += values;
+    }
+    return out;
+}
+
+bool
+CpxCodec::decodeDistribution(const uchar *p, const uchar *end, int count, float *into)
+{
+    int i = 0;
+    while (i < count) {
+
+        quint64 zeros, values;
+        if (!readVarint(p, end, zeros) || !readVarint(p, end, values)) return false;
+        if (zeros > quint64(count - i) || values > quint64(count - i) - zeros) return false;
+        if (quint64(end - p) < values * sizeof(float)) return false;
+
+        memset(into + i, 0, zeros * sizeof(float));
+        i += zeros;
+
+        memcpy(into + i, p, values * sizeof(float));
+        p += values * sizeof(float);
+        i += values;
+    }
+    return true;
+}
+
+bool
+CpxCodec::isKept(int duration, int count)
+{
+    int i = 0;
+    while (i < duration && i < count) i = nextKept(i, count);
+    return i == duration && i < count;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_CpxCodec_h
+#define _GC_CpxCodec_h
+
+#include <QByteArray>
+#include <QVector>
+
+// How the mean max and distribution arrays are encoded in a .cpx file,
+// written by RideFileCache::serialize() and read by RideFileCacheReader.
+// The decoders check every length against the end of the block so a
+// damaged file is rejected rather than read past.
+
+namespace CpxCodec
+{
+    // Mean max arrays are kept for every second up to an hour and
+    // then for durations about 1% apart, and always the last one.
+    // Those in between are interpolated when read back. The values
+    // kept are written as the difference between the bits of each
+    // float and the last, zigzag and varint encoded, so they are
+    // read back exactly and a smooth curve needs 1-3 bytes a value.
+    QByteArray encodeMeanMax(const QVector<float> &array);
+
+    // decode a mean max of count values into[0] .. into[upto]
+    bool decodeMeanMax(const uchar *p, const uchar *end, int count, int upto, float *into);
+
+    // Distributions are mostly empty so runs of zeros are skipped:
+    // a varint count of zeros, a varint count of values and then
+    // the values as floats, repeated until the array is filled.
+    QByteArray encodeDistribution(const QVector<float> &array);
+    bool decodeDistribution(const uchar *p, const uchar *end, int count, float *into);
+
+    // the durations kept, and so read back exactly
+    bool isKept(int duration, int count);
+};
+
+#endif
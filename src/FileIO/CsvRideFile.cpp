@@ -1024,7 +1024,7 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
                         p->secs = lastsecs;
                         p->km = lastKM;
                         for(int i=0; i<25; i++)
-                            p->number[i] = els[i].toDouble();
+                            p->number.set(i, els[i].toDouble());
 
                         rowSeries->datapoints.append(p);
                     }
@@ -1056,7 +1056,7 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
                         XDataPoint *p = new XDataPoint();
                         p->secs = minutes * 60.0;
                         p->km = km;
-                        p->number[0] = target;
+                        p->number.set(0, target);
 
                         trainSeries->datapoints.append(p);
                     }
@@ -1173,6 +1173,9 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
 bool
 CsvFileReader::writeRideFile(Context *, const RideFile *ride, QFile &file, CsvType format) const
 {
+    // derived series are only computed when asked for
+    ride->deriveAll();
+
     if (!file.open(QIODevice::WriteOnly)) return(false);
 
     // always save CSV in metric format
@@ -1167,10 +1167,10 @@ struct FitFileReaderState
                         case 3:
                             p->secs = secs;
                             p->km = last_distance;
-                            p->number[0] = ((data32 >> 24) & 255);
-                            p->number[1] = ((data32 >> 8) & 255);
-                            p->number[2] = ((data32 >> 16) & 255);
-                            p->number[3] = (data32 & 255);
+                            p->number.set(0, ((data32 >> 24) & 255));
+                            p->number.set(1, ((data32 >> 8) & 255));
+                            p->number.set(2, ((data32 >> 16) & 255));
+                            p->number.set(3, (data32 & 255));
                             gearsXdata->datapoints.append(p);
                             break;
                         default:
@@ -1241,7 +1241,7 @@ struct FitFileReaderState
 	      }
 	      XDataPoint *p = new XDataPoint();
 	      p->secs = hrv_time;
-	      p->number[0] = rrvalue;
+	      p->number.set(0, rrvalue);
 	      hrvXdata->datapoints.append(p);
 	    }
 	}
@@ -1643,9 +1643,9 @@ struct FitFileReaderState
                             offset = 0;
 
                         switch (_values.type) {
-                            case SingleValue: p_deve->number[idx]=_values.v/(float)scale+offset; break;
-                            case FloatValue: p_deve->number[idx]=_values.f/(float)scale+offset; break;
-                            case StringValue: p_deve->string[idx]=_values.s.c_str(); break;
+                            case SingleValue: p_deve->number.set(idx, _values.v/(float)scale+offset); break;
+                            case FloatValue: p_deve->number.set(idx, _values.f/(float)scale+offset); break;
+                            case StringValue: p_deve->string.set(idx, _values.s.c_str()); break;
                             default: break;
                         }
                     }
@@ -1678,9 +1678,9 @@ struct FitFileReaderState
                            p_extra = new XDataPoint();
 
                         switch (_values.type) {
-                            case SingleValue: p_extra->number[idx]=_values.v/scale+offset; break;
-                            case FloatValue: p_extra->number[idx]=_values.f/scale+offset; break;
-                            case StringValue: p_extra->string[idx]=_values.s.c_str(); break;
+                            case SingleValue: p_extra->number.set(idx, _values.v/scale+offset); break;
+                            case FloatValue: p_extra->number.set(idx, _values.f/scale+offset); break;
+                            case StringValue: p_extra->string.set(idx, _values.s.c_str()); break;
                             default: break;
                         }
                     }
@@ -1939,9 +1939,9 @@ struct FitFileReaderState
         XDataPoint *p = new XDataPoint();
         p->secs = last_time;
         p->km = last_distance;
-        p->number[0] = length_type + swim_stroke;
-        p->number[1] = length_duration;
-        p->number[2] = total_strokes;
+        p->number.set(0, length_type + swim_stroke);
+        p->number.set(1, length_duration);
+        p->number.set(2, total_strokes);
 
         swimXdata->datapoints.append(p);
 
@@ -2059,10 +2059,10 @@ struct FitFileReaderState
         XDataPoint *p = new XDataPoint();
         p->secs = secs;
         p->km = last_distance;
-        p->number[0] = windSpeed;
-        p->number[1] = windHeading;
-        p->number[2] = temp;
-        p->number[3] = humidity;
+        p->number.set(0, windSpeed);
+        p->number.set(1, windHeading);
+        p->number.set(2, temp);
+        p->number.set(3, humidity);
 
         weatherXdata->datapoints.append(p);
     }
@@ -3490,6 +3490,9 @@ void write_record(QByteArray *array, const RideFile *ride, bool withAlt, bool wi
 QByteArray
 FitFileReader::toByteArray(Context *context, const RideFile *ride, bool withAlt, bool withWatts, bool withHr, bool withCad) const
 {
+    // derived series are only computed when asked for
+    ride->deriveAll();
+
     const char *metrics[] = {
         "total_distance",
         "workout_time",
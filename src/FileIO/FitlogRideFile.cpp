@@ -54,6 +54,9 @@ RideFile *FitlogFileReader::openRideFile(QFile &file, QStringList &errors, QList
 bool
 FitlogFileReader::writeRideFile(Context *context, const RideFile *ride, QFile &file) const
 {
+    // derived series are only computed when asked for
+    ride->deriveAll();
+
     QDomText text;
     QDomDocument doc;
     QDomProcessingInstruction hdr = doc.createProcessingInstruction("xml","version=\"1.0\"");
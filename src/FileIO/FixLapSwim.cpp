@@ -228,6 +228,7 @@ FixLapSwim::postProcess(RideFile *ride, DataProcessorConfig *config=0, QString o
     // rebuild intervals and force metric update
     ride->fillInIntervals();
     ride->context->rideItem()->isstale = true;
+    ride->context->rideItem()->staleconfig = 0;
     ride->context->rideItem()->refresh();
 
     return true;
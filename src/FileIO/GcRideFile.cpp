@@ -177,6 +177,9 @@ GcFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*)
 bool
 GcFileReader::writeRideFile(Context *,const RideFile *ride, QFile &file) const
 {
+    // derived series are only computed when asked for
+    ride->deriveAll();
+
     QDomDocument doc("GoldenCheetah");
     QDomElement root = doc.createElement("ride");
     doc.appendChild(root);
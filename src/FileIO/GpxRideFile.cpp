@@ -49,6 +49,9 @@ RideFile *GpxFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
 QByteArray
 GpxFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool withWatts, bool withHr, bool withCad) const
 {
+    // derived series are only computed when asked for
+    ride->deriveAll();
+
     //
     // GPX Standard defined here:  http://www.topografix.com/GPX/1/1/
     //
@@ -287,9 +287,9 @@ xdata_value_list: xdata_value | xdata_value_list ',' xdata_value
 xdata_value:
         SECS ':' number                         { jc->xdatapoint.secs = jc->JsonNumber; }
         | KM ':' number                         { jc->xdatapoint.km = jc->JsonNumber; }
-        | VALUE ':' number                      { jc->xdatapoint.number[0] = jc->JsonNumber; }
+        | VALUE ':' number                      { jc->xdatapoint.number.set(0, jc->JsonNumber); }
         | VALUES ':' '[' number_list ']'        { for(int i=0; i<jc->numberlist.count() && i<XDATA_MAXVALUES; i++)
-                                                      jc->xdatapoint.number[i]= jc->numberlist[i];
+                                                      jc->xdatapoint.number.set(i, jc->numberlist[i]);
                                                   jc->numberlist.clear(); }
         | string ':' number                     { /* ignored for future compatibility */ }
         | string ':' string                     { /* ignored for future compatibility */ }
@@ -455,6 +455,9 @@ JsonFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*
 QByteArray
 JsonFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool withWatts, bool withHr, bool withCad) const
 {
+    // derived series are only computed when asked for
+    ride->deriveAll();
+
     QByteArray out;
 
     // start of document and ride
@@ -241,6 +241,9 @@ static StyleMapPtr CreateStyleMap(const char* id) {
 bool
 KmlFileReader::writeRideFile(Context *, const RideFile * ride, QFile &file) const
 {
+    // derived series are only computed when asked for
+    ride->deriveAll();
+
     double start_lat = 0.0;
     double start_lon = 0.0;
     double end_lat = 0.0;
@@ -0,0 +1,425 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MeanMaxSearch.h"
+
+#include <cmath>
+#include <stdlib.h>
+
+//----------------------------------------------------------------------
+// Mark Rages' Algorithm for Fast Find of Mean-Max
+//----------------------------------------------------------------------
+
+/*
+
+   A Faster Mean-Max Algorithm
+
+   Premises:
+
+   1 - maximum average power for a given interval occurs at maximum
+       energy for the interval, because the interval time is fixed;
+
+   2 - the energy in an interval enclosing a smaller interval will
+       always be equal or greater than an interval;
+
+   3 - finding maximum of means is a search algorithm, so biggest
+       gains are found in reducing the search space as quickly as
+       possible.
+
+   Algorithm
+
+   note: I find it easier to reason with concrete numbers, so I will
+   describe the algorithm in terms of power and 60 second max-mean:
+
+   To find the maximum average power for one minute:
+
+   1 - integrate the watts over the entire ride to get accumulated
+       energy in joules.  This is a monotonic function (assuming watts
+       are positive).  The final value is the energy for the whole
+       ride.  Once this is done, the energy for any section can be
+       found with a single subtraction.
+
+   2 - divide the energy into overlapping two-minute sections.
+       Section one = 0:00 -> 2:00, section two = 1:00 -> 3:00, etc.
+
+       Example:  Find 60s MM in 5-minute file
+
+       +----------+----------+----------+----------+----------+
+       | minute 1 | minute 2 | minute 3 | minute 4 | minute 5 |
+       +----------+----------+----------+----------+----------+
+       |             |_MEAN_MAX_|                             |
+       +---------------------+---------------------+----------+
+       |      segment 1      |      segment 3      |
+       +----------+----------+----------+----------+----------+
+                  |      segment 2      |      segment 4      |
+                  +---------------------+---------------------+
+
+       So no matter where the MEAN_MAX segment is located in time, it
+       will be wholly contained in one segment.
+
+       In practice, it is a little faster to make the windows smaller
+       and overlap more:
+       +----------+----------+----------+----------+----------+
+       | minute 1 | minute 2 | minute 3 | minute 4 | minute 5 |
+       +----------+----------+----------+----------+----------+
+       |             |_MEAN_MAX_|                             |
+       +-------------+----------------------------------------+
+          |  segment 1  |
+          +--+----------+--+
+          |  segment 2  |
+          +--+----------+--+
+             |  segment 3  |
+             +--+----------+--+
+                |  segment 4  |
+                +--+----------+--+
+                   |  segment 5  |
+                   +--+----------+--+
+                      |  segment 6  |
+                      +--+----------+--+
+                         |  segment 7  |
+                         +--+----------+--+
+                            |  segment 8  |
+                            +--+----------+--+
+                               |  segment 9  |
+                               +-------------+
+                                            ... etc.
+
+       ( This is because whenever the actual mean max energy is
+         greater than a segment energy, we can skip the detail
+         comparison within that segment altogether.  The exact
+         tradeoff for optimum performance depends on the distribution
+         of the data.  It's a pretty shallow curve.  Values in the 1
+         minute to 1.5 minute range seem to work pretty well. )
+
+   3 - for each two minute section, subtract the accumulated energy at
+       the end of the section from the accumulated energy at the
+       beginning of the section.  That gives the energy for that section.
+
+   4 - in the first section, go second-by-second to find the maximum
+       60-second energy.  This is our candidate for 60-second energy
+
+   5 - go down the sorted list of sections.  If the energy in the next
+       section is less than the 60-second energy in the best candidate so
+       far, skip to the next section without examining it carefully,
+       because the section cannot possibly have a one-minute section with
+       greater energy.
+
+       while (section->energy > candidate) {
+         candidate=max(candidate, search(section, 60));
+         section++;
+       }
+
+   6. candidate is the mean max for 60 seconds.
+
+   Enhancements that are not implemented:
+
+     - The two-minute overlapping sections can be reused for 59
+       seconds, etc.  The algorithm will degrade to exhaustive search
+       if the looked-for interval is much smaller than the enclosing
+       interval.
+
+     - The sections can be sorted by energy in reverse order before
+       step #4.  Then the search in #5 can be terminated early, the
+       first time it fails.  In practice, the comparisons in the
+       search outnumber the saved comparisons.  But this might be a
+       useful optimization if the windows are reused per the previous
+       idea.
+
+*/
+
+static double *
+integrate_series(const QVector<double> &data)
+{
+    // would be better to do pure QT and use QVector -- but no memory leak
+    double *integrated= (double *)malloc(sizeof(double)*(data.size()+1));
+    int i;
+    double acc=0;
+
+    for (i=0; i<data.size(); i++) {
+        integrated[i]=acc;
+        acc+=data[i];
+    }
+    integrated[i]=acc;
+
+    return integrated;
+}
+
+static double
+partial_max_mean(const double *dataseries_i, int start, int end, int length, int *offset)
+{
+    int i=0;
+    double candidate=0;
+
+    int best_i=0;
+
+    for (i=start; i<(1+end-length); i++) {
+        double test_energy=dataseries_i[length+i]-dataseries_i[i];
+        if (test_energy>candidate) {
+            candidate=test_energy;
+            best_i=i;
+        }
+    }
+    if (offset) *offset=best_i;
+
+    return candidate;
+}
+
+double
+MeanMaxSearch::dividedMaxMean(const double *dataseries_i, int datalength, int length, int *offset)
+{
+    int shift=length;
+
+    //if sorting data the following is an important speedup hack
+    if (shift>180) shift=180;
+
+    int window_length=length+shift;
+
+    if (window_length>datalength) window_length=datalength;
+
+    // put down as many windows as will fit without overrunning data
+    int start=0;
+    int end=0;
+    double energy=0;
+
+    double candidate=0;
+    int this_offset=0;
+
+    for (start=0; start+window_length<=datalength; start+=shift) {
+        end=start+window_length;
+        energy=dataseries_i[end]-dataseries_i[start];
+
+        if (energy < candidate) {
+          continue;
+        }
+        double window_mm=partial_max_mean(dataseries_i, start, end, length, &this_offset);
+
+        if (window_mm>candidate) {
+            candidate=window_mm;
+            if (offset) *offset=this_offset;
+        }
+    }
+
+    // if the overlapping windows don't extend to the end of the data,
+    // let's tack another one on at the end
+
+    if (end<datalength) {
+        start=datalength-window_length;
+        end=datalength;
+        energy=dataseries_i[end]-dataseries_i[start];
+
+        if (energy >= candidate) {
+
+            double window_mm=partial_max_mean(dataseries_i, start, end, length, &this_offset);
+
+            if (window_mm>candidate) {
+                candidate=window_mm;
+                if (offset) *offset=this_offset;
+            }
+        }
+    }
+
+    return candidate;
+}
+
+int
+MeanMaxSearch::nextLength(int i)
+{
+    if (i<120) return i+1;
+    else if (i<600) return i+2;
+    else if (i<1200) return i+5;
+    else if (i<3600) return i+20;
+    else if (i<7200) return i+120;
+    else return i+300;
+}
+
+void
+MeanMaxSearch::legacy(const QVector<double> &data, QVector<double> &energy)
+{
+    double *dataseries_i = integrate_series(data);
+
+    for (int i=1; i<data.size(); i=nextLength(i))
+        energy[i] = dividedMaxMean(dataseries_i, data.size(), i, NULL);
+
+    free(dataseries_i);
+}
+
+//----------------------------------------------------------------------
+// Exact Mean-Max search
+//----------------------------------------------------------------------
+//
+// Works like the search above, but:
+//
+// 1 - when the data are all integers (most series) the running total
+//     is kept as 64 bit integers rather than doubles. The totals are
+//     exact either way, since they're well within the 53 bits a double
+//     holds exactly, so the energies are the same.
+//
+// 2 - the best window found for one length is grown to seed the
+//     candidate for the next, since the best window a little longer
+//     is rarely anywhere else. So almost all sections are skipped
+//     without being examined carefully right from the start.
+//
+// 3 - the bests can never grow faster than they already have: any
+//     window of length L splits into windows of length L-s and s, so
+//     the best for L is at most best(L-s) + best(s). Both are known,
+//     since the step s between lengths is always a length we searched.
+//     Once the candidate reaches that bound the length is settled and
+//     the rest of the sections are not looked at, often that is as
+//     soon as the seed. This is only done with integer totals, where
+//     the sums are exact.
+//
+// 4 - the search within a section is just a maximum, which the
+//     compiler can vectorise. We only go back to find where it was
+//     when it is a new best.
+//
+// Skipping sections is only safe when the data are never negative, so
+// a section's energy is at least that of any window in it; otherwise
+// every window is examined. Where the data are never negative the
+// bests are identical to the search above (it is also exact), where
+// they are (the delta series) these are the true maximums.
+//
+template <class T>
+static inline T
+windowMax(const T *integrated, int start, int last, int length)
+{
+    T best = integrated[start+length] - integrated[start];
+    for (int i=start+1; i<=last; i++) {
+        T test = integrated[i+length] - integrated[i];
+        best = test > best ? test : best;
+    }
+    return best;
+}
+
+template <class T>
+static void
+exactMeanMax(const T *integrated, int datalength, bool positive, bool bounded, QVector<T> &energy)
+{
+    int offset = 0; // of the last best
+    int previous = 0; // length
+
+    for (int length=1; length<datalength; previous=length, length=MeanMaxSearch::nextLength(length)) {
+
+        // never less than zero, as before
+        T candidate = 0;
+
+        if (!positive) {
+
+            // look at every window
+            T best = windowMax(integrated, 0, datalength-length, length);
+            if (best > candidate) candidate = best;
+
+        } else {
+
+            // grow the last best window, in whichever direction is best
+            int grow = length - previous;
+            int first = offset - grow < 0 ? 0 : offset - grow;
+            int last = offset > datalength-length ? datalength-length : offset;
+            for (int i=first; i<=last; i++) {
+                T seed = integrated[i+length] - integrated[i];
+                if (seed > candidate) {
+                    candidate = seed;
+                    offset = i;
+                }
+            }
+
+            // as good as it can possibly be ?
+            bool settled = false;
+            if (bounded && previous) {
+                T bound = energy[previous] + energy[grow];
+                settled = candidate >= bound;
+            }
+
+            // same sections as divided_max_mean
+            int shift = length > 180 ? 180 : length;
+            int window_length = length + shift;
+            if (window_length > datalength) window_length = datalength;
+
+            int start = 0, end = 0;
+            bool tail = false;
+            while (!settled && !tail) {
+
+                if (start+window_length <= datalength) {
+                    end = start + window_length;
+                } else {
+                    // tack another on at the end if needed
+                    if (end >= datalength) break;
+                    start = datalength - window_length;
+                    end = datalength;
+                    tail = true;
+                }
+
+                // can't contain anything better
+                if (integrated[end] - integrated[start] > candidate) {
+
+                    T best = windowMax(integrated, start, end-length, length);
+                    if (best > candidate) {
+                        candidate = best;
+
+                        // where was it ?
+                        for (int i=start; i<=end-length; i++) {
+                            if (integrated[i+length] - integrated[i] == best) {
+                                offset = i;
+                                break;
+                            }
+                        }
+
+                        if (bounded && previous)
+                            settled = candidate >= energy[previous] + energy[grow];
+                    }
+                }
+                start += shift;
+            }
+        }
+        energy[length] = candidate;
+    }
+}
+
+void
+MeanMaxSearch::exact(const QVector<double> &data, QVector<double> &energy)
+{
+    int datalength = data.size();
+
+    // what kind of data do we have ?
+    bool integers = datalength < (1<<22);
+    bool positive = true;
+    for (int i=0; i<datalength; i++) {
+        if (data[i] < 0) positive = false;
+        if (data[i] != floor(data[i]) || fabs(data[i]) >= 2147483648.0) integers = false;
+    }
+
+    if (integers) {
+
+        QVector<qint64> integrated(datalength+1);
+        qint64 acc = 0;
+        for (int i=0; i<datalength; i++) {
+            integrated[i] = acc;
+            acc += qint64(data[i]);
+        }
+        integrated[datalength] = acc;
+
+        QVector<qint64> best(energy.size());
+        exactMeanMax(integrated.constData(), datalength, positive, true, best);
+        for (int i=0; i<best.size(); i++) energy[i] = double(best[i]);
+
+    } else {
+
+        double *integrated = integrate_series(data);
+        exactMeanMax(integrated, datalength, positive, false, energy);
+        free(integrated);
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_MeanMaxSearch_h
+#define _GC_MeanMaxSearch_h
+
+#include <QVector>
+
+// The searches for the best energy over each window length in a series
+// of samples, as used by RideFileCache to compute the mean maximals. The
+// data are one value per sample, energy[i] is set to the best sum over
+// any i consecutive samples for each length searched (see nextLength),
+// and must have room for data.size() values.
+
+namespace MeanMaxSearch
+{
+    // the window lengths searched, we increment to limit the
+    // search scope for longer durations
+    int nextLength(int length);
+
+    // Mark Rages' search for one window length over the running total
+    // of datalength samples (integrated[i] is the sum before sample i)
+    double dividedMaxMean(const double *integrated, int datalength, int length, int *offset);
+
+    // the original search, a dividedMaxMean for each length
+    void legacy(const QVector<double> &data, QVector<double> &energy);
+
+    // the same bests found quicker, and the true bests where the
+    // data can be negative (the delta series)
+    void exact(const QVector<double> &data, QVector<double> &energy);
+};
+
+#endif
@@ -0,0 +1,449 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "NativeRideFile.h"
+#include "Context.h"
+#include "Athlete.h"
+
+#include <QDataStream>
+#include <QFileInfo>
+#include <QTemporaryFile>
+#include <string.h>
+
+// the recorded series we store, derived series are always
+// recalculated when the ride is opened so we don't keep them
+static const RideFile::SeriesType nativeSeries[] = {
+    RideFile::secs, RideFile::cad, RideFile::hr, RideFile::km, RideFile::kph,
+    RideFile::nm, RideFile::watts, RideFile::alt, RideFile::lon, RideFile::lat,
+    RideFile::headwind, RideFile::slope, RideFile::temp, RideFile::lrbalance,
+    RideFile::lte, RideFile::rte, RideFile::lps, RideFile::rps,
+    RideFile::lpco, RideFile::rpco, RideFile::lppb, RideFile::rppb,
+    RideFile::lppe, RideFile::rppe, RideFile::lpppb, RideFile::rpppb,
+    RideFile::lpppe, RideFile::rpppe, RideFile::smo2, RideFile::thb,
+    RideFile::rvert, RideFile::rcad, RideFile::rcontact, RideFile::tcore,
+    RideFile::interval, RideFile::none
+};
+
+static const char nativeMagic[4] = { 'G', 'C', 'B', 'A' };
+
+static qint64 align8(qint64 x) { return (x + 7) & ~qint64(7); }
+
+NativeRideFileMap::NativeRideFileMap(QFile *file, uchar *map, unsigned int samples) :
+    secsOffset(0), kmOffset(0), file(file), map(map), samples_(samples)
+{
+    for (int i=0; i<RideFile::none; i++) columns[i] = NULL;
+}
+
+NativeRideFileMap::~NativeRideFileMap()
+{
+    file->unmap(map);
+    file->close();
+    delete file;
+}
+
+bool
+NativeRideFileMap::stored(RideFile::SeriesType series)
+{
+    for (int s=0; nativeSeries[s] != RideFile::none; s++)
+        if (nativeSeries[s] == series) return true;
+    return false;
+}
+
+void
+NativeRideFileMap::column(RideFile::SeriesType series, double *values) const
+{
+    const double *from = columns[series];
+    if (from == NULL) {
+        double value = RideFilePoint().value(series);
+        for (unsigned int i=0; i<samples_; i++) values[i] = value;
+        return;
+    }
+
+    double offset = series == RideFile::secs ? secsOffset : (series == RideFile::km ? kmOffset : 0);
+    if (offset) for (unsigned int i=0; i<samples_; i++) values[i] = from[i] - offset;
+    else memcpy(values, from, samples_ * sizeof(double));
+}
+
+void
+NativeRideFileMap::read(RideFile *ride) const
+{
+    for (unsigned int i=0; i<samples_; i++) {
+        RideFilePoint p;
+        for (int s=0; nativeSeries[s] != RideFile::none; s++)
+            if (columns[nativeSeries[s]]) p.setValue(nativeSeries[s], columns[nativeSeries[s]][i]);
+        ride->appendPoint(p);
+    }
+}
+
+RideFile *
+NativeFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
+{
+    return openSeries(file, errors, NULL, NULL);
+}
+
+RideFile *
+NativeFileReader::openSeries(QFile &file, QStringList &errors, const QList<RideFile::SeriesType> *series,
+                             const QStringList *xdataSeries) const
+{
+    // the ride keeps the mapping, so it needs its own file
+    QFile *mapped = new QFile(file.fileName());
+    if (!mapped->open(QFile::ReadOnly)) {
+        errors << "unable to open file" + file.fileName();
+        delete mapped;
+        return NULL;
+    }
+
+    // map the whole file, only the pages we touch will be read
+    qint64 size = mapped->size();
+    uchar *map = size >= qint64(sizeof(NativeRideFileHeader)) ? mapped->map(0, size) : NULL;
+    if (map == NULL) {
+        errors << "unable to map file" + file.fileName();
+        delete mapped;
+        return NULL;
+    }
+
+    // check its a file we can read
+    const NativeRideFileHeader *head = reinterpret_cast<const NativeRideFileHeader*>(map);
+    qint64 dirEnd = sizeof(NativeRideFileHeader) + qint64(head->columns) * sizeof(NativeRideFileColumn);
+    if (memcmp(head->magic, nativeMagic, 4) || head->version != NativeRideFileVersion ||
+        dirEnd > size || head->metaOffset < dirEnd || head->metaSize < 0 ||
+        head->metaOffset + head->metaSize > size) {
+        errors << "bad header in file" + file.fileName();
+        mapped->unmap(map);
+        delete mapped;
+        return NULL;
+    }
+
+    // from here the map owns the file
+    NativeRideFileMap *columns = new NativeRideFileMap(mapped, map, head->samples);
+    RideFile *ride = new RideFile();
+
+    // locate the columns, the data present flags are as
+    // they were when written, before any samples are read
+    const NativeRideFileColumn *dir = reinterpret_cast<const NativeRideFileColumn*>(map + sizeof(NativeRideFileHeader));
+    for (unsigned int i=0; i<head->columns; i++) {
+        if (dir[i].series < 0 || dir[i].series >= RideFile::none || !NativeRideFileMap::stored(RideFile::SeriesType(dir[i].series)) ||
+            dir[i].offset < dirEnd || dir[i].offset + qint64(head->samples) * qint64(sizeof(double)) > size) {
+            errors << "bad column in file" + file.fileName();
+            delete ride;
+            delete columns;
+            return NULL;
+        }
+        RideFile::SeriesType x = static_cast<RideFile::SeriesType>(dir[i].series);
+        columns->columns[x] = reinterpret_cast<const double*>(map + dir[i].offset);
+        ride->setDataPresent(x, dir[i].present != 0);
+    }
+
+    // leave out the columns nobody asked for, but remember they are there
+    if (series) {
+        for (int s=0; nativeSeries[s] != RideFile::none; s++) {
+            RideFile::SeriesType x = nativeSeries[s];
+            if (columns->columns[x] && x != RideFile::secs && x != RideFile::km && x != RideFile::interval && !series->contains(x)) {
+                columns->columns[x] = NULL;
+                ride->partial_ = true;
+            }
+        }
+    }
+
+    // metadata
+    QByteArray meta = QByteArray::fromRawData(reinterpret_cast<const char*>(map + head->metaOffset), head->metaSize);
+    QDataStream in(meta);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    QDateTime startTime;
+    double recIntSecs;
+    QString deviceType, fileFormat, id;
+    in >> startTime >> recIntSecs >> deviceType >> fileFormat >> id;
+    ride->setStartTime(startTime);
+    ride->setRecIntSecs(recIntSecs);
+    ride->setDeviceType(deviceType);
+    ride->setFileFormat(fileFormat);
+    ride->setId(id);
+
+    QMap<QString,QString> tags;
+    in >> tags >> ride->metricOverrides;
+    QMapIterator<QString,QString> t(tags);
+    while (t.hasNext()) {
+        t.next();
+        ride->setTag(t.key(), t.value());
+    }
+
+    qint32 count;
+    in >> count;
+    for (int i=0; i<count && in.status() == QDataStream::Ok; i++) {
+        qint32 type;
+        double start, stop;
+        QString name;
+        in >> type >> start >> stop >> name;
+        ride->addInterval(static_cast<RideFileInterval::IntervalType>(type), start, stop, name);
+    }
+
+    in >> count;
+    for (int i=0; i<count && in.status() == QDataStream::Ok; i++) {
+        double start;
+        qint32 value;
+        QString name;
+        in >> start >> value >> name;
+        ride->addCalibration(start, value, name);
+    }
+
+    in >> count;
+    for (int i=0; i<count && in.status() == QDataStream::Ok; i++) {
+        RideFilePoint p;
+        in >> p.secs >> p.watts >> p.cad >> p.hr;
+        ride->appendReference(p);
+    }
+
+    in >> count;
+    for (int i=0; i<count && in.status() == QDataStream::Ok; i++) {
+        XDataSeries *xseries = new XDataSeries();
+        QList<qint32> types;
+        qint32 points, length;
+        in >> xseries->name >> xseries->valuename >> xseries->unitname >> types >> points >> length;
+        foreach(qint32 type, types) xseries->valuetype << static_cast<RideFile::SeriesType>(type);
+
+        if (xdataSeries && !xdataSeries->contains(xseries->name)) {
+
+            // keep the definition but skip the samples
+            in.skipRawData(length);
+            ride->partial_ = true;
+
+        } else {
+
+            int values = qMin(xseries->valuename.count(), XDATA_MAXVALUES);
+            for (int j=0; j<points && in.status() == QDataStream::Ok; j++) {
+                XDataPoint *p = new XDataPoint();
+                in >> p->secs >> p->km;
+                for (int k=0; k<values; k++) {
+                    double number;
+                    QString string;
+                    in >> number >> string;
+                    p->number.set(k, number);
+                    p->string.set(k, string);
+                }
+                xseries->datapoints << p;
+            }
+        }
+        ride->addXData(xseries->name, xseries);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        errors << "bad metadata in file" + file.fileName();
+        delete ride;
+        delete columns;
+        return NULL;
+    }
+
+    // RideFileFactory drags the samples and intervals back to start
+    // from zero, we do that here so it needn't read the samples in
+    if (head->samples) {
+        if (columns->columns[RideFile::secs]) columns->secsOffset = columns->columns[RideFile::secs][0];
+        if (columns->columns[RideFile::km]) columns->kmOffset = columns->columns[RideFile::km][0];
+        foreach(RideFileInterval *i, ride->intervals()) {
+            i->start -= columns->secsOffset;
+            i->stop -= columns->secsOffset;
+        }
+    }
+
+    // without intervals RideFileFactory fills them in from the
+    // samples, which only does anything if they were marked
+    if (ride->intervals().empty() && columns->columns[RideFile::interval]) {
+        columns->secsOffset = columns->kmOffset = 0;
+        columns->read(ride);
+        delete columns;
+        return ride;
+    }
+
+    // the samples are read in when first needed
+    ride->setMapped(columns);
+    return ride;
+}
+
+bool
+NativeFileReader::writeRideFile(Context *, const RideFile *ride, QFile &file) const
+{
+    return writeNative(ride, file, 0, 0);
+}
+
+bool
+NativeFileReader::writeNative(const RideFile *ride, QFile &file, qint64 sourceSize, qint64 sourceModified)
+{
+    // which columns are we going to write?
+    QVector<RideFile::SeriesType> present;
+    if (ride->dataPoints().count()) {
+        for (int s=0; nativeSeries[s] != RideFile::none; s++)
+            if (nativeSeries[s] == RideFile::secs || ride->isDataPresent(nativeSeries[s]))
+                present << nativeSeries[s];
+    }
+
+    // metadata
+    QByteArray meta;
+    QDataStream out(&meta, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+
+    out << ride->startTime() << ride->recIntSecs() << ride->deviceType() << ride->fileFormat() << ride->id();
+    out << ride->tags() << ride->metricOverrides;
+
+    out << qint32(ride->intervals().count());
+    foreach(RideFileInterval *i, ride->intervals())
+        out << qint32(i->type) << i->start << i->stop << i->name;
+
+    out << qint32(ride->calibrations().count());
+    foreach(RideFileCalibration *c, ride->calibrations())
+        out << c->start << qint32(c->value) << c->name;
+
+    out << qint32(ride->referencePoints().count());
+    foreach(RideFilePoint *p, ride->referencePoints())
+        out << p->secs << p->watts << p->cad << p->hr;
+
+    QMap<QString,XDataSeries*> &xdata = const_cast<RideFile*>(ride)->xdata();
+    out << qint32(xdata.count());
+    foreach(XDataSeries *series, xdata) {
+        QList<qint32> types;
+        foreach(RideFile::SeriesType type, series->valuetype) types << qint32(type);
+
+        // samples are length prefixed so readers can skip them
+        QByteArray samples;
+        QDataStream sout(&samples, QIODevice::WriteOnly);
+        sout.setVersion(QDataStream::Qt_4_6);
+
+        int values = qMin(series->valuename.count(), XDATA_MAXVALUES);
+        foreach(XDataPoint *p, series->datapoints) {
+            sout << p->secs << p->km;
+            for (int k=0; k<values; k++) sout << p->number[k] << p->string[k];
+        }
+
+        out << series->name << series->valuename << series->unitname << types
+            << qint32(series->datapoints.count()) << qint32(samples.size());
+        out.writeRawData(samples.constData(), samples.size());
+    }
+
+    // layout
+    NativeRideFileHeader head;
+    memcpy(head.magic, nativeMagic, 4);
+    head.version = NativeRideFileVersion;
+    head.samples = ride->dataPoints().count();
+    head.columns = present.count();
+
+    QVector<NativeRideFileColumn> dir(present.count());
+    qint64 offset = align8(sizeof(NativeRideFileHeader) + present.count() * sizeof(NativeRideFileColumn));
+    for (int i=0; i<present.count(); i++) {
+        dir[i].series = present[i];
+        dir[i].present = ride->isDataPresent(present[i]) ? 1 : 0;
+        dir[i].offset = offset;
+        offset += qint64(head.samples) * sizeof(double);
+    }
+    head.metaOffset = offset;
+    head.metaSize = meta.size();
+    head.sourceSize = sourceSize;
+    head.sourceModified = sourceModified;
+
+    // now write it
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.resize(0);
+
+    file.write(reinterpret_cast<const char*>(&head), sizeof(head));
+    file.write(reinterpret_cast<const char*>(dir.constData()), dir.count() * sizeof(NativeRideFileColumn));
+    qint64 pad = align8(file.pos()) - file.pos();
+    if (pad) file.write(QByteArray(pad, '\0'));
+
+    QVector<double> column(head.samples);
+    foreach(RideFile::SeriesType series, present) {
+        for (unsigned int i=0; i<head.samples; i++) column[i] = ride->dataPoints()[i]->value(series);
+        file.write(reinterpret_cast<const char*>(column.constData()), column.count() * sizeof(double));
+    }
+    file.write(meta);
+
+    bool ok = (file.error() == QFile::NoError);
+    file.close();
+    return ok;
+}
+
+QString
+NativeFileReader::cacheFileFor(Context *context, QString filename)
+{
+    if (context == NULL || context->athlete == NULL) return "";
+    return cacheFileFor(context->athlete->home, filename);
+}
+
+QString
+NativeFileReader::cacheFileFor(AthleteDirectoryStructure *home, QString filename)
+{
+    // only native activities in the activities folder
+    QFileInfo info(filename);
+    if (info.suffix().toLower() != "json" ||
+        info.canonicalPath() != home->activities().canonicalPath())
+        return "";
+
+    return home->cache().canonicalPath() + "/" + info.baseName() + ".gcb";
+}
+
+void
+NativeFileReader::sourceStamp(QString filename, qint64 &size, qint64 &modified)
+{
+    QFileInfo info(filename);
+    size = info.size();
+    modified = info.lastModified().toMSecsSinceEpoch();
+}
+
+bool
+NativeFileReader::isCurrent(QString filename, QString cachefile)
+{
+    // timestamps alone can't be trusted, a restored backup or a copy
+    // from another machine can be older than the copy we made, so it
+    // must have been made from a file of exactly this size and time
+    QFile file(cachefile);
+    if (!file.open(QFile::ReadOnly)) return false;
+
+    NativeRideFileHeader head;
+    bool read = file.read(reinterpret_cast<char*>(&head), sizeof(head)) == qint64(sizeof(head));
+    file.close();
+    if (!read || memcmp(head.magic, nativeMagic, 4) || head.version != NativeRideFileVersion) return false;
+
+    qint64 size, modified;
+    sourceStamp(filename, size, modified);
+    return head.sourceSize == size && head.sourceModified == modified;
+}
+
+bool
+NativeFileReader::writeCache(Context *, const RideFile *ride, QString cachefile,
+                             qint64 sourceSize, qint64 sourceModified)
+{
+    // write alongside then swap it in, so readers
+    // never see a partially written file
+    QTemporaryFile tmp(cachefile + ".XXXXXX");
+    tmp.setAutoRemove(false);
+    if (!tmp.open()) return false;
+    QString tmpname = tmp.fileName();
+    tmp.close();
+
+    QFile file(tmpname);
+    if (!writeNative(ride, file, sourceSize, sourceModified)) {
+        QFile::remove(tmpname);
+        return false;
+    }
+
+    // an open ride may still have the old one mapped, on some
+    // platforms it can't be replaced until it lets go of it
+    QFile::remove(cachefile);
+    if (!QFile::rename(tmpname, cachefile)) {
+        QFile::remove(tmpname);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _NativeRideFile_h
+#define _NativeRideFile_h
+#include "GoldenCheetah.h"
+
+#include "RideFile.h"
+
+// The native binary activity format (.gcb) holds exactly the same
+// data as the GoldenCheetah .json format, but stores the samples
+// column-wise as raw doubles so it can be memory mapped and read
+// without any parsing.
+//
+// A .gcb copy of every .json in the athlete's activities folder is
+// kept in the cache folder and is used in preference to the .json
+// whenever it was made from the .json as it is now. The .json is
+// always the master copy, the .gcb is internal to RideFileFactory
+// and is not offered as an import or export format.
+//
+// The samples are not read in when the file is opened, the ride
+// keeps the file mapped until something asks for its dataPoints().
+// Until then RideFile::series() is served from the mapped columns.
+//
+static const unsigned int NativeRideFileVersion = 3;
+// revision history:
+// version  date         description
+// 1        16-Oct-17    Initial - header, column directory, columns, metadata
+// 2        16-Oct-17    XDATA samples length prefixed so they can be skipped
+// 3        16-Oct-17    Source size and modified time, data present flags
+
+// The file has a binary format:
+// 1 x Header - describing the version and layout
+// n x Column directory entries - series and offset of each column
+// n x Columns - header.samples doubles, aligned on 8 bytes
+// 1 x Metadata - first class variables, tags, intervals, calibrations,
+//                references, overrides and xdata as a QDataStream
+//
+// Like the .cpx files these are local caches so we write everything
+// in local format and do not worry about endianness.
+struct NativeRideFileHeader {
+
+    char magic[4];              // "GCBA"
+    unsigned int version;       // NativeRideFileVersion
+    unsigned int samples;       // number of samples in each column
+    unsigned int columns;       // number of column directory entries
+    qint64 metaOffset;          // where the metadata block starts
+    qint64 metaSize;            // and how long it is
+    qint64 sourceSize;          // size of the .json it was made from
+    qint64 sourceModified;      // and when it was modified, msecs since epoch
+};
+
+struct NativeRideFileColumn {
+
+    int series;                 // RideFile::SeriesType
+    int present;                // RideFile::isDataPresent() when written
+    qint64 offset;              // where the column starts
+};
+
+class Context;
+class AthleteDirectoryStructure;
+
+// An open .gcb whose samples have not been read in yet, it belongs
+// to the RideFile it was opened for, see RideFile::loadPoints()
+class NativeRideFileMap
+{
+    public:
+        NativeRideFileMap(QFile *file, uchar *map, unsigned int samples);
+        ~NativeRideFileMap();
+
+        int samples() const { return samples_; }
+
+        // can this series be read from the columns, i.e. is it one we store?
+        static bool stored(RideFile::SeriesType series);
+
+        // a column as it will be once the samples are read in, i.e.
+        // dragged back to start from zero, and defaulted if not stored
+        void column(RideFile::SeriesType series, double *values) const;
+
+        // append the samples to the ride as stored, not dragged back
+        void read(RideFile *ride) const;
+
+        // located by NativeFileReader, NULL if not stored or not wanted
+        const double *columns[RideFile::none];
+        double secsOffset, kmOffset;
+
+    private:
+        QFile *file;
+        uchar *map;
+        unsigned int samples_;
+};
+
+struct NativeFileReader : public RideFileReader {
+
+    virtual RideFile *openRideFile(QFile &file, QStringList &errors, QList<RideFile*>* = 0) const;
+
+    // only load the listed series and XDATA, NULL means all of them
+    RideFile *openSeries(QFile &file, QStringList &errors, const QList<RideFile::SeriesType> *series,
+                         const QStringList *xdata) const;
+    bool writeRideFile(Context *context, const RideFile *ride, QFile &file) const;
+    bool hasWrite() const { return true; }
+
+    // as above, recording the activity it was made from
+    static bool writeNative(const RideFile *ride, QFile &file, qint64 sourceSize, qint64 sourceModified);
+
+    // the binary copy of an activity in the athlete cache, returns
+    // an empty string if the file is not a native activity (.json)
+    static QString cacheFileFor(Context *context, QString filename);
+    static QString cacheFileFor(AthleteDirectoryStructure *home, QString filename);
+
+    // was the binary copy made from the activity as it is now?
+    static bool isCurrent(QString filename, QString cachefile);
+
+    // the size and modified time recorded in a binary copy, taken
+    // before the activity is read so a later change is not missed
+    static void sourceStamp(QString filename, qint64 &size, qint64 &modified);
+
+    // write a binary copy to the cache, safely replacing any old one
+    static bool writeCache(Context *context, const RideFile *ride, QString cachefile,
+                           qint64 sourceSize, qint64 sourceModified);
+};
+
+#endif // _NativeRideFile_h
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "PDEstimateStore.h"
+#include "RideFileCache.h"
+#include "Context.h"
+#include "Athlete.h"
+#include "RideItem.h"
+
+#include <QDir>
+#include <QFile>
+#include <QDataStream>
+
+// bump when the layout of the saved weeks changes, or
+// the models or the way they are fitted does
+static const quint32 storeVersion = 1;
+
+PDEstimateStore::PDEstimateStore(Context *context) : context(context), loaded(false)
+{
+}
+
+bool
+PDEstimateStore::find(QDate begin, quint32 print, Week &week)
+{
+    if (!loaded) load();
+
+    QMap<QDate, Week>::const_iterator it = weeks.constFind(begin);
+    if (it == weeks.constEnd() || it.value().print == 0 || it.value().print != print) return false;
+
+    week = it.value();
+    return true;
+}
+
+void
+PDEstimateStore::update(const QMap<QDate, Week> &refreshed)
+{
+    if (!loaded) load();
+
+    // only write it if something changed
+    bool changed = refreshed.count() != weeks.count();
+    QMap<QDate, Week>::const_iterator it = refreshed.constBegin();
+    for (; !changed && it != refreshed.constEnd(); ++it) {
+        QMap<QDate, Week>::const_iterator was = weeks.constFind(it.key());
+        if (was == weeks.constEnd() || was.value().print != it.value().print ||
+            was.value().window != it.value().window) changed = true;
+    }
+
+    weeks = refreshed;
+    if (changed) save();
+}
+
+//
+// SAVED WEEKS
+//
+static QDataStream &operator<<(QDataStream &out, const PDEstimate &est)
+{
+    out << est.from << est.to << est.model << est.WPrime << est.CP << est.FTP << est.PMax << est.EI
+        << est.wpk << est.parameters;
+    return out;
+}
+
+static QDataStream &operator>>(QDataStream &in, PDEstimate &est)
+{
+    in >> est.from >> est.to >> est.model >> est.WPrime >> est.CP >> est.FTP >> est.PMax >> est.EI
+       >> est.wpk >> est.parameters;
+    return in;
+}
+
+QString
+PDEstimateStore::fileName()
+{
+    return context->athlete->home->cache().canonicalPath() + "/bests/estimates.bests";
+}
+
+void
+PDEstimateStore::load()
+{
+    loaded = true;
+    weeks.clear();
+
+    QFile file(fileName());
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    QDataStream in(&file);
+    quint32 version, cpxversion, count;
+    in >> version >> cpxversion >> count;
+
+    // out of date, start again
+    if (version != storeVersion || cpxversion != RideFileCacheVersion) return;
+
+    for (quint32 i=0; i<count && in.status() == QDataStream::Ok; i++) {
+        QDate begin;
+        Week week;
+        in >> begin >> week.print >> week.window >> week.bests >> week.wpk >> week.estimates;
+        weeks.insert(begin, week);
+    }
+
+    if (in.status() != QDataStream::Ok) weeks.clear();
+}
+
+void
+PDEstimateStore::save()
+{
+    QDir cache = context->athlete->home->cache();
+    if (!cache.exists("bests")) cache.mkdir("bests");
+
+    QFile file(fileName());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return;
+
+    QDataStream out(&file);
+    out << quint32(storeVersion) << quint32(RideFileCacheVersion) << quint32(weeks.count());
+
+    QMap<QDate, Week>::const_iterator it = weeks.constBegin();
+    for (; it != weeks.constEnd(); ++it)
+        out << it.key() << it.value().print << it.value().window << it.value().bests
+            << it.value().wpk << it.value().estimates;
+}
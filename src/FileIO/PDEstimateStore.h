@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_PDEstimateStore_h
+#define _GC_PDEstimateStore_h 1
+#include "GoldenCheetah.h"
+
+#include "PDModel.h"
+
+#include <QDate>
+#include <QList>
+#include <QMap>
+#include <QVector>
+
+class Context;
+class RideItem;
+
+//
+// The PD model estimates are fitted to the bests of a rolling 12 weeks,
+// a week at a time from the first activity with power. Rebuilding them
+// means reading the .cpx of every activity and fitting every model for
+// every week, so the weekly bests and the estimates fitted to each
+// window are kept in cache/bests and only redone when they change.
+//
+// Each week carries a fingerprint of its activities, so a week is only
+// read again when an activity in it is added, changed or deleted. Each
+// week also carries a fingerprint of the 12 weeks its estimates were
+// fitted to, so the models are only fitted again for the windows that
+// have one of those weeks in them.
+//
+class PDEstimateStore
+{
+    public:
+        PDEstimateStore(Context *context);
+
+        class Week
+        {
+            public:
+                Week() : print(0), window(0) {}
+
+                quint32 print;  // activities in the week, 0 if a .cpx was missing
+                quint32 window; // the weeks the estimates were fitted to
+                QVector<float> bests, wpk;
+                QList<PDEstimate> estimates;
+        };
+
+        // the week starting on begin from the last refresh, if unchanged
+        bool find(QDate begin, quint32 print, Week &week);
+
+        // the weeks from this refresh replace those held, and are saved
+        void update(const QMap<QDate, Week> &refreshed);
+
+    private:
+        QString fileName();
+        void load();
+        void save();
+
+        Context *context;
+        bool loaded;
+        QMap<QDate, Week> weeks;
+};
+
+#endif // _GC_PDEstimateStore_h
@@ -419,7 +419,7 @@ void HrmRideFile(RideFile *rideFile, RideFile*gpxresult, bool haveGPX, XDataSeri
 	  XDataPoint *p_hrv = new XDataPoint();
 	  hrv_time += hrm/1000.0;
 	  p_hrv->secs = hrv_time;
-	  p_hrv->number[0] = hrm;
+	  p_hrv->number.set(0, hrm);
 	  hrvXdata->datapoints.append(p_hrv);
 	  hr = 60000.0/hrm;
 	} else {
@@ -342,9 +342,9 @@ PwxFileReader::PwxFromDomDoc(QDomDocument doc, QStringList&) const
                     XDataPoint *p = new XDataPoint();
                     p->secs = rtime;
                     p->km = rdist;
-                    p->number[0] = (add.km > rdist) ? 1 : 0;
-                    p->number[1] = deltaSecs;
-                    p->number[2] = round(add.cad * deltaSecs / 60.0);
+                    p->number.set(0, (add.km > rdist) ? 1 : 0);
+                    p->number.set(1, deltaSecs);
+                    p->number.set(2, round(add.cad * deltaSecs / 60.0));
                     swimXdata->datapoints.append(p);
                 }
 
@@ -600,6 +600,9 @@ PwxFileReader::PwxFromDomDoc(QDomDocument doc, QStringList&) const
 bool
 PwxFileReader::writeRideFile(Context *context, const RideFile *ride, QFile &file) const
 {
+    // derived series are only computed when asked for
+    ride->deriveAll();
+
     QDomText text; // used all over
     QDomDocument doc;
     QDomProcessingInstruction hdr = doc.createProcessingInstruction("xml","version=\"1.0\"");
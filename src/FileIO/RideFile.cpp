@@ -19,6 +19,7 @@
  */
 
 #include "RideFile.h"
+#include "NativeRideFile.h"
 #include "FilterHRV.h"
 #include "WPrime.h"
 #include "Athlete.h"
@@ -28,10 +29,13 @@
 #include "Settings.h"
 #include "Colors.h"
 #include "Units.h"
+#include "SeriesKernels.h"
 
 #include <QtXml/QtXml>
+#include <QAtomicInt>
 #include <algorithm> // for std::lower_bound
 #include <assert.h>
+#include <string.h>
 #ifdef Q_CC_MSVC
 #include <float.h>
 #endif
@@ -65,9 +69,11 @@ const QChar deltaChar(0x0394);
 RideFile::RideFile(const QDateTime &startTime, double recIntSecs) :
             wstale(true), startTime_(startTime), recIntSecs_(recIntSecs),
             deviceType_("unknown"), data(NULL), wprime_(NULL), 
-            weight_(0), totalCount(0), totalTemp(0), dstale(true)
+            weight_(0), totalCount(0), totalTemp(0), dstale(AllDerivedSeries), deriveLock(QMutex::Recursive), partial_(false),
+            mapLock(QMutex::Recursive), mapped_(0), map_(NULL), loading_(false)
 {
     command = new RideFileCommand(this);
+    for (int i=0; i<none; i++) columnBuilt_[i] = -1; // see series()
 
     minPoint = new RideFilePoint();
     maxPoint = new RideFilePoint();
@@ -80,7 +86,8 @@ RideFile::RideFile(const QDateTime &startTime, double recIntSecs) :
 // and we want to get special fields and ESPECIALLY "CP" and "Weight"
 RideFile::RideFile(RideFile *p) :
     wstale(true), recIntSecs_(p->recIntSecs_), deviceType_(p->deviceType_), data(NULL), wprime_(NULL), 
-    weight_(p->weight_), totalCount(0), dstale(true)
+    weight_(p->weight_), totalCount(0), dstale(AllDerivedSeries), deriveLock(QMutex::Recursive), partial_(p->partial_),
+    mapLock(QMutex::Recursive), mapped_(0), map_(NULL), loading_(false)
 {
     startTime_ = p->startTime_;
     tags_ = p->tags_;
@@ -92,6 +99,7 @@ RideFile::RideFile(RideFile *p) :
     context = p->context;
 
     command = new RideFileCommand(this);
+    for (int i=0; i<none; i++) columnBuilt_[i] = -1; // see series()
     minPoint = new RideFilePoint();
     maxPoint = new RideFilePoint();
     avgPoint = new RideFilePoint();
@@ -101,9 +109,11 @@ RideFile::RideFile(RideFile *p) :
 
 RideFile::RideFile() : 
     wstale(true), recIntSecs_(0.0), deviceType_("unknown"), data(NULL), wprime_(NULL), 
-    weight_(0), totalCount(0), dstale(true)
+    weight_(0), totalCount(0), dstale(AllDerivedSeries), deriveLock(QMutex::Recursive), partial_(false),
+    mapLock(QMutex::Recursive), mapped_(0), map_(NULL), loading_(false)
 {
     command = new RideFileCommand(this);
+    for (int i=0; i<none; i++) columnBuilt_[i] = -1; // see series()
 
     minPoint = new RideFilePoint();
     maxPoint = new RideFilePoint();
@@ -116,6 +126,7 @@ RideFile::~RideFile()
     emit deleted();
     foreach(RideFilePoint *point, dataPoints_)
         delete point;
+    if (map_) delete map_;
     //foreach(RideFileCalibration *calibration, calibrations_)
         //delete calibration;
     //foreach(RideFileInterval *interval, intervals_)
@@ -138,24 +149,74 @@ void RideFile::setStartTime(const QDateTime &value) {
     startTime_ = value;
 }
 
-unsigned int
-RideFile::computeFileCRC(QString filename)
+// 64 bit hash of the file contents, MurmurHash64A read a chunk at
+// a time so big imported files aren't all held in memory at once.
+// the words are read in local byte order, it is only used in caches
+quint64
+RideFile::computeFileHash(QString filename)
 {
     QFile file(filename);
-    QFileInfo fileinfo(file);
-
-    // open file
     if (!file.open(QFile::ReadOnly)) return 0;
 
-    // allocate space
-    QScopedArrayPointer<char> data(new char[file.size()]);
+    const quint64 m = Q_UINT64_C(0xc6a4a7935bd1e995);
+    const int r = 47;
+    quint64 h = Q_UINT64_C(0x8445d61a4e774912) ^ (quint64(file.size()) * m);
 
-    // read entire file into memory
-    QDataStream *rawstream(new QDataStream(&file));
-    rawstream->readRawData(&data[0], file.size());
-    file.close();
+    // each chunk is a whole number of words, except the last
+    QByteArray chunk(64 * 1024, '\0');
+    char *data = chunk.data();
+    qint64 got;
+    do {
+        got = 0;
+        qint64 n;
+        while (got < chunk.size() && (n = file.read(data + got, chunk.size() - got)) > 0) got += n;
+
+        qint64 words = got / 8;
+        for (qint64 i=0; i<words; i++) {
+            quint64 k;
+            memcpy(&k, data + i * 8, sizeof(k));
+            k *= m;
+            k ^= k >> r;
+            k *= m;
+            h ^= k;
+            h *= m;
+        }
 
-    return qChecksum(&data[0], file.size());
+        // the tail of the last chunk
+        const uchar *tail = reinterpret_cast<const uchar*>(data + words * 8);
+        switch (got & 7) {
+        case 7: h ^= quint64(tail[6]) << 48;
+        case 6: h ^= quint64(tail[5]) << 40;
+        case 5: h ^= quint64(tail[4]) << 32;
+        case 4: h ^= quint64(tail[3]) << 24;
+        case 3: h ^= quint64(tail[2]) << 16;
+        case 2: h ^= quint64(tail[1]) << 8;
+        case 1: h ^= quint64(tail[0]);
+                h *= m;
+        }
+    } while (got == chunk.size());
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+// the size and time last modified, when they haven't changed since it
+// was last hashed the contents haven't, false if it couldn't be read
+// in which case it should be taken as changed
+bool
+RideFile::statFile(QString filename, quint64 &size, qint64 &modified)
+{
+    QFileInfo info(filename);
+    if (!info.exists()) {
+        size = 0;
+        modified = 0;
+        return false;
+    }
+    size = info.size();
+    modified = info.lastModified().toMSecsSinceEpoch();
+    return true;
 }
 
 void
@@ -183,7 +244,9 @@ RideFile::updateDataTag()
     if (areDataPresent()->lat ||
         areDataPresent()->lon ) flags += 'G'; // GPS
     else flags += '-';
-    if (areDataPresent()->slope) flags += 'L'; // Slope
+    if (areDataPresent()->slope ||
+        (areDataPresent()->alt &&
+         areDataPresent()->km)) flags += 'L'; // Slope, or can be derived
     else flags += '-';
     if (areDataPresent()->headwind) flags += 'W'; // Windspeed
     else flags += '-';
@@ -204,6 +267,9 @@ RideFile::updateDataTag()
 WPrime *
 RideFile::wprimeData()
 {
+    // other threads may want it too, the derived data lock
+    // is held whilst it computes so we can use that
+    QMutexLocker locker(&deriveLock);
     if (wprime_ == NULL || wstale) {
         if (!wprime_) wprime_ = new WPrime();
         wprime_->setRide(const_cast<RideFile*>(this)); // recompute
@@ -212,6 +278,13 @@ RideFile::wprimeData()
     return wprime_;
 }
 
+void
+RideFile::invalidateWprime()
+{
+    QMutexLocker locker(&deriveLock);
+    wstale = true;
+}
+
 bool
 RideFile::isRun() const
 {
@@ -410,6 +483,41 @@ RideFile::colorFor(SeriesType series)
     }
 }
 
+QList<RideFile::SeriesType>
+RideFile::inputsFor(SeriesType series)
+{
+    QList<SeriesType> inputs;
+
+    switch (series) {
+    case RideFile::cadd: inputs << cad; break;
+    case RideFile::hrd: inputs << hr; break;
+    case RideFile::kphd: inputs << kph; break;
+    case RideFile::nmd: inputs << nm; break;
+    case RideFile::wattsd:
+    case RideFile::NP:
+    case RideFile::xPower:
+    case RideFile::wattsKg:
+    case RideFile::aTISS:
+    case RideFile::anTISS:
+    case RideFile::wprime:
+    case RideFile::wbal: inputs << watts; break;
+    case RideFile::aPower:
+    case RideFile::aPowerKg: inputs << watts << alt; break;
+    case RideFile::vam: inputs << alt; break;
+    case RideFile::slope: inputs << slope << alt << km; break;
+    case RideFile::gear: inputs << kph << cad << watts; break;
+    case RideFile::o2hb:
+    case RideFile::hhb: inputs << smo2 << thb; break;
+    case RideFile::clength: inputs << kph << cad << rcad; break;
+    case RideFile::tcore: inputs << tcore << hr; break;
+    case RideFile::index:
+    case RideFile::hrv:
+    case RideFile::none: break;
+    default: inputs << series; break;
+    }
+    return inputs;
+}
+
 QString
 RideFile::unitName(SeriesType series, Context *context)
 {
@@ -491,7 +599,7 @@ RideFile::clearIntervals()
 void
 RideFile::fillInIntervals()
 {
-    if (dataPoints_.empty())
+    if (dataPoints().empty())
         return;
     intervals_.clear();
     double start = dataPoints().first()->secs;
@@ -591,11 +699,11 @@ RideFile::intervalBeginSecs(const double secs) const
     RideFilePoint p;
     p.secs = secs;
     QVector<RideFilePoint*>::const_iterator i = std::lower_bound(
-        dataPoints_.begin(), dataPoints_.end(), &p, ComparePointSecs());
-    if (i == dataPoints_.end())
-        return dataPoints_.size()-1;
-    int offset = i - dataPoints_.begin();
-    if (offset > dataPoints_.size()) return dataPoints_.size()-1;
+        dataPoints().begin(), dataPoints().end(), &p, ComparePointSecs());
+    if (i == dataPoints().end())
+        return dataPoints().size()-1;
+    int offset = i - dataPoints().begin();
+    if (offset > dataPoints().size()) return dataPoints().size()-1;
     else if (offset <0) return 0;
     else return offset;
 }
@@ -607,11 +715,11 @@ RideFile::distanceToTime(double km) const
     p.km = km;
 
     // Check we have some data and the secs is in bounds
-    if (dataPoints_.isEmpty()) return 0;
-    if (km < dataPoints_.first()->km) return dataPoints_.first()->secs;
-    if (km > dataPoints_.last()->km) return dataPoints_.last()->secs;
+    if (dataPoints().isEmpty()) return 0;
+    if (km < dataPoints().first()->km) return dataPoints().first()->secs;
+    if (km > dataPoints().last()->km) return dataPoints().last()->secs;
 
-    QVector<RideFilePoint*>::const_iterator i = std::lower_bound(dataPoints_.begin(), dataPoints_.end(), &p, ComparePointKm());
+    QVector<RideFilePoint*>::const_iterator i = std::lower_bound(dataPoints().begin(), dataPoints().end(), &p, ComparePointKm());
     return (*i)->secs;
 }
 double
@@ -621,11 +729,11 @@ RideFile::timeToDistance(double secs) const
     p.secs = secs;
 
     // Check we have some data and the secs is in bounds
-    if (dataPoints_.isEmpty()) return 0;
-    if (secs < dataPoints_.first()->secs) return dataPoints_.first()->km;
-    if (secs > dataPoints_.last()->secs) return dataPoints_.last()->km;
+    if (dataPoints().isEmpty()) return 0;
+    if (secs < dataPoints().first()->secs) return dataPoints().first()->km;
+    if (secs > dataPoints().last()->secs) return dataPoints().last()->km;
 
-    QVector<RideFilePoint*>::const_iterator i = std::lower_bound(dataPoints_.begin(), dataPoints_.end(), &p, ComparePointSecs());
+    QVector<RideFilePoint*>::const_iterator i = std::lower_bound(dataPoints().begin(), dataPoints().end(), &p, ComparePointSecs());
     return (*i)->km;
 }
 
@@ -637,10 +745,10 @@ RideFile::timeIndex(double secs) const
     p.secs = secs;
 
     QVector<RideFilePoint*>::const_iterator i = std::lower_bound(
-        dataPoints_.begin(), dataPoints_.end(), &p, ComparePointSecs());
-    if (i == dataPoints_.end())
-        return dataPoints_.size()-1;
-    return i - dataPoints_.begin();
+        dataPoints().begin(), dataPoints().end(), &p, ComparePointSecs());
+    if (i == dataPoints().end())
+        return dataPoints().size()-1;
+    return i - dataPoints().begin();
 }
 
 int
@@ -651,10 +759,10 @@ RideFile::distanceIndex(double km) const
     p.km = km;
 
     QVector<RideFilePoint*>::const_iterator i = std::lower_bound(
-        dataPoints_.begin(), dataPoints_.end(), &p, ComparePointKm());
-    if (i == dataPoints_.end())
-        return dataPoints_.size()-1;
-    return i - dataPoints_.begin();
+        dataPoints().begin(), dataPoints().end(), &p, ComparePointKm());
+    if (i == dataPoints().end())
+        return dataPoints().size()-1;
+    return i - dataPoints().begin();
 }
 
 
@@ -709,8 +817,8 @@ RideFileFactory::writeRideFile(Context *context, const RideFile *ride, QFile &fi
     // get the ride file writer for this format
     RideFileReader *reader = readFuncs_.value(format.toLower());
 
-    // write away
-    if (!reader) return false;
+    // write away, but never a ride that was only partly read
+    if (!reader || ride->isPartial()) return false;
     else return reader->writeRideFile(context, ride, file);
 }
 
@@ -770,6 +878,18 @@ static QByteArray gUncompress(const QByteArray &data)
 
 RideFile *RideFileFactory::openRideFile(Context *context, QFile &file,
                                            QStringList &errors, QList<RideFile*> *rideList) const
+{
+    return readRideFile(context, file, errors, rideList, NULL, NULL);
+}
+
+RideFile *RideFileFactory::openRideFile(Context *context, QFile &file, QStringList &errors,
+                                        const QList<RideFile::SeriesType> &series, const QStringList &xdata) const
+{
+    return readRideFile(context, file, errors, NULL, &series, &xdata);
+}
+
+RideFile *RideFileFactory::readRideFile(Context *context, QFile &file, QStringList &errors, QList<RideFile*> *rideList,
+                                        const QList<RideFile::SeriesType> *series, const QStringList *xdata) const
 {
     // is it compressed with gzip?
     QString suffix = QFileInfo(file).completeSuffix();
@@ -829,8 +949,30 @@ RideFile *RideFileFactory::openRideFile(Context *context, QFile &file,
 
     } else {
 
-        // open and read the file
-        result = reader->openRideFile(file, errors, rideList);
+        // native activities keep a binary copy in the cache that
+        // is much quicker to read, use it if it is up to date
+        QString binary = NativeFileReader::cacheFileFor(context, file.fileName());
+        result = NULL;
+
+        if (binary != "" && NativeFileReader::isCurrent(file.fileName(), binary)) {
+            QFile bfile(binary);
+            QStringList berrors;
+            result = NativeFileReader().openSeries(bfile, berrors, series, xdata);
+        }
+
+        if (!result) {
+
+            // what we are about to read, so a change whilst we
+            // do is noticed next time
+            qint64 size=0, modified=0;
+            if (binary != "") NativeFileReader::sourceStamp(file.fileName(), size, modified);
+
+            // open and read the file
+            result = reader->openRideFile(file, errors, rideList);
+
+            // and refresh the binary copy for next time
+            if (result && binary != "") NativeFileReader::writeCache(context, result, binary, size, modified);
+        }
     }
 
     // if it was successful, lets post process the file
@@ -838,7 +980,11 @@ RideFile *RideFileFactory::openRideFile(Context *context, QFile &file,
 
         result->context = context;
 
-        if (result->intervals().empty()) result->fillInIntervals();
+        // a mapped binary copy has done this and the drag back
+        // below already, so the samples needn't be read in yet
+        bool mapped = result->isMapped();
+
+        if (result->intervals().empty() && !mapped) result->fillInIntervals();
         // override the file ride time with that set from the filename
         // but only if it matches the GC format
         QFileInfo fileInfo(file.fileName());
@@ -878,7 +1024,7 @@ RideFile *RideFileFactory::openRideFile(Context *context, QFile &file,
 
         // reset timestamps and distances to always start from zero
         double timeOffset=0.00f, kmOffset=0.00f;
-        if (result->dataPoints().count()) {
+        if (!mapped && result->dataPoints().count()) {
             timeOffset=result->dataPoints()[0]->secs;
             kmOffset=result->dataPoints()[0]->km;
         }
@@ -891,12 +1037,18 @@ RideFile *RideFileFactory::openRideFile(Context *context, QFile &file,
             }
         }
 
+        // samples were adjusted in place
+        result->invalidateSeries();
+
         // drag back intervals
         foreach(RideFileInterval *i, result->intervals()) {
             i->start -= timeOffset;
             i->stop -= timeOffset;
         }
 
+        // keep xdata as small as we can
+        foreach(XDataSeries *x, result->xdata()) x->compact();
+
         // calculate derived data series -- after data fixers applied above
         // Update presens and filter HRV
         XDataSeries *series = result->xdata("HRV");
@@ -915,8 +1067,8 @@ RideFile *RideFileFactory::openRideFile(Context *context, QFile &file,
                     }
             }
 
-        // calculate derived data series -- after data fixers applied above
-        if (context) result->recalculateDerivedSeries();
+        // derived data series are calculated on demand, after the
+        // data fixers applied above, see RideFile::deriveSeries()
 
         // what data is present - after processor in case 'derived' or adjusted
         result->updateDataTag();
@@ -1008,18 +1160,22 @@ RideFile::xdataValue(RideFilePoint *p, int &idx, QString sxdata, QString series,
     XDataSeries *s = xdata(sxdata);
 
     // if not there or no values return NA
-    if (s == NULL || !s->valuename.contains(series) || s->datapoints.count()==0)
+    if (s == NULL || s->datapoints.count()==0)
         return RideFile::NA;
 
     // get index of series we care about
     int vindex = s->valuename.indexOf(series);
+    if (vindex < 0) return RideFile::NA;
 
     // where are we in the ride?
     double secs = p->secs;
 
-    // do we need to move on?
-    while (idx < s->datapoints.count() && s->datapoints[idx]->secs < secs)
-        idx++;
+    // do we need to move on? callers usually step through the ride
+    // so check just ahead of the cursor before searching the rest
+    if (idx < s->datapoints.count() && s->datapoints[idx]->secs < secs) {
+        if (idx+1 < s->datapoints.count() && s->datapoints[idx+1]->secs >= secs) idx++;
+        else idx = s->nextIndex(secs, idx);
+    }
 
     // so at this point we are looking at a point that is either
     // the same point as us or is ahead of us
@@ -1421,7 +1577,7 @@ void RideFile::appendOrUpdatePoint(double secs, double cad, double hr, double km
 #endif
 
     // if bad time or distance ignore it if NOT the first sample
-    if (dataPoints_.count() != 0 && secs == 0.00f && km == 0.00f) return;
+    if (points().count() != 0 && secs == 0.00f && km == 0.00f) return;
 
     // truncate alt out of bounds -- ? should do for all, but uncomfortable about
     //                                 setting an absolute max. At least We know the highest
@@ -1439,17 +1595,20 @@ void RideFile::appendOrUpdatePoint(double secs, double cad, double hr, double km
                                              rvert, rcad, rcontact, tcore,
                                              interval);
 
+    // cheap, so fine when appending sample by sample
+    invalidateSeries();
+
     if (!forceAppend) {
         int idx = timeIndex(secs);
         if (idx != -1) {
-            if (dataPoints_.at(idx)->secs == secs) {
-                updatePoint(point, dataPoints_.at(idx));
-                dataPoints_.replace(idx, point);
+            if (points().at(idx)->secs == secs) {
+                updatePoint(point, points().at(idx));
+                points().replace(idx, point);
             } else {
-                if (dataPoints_.at(idx)->secs > secs)
-                    dataPoints_.insert(idx, point);
+                if (points().at(idx)->secs > secs)
+                    points().insert(idx, point);
                 else
-                    dataPoints_.insert(idx+1, point);
+                    points().insert(idx+1, point);
             }
         } else
            forceAppend = true;
@@ -1467,7 +1626,7 @@ void RideFile::appendOrUpdatePoint(double secs, double cad, double hr, double km
                                                  rvert, rcad, rcontact, tcore,
                                                  interval);
 
-        dataPoints_.append(point);
+        points().append(point);
     }
 
     dataPresent.secs     |= (secs != 0);
@@ -1659,8 +1818,11 @@ RideFile::setDataPresent(SeriesType series, bool value)
 }
 
 bool
-RideFile::isDataPresent(SeriesType series)
+RideFile::isDataPresent(SeriesType series) const
 {
+    // some derived series are only present once derived
+    if (staleGroups()) deriveSeries(series);
+
     switch (series) {
         case secs : return dataPresent.secs; break;
         case cadd :
@@ -1714,47 +1876,194 @@ RideFile::isDataPresent(SeriesType series)
     }
     return false;
 }
+bool
+RideFile::hasSeries(SeriesType series) const
+{
+    if (sampleCount() == 0) return false;
+
+    switch (series) {
+
+        // always available when we have samples
+        case secs :
+        case km :
+        case interval : return true;
+
+        // derived, see deriveSeries()
+        case NP : return dataPresent.np;
+        case xPower : return dataPresent.xp;
+        case aPower : return dataPresent.apower;
+        case aTISS :
+        case anTISS : return dataPresent.watts;
+        case clength : return dataPresent.kph && (dataPresent.cad || dataPresent.rcad);
+        case tcore : return dataPresent.tcore || dataPresent.hr;
+
+        // not held in the data points
+        case vam :
+        case wattsKg :
+        case wprime :
+        case wbal :
+        case aPowerKg :
+        case index :
+        case hrv : return false;
+
+        default : return isDataPresent(series);
+    }
+}
+
+// unique across all rides, as the same ride may be reopened
+static QAtomicInt revisions;
+
+RideFileSeries
+RideFile::series(SeriesType series) const
+{
+    if (series < 0 || series >= none) return RideFileSeries();
+
+    // derived series are only computed when first asked for
+    deriveSeries(series);
+    if (!hasSeries(series)) return RideFileSeries();
+
+    // build on first use, the same ride may be read
+    // from multiple threads (e.g. when computing the cpx)
+    QMutexLocker locker(&columnLock);
+
+    // what it is built from, a change from here on is caught next time
+    int current = loadAcquire(dataRevision_);
+
+    QVector<double> &column = columns_[series];
+    int n = sampleCount();
+    if (column.count() != n || columnBuilt_[series] != current) {
+        column.resize(n);
+        double *value = column.data();
+
+        // straight from the binary copy if the samples aren't read in yet
+        QMutexLocker mapLocker(&mapLock);
+        if (map_ && NativeRideFileMap::stored(series)) map_->column(series, value);
+        else {
+            mapLocker.unlock();
+            foreach(const RideFilePoint *p, dataPoints()) *value++ = p->value(series);
+        }
+        columnRevisions_[series] = revisions.fetchAndAddOrdered(1);
+        columnBuilt_[series] = current;
+
+        // drop the column used least recently, any views of
+        // it keep their own reference so remain valid
+        columnsUsed.removeOne(series);
+        if (columnsUsed.count() >= MaxCachedSeries) columns_[columnsUsed.takeFirst()].clear();
+    } else columnsUsed.removeOne(series);
+    columnsUsed.append(series);
+
+    return RideFileSeries(column);
+}
+
+int
+RideFile::seriesRevision(SeriesType series) const
+{
+    int n = sampleCount();
+    if (series < 0 || series >= none || n == 0) return -1;
+
+    QMutexLocker locker(&columnLock);
+    if (columns_[series].count() != n || columnBuilt_[series] != loadAcquire(dataRevision_)) return -1;
+    return columnRevisions_[series];
+}
+
+void
+RideFile::setMapped(NativeRideFileMap *map)
+{
+    QMutexLocker locker(&mapLock);
+    if (map_) delete map_;
+    map_ = map;
+    mapped_.fetchAndStoreRelease(map ? 1 : 0);
+}
+
+void
+RideFile::loadPoints() const
+{
+    QMutexLocker locker(&mapLock);
+
+    // another thread may have got here first, or we are
+    // appending the samples as they are read in below
+    if (map_ == NULL || loading_) return;
+
+    RideFile *self = const_cast<RideFile*>(this);
+    loading_ = true;
+    map_->read(self);
+
+    // and drag them back, as RideFileFactory would have
+    if (map_->secsOffset || map_->kmOffset) {
+        foreach(RideFilePoint *p, dataPoints_) {
+            p->secs -= map_->secsOffset;
+            p->km -= map_->kmOffset;
+        }
+    }
+    loading_ = false;
+
+    // any columns already built from the map still hold
+    delete self->map_;
+    self->map_ = NULL;
+    self->mapped_.fetchAndStoreRelease(0);
+}
+
+int
+RideFile::sampleCount() const
+{
+    if (isMapped()) {
+        QMutexLocker locker(&mapLock);
+        if (map_) return map_->samples();
+    }
+    return dataPoints_.count();
+}
+
+void
+RideFile::invalidateSeries()
+{
+    // the columns are built again when next used, the old ones are
+    // left for that, or to be dropped as the least recently used
+    dataRevision_.ref();
+}
+
 void
 RideFile::setPointValue(int index, SeriesType series, double value)
 {
+    invalidateSeries();
+
     switch (series) {
-        case secs : dataPoints_[index]->secs = value; break;
-        case cad : dataPoints_[index]->cad = value; break;
-        case hr : dataPoints_[index]->hr = value; break;
-        case km : dataPoints_[index]->km = value; break;
-        case kph : dataPoints_[index]->kph = value; break;
-        case nm : dataPoints_[index]->nm = value; break;
-        case watts : dataPoints_[index]->watts = value; break;
-        case alt : dataPoints_[index]->alt = value; break;
-        case lon : dataPoints_[index]->lon = value; break;
-        case lat : dataPoints_[index]->lat = value; break;
-        case headwind : dataPoints_[index]->headwind = value; break;
-        case slope : dataPoints_[index]->slope = value; break;
-        case temp : dataPoints_[index]->temp = value; break;
-        case lrbalance : dataPoints_[index]->lrbalance = value; break;
-        case lte : dataPoints_[index]->lte = value; break;
-        case rte : dataPoints_[index]->rte = value; break;
-        case lps : dataPoints_[index]->lps = value; break;
-        case rps : dataPoints_[index]->rps = value; break;
-        case lpco : dataPoints_[index]->lpco = value; break;
-        case rpco : dataPoints_[index]->rpco = value; break;
-        case lppb : dataPoints_[index]->lppb = value; break;
-        case rppb : dataPoints_[index]->rppb = value; break;
-        case lppe : dataPoints_[index]->lppe = value; break;
-        case rppe : dataPoints_[index]->rppe = value; break;
-        case lpppb : dataPoints_[index]->lpppb = value; break;
-        case rpppb : dataPoints_[index]->rpppb = value; break;
-        case lpppe : dataPoints_[index]->lpppe = value; break;
-        case rpppe : dataPoints_[index]->rpppe = value; break;
-        case smo2 : dataPoints_[index]->smo2 = value; break;
-        case thb : dataPoints_[index]->thb = value; break;
-        case o2hb : dataPoints_[index]->o2hb = value; break;
-        case hhb : dataPoints_[index]->hhb = value; break;
-        case rcad : dataPoints_[index]->rcad = value; break;
-        case rvert : dataPoints_[index]->rvert = value; break;
-        case rcontact : dataPoints_[index]->rcontact = value; break;
-        case interval : dataPoints_[index]->interval = value; break;
-        case tcore : dataPoints_[index]->tcore = value; break;
+        case secs : points()[index]->secs = value; break;
+        case cad : points()[index]->cad = value; break;
+        case hr : points()[index]->hr = value; break;
+        case km : points()[index]->km = value; break;
+        case kph : points()[index]->kph = value; break;
+        case nm : points()[index]->nm = value; break;
+        case watts : points()[index]->watts = value; break;
+        case alt : points()[index]->alt = value; break;
+        case lon : points()[index]->lon = value; break;
+        case lat : points()[index]->lat = value; break;
+        case headwind : points()[index]->headwind = value; break;
+        case slope : points()[index]->slope = value; break;
+        case temp : points()[index]->temp = value; break;
+        case lrbalance : points()[index]->lrbalance = value; break;
+        case lte : points()[index]->lte = value; break;
+        case rte : points()[index]->rte = value; break;
+        case lps : points()[index]->lps = value; break;
+        case rps : points()[index]->rps = value; break;
+        case lpco : points()[index]->lpco = value; break;
+        case rpco : points()[index]->rpco = value; break;
+        case lppb : points()[index]->lppb = value; break;
+        case rppb : points()[index]->rppb = value; break;
+        case lppe : points()[index]->lppe = value; break;
+        case rppe : points()[index]->rppe = value; break;
+        case lpppb : points()[index]->lpppb = value; break;
+        case rpppb : points()[index]->rpppb = value; break;
+        case lpppe : points()[index]->lpppe = value; break;
+        case rpppe : points()[index]->rpppe = value; break;
+        case smo2 : points()[index]->smo2 = value; break;
+        case thb : points()[index]->thb = value; break;
+        case o2hb : points()[index]->o2hb = value; break;
+        case hhb : points()[index]->hhb = value; break;
+        case rcad : points()[index]->rcad = value; break;
+        case rvert : points()[index]->rvert = value; break;
+        case rcontact : points()[index]->rcontact = value; break;
+        case interval : points()[index]->interval = value; break;
+        case tcore : points()[index]->tcore = value; break;
         default:
         case none : break;
     }
@@ -1880,7 +2189,8 @@ RideFilePoint::setValue(RideFile::SeriesType series, double value)
 double
 RideFile::getPointValue(int index, SeriesType series) const
 {
-    return dataPoints_[index]->value(series);
+    if (staleGroups()) deriveSeries(series);
+    return dataPoints()[index]->value(series);
 }
 
 QVariant
@@ -1902,18 +2212,21 @@ RideFile::getPoint(int index, SeriesType series) const
 QVariant
 RideFile::getMinPoint(SeriesType series) const
 {
+    points(); // worked out as the samples are read in
     return getPointFromValue(minPoint->value(series), series);
 }
 
 QVariant
 RideFile::getAvgPoint(SeriesType series) const
 {
+    points(); // worked out as the samples are read in
     return getPointFromValue(avgPoint->value(series), series);
 }
 
 QVariant
 RideFile::getMaxPoint(SeriesType series) const
 {
+    points(); // worked out as the samples are read in
     return getPointFromValue(maxPoint->value(series), series);
 }
 
@@ -2092,21 +2405,24 @@ RideFile::minimumFor(SeriesType series)
 void
 RideFile::deletePoint(int index)
 {
-    delete dataPoints_[index];
-    dataPoints_.remove(index);
+    invalidateSeries();
+    delete points()[index];
+    points().remove(index);
 }
 
 void
 RideFile::deletePoints(int index, int count)
 {
-    for(int i=index; i<(index+count); i++) delete dataPoints_[i];
-    dataPoints_.remove(index, count);
+    invalidateSeries();
+    for(int i=index; i<(index+count); i++) delete points()[i];
+    points().remove(index, count);
 }
 
 void
 RideFile::insertPoint(int index, RideFilePoint *point)
 {
-    dataPoints_.insert(index, point);
+    invalidateSeries();
+    points().insert(index, point);
 }
 
 void
@@ -2126,7 +2442,8 @@ RideFile::deleteXDataPoints(QString _xdata, int index, int count)
 void
 RideFile::appendPoints(QVector <struct RideFilePoint *> newRows)
 {
-    dataPoints_ += newRows;
+    invalidateSeries();
+    points() += newRows;
 }
 
 void
@@ -2136,11 +2453,20 @@ RideFile::appendXDataPoints(QString _xdata, QVector<XDataPoint *> points)
     if (series) series->datapoints << points;
 }
 
+void
+RideFile::derivedStale()
+{
+    QMutexLocker locker(&deriveLock);
+    wstale = true;
+    dstale.fetchAndStoreRelease(AllDerivedSeries);
+}
+
 void
 RideFile::emitSaved()
 {
     weight_ = 0;
-    wstale = dstale = true;
+    derivedStale();
+    invalidateSeries();
     emit saved();
 }
 
@@ -2148,7 +2474,8 @@ void
 RideFile::emitReverted()
 {
     weight_ = 0;
-    wstale = dstale = true;
+    derivedStale();
+    invalidateSeries();
     emit reverted();
 }
 
@@ -2156,7 +2483,8 @@ void
 RideFile::emitModified()
 {
     weight_ = 0;
-    wstale = dstale = true;
+    derivedStale();
+    invalidateSeries();
     emit modified();
 }
 
@@ -2261,23 +2589,184 @@ RideFile::arePresent()
 
 void
 RideFile::recalculateDerivedSeries(bool force)
+{
+    derive(AllDerivedSeries, force);
+}
+
+void
+RideFile::deriveSeries(SeriesType series) const
+{
+    unsigned int group = derivedGroup(series);
+    if (staleGroups() & group) const_cast<RideFile*>(this)->derive(group, false);
+}
+
+void
+RideFile::deriveAll() const
+{
+    if (staleGroups()) const_cast<RideFile*>(this)->derive(AllDerivedSeries, false);
+}
+
+unsigned int
+RideFile::derivedGroup(SeriesType series)
+{
+    switch (series) {
+        case kphd :
+        case wattsd :
+        case cadd :
+        case nmd :
+        case hrd : return DeltaSeries;
+        case NP : return NPSeries;
+        case xPower : return XPowerSeries;
+        case aPower :
+        case aPowerKg : return APowerSeries;
+        case aTISS :
+        case anTISS : return TISSSeries;
+        case slope : return SlopeSeries;
+        case gear : return GearSeries;
+        case o2hb :
+        case hhb : return HbSeries;
+        case clength : return CLengthSeries;
+        case tcore : return TcoreSeries;
+        default : return 0;
+    }
+}
+
+void
+RideFile::derive(unsigned int groups, bool force)
 {
     // derived data is calculated from the data that is present
     // we should set to 0 where we cannot derive since we may
     // be called after data is deleted or added
-    if (!force && dstale == false) return; // we're already up to date
+    QMutexLocker locker(&deriveLock);
+
+    // another thread may have got here first
+    if (!force) groups &= staleGroups();
+    if (!groups) return; // we're already up to date
+
+    // derived values are kept in the samples
+    points();
+
+    if (groups & DeltaSeries) deriveDeltas();
+    if (groups & NPSeries) deriveNP();
+    if (groups & XPowerSeries) deriveXPower();
+    if (groups & APowerSeries) deriveAPower();
+    if (groups & TISSSeries) deriveTISS();
+    if (groups & SlopeSeries) deriveSlope();
+    if (groups & GearSeries) deriveGear();
+    if (groups & HbSeries) deriveHb();
+    if (groups & CLengthSeries) deriveCLength();
+    if (groups & TcoreSeries) deriveTcore();
+
+    // derived values have changed
+    columnLock.lock();
+    for (int i=0; i<none; i++)
+        if (derivedGroup(static_cast<SeriesType>(i)) & groups) {
+            columns_[i].clear();
+            columnBuilt_[i] = -1;
+            columnsUsed.removeOne(i);
+        }
+    columnLock.unlock();
+
+    // and we're done
+    dstale.fetchAndStoreRelease(staleGroups() & ~groups);
+}
+
+// first difference of a series against time, all zero if the series is not present
+static void
+timeDifference(const RideFileSeries &values, const double *secs, QVector<double> &out)
+{
+    if (values.isEmpty()) out.fill(0);
+    else SeriesKernels::firstDifference(values.constData(), secs, out.data(), out.count());
+}
+
+void
+RideFile::deriveDeltas()
+{
+    int n = dataPoints_.count();
+    if (n == 0) return;
+
+    RideFileSeries secsColumn = series(RideFile::secs);
+    const double *secs = secsColumn.constData();
+    QVector<double> kphd(n), wattsd(n), cadd(n), nmd(n), hrd(n);
+
+    timeDifference(series(RideFile::kph), secs, kphd);
+    for (int i=0; i<n; i++) kphd[i] /= 3.60f; // m/s/s
 
+    // Other delta values -- only interested in growth for power, cadence 
+    timeDifference(series(RideFile::watts), secs, wattsd);
+    SeriesKernels::bandPass(wattsd.data(), n, 0, 2500);
+    timeDifference(series(RideFile::cad), secs, cadd);
+    SeriesKernels::bandPass(cadd.data(), n, 0, 200);
+
+    // we want drops when looking for jump out saddle vs sit down
+    timeDifference(series(RideFile::nm), secs, nmd);
+
+    // we want recovery and increase times for hr
+    RideFileSeries hr = series(RideFile::hr);
+    timeDifference(hr, secs, hrd);
+
+    // ignore hr dropouts -- 0 means dropout not dead!
+    if (!hr.isEmpty()) for (int i=1; i<n; i++) if (!hr[i] || !hr[i-1]) hrd[i] = 0;
+
+    for (int i=0; i<n; i++) {
+        RideFilePoint *p = dataPoints_[i];
+        p->kphd = kphd[i];
+        p->wattsd = wattsd[i];
+        p->cadd = cadd[i];
+        p->nmd = nmd[i];
+        p->hrd = hrd[i];
+    }
+}
+
+void
+RideFile::deriveNP()
+{
     //
     // NP Initialisation -- working variables
     //
-    QVector<double> NProlling;
+    int n = dataPoints_.count();
     int NProllingwindowsize = 30 / (recIntSecs_ ? recIntSecs_ : 1);
-    if (NProllingwindowsize > 1) NProlling.resize(NProllingwindowsize);
     double NPtotal = 0;
     int NPcount = 0;
-    int NPindex = 0;
-    double NPsum = 0;
 
+    if (n && dataPresent.watts && NProllingwindowsize > 1) {
+
+        dataPresent.np = true;
+
+        // 30s rolling average raised to the 4th power
+        QVector<double> rolling(n);
+        SeriesKernels::rollingMean(series(RideFile::watts).constData(), rolling.data(), n, NProllingwindowsize);
+        for (int i=0; i<n; i++) rolling[i] = (rolling[i] * rolling[i]) * (rolling[i] * rolling[i]);
+
+        // running total, then root for ride so far
+        for (int i=0; i<n; i++) rolling[i] = (NPtotal += rolling[i]);
+        for (int i=0; i<n; i++) {
+            double root = sqrt(sqrt(rolling[i] / (i+1)));
+            rolling[i] = (i+1)*recIntSecs_ > 30 ? root : 0;
+        }
+        NPcount = n;
+
+        for (int i=0; i<n; i++) dataPoints_[i]->np = rolling[i];
+
+    } else {
+
+        foreach(RideFilePoint *p, dataPoints_) p->np = 0.00f;
+    }
+
+    // now the min and max values for NP
+    foreach(RideFilePoint *p, dataPoints_) {
+        if (p->np > maxPoint->np) maxPoint->np = p->np;
+        if (p->np < minPoint->np) minPoint->np = p->np;
+    }
+
+    // Averages and Totals
+    avgPoint->np = NPcount ? (NPtotal / NPcount) : 0;
+    totalPoint->np = NPtotal;
+}
+
+void
+RideFile::deriveXPower()
+{
     //
     // XPower Initialisation -- working variables
     //
@@ -2292,208 +2781,206 @@ RideFile::recalculateDerivedSeries(bool force)
     double XPtotal = 0.0;
     int XPcount = 0;
 
-    //
-    // APower Initialisation -- working variables
-    double APtotal=0;
-    double APcount=0;
+    int n = dataPoints_.count();
+    if (n && dataPresent.watts) {
 
-    // aTISS - Aerobic Training Impact Scoring System
-    static const double a = 0.663788683661645f;
-    static const double b = -7.5095428451195f;
-    static const double c = -0.86118031563782f;
-    //static const double t = 2;
-    // anTISS
-    static const double an = 0.238923886004611f;
-    //static const double bn = -12.2066385296127f;
-    static const double bn = -61.849f;
-    static const double cn = -1.73549567522521f;
+        dataPresent.xp = true;
 
-    int CP = 0;
-    //int WPRIME = 0;
-    double aTISS = 0.0f;
-    double anTISS = 0.0f;
+        RideFileSeries secsColumn = series(RideFile::secs);
+        RideFileSeries wattsColumn = series(RideFile::watts);
+        const double *secs = secsColumn.constData();
+        const double *watts = wattsColumn.constData();
+        QVector<double> weighted(n);
 
-    // set WPrime and CP
-    if (context->athlete->zones(isRun())) {
-        int zoneRange = context->athlete->zones(isRun())->whichRange(startTime().date());
-        CP = zoneRange >= 0 ? context->athlete->zones(isRun())->getCP(zoneRange) : 0;
-        //WPRIME = zoneRange >= 0 ? context->athlete->zones(isRun())->getWprime(zoneRange) : 0;
+        int i=0;
+        while (i<n) {
 
-        // did we override CP in metadata / metrics ?
-        int oCP = getTag("CP","0").toInt();
-        if (oCP) CP=oCP;
-    }
+            // decay through any gap in recording
+            while ((XPweighted > NEGLIGIBLE) && (secs[i] > XPlastSecs + XPsecsDelta + EPSILON)) {
+                XPweighted *= XPattenuation;
+                XPlastSecs += XPsecsDelta;
+                XPtotal += pow(XPweighted, 4.0);
+                XPcount++;
+            }
 
-    // wheelsize - use meta, then config then drop to 2100
-    double wheelsize = getTag(tr("Wheelsize"), "0.0").toDouble();
-    if (wheelsize == 0) wheelsize = appsettings->cvalue(context->athlete->cyclist, GC_WHEELSIZE, 2100).toInt();
-    wheelsize /= 1000.00f; // need it in meters
+            // then the samples up to the next gap in one go
+            int j=i+1;
+            while (j<n && secs[j] <= secs[j-1] + XPsecsDelta + EPSILON) j++;
 
-    // last point looked at
-    RideFilePoint *lastP = NULL;
+            XPweighted = SeriesKernels::ewma(watts+i, weighted.data()+i, j-i, XPattenuation, XPsampleWeight, XPweighted);
+            for (int k=i; k<j; k++) {
+                XPtotal += (weighted[k] * weighted[k]) * (weighted[k] * weighted[k]);
+                XPcount++;
+                dataPoints_[k]->xp = sqrt(sqrt(XPtotal / XPcount));
+            }
+            XPlastSecs = secs[j-1];
+            i = j;
+        }
+    }
 
+    // now the min and max values for xPower
     foreach(RideFilePoint *p, dataPoints_) {
+        if (p->xp > maxPoint->xp) maxPoint->xp = p->xp;
+        if (p->xp < minPoint->xp) minPoint->xp = p->xp;
+    }
 
-        // Delta
-        if (lastP) {
+    // Averages and Totals
+    avgPoint->xp = XPcount ? (XPtotal / XPcount) : 0;
+    totalPoint->xp = XPtotal;
+}
 
-            double deltaSpeed = (p->kph - lastP->kph) / 3.60f;
-            double deltaTime = p->secs - lastP->secs;
+void
+RideFile::deriveAPower()
+{
+    static const double a0  = -174.1448622f;
+    static const double a1  = 1.0899959f;
+    static const double a2  = -0.0015119f;
+    static const double a3  = 7.2674E-07f;
+    //static const double E = 2.71828183f;
 
-            if (deltaTime > 0) {
+    double APtotal=0;
+    double APcount=0;
 
-                p->kphd = deltaSpeed / deltaTime;
+    int n = dataPoints_.count();
+    QVector<double> apower(n);
 
-                // Other delta values -- only interested in growth for power, cadence 
-                double pd = (p->watts - lastP->watts) / deltaTime;
-                p->wattsd = pd > 0 && pd < 2500 ? pd : 0;
+    if (n && dataPresent.watts == true && dataPresent.alt == true) {
 
-                double cd = (p->cad - lastP->cad) / deltaTime;
-                p->cadd = cd > 0 && cd < 200 ? cd : 0;
+        dataPresent.apower = true;
 
-                double nd = (p->nm - lastP->nm) / deltaTime;
-                p->nmd = nd; // we want drops when looking for jump out saddle vs sit down
+        RideFileSeries wattsColumn = series(RideFile::watts);
+        RideFileSeries altColumn = series(RideFile::alt);
+        const double *watts = wattsColumn.constData();
+        const double *alt = altColumn.constData();
 
-                // we want recovery and increase times for hr
-                p->hrd = (p->hr - lastP->hr) / deltaTime;
-                // ignore hr dropouts -- 0 means dropout not dead!
-                if (!p->hr || (lastP && lastP->hr == 0)) p->hrd = 0;
+        // %Vo2max at altitude, 100% at or below sea level
+        QVector<double> vo2maxPCT(n);
+        for (int i=0; i<n; i++) {
+            // pbar [mbar]= 0.76*EXP( -alt[m] / 7000 )*1000 
+            double pbar = 0.76f * exp(alt[i] / -7000.00f) * 1000.00f;
 
-            }
+            // %Vo2max= a0 + a1 * pbar + a2 * pbar ^2 + a3 * pbar ^3 (with pbar in mbar)
+            vo2maxPCT[i] = a0 + (a1 * pbar) + (a2 * pbar * pbar) + (a3 * pbar * pbar * pbar);
         }
 
-        //
-        // NP
-        //
-        if (dataPresent.watts && NProllingwindowsize > 1) {
+        SeriesKernels::ratio(watts, vo2maxPCT.constData(), apower.data(), n, 100);
+        for (int i=0; i<n; i++) apower[i] = alt[i] > 0 ? apower[i] : watts[i];
 
-            dataPresent.np = true;
+    } else {
 
-            // sum last 30secs
-            NPsum += p->watts;
-            NPsum -= NProlling[NPindex];
-            NProlling[NPindex] = p->watts;
+        for (int i=0; i<n; i++) apower[i] = dataPoints_[i]->watts;
+    }
 
-            // running total and count
-            NPtotal += pow(NPsum/NProllingwindowsize,4); // raise rolling average to 4th power
-            NPcount ++;
+    for (int i=0; i<n; i++) {
+        RideFilePoint *p = dataPoints_[i];
+        p->apower = apower[i];
 
-            // root for ride so far
-            if (NPcount && NPcount*recIntSecs_ > 30) {
-                p->np = pow(NPtotal / (NPcount), 0.25);
-            } else {
-                p->np = 0.00f;
-            }
+        // now the min and max values for aPower
+        if (p->apower > maxPoint->apower) maxPoint->apower = p->apower;
+        if (p->apower < minPoint->apower) minPoint->apower = p->apower;
 
-            // move index on/round
-            NPindex = (NPindex >= NProllingwindowsize-1) ? 0 : NPindex+1;
+        APtotal += p->apower;
+        APcount++;
+    }
 
-        } else {
+    // Averages and Totals
+    avgPoint->apower = APcount ? (APtotal / APcount) : 0;
+    totalPoint->apower = APtotal;
+}
 
-            p->np = 0.00f;
-        }
+void
+RideFile::deriveTISS()
+{
+    // aTISS - Aerobic Training Impact Scoring System
+    static const double a = 0.663788683661645f;
+    static const double b = -7.5095428451195f;
+    static const double c = -0.86118031563782f;
+    //static const double t = 2;
+    // anTISS
+    static const double an = 0.238923886004611f;
+    //static const double bn = -12.2066385296127f;
+    static const double bn = -61.849f;
+    static const double cn = -1.73549567522521f;
 
-        // now the min and max values for NP
-        if (p->np > maxPoint->np) maxPoint->np = p->np;
-        if (p->np < minPoint->np) minPoint->np = p->np;
+    int CP = 0;
+    //int WPRIME = 0;
+    double aTISS = 0.0f;
+    double anTISS = 0.0f;
 
-        //
-        // xPower
-        //
-        if (dataPresent.watts) {
+    // set WPrime and CP
+    if (context && context->athlete->zones(isRun())) {
+        int zoneRange = context->athlete->zones(isRun())->whichRange(startTime().date());
+        CP = zoneRange >= 0 ? context->athlete->zones(isRun())->getCP(zoneRange) : 0;
+        //WPRIME = zoneRange >= 0 ? context->athlete->zones(isRun())->getWprime(zoneRange) : 0;
 
-            dataPresent.xp = true;
+        // did we override CP in metadata / metrics ?
+        int oCP = getTag("CP","0").toInt();
+        if (oCP) CP=oCP;
+    }
 
-            while ((XPweighted > NEGLIGIBLE) && (p->secs > XPlastSecs + XPsecsDelta + EPSILON)) {
-                XPweighted *= XPattenuation;
-                XPlastSecs += XPsecsDelta;
-                XPtotal += pow(XPweighted, 4.0);
-                XPcount++;
-            }
+    // Anaerobic and Aerobic TISS
+    if (CP && dataPresent.watts) {
+        foreach(RideFilePoint *p, dataPoints_) {
 
-            XPweighted *= XPattenuation;
-            XPweighted += XPsampleWeight * p->watts;
-            XPlastSecs = p->secs;
-            XPtotal += pow(XPweighted, 4.0);
-            XPcount++;
-        
-            p->xp = pow(XPtotal / XPcount, 0.25);
+            // a * exp (b * exp (c * fraction of cp) ) 
+            aTISS += recIntSecs_ * (a * exp(b * exp(c * (double(p->watts) / double(CP)))));
+            anTISS += recIntSecs_ * (an * exp(bn * exp(cn * (double(p->watts) / double(CP)))));
+            p->atiss = aTISS;
+            p->antiss = anTISS;
         }
+    }
+}
 
-        // now the min and max values for NP
-        if (p->xp > maxPoint->xp) maxPoint->xp = p->xp;
-        if (p->xp < minPoint->xp) minPoint->xp = p->xp;
-
-        // aPower
-        if (dataPresent.watts == true && dataPresent.alt == true) {
-
-            dataPresent.apower = true;
-
-            static const double a0  = -174.1448622f;
-            static const double a1  = 1.0899959f;
-            static const double a2  = -0.0015119f;
-            static const double a3  = 7.2674E-07f;
-            //static const double E = 2.71828183f;
-
-            if (p->alt > 0) {
-                // pbar [mbar]= 0.76*EXP( -alt[m] / 7000 )*1000 
-                double pbar = 0.76f * exp(p->alt / -7000.00f) * 1000.00f;
+void
+RideFile::deriveSlope()
+{
+    if (dataPresent.slope || !dataPresent.alt || !dataPresent.km) return;
 
-                // %Vo2max= a0 + a1 * pbar + a2 * pbar ^2 + a3 * pbar ^3 (with pbar in mbar)
-                double vo2maxPCT = a0 + (a1 * pbar) + (a2 * pow(pbar,2)) + (a3 * pow(pbar,3)); 
+    int n = dataPoints_.count();
+    if (n) {
 
-                p->apower = double(p->watts / vo2maxPCT) * 100;
+        // rise over run, both in metres
+        QVector<double> deltaAltitude(n), deltaDistance(n), slope(n);
+        SeriesKernels::firstDifference(series(RideFile::alt).constData(), NULL, deltaAltitude.data(), n);
+        SeriesKernels::firstDifference(series(RideFile::km).constData(), NULL, deltaDistance.data(), n);
+        for (int i=0; i<n; i++) deltaDistance[i] *= 1000;
 
-            } else {
+        SeriesKernels::ratio(deltaAltitude.constData(), deltaDistance.constData(), slope.data(), n, 100);
 
-                p->apower = p->watts;
-            }
+        // outliers are replaced with the slope before them
+        for (int i=1; i<n; i++) if (slope[i] > 20 || slope[i] < -20) slope[i] = slope[i-1];
 
-        } else {
-
-            p->apower = p->watts;
-        }
-
-        // now the min and max values for NP
-        if (p->apower > maxPoint->apower) maxPoint->apower = p->apower;
-        if (p->apower < minPoint->apower) minPoint->apower = p->apower;
+        // Smooth the slope since it has been derived, the first
+        // few points don't have a full window so leave them be
+        int smoothPoints = 10;
+        QVector<double> smoothed(n);
+        SeriesKernels::rollingMean(slope.constData(), smoothed.data(), n, smoothPoints);
 
-        APtotal += p->apower;
-        APcount++;
+        for (int i=0; i<n; i++) dataPoints_[i]->slope = i >= smoothPoints ? smoothed[i] : slope[i];
+    }
+    setDataPresent(RideFile::slope, true);
+}
 
-        // Anaerobic and Aerobic TISS
-        if (CP && dataPresent.watts) {
+void
+RideFile::deriveGear()
+{
+    // wheelsize - use meta, then config then drop to 2100
+    double wheelsize = getTag(tr("Wheelsize"), "0.0").toDouble();
+    if (wheelsize == 0) wheelsize = context ? appsettings->cvalue(context->athlete->cyclist, GC_WHEELSIZE, 2100).toInt() : 2100;
+    wheelsize /= 1000.00f; // need it in meters
 
-            // a * exp (b * exp (c * fraction of cp) ) 
-            aTISS += recIntSecs_ * (a * exp(b * exp(c * (double(p->watts) / double(CP)))));
-            anTISS += recIntSecs_ * (an * exp(bn * exp(cn * (double(p->watts) / double(CP)))));
-            p->atiss = aTISS;
-            p->antiss = anTISS;
-        }
+    // derive or calculate gear ratio either from XDATA (if "GEARS" XData data exists)
+    // or from speed and cadence
+    XDataSeries *series = xdata("GEARS");
+    bool gears = series && series->datapoints.count() > 0;
+    int idx=0;
 
-        if (!dataPresent.slope && dataPresent.alt && dataPresent.km) {
-            if (lastP) {
-                double deltaDistance = (p->km - lastP->km) * 1000;
-                double deltaAltitude = p->alt - lastP->alt;
-                if (deltaDistance>0) {
-                    p->slope = (deltaAltitude / deltaDistance) * 100;
-                } else {
-                    p->slope = 0;
-                }
-                if (p->slope > 20 || p->slope < -20) {
-                    p->slope = lastP->slope;
-                }
-            }
-        }
+    foreach(RideFilePoint *p, dataPoints_) {
 
-        // derive or calculate gear ratio either from XDATA (if "GEARS" XData data exists)
-        // or from speed and cadence
         double front = RideFile::NA;
         double rear = RideFile::NA;
 
-        XDataSeries *series = xdata("GEARS");
-        if (series && series->datapoints.count() > 0)  {
-            int idx=0;
+        if (gears)  {
             front = xdataValue(p, idx, "GEARS", "FRONT", RideFile::REPEAT);
             rear = xdataValue(p, idx, "GEARS", "REAR", RideFile::REPEAT);
         }
@@ -2531,50 +3018,6 @@ RideFile::recalculateDerivedSeries(bool force)
                 p->gear = 0.0f;
             }
         }
-
-        // split out O2Hb and HHb when we have SmO2 and tHb
-        // O2Hb is oxygenated haemoglobin and HHb is deoxygenated haemoglobin
-        if (dataPresent.smo2 && dataPresent.thb) {
-
-            if (p->smo2 > 0 && p->thb > 0) {
-                setDataPresent(RideFile::o2hb, true);
-                setDataPresent(RideFile::hhb, true);
-
-                p->o2hb = (p->thb * p->smo2) / 100.00f;
-                p->hhb = p->thb - p->o2hb;
-            } else {
-
-                p->o2hb = p->hhb = 0;
-            }
-        }
-
-        // can we derive cycle length ?
-        // needs speed and cadence
-        if (p->kph && (p->cad || p->rcad)) {
-            // need to say we got it
-            setDataPresent(RideFile::clength, true);
-
-            //  only if ride point has cadence and speed > 0
-            if ((p->cad > 0.0f  || p->rcad > 0.0f ) && p->kph > 0.0f) {
-                double cad = p->rcad;
-                if (cad == 0)
-                    cad = p->cad;
-
-                p->clength = (1000.00f * p->kph) / (cad * 60.00f);
-
-                // rounding to 2 decimals
-                p->clength = round(p->clength * 100.00f) / 100.00f;
-            }
-            else {
-                p->clength = 0.0f; // to be filled up with previous gear later
-            }
-
-        } else {
-            p->clength = 0.0f;
-        }
-
-        // last point
-        lastP = p;
     }
 
     // remove gear outlier (for single outlier values = 1 second) and
@@ -2604,26 +3047,65 @@ RideFile::recalculateDerivedSeries(bool force)
 
         }
     }
+}
 
-    // Smooth the slope if it has been derived
-    if (!dataPresent.slope && dataPresent.alt && dataPresent.km) {
-        int smoothPoints = 10;
-        // initialise rolling average
-        double rtot = 0;
-        for (int i=smoothPoints; i>0 && dataPoints_.count()-i >=0; i--) {
-            rtot += dataPoints_[dataPoints_.count()-i]->slope;
+void
+RideFile::deriveHb()
+{
+    // split out O2Hb and HHb when we have SmO2 and tHb
+    // O2Hb is oxygenated haemoglobin and HHb is deoxygenated haemoglobin
+    if (!dataPresent.smo2 || !dataPresent.thb) return;
+
+    foreach(RideFilePoint *p, dataPoints_) {
+
+        if (p->smo2 > 0 && p->thb > 0) {
+            setDataPresent(RideFile::o2hb, true);
+            setDataPresent(RideFile::hhb, true);
+
+            p->o2hb = (p->thb * p->smo2) / 100.00f;
+            p->hhb = p->thb - p->o2hb;
+        } else {
+
+            p->o2hb = p->hhb = 0;
         }
+    }
+}
+
+void
+RideFile::deriveCLength()
+{
+    foreach(RideFilePoint *p, dataPoints_) {
+
+        // can we derive cycle length ?
+        // needs speed and cadence
+        if (p->kph && (p->cad || p->rcad)) {
+            // need to say we got it
+            setDataPresent(RideFile::clength, true);
 
-        // now run backwards setting the rolling average
-        for (int i=dataPoints_.count()-1; i>=smoothPoints; i--) {
-            double here = dataPoints_[i]->slope;
-            dataPoints_[i]->slope = rtot / smoothPoints;
-            rtot -= here;
-            rtot += dataPoints_[i-smoothPoints]->slope;
+            //  only if ride point has cadence and speed > 0
+            if ((p->cad > 0.0f  || p->rcad > 0.0f ) && p->kph > 0.0f) {
+                double cad = p->rcad;
+                if (cad == 0)
+                    cad = p->cad;
+
+                p->clength = (1000.00f * p->kph) / (cad * 60.00f);
+
+                // rounding to 2 decimals
+                p->clength = round(p->clength * 100.00f) / 100.00f;
+            }
+            else {
+                p->clength = 0.0f; // to be filled up with previous gear later
+            }
+
+        } else {
+            p->clength = 0.0f;
         }
-        setDataPresent(RideFile::slope, true);
     }
+}
 
+void
+RideFile::deriveTcore()
+{
     //
     // Core Temperature
     //
@@ -2779,19 +3261,6 @@ RideFile::recalculateDerivedSeries(bool force)
             foreach(RideFilePoint *p, dataPoints_) p->tcore = CTStart;
         }
     }
-
-    // Averages and Totals
-    avgPoint->np = NPcount ? (NPtotal / NPcount) : 0;
-    totalPoint->np = NPtotal;
-
-    avgPoint->xp = XPcount ? (XPtotal / XPcount) : 0;
-    totalPoint->xp = XPtotal;
-
-    avgPoint->apower = APcount ? (APtotal / APcount) : 0;
-    totalPoint->apower = APtotal;
-
-    // and we're done
-    dstale=false;
 }
 
 #ifdef GC_HAVE_SAMPLERATE
@@ -3376,3 +3845,39 @@ XDataSeries::timeIndex(double secs) const
         return datapoints.size()-1;
     return i - datapoints.begin();
 }
+
+int
+XDataSeries::nextIndex(double secs, int from) const
+{
+    XDataPoint p;
+    p.secs = secs;
+
+    // returns datapoints.count() if there isn't one
+    QVector<XDataPoint*>::const_iterator i = std::lower_bound(
+        datapoints.begin() + qBound(0, from, datapoints.count()), datapoints.end(), &p, CompareXDataPointSecs());
+    return i - datapoints.begin();
+}
+
+void
+XDataSeries::compact()
+{
+    int values = valuename.count();
+
+    // QString is implicitly shared, so pooling them means
+    // repeated values all point at the same storage
+    QSet<QString> pool;
+
+    foreach(XDataPoint *p, datapoints) {
+        p->number.resize(values);
+        p->string.resize(values);
+
+        for (int i=0; i<p->string.count(); i++) {
+            QString value = p->string[i];
+            if (value.isEmpty()) continue;
+
+            QSet<QString>::const_iterator it = pool.constFind(value);
+            if (it == pool.constEnd()) pool.insert(value);
+            else p->string.set(i, *it);
+        }
+    }
+}
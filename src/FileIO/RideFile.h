@@ -27,6 +27,8 @@
 #include <QMap>
 #include <QVector>
 #include <QObject>
+#include <QMutex>
+#include <QAtomicInt>
 
 class RideItem;
 class RideCache;
@@ -37,19 +39,23 @@ class RideFile;
 class XDataSeries;
 class XDataPoint;
 struct RideFilePoint;
+class NativeRideFileMap;
 struct RideFileDataPresent;
 class RideFileInterval;
 class EditorData;      // attached to a RideFile
 class RideFileCommand; // for manipulating ride data
 class Context;      // for context; cyclist, homedir
 
-// This file defines four classes:
+// This file defines five classes:
 //
 // RideFile, as the name suggests, represents the data stored in a ride file,
 // regardless of what type of file it is (.raw, .srm, .csv).
 //
 // RideFilePoint represents the data for a single sample in a RideFile.
 //
+// RideFileSeries is a read-only view of a single data series in a RideFile,
+// held as one contiguous array (column) rather than spread across points.
+//
 // RideFileReader is an abstract base class for function-objects that take a
 // filename and return a RideFile object representing the ride stored in the
 // corresponding file.
@@ -136,6 +142,44 @@ class RideFileInterval
         bool isBest() const;
 };
 
+//
+// A read-only view of one series held in a RideFile as a contiguous
+// array, see RideFile::series(). The view shares the column with the
+// ride, so it stays valid if the ride drops or rebuilds the column,
+// e.g. when it is modified on another thread, it just won't see the
+// changes made since.
+//
+class RideFileSeries
+{
+    public:
+        RideFileSeries() : start_(0), count_(0) {}
+        RideFileSeries(const QVector<double> &column) : column_(column), start_(0), count_(column.count()) {}
+
+        bool isEmpty() const { return count_ == 0; }
+        int count() const { return count_; }
+
+        double at(int i) const { return column_.constData()[start_ + i]; }
+        double operator[](int i) const { return column_.constData()[start_ + i]; }
+
+        const double *constData() const { return column_.constData() + start_; }
+        const double *begin() const { return constData(); }
+        const double *end() const { return constData() + count_; }
+
+        // subset of samples, e.g. for an interval
+        RideFileSeries mid(int start, int count) const {
+            if (start < 0 || start >= count_ || count <= 0) return RideFileSeries();
+            if (start + count > count_) count = count_ - start;
+            RideFileSeries subset(*this);
+            subset.start_ = start_ + start;
+            subset.count_ = count;
+            return subset;
+        }
+
+    private:
+        QVector<double> column_;
+        int start_, count_;
+};
+
 struct RideFileCalibration
 {
     double start;
@@ -173,6 +217,7 @@ class RideFile : public QObject // QObject to emit signals
         friend class TcxFileReader;
         friend struct PwxFileReader;
         friend struct JsonFileReader;
+        friend struct NativeFileReader;
         friend class ManualRideDialog;
         friend class PolarFileReader;
         friend class Strava;
@@ -186,7 +231,8 @@ class RideFile : public QObject // QObject to emit signals
         friend class Snippets;
 
         // utility
-        static unsigned int computeFileCRC(QString); 
+        static quint64 computeFileHash(QString);
+        static bool statFile(QString, quint64 &size, qint64 &modified);
         void updateDataTag();
 
         // Constructor / Destructor
@@ -235,10 +281,14 @@ class RideFile : public QObject // QObject to emit signals
         static double maximumFor(SeriesType series);
         static double minimumFor(SeriesType series);
         static QColor colorFor(SeriesType series);
+        static QList<SeriesType> inputsFor(SeriesType series); // recorded series it is derived from
         static bool parseRideFileName(const QString &name, QDateTime *dt);
         bool isRun() const;
         bool isSwim() const;
 
+        // opened with just the series a consumer needed, must not be saved
+        bool isPartial() const { return partial_; }
+
         // Working with DATAPOINTS -- ***use command to modify***
         RideFileCommand *command;
         double getPointValue(int index, SeriesType series) const;
@@ -276,22 +326,53 @@ class RideFile : public QObject // QObject to emit signals
 
         void updatePoint(RideFilePoint *point, const RideFilePoint *oldPoint);
 
-        const QVector<RideFilePoint*> &dataPoints() const { return dataPoints_; }
+        // rides opened from a binary copy read the samples in on first use
+        const QVector<RideFilePoint*> &dataPoints() const { if (isMapped()) loadPoints(); return dataPoints_; }
+        int sampleCount() const; // without reading them in
+
+        // Working with COLUMNS -- each series that is present can be
+        // accessed as a single contiguous array, which is much kinder
+        // to the cache than chasing RideFilePoint pointers. Columns are
+        // copies built on first use, the samples remain the master, and
+        // only the MaxCachedSeries used most recently are kept. Each
+        // change to the samples bumps a revision so they are built
+        // again, the methods here all do, code that writes through a
+        // RideFilePoint* itself must call invalidateSeries() when done.
+        // Code that only reads samples should prefer this to dataPoints()
+        // derived series are computed on first use, see deriveSeries()
+        RideFileSeries series(SeriesType series) const;
+        bool hasSeries(SeriesType series) const;
+        void invalidateSeries();
+
+        // changes each time the column is built, so anything worked out
+        // from series() can tell if it is out of date; -1 if not built
+        int seriesRevision(SeriesType series) const;
 
         // recalculate all the derived data series
         // might want to move to a factory for these
         // at some point, but for now hard coded
         //
-        // YOU MUST ALWAYS CALL THIS BEFORE ACESSING
-        // THE DERIVED DATA. IT IS REFRESHED ON DEMAND.
-        // STATE IS MAINTAINED IN 'bool dstale' BELOW
-        // TO ENSURE IT IS ONLY REFRESHED IF NEEDED
+        // YOU MUST ALWAYS CALL THIS OR deriveSeries() BEFORE
+        // ACESSING THE DERIVED DATA IN THE DATA POINTS. IT IS
+        // REFRESHED ON DEMAND. STATE IS MAINTAINED IN 'dstale'
+        // BELOW TO ENSURE IT IS ONLY REFRESHED IF NEEDED
         //
         void recalculateDerivedSeries(bool force=false);
 
+        // just the derived series asked for (and any computed along
+        // with it, e.g. all the deltas). series(), getPointValue() and
+        // isDataPresent() call this so only code walking dataPoints()
+        // directly needs to. Derived data is a cache of the recorded
+        // data so this is const, much like wprimeData()
+        void deriveSeries(SeriesType series) const;
+
+        // all of them, for code that walks dataPoints() and may read any
+        // derived value, e.g. the file writers and the uploaders
+        void deriveAll() const;
+
         // Working with DATAPRESENT flags
         inline const RideFileDataPresent *areDataPresent() const { return &dataPresent; }
-        bool isDataPresent(SeriesType series);
+        bool isDataPresent(SeriesType series) const;
         QVector<SeriesType> arePresent(); // list of what is present
 
         // Working with FIRST CLASS variables
@@ -350,6 +431,7 @@ class RideFile : public QObject // QObject to emit signals
         double getHeight(); // legacy - moved to Athlete::getHeight
  
         WPrime *wprimeData(); // return wprime, init/refresh if needed
+        void invalidateWprime(); // refreshed when next asked for
 
         // XDATA
         XDataSeries *xdata(QString name) { return xdata_.value(name, NULL); }
@@ -433,7 +515,65 @@ class RideFile : public QObject // QObject to emit signals
         void updateMax(RideFilePoint* point);
         void updateAvg(RideFilePoint* point);
 
-        bool dstale; // is derived data up to date?
+        // read a flag another thread may set, see dstale and mapped_
+        static int loadAcquire(const QAtomicInt &value) {
+#if QT_VERSION >= 0x050000
+            return value.loadAcquire();
+#else
+            return value;
+#endif
+        }
+
+        // derived series are computed in groups, each with its
+        // own bit in dstale so we only compute what is asked for
+        enum { DeltaSeries = 0x1, NPSeries = 0x2, XPowerSeries = 0x4, APowerSeries = 0x8,
+               TISSSeries = 0x10, SlopeSeries = 0x20, GearSeries = 0x40, HbSeries = 0x80,
+               CLengthSeries = 0x100, TcoreSeries = 0x200, AllDerivedSeries = 0x3ff };
+        static unsigned int derivedGroup(SeriesType series);
+
+        void derive(unsigned int groups, bool force);
+        void deriveDeltas();
+        void deriveNP();
+        void deriveXPower();
+        void deriveAPower();
+        void deriveTISS();
+        void deriveSlope();
+        void deriveGear();
+        void deriveHb();
+        void deriveCLength();
+        void deriveTcore();
+
+        // which derived data groups are out of date? it is checked
+        // without the lock, so only changed whilst holding deriveLock,
+        // as is wstale, which is only read holding it too
+        QAtomicInt dstale;
+        unsigned int staleGroups() const { return loadAcquire(dstale); }
+        void derivedStale(); // all of them, and W'
+        QMutex deriveLock;
+        bool partial_; // only some of the series were loaded
+
+        // columnar copies of the data points, see series(), only
+        // the ones used most recently are kept
+        enum { MaxCachedSeries = 16 };
+        mutable QVector<double> columns_[none];
+        mutable int columnRevisions_[none];
+        mutable int columnBuilt_[none]; // the dataRevision_ each was built from
+        QAtomicInt dataRevision_; // bumped by every change to the samples
+        mutable QList<int> columnsUsed; // least recently first
+        mutable QMutex columnLock;
+
+        // samples not yet read in from a binary copy, see NativeFileReader
+        // mapped_ is checked without the lock, so is set last and cleared
+        // once the samples are in dataPoints_
+        bool isMapped() const { return loadAcquire(mapped_) != 0; }
+        void setMapped(NativeRideFileMap *map);
+        void loadPoints() const;
+        QVector<RideFilePoint*> &points() const { if (isMapped()) loadPoints(); return const_cast<RideFile*>(this)->dataPoints_; }
+
+        mutable QMutex mapLock;
+        mutable QAtomicInt mapped_;
+        NativeRideFileMap *map_;
+        mutable bool loading_;
 
         // data required to compute headwind based on weather broadcast
         double windSpeed_, windHeading_;
@@ -543,27 +683,40 @@ class RideFileIterator {
 
 #define XDATA_MAXVALUES 32
 
-class XDataPoint {
+// XDATA values only take as many slots as have been written, which
+// is at most the number of values the series declares, rather than
+// a fixed XDATA_MAXVALUES. Reading an unwritten slot gives a default
+// value, set() grows the slots to fit, there is no writable []
+// so a slot is never added by accident.
+//
+// They are still kept with each point, rather than as a column for
+// each value with strings pooled, as the readers, the editor and the
+// data filter all work with XDataPoint; XDataSeries::compact() sizes
+// them and shares repeated strings once a series is read.
+template <typename T>
+class XDataValues {
 public:
-    XDataPoint() {
-        secs=km=0;
-        for(int i=0; i<XDATA_MAXVALUES; i++) {
-            number[i]=0;
-            string[i]="";
-        }
-    }
-    XDataPoint (const XDataPoint &other) {
-        this->secs=other.secs;
-        this->km=other.km;
-        for(int i=0; i<XDATA_MAXVALUES; i++) {
-            this->number[i]= other.number[i];
-            this->string[i]= other.string[i];
-        }
+    T operator[](int i) const { return i >= 0 && i < values.count() ? values.at(i) : T(); }
+    void set(int i, const T &value) {
+        if (i < 0) return;
+        if (i >= values.count()) values.resize(i+1);
+        values[i] = value;
     }
 
+    int count() const { return values.count(); }
+    void resize(int n) { values.resize(n); values.squeeze(); }
+
+private:
+    QVector<T> values;
+};
+
+class XDataPoint {
+public:
+    XDataPoint() : secs(0), km(0) {}
+
     double secs, km;
-    double number[XDATA_MAXVALUES];
-    QString string[XDATA_MAXVALUES];
+    XDataValues<double> number;
+    XDataValues<QString> string;
 };
 
 class XDataSeries {
@@ -580,6 +733,11 @@ public:
     ~XDataSeries() { foreach(XDataPoint *p, datapoints) delete p; }
 
     int timeIndex(double) const;          // get index offset for time in secs
+    int nextIndex(double, int from) const; // first point at or after time, searching on from index
+
+    // size value slots to those declared in valuename and
+    // share the storage of repeated string values
+    void compact();
 
     QString name;
     QStringList valuename;
@@ -608,6 +766,9 @@ class RideFileFactory {
 
         RideFileFactory() {}
 
+        RideFile *readRideFile(Context *context, QFile &file, QStringList &errors, QList<RideFile*> *rideList,
+                               const QList<RideFile::SeriesType> *series, const QStringList *xdata) const;
+
     protected:
 
         friend class ::MetricAggregator;
@@ -627,6 +788,12 @@ class RideFileFactory {
         int registerReader(const QString &suffix, const QString &description,
                            RideFileReader *reader);
         RideFile *openRideFile(Context *context, QFile &file, QStringList &errors, QList<RideFile*>* = 0) const;
+
+        // open with just the listed series (secs, km and interval are always loaded)
+        // and XDATA series when the file format supports it, otherwise the whole
+        // ride is read. Presence flags are kept for series that were not loaded.
+        RideFile *openRideFile(Context *context, QFile &file, QStringList &errors,
+                               const QList<RideFile::SeriesType> &series, const QStringList &xdata) const;
         bool writeRideFile(Context *context, const RideFile *ride, QFile &file, QString format) const;
         QStringList suffixes() const;
         QStringList writeSuffixes() const;
@@ -17,6 +17,10 @@
  */
 
 #include "RideFileCache.h"
+#include "RideFileCacheIndex.h"
+#include "RideFileCacheReader.h"
+#include "CpxCodec.h"
+#include "MeanMaxSearch.h"
 #include "MainWindow.h"
 #include "Context.h"
 #include "Athlete.h"
@@ -26,8 +30,10 @@
 #include "PaceZones.h"
 #include "WPrime.h" // for wbal zones
 #include "LTMSettings.h" // getAllBestsFor needs this
+#include "Settings.h"
 
 #include <cmath> // for pow()
+#include <string.h> // for memcpy()
 #include <QDebug>
 #include <QFileInfo>
 #include <QMessageBox>
@@ -82,39 +88,14 @@ RideFileCache::RideFileCache(Context *context, QString fileName, double weight,
     // Get info for ride file and cache file
     QFileInfo rideFileInfo(rideFileName);
     cacheFileName = context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx";
-    QFileInfo cacheFileInfo(cacheFileName);
 
     // is it up-to-date?
-    if (cacheFileInfo.exists() && cacheFileInfo.size() >= (int)sizeof(struct RideFileCacheHeader)) {
-
-        // we have a file, it is more recent than the ride file
-        // but is it the latest version?
-        RideFileCacheHeader head;
-        QFile cacheFile(cacheFileName);
-        if (cacheFile.open(QIODevice::ReadOnly) == true) {
-
-            // read the header
-            QDataStream inFile(&cacheFile);
-            inFile.readRawData((char *) &head, sizeof(head));
-            cacheFile.close();
-
-            // its more recent -or- the crc is the same
-            if (rideFileInfo.lastModified() <= cacheFileInfo.lastModified() ||
-                head.crc == RideFile::computeFileCRC(rideFileName)) {
- 
-                // it is the same ?
-                if (head.version == RideFileCacheVersion && head.WEIGHT == weight) {
-
-                    // WE'RE GOOD
-                    if (check == false) readCache(); // if check is false we aren't just checking
-                    return;
-                } else {
-                    // for debug only
-                    //qDebug()<<"refresh because version ("<<RideFileCacheVersion<<","<<head.version<<")"
-                    //        << " weight ("<< weight <<"," <<head.WEIGHT<<")";
-                }
-            }
-        }
+    RideFileCacheReader reader;
+    if (openCurrent(reader, rideFileName, cacheFileName, weight)) {
+
+        // WE'RE GOOD
+        if (check == false) readCache(reader); // if check is false we aren't just checking
+        return;
     }
 
     // NEED TO UPDATE!!
@@ -165,184 +146,91 @@ RideFileCache::checkStale(Context *context, RideItem*item)
     else
         cacheFileName = context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx";
 
-    QFileInfo cacheFileInfo(cacheFileName);
-
-    // is it up-to-date?
-    if (cacheFileInfo.exists() && cacheFileInfo.size() >= (int)sizeof(struct RideFileCacheHeader)) {
-
-        // we have a file, it is more recent than the ride file
-        // but is it the latest version?
-        RideFileCacheHeader head;
-        QFile cacheFile(cacheFileName);
-        if (cacheFile.open(QIODevice::ReadOnly) == true) {
-
-            // read the header
-            QDataStream inFile(&cacheFile);
-            inFile.readRawData((char *) &head, sizeof(head));
-            cacheFile.close();
+    // is it up-to-date? with the weight it was last checked with, this
+    // is called off the gui thread after RideItem::checkStale has set it
+    RideFileCacheReader reader;
+    return !openCurrent(reader, rideFileName, cacheFileName, item->weight);
+}
 
-            // its more recent -or- the crc is the same
-            if (rideFileInfo.lastModified() <= cacheFileInfo.lastModified() ||
-                head.crc == RideFile::computeFileCRC(rideFileName)) {
+// open the .cpx if it is the latest version and up to date with the ride file
+bool
+RideFileCache::openCurrent(RideFileCacheReader &reader, QString rideFileName, QString cacheFileName, double weight)
+{
+    QFileInfo rideFileInfo(rideFileName);
+    QFileInfo cacheFileInfo(cacheFileName);
 
-                // it is the same ?
-                if (head.version == RideFileCacheVersion && head.WEIGHT == item->getWeight()) {
+    // does it exist, and is it the latest version ?
+    if (!cacheFileInfo.exists() || reader.open(cacheFileName) == false) return false;
 
-                    // WE'RE GOOD
-                    return false;
-                }
-            }
-        }
-    }
+    // it is more recent -or- the crc is the same, and the same weight was used
+    if (reader.header().WEIGHT == weight &&
+        (rideFileInfo.lastModified() <= cacheFileInfo.lastModified() ||
+         reader.header().crc == RideFile::computeFileHash(rideFileName))) return true;
 
-    // its stale !
-    return true;
+    //qDebug()<<"refresh because weight ("<< weight <<"," <<reader.header().WEIGHT<<") or crc";
+    reader.close();
+    return false;
 }
 
-// returns offset from end of head
-static long offsetForMeanMax(RideFileCacheHeader head, RideFile::SeriesType series)
+// the same for an activity, with the weight it uses
+bool
+RideFileCache::openCurrent(RideFileCacheReader &reader, Context *context, RideItem *item)
 {
-    long offset = 0;
-
-    switch (series) {
-    case RideFile::aPowerKg : offset += head.aPowerMeanMaxCount * sizeof(float);
-    case RideFile::aPower : offset += head.vamMeanMaxCount * sizeof(float);
-    case RideFile::vam : offset += head.npMeanMaxCount * sizeof(float);
-    case RideFile::NP : offset += head.xPowerMeanMaxCount * sizeof(float);
-    case RideFile::xPower : offset += head.kphMeanMaxCount * sizeof(float);
-    case RideFile::hrd : offset += head.hrdMeanMaxCount * sizeof(float);
-    case RideFile::nmd : offset += head.nmdMeanMaxCount * sizeof(float);
-    case RideFile::cadd : offset += head.caddMeanMaxCount * sizeof(float);
-    case RideFile::wattsd : offset += head.wattsdMeanMaxCount * sizeof(float);
-    case RideFile::kphd : offset += head.kphdMeanMaxCount * sizeof(float);
-    case RideFile::kph : offset += head.nmMeanMaxCount * sizeof(float);
-    case RideFile::nm : offset += head.cadMeanMaxCount * sizeof(float);
-    case RideFile::cad : offset += head.hrMeanMaxCount * sizeof(float);
-    case RideFile::hr : offset += head.wattsKgMeanMaxCount * sizeof(float);
-    case RideFile::wattsKg : offset += head.wattsMeanMaxCount * sizeof(float);
-    case RideFile::watts : offset += 0;
-    default:
-        break;
-    }
+    QString rideFileName = context->athlete->home->activities().canonicalPath() + "/" + item->fileName;
+    QFileInfo rideFileInfo(rideFileName);
 
-    return offset;
+    return openCurrent(reader, rideFileName, context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx",
+                       item->getWeight());
 }
 
-//offset to tiz table
-static long offsetForTiz(RideFileCacheHeader head, RideFile::SeriesType series)
+// keep the best of the raw values read from a cache file
+static void meanMaxBest(QVector<float> &into, const float *from, int count, float divisor)
 {
-    long offset = 0;
-
-    // skip past the mean max arrays
-    offset += head.aPowerKgMeanMaxCount * sizeof(float);
-    offset += head.aPowerMeanMaxCount * sizeof(float);
-    offset += head.vamMeanMaxCount * sizeof(float);
-    offset += head.npMeanMaxCount * sizeof(float);
-    offset += head.xPowerMeanMaxCount * sizeof(float);
-    offset += head.hrdMeanMaxCount * sizeof(float);
-    offset += head.nmdMeanMaxCount * sizeof(float);
-    offset += head.caddMeanMaxCount * sizeof(float);
-    offset += head.wattsdMeanMaxCount * sizeof(float);
-    offset += head.kphdMeanMaxCount * sizeof(float);
-    offset += head.kphMeanMaxCount * sizeof(float);
-    offset += head.nmMeanMaxCount * sizeof(float);
-    offset += head.cadMeanMaxCount * sizeof(float);
-    offset += head.hrMeanMaxCount * sizeof(float);
-    offset += head.wattsKgMeanMaxCount * sizeof(float);
-    offset += head.wattsMeanMaxCount * sizeof(float);
-
-    // skip past the distribution arrays
-    offset += head.wattsDistCount * sizeof(float);
-    offset += head.hrDistCount * sizeof(float);
-    offset += head.cadDistCount * sizeof(float);
-    offset += head.gearDistCount * sizeof(float);
-    offset += head.nmDistrCount * sizeof(float);
-    offset += head.kphDistCount * sizeof(float);
-    offset += head.xPowerDistCount * sizeof(float);
-    offset += head.npDistCount * sizeof(float);
-    offset += head.wattsKgDistCount * sizeof(float);
-    offset += head.aPowerDistCount * sizeof(float);
-    offset += head.smo2DistCount * sizeof(float);
-    offset += head.wbalDistCount * sizeof(float);
-
-    // tiz ist currently just for RideFile:watts, RideFile:hr, RideFile:kph and RideFile:wbal
-    // watts is first - so move on with offset only for 'hr' and 'kph' and 'wbal'
-    // structure for "tiz" data - watts(10)/CPwatts(4)/HR(10)/CPhr(4)/PACE(10)/CPpace
-    if (series == RideFile::hr) offset += (10+4) * sizeof(float);
-    if (series == RideFile::kph) offset += 2*(10+4) * sizeof(float);
-    if (series == RideFile::wbal) offset += 3*(10+4) * sizeof(float);
-
-    return offset;
-}
-
+    int had = into.size();
+    if (had < count) into.resize(count);
 
-// returns offset from end of head
-static long countForMeanMax(RideFileCacheHeader head, RideFile::SeriesType series)
-{
-    switch (series) {
-    case RideFile::aPowerKg : return head.aPowerKgMeanMaxCount;
-    case RideFile::aPower : return head.aPowerMeanMaxCount;
-    case RideFile::wattsKg : return head.wattsKgMeanMaxCount;
-    case RideFile::vam : return head.vamMeanMaxCount;
-    case RideFile::NP : return head.npMeanMaxCount;
-    case RideFile::xPower :  return head.xPowerMeanMaxCount;
-    case RideFile::kph :  return head.kphMeanMaxCount;
-    case RideFile::kphd :  return head.kphdMeanMaxCount;
-    case RideFile::wattsd :  return head.wattsdMeanMaxCount;
-    case RideFile::cadd :  return head.caddMeanMaxCount;
-    case RideFile::nmd :  return head.nmdMeanMaxCount;
-    case RideFile::hrd :  return head.hrdMeanMaxCount;
-    case RideFile::nm :  return head.nmMeanMaxCount;
-    case RideFile::cad :  return head.cadMeanMaxCount;
-    case RideFile::hr :  return head.hrMeanMaxCount;
-    case RideFile::watts :  return head.wattsMeanMaxCount;
-    default:
-        break;
+    float *to = into.data();
+    for (int i=0; i<count; i++) {
+        float value = from[i] / divisor;
+        if (i >= had || value > to[i]) to[i] = value;
     }
-
-    return 0;
 }
 
 QVector<float> RideFileCache::meanMaxPowerFor(Context *context, QVector<float> &wpk, QDate from, QDate to, bool wantruns)
 {
-    QVector<float> returning;
-    QVector<float> returningwpk;
-    bool first = true;
-
     // look at all the rides
+    QList<RideItem*> rides;
     foreach (RideItem *item, context->athlete->rideCache->rides()) {
 
         if (item->dateTime.date() < from || item->dateTime.date() > to) continue; // not one we want
 
         if (item->isRun && !wantruns) continue; // they don't want runs
 
-        // get the power data
-        if (first == true) {
-
-            // first time through the whole thing is going to be best
-            returning =  meanMaxPowerFor(context, returningwpk, context->athlete->home->activities().canonicalPath() + "/" + item->fileName);
-            first = false;
-
-        } else {
-
-            QVector<float> thiswpk;
+        rides << item;
+    }
+    return meanMaxPowerFor(context, wpk, rides);
+}
 
-            // next time through we should only pick out better times
-            QVector<float> ridebest = meanMaxPowerFor(context, thiswpk, context->athlete->home->activities().canonicalPath() + "/" + item->fileName);
+QVector<float> RideFileCache::meanMaxPowerFor(Context *context, QVector<float> &wpk, const QList<RideItem*> &rides, bool *complete)
+{
+    QVector<float> returning;
+    QVector<float> returningwpk;
 
-            // do we need to increase the returning array?
-            if (returning.size() < ridebest.size()) returning.resize(ridebest.size());
+    if (complete) *complete = true;
 
-            // now update where its a better number
-            for (int i=0; i<ridebest.size(); i++)
-                if (ridebest[i] > returning[i]) returning[i] = ridebest[i];
+    RideFileCacheReader reader;
+    foreach (RideItem *item, rides) {
 
-            // do we need to increase the returning array?
-            if (returningwpk.size() < thiswpk.size()) returningwpk.resize(thiswpk.size());
+        // only the power and wpk arrays are read from the cache file
+        if (!openCurrent(reader, context, item)) {
+            if (complete) *complete = false;
+            continue;
+        }
 
-            // now update where its a better number
-            for (int i=0; i<thiswpk.size(); i++)
-                if (thiswpk[i] > returningwpk[i]) returningwpk[i] =thiswpk[i];
+        // now update where its a better number
+        if (reader.meanMaxCount(RideFile::watts) > 0) {
+            meanMaxBest(returning, reader.meanMaxData(RideFile::watts), reader.meanMaxCount(RideFile::watts), 1.0f);
+            meanMaxBest(returningwpk, reader.meanMaxData(RideFile::wattsKg), reader.meanMaxCount(RideFile::wattsKg), 100.0f);
         }
     }
 
@@ -353,54 +241,21 @@ QVector<float> RideFileCache::meanMaxPowerFor(Context *context, QVector<float> &
 
 QVector<float> RideFileCache::meanMaxPowerFor(Context *context, QVector<float>&wpk, QString fileName)
 {
-    QTime start;
-    start.start();
-
     QVector<float> returning;
 
     // Get info for ride file and cache file
     QFileInfo rideFileInfo(fileName);
-    QString cacheFilename = context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx";
-    QFileInfo cacheFileInfo(cacheFilename);
-
-    // is it up-to-date?
-    if (cacheFileInfo.exists() && cacheFileInfo.size() >= (int)sizeof(struct RideFileCacheHeader)) {
-
-        // we have a file, it is more recent than the ride file
-        // but is it the latest version?
-        RideFileCacheHeader head;
-        QFile cacheFile(cacheFilename);
-        if (cacheFile.open(QIODevice::ReadOnly) == true) {
-
-            // read the header
-            QDataStream inFile(&cacheFile);
-            inFile.readRawData((char *) &head, sizeof(head));
-
-            // check its an up to date format and contains power
-            if (head.version == RideFileCacheVersion && head.wattsMeanMaxCount > 0) {
+    RideFileCacheReader reader(context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx");
 
-                // seek to start of meanmax array in the cache
-                long offset = offsetForMeanMax(head, RideFile::watts) + sizeof(head);
-                cacheFile.seek(qint64(offset));
+    // check its an up to date format and contains power
+    if (reader.meanMaxCount(RideFile::watts) > 0) {
 
-                // read from cache and put straight into QVector memory
-                // a little naughty but seems to work ok
-                returning.resize(head.wattsMeanMaxCount);
-                inFile.readRawData((char*)returning.constData(), head.wattsMeanMaxCount * sizeof(float));
+        // straight from the mapped file into QVector memory
+        returning.resize(reader.meanMaxCount(RideFile::watts));
+        memcpy(returning.data(), reader.meanMaxData(RideFile::watts), returning.size() * sizeof(float));
 
-                offset = offsetForMeanMax(head, RideFile::wattsKg) + sizeof(head);
-                cacheFile.seek(qint64(offset));
-
-                wpk.resize(head.wattsKgMeanMaxCount);
-                inFile.readRawData((char*)wpk.constData(), head.wattsKgMeanMaxCount * sizeof(float));
-                for(int i=0; i<wpk.size(); i++) wpk[i] = wpk[i] / 100.00f;
-
-                //qDebug()<<"retrieved:"<<head.wattsMeanMaxCount<<"in:"<<start.elapsed()<<"ms";
-            }
-
-            // we're done reading
-            cacheFile.close();
-        }
+        wpk.resize(0);
+        meanMaxBest(wpk, reader.meanMaxData(RideFile::wattsKg), reader.meanMaxCount(RideFile::wattsKg), 100.0f);
     }
 
     // will be empty if no up to date cache
@@ -413,45 +268,16 @@ QVector<float> RideFileCache::meanMaxPowerFor(Context *context, QVector<float>&w
 // API bests for a ride
 QVector<float> RideFileCache::meanMaxFor(QString cacheFilename, RideFile::SeriesType series)
 {
-    QTime start;
-    start.start();
-
     QVector<float> returning;
 
-    // Get info for ride file and cache file
-    QFileInfo cacheFileInfo(cacheFilename);
-
-    // is it up-to-date?
-    if (cacheFileInfo.exists() && cacheFileInfo.size() >= (int)sizeof(struct RideFileCacheHeader)) {
-
-        // we have a file, it is more recent than the ride file
-        // but is it the latest version?
-        RideFileCacheHeader head;
-        QFile cacheFile(cacheFilename);
-        if (cacheFile.open(QIODevice::ReadOnly) == true) {
+    // check its an up to date format and has the series
+    RideFileCacheReader reader(cacheFilename);
+    int count = reader.meanMaxCount(series);
+    if (count > 0) {
 
-            // read the header
-            QDataStream inFile(&cacheFile);
-            inFile.readRawData((char *) &head, sizeof(head));
-
-            int count = countForMeanMax(head, series);
-
-            // check its an up to date format and contains power
-            if (head.version == RideFileCacheVersion && count>0) {
-
-                // seek to start of meanmax array in the cache
-                long offset = offsetForMeanMax(head, series) + sizeof(head);
-                cacheFile.seek(qint64(offset));
-
-                // read from cache and put straight into QVector memory
-                // a little naughty but seems to work ok
-                returning.resize(count);
-                inFile.readRawData((char*)returning.constData(), count * sizeof(float));
-            }
-
-            // we're done reading
-            cacheFile.close();
-        }
+        // straight from the mapped file into QVector memory
+        returning.resize(count);
+        memcpy(returning.data(), reader.meanMaxData(series), count * sizeof(float));
     }
 
     // will be empty if no up to date cache
@@ -462,20 +288,14 @@ QVector<float> RideFileCache::meanMaxFor(QString cacheFilename, RideFile::Series
 // API bests for a date range
 QVector<float> RideFileCache::meanMaxFor(QString cacheDir, RideFile::SeriesType series, QDate from, QDate to)
 {
-    QTime start;
-    start.start();
-
-    bool first = true;
     QVector<float> returning;
 
     // loop through all CPX files
+    RideFileCacheReader reader;
     foreach(QString cacheFilename, QDir(cacheDir).entryList(QDir::Files)) {
 
         // is it a cpx file ?
         if (!cacheFilename.endsWith(".cpx")) continue;
-   
-        // is it big enough ? 
-        if (QFileInfo(cacheDir + "/" + cacheFilename).size() < (int)sizeof(struct RideFileCacheHeader)) continue;
 
         // lets check it parses ok ?
         QDateTime dt;
@@ -484,22 +304,12 @@ QVector<float> RideFileCache::meanMaxFor(QString cacheDir, RideFile::SeriesType
         // in range?
         if (dt.date() < from || dt.date() > to) continue;
 
-        // get data
-        QVector<float> current = RideFileCache::meanMaxFor(cacheDir + "/" + cacheFilename, series);
-
-        // first ?
-        if (first) {
-            first = false;
-            returning = current;
-        } else {
-            if (current.size() > returning.size()) returning.resize(current.size());
-            for(int i=0; i< current.size(); i++) if (current[i] > returning[i]) returning[i]=current[i];
-        }
+        // get data, only the series asked for is read
+        if (reader.open(cacheDir + "/" + cacheFilename) && reader.meanMaxCount(series) > 0)
+            meanMaxBest(returning, reader.meanMaxData(series), reader.meanMaxCount(series), 1.0f);
     }
 
-    // will be empty if no up to date cache
     return returning;
-
 }
 
 RideFileCache::RideFileCache(RideFile *ride) :
@@ -546,7 +356,6 @@ RideFileCache::RideFileCache(RideFile *ride) :
     wbalTimeInZone.resize(4);
 
     WEIGHT = ride->getWeight();
-    ride->recalculateDerivedSeries(); // accel and others
 
     // calculate all the arrays
     compute();
@@ -690,6 +499,27 @@ QList<RideFile::SeriesType> RideFileCache::meanMaxList()
     return list;
 }
 
+QList<RideFile::SeriesType>
+RideFileCache::computedList()
+{
+    // mean maxes, distributions and time in zone
+    QList<RideFile::SeriesType> computed = meanMaxList();
+    computed << RideFile::kphd << RideFile::wattsd << RideFile::cadd << RideFile::nmd << RideFile::hrd
+             << RideFile::gear << RideFile::smo2 << RideFile::wbal;
+    return computed;
+}
+
+void
+RideFileCache::inputs(QList<RideFile::SeriesType> &series, QStringList &xdata)
+{
+    foreach(RideFile::SeriesType x, computedList())
+        foreach(RideFile::SeriesType recorded, RideFile::inputsFor(x))
+            if (!series.contains(recorded)) series << recorded;
+
+    // gear ratios come from XDATA when it is there
+    if (!xdata.contains("GEARS")) xdata << "GEARS";
+}
+
 QVector<double> &
 RideFileCache::meanMaxArray(RideFile::SeriesType series)
 {
@@ -833,7 +663,7 @@ RideFileCache::refreshCache()
     static bool writeerror=false;
 
     // set head crc
-    crc = RideFile::computeFileCRC(rideFileName);
+    crc = RideFile::computeFileHash(rideFileName);
 
     // update cache!
     QFile cacheFile(cacheFileName);
@@ -862,6 +692,7 @@ RideFileCache::refreshCache()
                 context->athlete->cpxCache.removeAt(i);
             } else i++;
         }
+        context->athlete->cpxIndex->invalidate(date);
 
 
     } else if (writeerror == false) {
@@ -895,63 +726,64 @@ void RideFileCache::refresh(RideFile *file)
     compute();
 }
 
-// this function is a candidate for supporting
-// threaded calculations, each of the computes
-// in here could go in its own thread. Users
-// with many cores would benefit enormously
+// each of the computes in here is a task, run together on the
+// shared pool, see RideFileCacheTasks
 void RideFileCache::RideFileCache::compute()
 {
     if (ride == NULL) {
         return;
     }
 
+    // derive just the series we use, before the tasks start
+    foreach(RideFile::SeriesType x, computedList()) ride->deriveSeries(x);
+
+    // and W'bal, which is computed on first use
+    if (ride->isDataPresent(RideFile::watts)) ride->wprimeData();
+
+    // the zone parameters the distributions use
+    int zoneRange = context->athlete->zones(ride->isRun()) ? context->athlete->zones(ride->isRun())->whichRange(ride->startTime().date()) : -1;
+    int hrZoneRange = context->athlete->hrZones(ride->isRun()) ? context->athlete->hrZones(ride->isRun())->whichRange(ride->startTime().date()) : -1;
+    int paceZoneRange = context->athlete->paceZones(ride->isSwim()) ? context->athlete->paceZones(ride->isSwim())->whichRange(ride->startTime().date()) : -1;
+
+    CP = zoneRange != -1 ? context->athlete->zones(ride->isRun())->getCP(zoneRange) : 0;
+    WPRIME = zoneRange != -1 ? context->athlete->zones(ride->isRun())->getWprime(zoneRange) : 0;
+    LTHR = hrZoneRange != -1 ? context->athlete->hrZones(ride->isRun())->getLT(hrZoneRange) : 0;
+    CV = paceZoneRange != -1 ? context->athlete->paceZones(ride->isSwim())->getCV(paceZoneRange) : 0;
+
+    RideFileCacheTasks tasks;
+
     // all the mean maxes
-    MeanMaxComputer thread1(ride, wattsMeanMax, RideFile::watts); thread1.start();
-    MeanMaxComputer thread2(ride, hrMeanMax, RideFile::hr); thread2.start();
-    MeanMaxComputer thread3(ride, cadMeanMax, RideFile::cad); thread3.start();
-    MeanMaxComputer thread4(ride, nmMeanMax, RideFile::nm); thread4.start();
-    MeanMaxComputer thread5(ride, kphMeanMax, RideFile::kph); thread5.start();
-    MeanMaxComputer thread6(ride, xPowerMeanMax, RideFile::xPower); thread6.start();
-    MeanMaxComputer thread7(ride, npMeanMax, RideFile::NP); thread7.start();
-    MeanMaxComputer thread8(ride, vamMeanMax, RideFile::vam); thread8.start();
-    MeanMaxComputer thread9(ride, wattsKgMeanMax, RideFile::wattsKg); thread9.start();
-    MeanMaxComputer thread10(ride, aPowerMeanMax, RideFile::aPower); thread10.start();
-    MeanMaxComputer thread11(ride, kphdMeanMax, RideFile::kphd); thread11.start();
-    MeanMaxComputer thread12(ride, wattsdMeanMax, RideFile::wattsd); thread12.start();
-    MeanMaxComputer thread13(ride, caddMeanMax, RideFile::cadd); thread13.start();
-    MeanMaxComputer thread14(ride, nmdMeanMax, RideFile::nmd); thread14.start();
-    MeanMaxComputer thread15(ride, hrdMeanMax, RideFile::hrd); thread15.start();
-    MeanMaxComputer thread16(ride, aPowerKgMeanMax, RideFile::aPowerKg); thread16.start();
+    tasks.add(new MeanMaxComputer(ride, wattsMeanMax, RideFile::watts));
+    tasks.add(new MeanMaxComputer(ride, hrMeanMax, RideFile::hr));
+    tasks.add(new MeanMaxComputer(ride, cadMeanMax, RideFile::cad));
+    tasks.add(new MeanMaxComputer(ride, nmMeanMax, RideFile::nm));
+    tasks.add(new MeanMaxComputer(ride, kphMeanMax, RideFile::kph));
+    tasks.add(new MeanMaxComputer(ride, xPowerMeanMax, RideFile::xPower));
+    tasks.add(new MeanMaxComputer(ride, npMeanMax, RideFile::NP));
+    tasks.add(new MeanMaxComputer(ride, vamMeanMax, RideFile::vam));
+    tasks.add(new MeanMaxComputer(ride, wattsKgMeanMax, RideFile::wattsKg));
+    tasks.add(new MeanMaxComputer(ride, aPowerMeanMax, RideFile::aPower));
+    tasks.add(new MeanMaxComputer(ride, kphdMeanMax, RideFile::kphd));
+    tasks.add(new MeanMaxComputer(ride, wattsdMeanMax, RideFile::wattsd));
+    tasks.add(new MeanMaxComputer(ride, caddMeanMax, RideFile::cadd));
+    tasks.add(new MeanMaxComputer(ride, nmdMeanMax, RideFile::nmd));
+    tasks.add(new MeanMaxComputer(ride, hrdMeanMax, RideFile::hrd));
+    tasks.add(new MeanMaxComputer(ride, aPowerKgMeanMax, RideFile::aPowerKg));
 
     // all the different distributions
-    computeDistribution(wattsDistribution, RideFile::watts);
-    computeDistribution(hrDistribution, RideFile::hr);
-    computeDistribution(cadDistribution, RideFile::cad);
-    computeDistribution(gearDistribution, RideFile::gear);
-    computeDistribution(nmDistribution, RideFile::nm);
-    computeDistribution(kphDistribution, RideFile::kph);
-    computeDistribution(wattsKgDistribution, RideFile::wattsKg);
-    computeDistribution(aPowerDistribution, RideFile::aPower);
-    computeDistribution(smo2Distribution, RideFile::smo2);
-    computeDistribution(wbalDistribution, RideFile::wbal);
-
-    // wait for them threads
-    thread1.wait();
-    thread2.wait();
-    thread3.wait();
-    thread4.wait();
-    thread5.wait();
-    thread6.wait();
-    thread7.wait();
-    thread8.wait();
-    thread9.wait();
-    thread10.wait();
-    thread11.wait();
-    thread12.wait();
-    thread13.wait();
-    thread14.wait();
-    thread15.wait();
-    thread16.wait();
+    tasks.add(new DistributionComputer(this, wattsDistribution, RideFile::watts));
+    tasks.add(new DistributionComputer(this, hrDistribution, RideFile::hr));
+    tasks.add(new DistributionComputer(this, cadDistribution, RideFile::cad));
+    tasks.add(new DistributionComputer(this, gearDistribution, RideFile::gear));
+    tasks.add(new DistributionComputer(this, nmDistribution, RideFile::nm));
+    tasks.add(new DistributionComputer(this, kphDistribution, RideFile::kph));
+    tasks.add(new DistributionComputer(this, wattsKgDistribution, RideFile::wattsKg));
+    tasks.add(new DistributionComputer(this, aPowerDistribution, RideFile::aPower));
+    tasks.add(new DistributionComputer(this, smo2Distribution, RideFile::smo2));
+    tasks.add(new DistributionComputer(this, wbalDistribution, RideFile::wbal));
+
+    // run them and wait till they're all done
+    tasks.run();
 
     // setup the doubles the users use
     doubleArray(wattsMeanMaxDouble, wattsMeanMax, RideFile::watts);
@@ -985,223 +817,91 @@ void RideFileCache::RideFileCache::compute()
     doubleArrayForDistribution(wbalDistributionDouble, wbalDistribution);
 }
 
-//----------------------------------------------------------------------
-// Mark Rages' Algorithm for Fast Find of Mean-Max
-//----------------------------------------------------------------------
-
-/*
-
-   A Faster Mean-Max Algorithm
-
-   Premises:
-
-   1 - maximum average power for a given interval occurs at maximum
-       energy for the interval, because the interval time is fixed;
-
-   2 - the energy in an interval enclosing a smaller interval will
-       always be equal or greater than an interval;
-
-   3 - finding maximum of means is a search algorithm, so biggest
-       gains are found in reducing the search space as quickly as
-       possible.
-
-   Algorithm
-
-   note: I find it easier to reason with concrete numbers, so I will
-   describe the algorithm in terms of power and 60 second max-mean:
-
-   To find the maximum average power for one minute:
-
-   1 - integrate the watts over the entire ride to get accumulated
-       energy in joules.  This is a monotonic function (assuming watts
-       are positive).  The final value is the energy for the whole
-       ride.  Once this is done, the energy for any section can be
-       found with a single subtraction.
-
-   2 - divide the energy into overlapping two-minute sections.
-       Section one = 0:00 -> 2:00, section two = 1:00 -> 3:00, etc.
-
-       Example:  Find 60s MM in 5-minute file
-
-       +----------+----------+----------+----------+----------+
-       | minute 1 | minute 2 | minute 3 | minute 4 | minute 5 |
-       +----------+----------+----------+----------+----------+
-       |             |_MEAN_MAX_|                             |
-       +---------------------+---------------------+----------+
-       |      segment 1      |      segment 3      |
-       +----------+----------+----------+----------+----------+
-                  |      segment 2      |      segment 4      |
-                  +---------------------+---------------------+
-
-       So no matter where the MEAN_MAX segment is located in time, it
-       will be wholly contained in one segment.
-
-       In practice, it is a little faster to make the windows smaller
-       and overlap more:
-       +----------+----------+----------+----------+----------+
-       | minute 1 | minute 2 | minute 3 | minute 4 | minute 5 |
-       +----------+----------+----------+----------+----------+
-       |             |_MEAN_MAX_|                             |
-       +-------------+----------------------------------------+
-          |  segment 1  |
-          +--+----------+--+
-          |  segment 2  |
-          +--+----------+--+
-             |  segment 3  |
-             +--+----------+--+
-                |  segment 4  |
-                +--+----------+--+
-                   |  segment 5  |
-                   +--+----------+--+
-                      |  segment 6  |
-                      +--+----------+--+
-                         |  segment 7  |
-                         +--+----------+--+
-                            |  segment 8  |
-                            +--+----------+--+
-                               |  segment 9  |
-                               +-------------+
-                                            ... etc.
-
-       ( This is because whenever the actual mean max energy is
-         greater than a segment energy, we can skip the detail
-         comparison within that segment altogether.  The exact
-         tradeoff for optimum performance depends on the distribution
-         of the data.  It's a pretty shallow curve.  Values in the 1
-         minute to 1.5 minute range seem to work pretty well. )
-
-   3 - for each two minute section, subtract the accumulated energy at
-       the end of the section from the accumulated energy at the
-       beginning of the section.  That gives the energy for that section.
-
-   4 - in the first section, go second-by-second to find the maximum
-       60-second energy.  This is our candidate for 60-second energy
-
-   5 - go down the sorted list of sections.  If the energy in the next
-       section is less than the 60-second energy in the best candidate so
-       far, skip to the next section without examining it carefully,
-       because the section cannot possibly have a one-minute section with
-       greater energy.
-
-       while (section->energy > candidate) {
-         candidate=max(candidate, search(section, 60));
-         section++;
-       }
-
-   6. candidate is the mean max for 60 seconds.
-
-   Enhancements that are not implemented:
-
-     - The two-minute overlapping sections can be reused for 59
-       seconds, etc.  The algorithm will degrade to exhaustive search
-       if the looked-for interval is much smaller than the enclosing
-       interval.
-
-     - The sections can be sorted by energy in reverse order before
-       step #4.  Then the search in #5 can be terminated early, the
-       first time it fails.  In practice, the comparisons in the
-       search outnumber the saved comparisons.  But this might be a
-       useful optimization if the windows are reused per the previous
-       idea.
-
-*/
-
-static data_t *
-integrate_series(cpintdata &data)
+//
+// TASKS
+//
+QThreadPool *
+RideFileCacheTasks::pool()
 {
-    // would be better to do pure QT and use QVector -- but no memory leak
-    data_t *integrated= (data_t *)malloc(sizeof(data_t)*(data.points.size()+1)); 
-    int i;
-    data_t acc=0;
+    static QThreadPool cpxPool;
+    return &cpxPool;
+}
 
-    for (i=0; i<data.points.size(); i++) {
-        integrated[i]=acc;
-        acc+=data.points[i].value;
-    }
-    integrated[i]=acc;
+// refresh workers run their own tasks, so the
+// pool only gets the threads they are not using
+static int reserved = 0;
 
-    return integrated;
+int
+RideFileCacheTasks::threads()
+{
+    int threads = appsettings->value(NULL, GC_REFRESH_THREADS, 0).toInt();
+    if (threads <= 0) threads = QThread::idealThreadCount();
+    return qMax(1, threads);
 }
 
-static data_t
-partial_max_mean(data_t *dataseries_i, int start, int end, int length, int *offset)
+void
+RideFileCacheTasks::configure()
 {
-    int i=0;
-    data_t candidate=0;
-
-    int best_i=0;
-
-    for (i=start; i<(1+end-length); i++) {
-        data_t test_energy=dataseries_i[length+i]-dataseries_i[i];
-        if (test_energy>candidate) {
-            candidate=test_energy;
-            best_i=i;
-        }
-    }
-    if (offset) *offset=best_i;
-
-    return candidate;
+    int threads = qMax(1, RideFileCacheTasks::threads() - reserved);
+    if (threads != pool()->maxThreadCount()) pool()->setMaxThreadCount(threads);
 }
 
-
-static data_t
-divided_max_mean(data_t *dataseries_i, int datalength, int length, int *offset)
+void
+RideFileCacheTasks::reserve(int workers)
 {
-    int shift=length;
-
-    //if sorting data the following is an important speedup hack
-    if (shift>180) shift=180;
-
-    int window_length=length+shift;
+    reserved = workers;
+    configure();
+}
 
-    if (window_length>datalength) window_length=datalength;
+void
+RideFileCacheTasks::add(QRunnable *task)
+{
+    task->setAutoDelete(false);
+    state->tasks << task;
+}
 
-    // put down as many windows as will fit without overrunning data
-    int start=0;
-    int end=0;
-    data_t energy=0;
+// helps out from the pool, keeps the tasks alive till it is done
+class RideFileCacheHelper : public QRunnable
+{
+    public:
+        RideFileCacheHelper(QSharedPointer<RideFileCacheTasks::State> state) : state(state) {}
+        void run() { RideFileCacheTasks::work(state.data()); }
 
-    data_t candidate=0;
-    int this_offset=0;
+    private:
+        QSharedPointer<RideFileCacheTasks::State> state;
+};
 
-    for (start=0; start+window_length<=datalength; start+=shift) {
-        end=start+window_length;
-        energy=dataseries_i[end]-dataseries_i[start];
+void
+RideFileCacheTasks::work(State *state)
+{
+    forever {
+        int next = state->next.fetchAndAddOrdered(1);
+        if (next >= state->tasks.count()) return;
 
-        if (energy < candidate) {
-          continue;
-        }
-        data_t window_mm=partial_max_mean(dataseries_i, start, end, length, &this_offset);
+        state->tasks[next]->run();
 
-        if (window_mm>candidate) {
-            candidate=window_mm;
-            if (offset) *offset=this_offset;
-        }
+        QMutexLocker locker(&state->lock);
+        if (++state->done == state->tasks.count()) state->finished.wakeAll();
     }
+}
 
-    // if the overlapping windows don't extend to the end of the data,
-    // let's tack another one on at the end
-
-    if (end<datalength) {
-        start=datalength-window_length;
-        end=datalength;
-        energy=dataseries_i[end]-dataseries_i[start];
-
-        if (energy >= candidate) {
+void
+RideFileCacheTasks::run()
+{
+    if (state->tasks.isEmpty()) return;
 
-            data_t window_mm=partial_max_mean(dataseries_i, start, end, length, &this_offset);
+    // no more helpers than there are threads, and we help too
+    QThreadPool *threads = pool();
+    int helpers = qMin(state->tasks.count() - 1, threads->maxThreadCount());
+    for (int i=0; i<helpers; i++) threads->start(new RideFileCacheHelper(state));
 
-            if (window_mm>candidate) {
-                candidate=window_mm;
-                if (offset) *offset=this_offset;
-            }
-        }
-    }
+    work(state.data());
 
-    return candidate;
+    // wait for any still running elsewhere
+    QMutexLocker locker(&state->lock);
+    while (state->done < state->tasks.count()) state->finished.wait(&state->lock);
 }
 
-
 void
 MeanMaxComputer::run()
 {
@@ -1244,9 +944,10 @@ MeanMaxComputer::run()
     // zero, since some files have a very large start time
     // that creates work for nil effect (but increases compute
     // time drastically).
-    cpintdata data;
-    data.rec_int_ms = (int) round(ride->recIntSecs() * 1000.0);
+    QVector<double> data;
+    data.reserve(ride->dataPoints().count());
     double lastsecs = 0;
+    double endsecs = 0; // of the last sample
     bool first = true;
     double offset = 0;
     foreach (const RideFilePoint *p, ride->dataPoints()) {
@@ -1266,19 +967,24 @@ MeanMaxComputer::run()
         // gap more than an hour, damn that ride file is a mess
         if (count > 3600) count = 1;
 
-        for(int i=0; i<count; i++)
-            data.points.append(cpintpoint(round(lastsecs+((i+1)*ride->recIntSecs() *1000.0)/1000), 0));
+        for(int i=0; i<count; i++) {
+            data.append(0);
+            endsecs = round(lastsecs+((i+1)*ride->recIntSecs() *1000.0)/1000);
+        }
         lastsecs = psecs;
 
         double secs = round(psecs * 1000.0) / 1000;
-        if (secs > 0) data.points.append(cpintpoint(secs, (int) round(p->value(baseSeries)*double(decimals))));
+        if (secs > 0) {
+            data.append((int) round(p->value(baseSeries)*double(decimals)));
+            endsecs = secs;
+        }
     }
 
 
     // don't bother with insufficient data
-    if (!data.points.count()) return;
+    if (!data.count()) return;
 
-    int total_secs = (int) ceil(data.points.back().secs);
+    int total_secs = (int) ceil(endsecs);
 
     // don't allow data more than two days
     // was one week, but no single ride is longer
@@ -1297,19 +1003,19 @@ MeanMaxComputer::run()
 
         double lastAlt=0;
 
-        for (int i=0; i<data.points.size(); i++) {
+        for (int i=0; i<data.size(); i++) {
 
             // handle drops gracefully (and first sample too)
             // if you manage to rise >5m in a second thats a data error too!
-            if (!lastAlt || (data.points[i].value - lastAlt) > 5) lastAlt=data.points[i].value;
+            if (!lastAlt || (data[i] - lastAlt) > 5) lastAlt=data[i];
 
             // NOTE: It is 360 not 3600 because Altitude is factored for decimal places
             //       since it is the base data series, but we are calculating VAM
             //       And we multiply by 10 at the end!
-            double vam = (((data.points[i].value - lastAlt) * 360)/ride->recIntSecs()) * 10;
+            double vam = (((data[i] - lastAlt) * 360)/ride->recIntSecs()) * 10;
             if (vam < 0) vam = 0;
-            lastAlt = data.points[i].value;
-            data.points[i].value = vam;
+            lastAlt = data[i];
+            data[i] = vam;
         }
     }
 
@@ -1329,13 +1035,13 @@ MeanMaxComputer::run()
 
             // loop over the data and convert to a rolling
             // average for the given windowsize
-            for (int i=0; i<data.points.size(); i++) {
+            for (int i=0; i<data.size(); i++) {
 
-                sum += data.points[i].value;
+                sum += data[i];
                 sum -= rolling[index];
 
-                rolling[index] = data.points[i].value;
-                data.points[i].value = pow(sum/(double)rollingwindowsize,4.0f); // raise rolling average to 4th power
+                rolling[index] = data[i];
+                data[i] = pow(sum/(double)rollingwindowsize,4.0f); // raise rolling average to 4th power
 
                 // move index on/round
                 index = (index >= rollingwindowsize-1) ? 0 : index+1;
@@ -1359,46 +1065,49 @@ MeanMaxComputer::run()
         if (rollingwindowsize > 1) {
 
             // loop over the data and convert to a EWMA
-            for (int i=0; i<data.points.size(); i++) {
+            for (int i=0; i<data.size(); i++) {
 
                 // dgr : BikeScore has weighting value from first point
                 if (false && i < rollingwindowsize) {
 
                     // get up to speed
-                    sum += data.points[i].value;
+                    sum += data[i];
                     ewma = sum / (i+1);
 
                 } else {
 
                     // we're up to speed
-                    ewma = (data.points[i].value * exp) + (ewma * rem);
+                    ewma = (data[i] * exp) + (ewma * rem);
                 }
-                data.points[i].value = pow(ewma, 4.0f);
+                data[i] = pow(ewma, 4.0f);
             }
         }
     }
 
     if (series == RideFile::wattsKg || series == RideFile::aPowerKg) {
-        for (int i=0; i<data.points.size(); i++) {
-            double wattsKg = data.points[i].value / ride->getWeight();
-            data.points[i].value = wattsKg;
+        for (int i=0; i<data.size(); i++) {
+            double wattsKg = data[i] / ride->getWeight();
+            data[i] = wattsKg;
         }
     }
 
+    // the best energy for each window length
+    QVector<data_t> energy(data.size());
+
+#ifdef GC_MEANMAX_LEGACY
+    MeanMaxSearch::legacy(data, energy);
+#else
+    MeanMaxSearch::exact(data, energy);
+#endif
 
     // the bests go in here...
     QVector <double> ride_bests(total_secs + 1);
 
-    data_t *dataseries_i = integrate_series(data);
-
-    for (int i=1; i<data.points.size();) {
-
-        int offset;
-        data_t c=divided_max_mean(dataseries_i,data.points.size(),i,&offset);
+    for (int i=1; i<data.size(); i=MeanMaxSearch::nextLength(i)) {
 
         // snaffle it away
         int sec = i*ride->recIntSecs();
-        data_t val = c / (data_t)i;
+        data_t val = energy[i] / (data_t)i;
 
         if (sec < ride_bests.size()) {
             if (series == RideFile::NP || series == RideFile::xPower)
@@ -1406,17 +1115,7 @@ MeanMaxComputer::run()
             else
                 ride_bests[sec] = val;
         }
-
-
-        // increments to limit search scope
-        if (i<120) i++;
-        else if (i<600) i+= 2;
-        else if (i<1200) i += 5;
-        else if (i<3600) i += 20;
-        else if (i<7200) i += 120;
-        else i += 300;
     }
-    free(dataseries_i);
 
     //
     // FILL IN THE GAPS AND FILL TARGET ARRAY
@@ -1487,7 +1186,7 @@ void RideFileCache::fastSearch(QVector<int>&input, QVector<int>&ride_bests, QVec
     for (int i=1; i<input.count();) {
 
         int offset;
-        data_t c=divided_max_mean(dataseries_i,input.count(),i,&offset);
+        data_t c=MeanMaxSearch::dividedMaxMean(dataseries_i,input.count(),i,&offset);
 
         // snaffle it away
         data_t val = c / (data_t)i;
@@ -1539,23 +1238,12 @@ RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType s
     // only bother if the data series is actually present
     if (ride->isDataPresent(needSeries) == false) return;
 
-    // get zones that apply, if any
+    // get zones that apply, if any, CP, WPRIME, LTHR and CV were
+    // set by compute() since the distributions run concurrently
     int zoneRange = context->athlete->zones(ride->isRun()) ? context->athlete->zones(ride->isRun())->whichRange(ride->startTime().date()) : -1;
     int hrZoneRange = context->athlete->hrZones(ride->isRun()) ? context->athlete->hrZones(ride->isRun())->whichRange(ride->startTime().date()) : -1;
     int paceZoneRange = context->athlete->paceZones(ride->isSwim()) ? context->athlete->paceZones(ride->isSwim())->whichRange(ride->startTime().date()) : -1;
 
-    if (zoneRange != -1) CP=context->athlete->zones(ride->isRun())->getCP(zoneRange);
-    else CP=0;
-
-    if (zoneRange != -1) WPRIME=context->athlete->zones(ride->isRun())->getWprime(zoneRange);
-    else WPRIME=0;
-
-    if (hrZoneRange != -1) LTHR=context->athlete->hrZones(ride->isRun())->getLT(hrZoneRange);
-    else LTHR=0;
-
-    if (paceZoneRange != -1) CV=context->athlete->paceZones(ride->isSwim())->getCV(paceZoneRange);
-    else CV=0;
-
     // setup the array based upon the ride
     int decimals = decimalsFor(series); //RideFile::decimalsFor(series) ? 1 : 0;
     double min = RideFile::minimumFor(series) * pow(10, decimals);
@@ -1671,29 +1359,45 @@ RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType s
 // AGGREGATE FOR A GIVEN DATE RANGE
 //
 
-// select and update bests
-static void meanMaxAggregate(QVector<double> &into, QVector<double> &other, QVector<QDate>&dates, QDate rideDate)
+// select and update bests, straight from the activity's cache file
+static void meanMaxAggregate(QVector<double> &into, RideFileCacheReader &reader, RideFile::SeriesType series,
+                             QVector<QDate>&dates, QDate rideDate)
 {
-    if (into.size() < other.size()) {
-        into.resize(other.size());
-        dates.resize(other.size());
+    int count = reader.meanMaxCount(series);
+    const float *other = reader.meanMaxData(series);
+    double divisor = pow(10, RideFileCache::decimalsFor(series));
+
+    if (into.size() < count) {
+        into.resize(count);
+        dates.resize(count);
     }
 
-    for (int i=0; i<other.size(); i++)
-        if (other[i] > into[i]) {
-            into[i] = other[i];
+    for (int i=0; i<count; i++) {
+        double value = double(other[i]) / divisor;
+        if (value > into[i]) {
+            into[i] = value;
             dates[i] = rideDate;
         }
+    }
 }
 
 // resize into and then sum the arrays
-static void distAggregate(QVector<double> &into, QVector<double> &other)
+static void distAggregate(QVector<double> &into, const QVector<double> &other)
 {
     if (into.size() < other.size()) into.resize(other.size());
     for (int i=0; i<other.size(); i++) into[i] += other[i];
 
 }
 
+static void distAggregate(QVector<double> &into, RideFileCacheReader &reader, RideFile::SeriesType series)
+{
+    int count = reader.distributionCount(series);
+    const float *other = reader.distributionData(series);
+
+    if (into.size() < count) into.resize(count);
+    for (int i=0; i<count; i++) into[i] += double(other[i]);
+}
+
 RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filter, QStringList files, bool onhome, RideItem *rideItem)
                : start(start), end(end), incomplete(false), context(context), rideFileName(""), ride(0)
 {
@@ -1718,6 +1422,73 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
     }
 
     // resize all the arrays to zero - expand as neccessary
+    resetAggregate();
+
+    // set cursor busy whilst we aggregate -- bit of feedback
+    // and less intrusive than a popup box
+    context->mainWindow->setCursor(Qt::WaitCursor);
+
+    // when nothing is filtered use the weeks, months and years
+    // already aggregated, see RideFileCacheIndex
+    if (!filter && !context->isfiltered && (!onhome || !context->ishomefiltered) && !rideItem) {
+
+        if (context->athlete->cpxIndex->aggregate(this, start, end) == false) incomplete = true;
+
+    } else {
+
+        // Iterate over the ride files (not the cpx files since they /might/ not
+        // exist, or /might/ be out of date.
+        RideFileCacheReader reader;
+        foreach (RideItem *item, context->athlete->rideCache->rides()) {
+
+            QDate rideDate = item->dateTime.date();
+
+            if (((filter == true && files.contains(item->fileName)) || filter == false) &&
+                rideDate >= start && rideDate <= end) {
+
+                // skip globally filtered values
+                if (context->isfiltered && !context->filters.contains(item->fileName)) continue;
+                if (onhome && context->ishomefiltered && !context->homeFilters.contains(item->fileName)) continue;
+                // skip other sports if rideItem is given
+                if (rideItem && ((rideItem->isRun != item->isRun) || (rideItem->isSwim != item->isSwim))) continue;
+
+                // get its cached values (will NOT! refresh if needed...)
+                if (openCurrent(reader, context, item) == false) {
+                    // ack, data not available !
+                    incomplete = true;
+                } else {
+
+                    // lets aggregate
+                    aggregate(reader, rideDate);
+                }
+            }
+        }
+    }
+
+    // set the cursor back to normal
+    context->mainWindow->setCursor(Qt::ArrowCursor);
+
+    // lets add to the cache for others to re-use -- but not if filtered or incomplete
+    if (incomplete == false && !context->isfiltered && (!context->ishomefiltered || !onhome) && !filter) {
+
+        if (context->athlete->cpxCache.count() > maxcache) {
+            delete(context->athlete->cpxCache.at(0));
+            context->athlete->cpxCache.removeAt(0);
+        }
+        context->athlete->cpxCache.append(new RideFileCache(this));
+    }
+}
+
+// an empty aggregate, used by the index for weeks, months and years
+RideFileCache::RideFileCache(Context *context)
+               : incomplete(false), context(context), rideFileName(""), ride(0), filter(false), onhome(false)
+{
+    resetAggregate();
+}
+
+void
+RideFileCache::resetAggregate()
+{
     xPowerMeanMax.resize(0);
     npMeanMax.resize(0);
     wattsMeanMax.resize(0);
@@ -1757,95 +1528,168 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
     paceTimeInZone.resize(10);
     paceCPTimeInZone.resize(4);
     wbalTimeInZone.resize(4);
+}
 
-    // set cursor busy whilst we aggregate -- bit of feedback
-    // and less intrusive than a popup box
-    context->mainWindow->setCursor(Qt::WaitCursor);
-
-    // Iterate over the ride files (not the cpx files since they /might/ not
-    // exist, or /might/ be out of date.
-    foreach (RideItem *item, context->athlete->rideCache->rides()) {
-
-        QDate rideDate = item->dateTime.date();
-
-        if (((filter == true && files.contains(item->fileName)) || filter == false) &&
-            rideDate >= start && rideDate <= end) {
-
-            // skip globally filtered values
-            if (context->isfiltered && !context->filters.contains(item->fileName)) continue;
-            if (onhome && context->ishomefiltered && !context->homeFilters.contains(item->fileName)) continue;
-            // skip other sports if rideItem is given
-            if (rideItem && ((rideItem->isRun != item->isRun) || (rideItem->isSwim != item->isSwim))) continue;
-
-            // get its cached values (will NOT! refresh if needed...)
-            // the true means it will check only
-            RideFileCache rideCache(context, context->athlete->home->activities().canonicalPath() + "/" + item->fileName, item->getWeight(), NULL, false, false);
-            if (rideCache.incomplete == true) {
-                // ack, data not available !
-                incomplete = true;
-            } else {
-
-                // lets aggregate
-                meanMaxAggregate(wattsMeanMaxDouble, rideCache.wattsMeanMaxDouble, wattsMeanMaxDate, rideDate);
-                meanMaxAggregate(hrMeanMaxDouble, rideCache.hrMeanMaxDouble, hrMeanMaxDate, rideDate);
-                meanMaxAggregate(cadMeanMaxDouble, rideCache.cadMeanMaxDouble, cadMeanMaxDate, rideDate);
-                meanMaxAggregate(nmMeanMaxDouble, rideCache.nmMeanMaxDouble, nmMeanMaxDate, rideDate);
-                meanMaxAggregate(kphMeanMaxDouble, rideCache.kphMeanMaxDouble, kphMeanMaxDate, rideDate);
-                meanMaxAggregate(kphdMeanMaxDouble, rideCache.kphdMeanMaxDouble, kphdMeanMaxDate, rideDate);
-                meanMaxAggregate(wattsdMeanMaxDouble, rideCache.wattsdMeanMaxDouble, wattsdMeanMaxDate, rideDate);
-                meanMaxAggregate(caddMeanMaxDouble, rideCache.caddMeanMaxDouble, caddMeanMaxDate, rideDate);
-                meanMaxAggregate(nmdMeanMaxDouble, rideCache.nmdMeanMaxDouble, nmdMeanMaxDate, rideDate);
-                meanMaxAggregate(hrdMeanMaxDouble, rideCache.hrdMeanMaxDouble, hrdMeanMaxDate, rideDate);
-                meanMaxAggregate(xPowerMeanMaxDouble, rideCache.xPowerMeanMaxDouble, xPowerMeanMaxDate, rideDate);
-                meanMaxAggregate(npMeanMaxDouble, rideCache.npMeanMaxDouble, npMeanMaxDate, rideDate);
-                meanMaxAggregate(vamMeanMaxDouble, rideCache.vamMeanMaxDouble, vamMeanMaxDate, rideDate);
-                meanMaxAggregate(wattsKgMeanMaxDouble, rideCache.wattsKgMeanMaxDouble, wattsKgMeanMaxDate, rideDate);
-                meanMaxAggregate(aPowerMeanMaxDouble, rideCache.aPowerMeanMaxDouble, aPowerMeanMaxDate, rideDate);
-                meanMaxAggregate(aPowerKgMeanMaxDouble, rideCache.aPowerKgMeanMaxDouble, aPowerKgMeanMaxDate, rideDate);
-
-                distAggregate(wattsDistributionDouble, rideCache.wattsDistributionDouble);
-                distAggregate(hrDistributionDouble, rideCache.hrDistributionDouble);
-                distAggregate(cadDistributionDouble, rideCache.cadDistributionDouble);
-                distAggregate(gearDistributionDouble, rideCache.gearDistributionDouble);
-                distAggregate(nmDistributionDouble, rideCache.nmDistributionDouble);
-                distAggregate(kphDistributionDouble, rideCache.kphDistributionDouble);
-                distAggregate(xPowerDistributionDouble, rideCache.xPowerDistributionDouble);
-                distAggregate(npDistributionDouble, rideCache.npDistributionDouble);
-                distAggregate(wattsKgDistributionDouble, rideCache.wattsKgDistributionDouble);
-                distAggregate(aPowerDistributionDouble, rideCache.aPowerDistributionDouble);
-                distAggregate(smo2DistributionDouble, rideCache.smo2DistributionDouble);
-                distAggregate(wbalDistributionDouble, rideCache.wbalDistributionDouble);
-
-                // cumulate timeinzones
-                for (int i=0; i<10; i++) {
-                    paceTimeInZone[i] += rideCache.paceTimeInZone[i];
-                    hrTimeInZone[i] += rideCache.hrTimeInZone[i];
-                    wattsTimeInZone[i] += rideCache.wattsTimeInZone[i];
-                    if (i<4) {
-                        paceCPTimeInZone[i] += rideCache.paceCPTimeInZone[i];
-                        hrCPTimeInZone[i] += rideCache.hrCPTimeInZone[i];
-                        wattsCPTimeInZone[i] += rideCache.wattsCPTimeInZone[i];
-                        wbalTimeInZone[i] += rideCache.wbalTimeInZone[i];
-                    }
-                }
-            }
+// add an activity to the aggregate, from its cache file
+void
+RideFileCache::aggregate(RideFileCacheReader &reader, QDate rideDate)
+{
+    // lets aggregate
+    meanMaxAggregate(wattsMeanMaxDouble, reader, RideFile::watts, wattsMeanMaxDate, rideDate);
+    meanMaxAggregate(hrMeanMaxDouble, reader, RideFile::hr, hrMeanMaxDate, rideDate);
+    meanMaxAggregate(cadMeanMaxDouble, reader, RideFile::cad, cadMeanMaxDate, rideDate);
+    meanMaxAggregate(nmMeanMaxDouble, reader, RideFile::nm, nmMeanMaxDate, rideDate);
+    meanMaxAggregate(kphMeanMaxDouble, reader, RideFile::kph, kphMeanMaxDate, rideDate);
+    meanMaxAggregate(kphdMeanMaxDouble, reader, RideFile::kphd, kphdMeanMaxDate, rideDate);
+    meanMaxAggregate(wattsdMeanMaxDouble, reader, RideFile::wattsd, wattsdMeanMaxDate, rideDate);
+    meanMaxAggregate(caddMeanMaxDouble, reader, RideFile::cadd, caddMeanMaxDate, rideDate);
+    meanMaxAggregate(nmdMeanMaxDouble, reader, RideFile::nmd, nmdMeanMaxDate, rideDate);
+    meanMaxAggregate(hrdMeanMaxDouble, reader, RideFile::hrd, hrdMeanMaxDate, rideDate);
+    meanMaxAggregate(xPowerMeanMaxDouble, reader, RideFile::xPower, xPowerMeanMaxDate, rideDate);
+    meanMaxAggregate(npMeanMaxDouble, reader, RideFile::NP, npMeanMaxDate, rideDate);
+    meanMaxAggregate(vamMeanMaxDouble, reader, RideFile::vam, vamMeanMaxDate, rideDate);
+    meanMaxAggregate(wattsKgMeanMaxDouble, reader, RideFile::wattsKg, wattsKgMeanMaxDate, rideDate);
+    meanMaxAggregate(aPowerMeanMaxDouble, reader, RideFile::aPower, aPowerMeanMaxDate, rideDate);
+    meanMaxAggregate(aPowerKgMeanMaxDouble, reader, RideFile::aPowerKg, aPowerKgMeanMaxDate, rideDate);
+
+    distAggregate(wattsDistributionDouble, reader, RideFile::watts);
+    distAggregate(hrDistributionDouble, reader, RideFile::hr);
+    distAggregate(cadDistributionDouble, reader, RideFile::cad);
+    distAggregate(gearDistributionDouble, reader, RideFile::gear);
+    distAggregate(nmDistributionDouble, reader, RideFile::nm);
+    distAggregate(kphDistributionDouble, reader, RideFile::kph);
+    distAggregate(xPowerDistributionDouble, reader, RideFile::xPower);
+    distAggregate(npDistributionDouble, reader, RideFile::NP);
+    distAggregate(wattsKgDistributionDouble, reader, RideFile::wattsKg);
+    distAggregate(aPowerDistributionDouble, reader, RideFile::aPower);
+    distAggregate(smo2DistributionDouble, reader, RideFile::smo2);
+    distAggregate(wbalDistributionDouble, reader, RideFile::wbal);
+
+    // cumulate timeinzones
+    const float *pace = reader.zoneData(RideFile::kph), *paceCP = reader.zoneData(RideFile::kph, true);
+    const float *hr = reader.zoneData(RideFile::hr), *hrCP = reader.zoneData(RideFile::hr, true);
+    const float *watts = reader.zoneData(RideFile::watts), *wattsCP = reader.zoneData(RideFile::watts, true);
+    const float *wbal = reader.zoneData(RideFile::wbal);
+    for (int i=0; i<10; i++) {
+        paceTimeInZone[i] += pace[i];
+        hrTimeInZone[i] += hr[i];
+        wattsTimeInZone[i] += watts[i];
+        if (i<4) {
+            paceCPTimeInZone[i] += paceCP[i];
+            hrCPTimeInZone[i] += hrCP[i];
+            wattsCPTimeInZone[i] += wattsCP[i];
+            wbalTimeInZone[i] += wbal[i];
         }
     }
+}
 
-    // set the cursor back to normal
-    context->mainWindow->setCursor(Qt::ArrowCursor);
+// mean max dates come from the other aggregate
+static void meanMaxMerge(QVector<double> &into, QVector<QDate> &dates, const QVector<double> &other, const QVector<QDate> &otherDates)
+{
+    if (into.size() < other.size()) {
+        into.resize(other.size());
+        dates.resize(other.size());
+    }
 
-    // lets add to the cache for others to re-use -- but not if filtered or incomplete
-    if (incomplete == false && !context->isfiltered && (!context->ishomefiltered || !onhome) && !filter) {
+    for (int i=0; i<other.size(); i++)
+        if (other[i] > into[i]) {
+            into[i] = other[i];
+            dates[i] = otherDates[i];
+        }
+}
 
-        if (context->athlete->cpxCache.count() > maxcache) {
-            delete(context->athlete->cpxCache.at(0));
-            context->athlete->cpxCache.removeAt(0);
+// add an aggregate of later activities to this one, so ties
+// go to the earliest just as when adding the activities themselves
+void
+RideFileCache::merge(const RideFileCache &other)
+{
+    if (other.incomplete) incomplete = true;
+
+    meanMaxMerge(wattsMeanMaxDouble, wattsMeanMaxDate, other.wattsMeanMaxDouble, other.wattsMeanMaxDate);
+    meanMaxMerge(hrMeanMaxDouble, hrMeanMaxDate, other.hrMeanMaxDouble, other.hrMeanMaxDate);
+    meanMaxMerge(cadMeanMaxDouble, cadMeanMaxDate, other.cadMeanMaxDouble, other.cadMeanMaxDate);
+    meanMaxMerge(nmMeanMaxDouble, nmMeanMaxDate, other.nmMeanMaxDouble, other.nmMeanMaxDate);
+    meanMaxMerge(kphMeanMaxDouble, kphMeanMaxDate, other.kphMeanMaxDouble, other.kphMeanMaxDate);
+    meanMaxMerge(kphdMeanMaxDouble, kphdMeanMaxDate, other.kphdMeanMaxDouble, other.kphdMeanMaxDate);
+    meanMaxMerge(wattsdMeanMaxDouble, wattsdMeanMaxDate, other.wattsdMeanMaxDouble, other.wattsdMeanMaxDate);
+    meanMaxMerge(caddMeanMaxDouble, caddMeanMaxDate, other.caddMeanMaxDouble, other.caddMeanMaxDate);
+    meanMaxMerge(nmdMeanMaxDouble, nmdMeanMaxDate, other.nmdMeanMaxDouble, other.nmdMeanMaxDate);
+    meanMaxMerge(hrdMeanMaxDouble, hrdMeanMaxDate, other.hrdMeanMaxDouble, other.hrdMeanMaxDate);
+    meanMaxMerge(xPowerMeanMaxDouble, xPowerMeanMaxDate, other.xPowerMeanMaxDouble, other.xPowerMeanMaxDate);
+    meanMaxMerge(npMeanMaxDouble, npMeanMaxDate, other.npMeanMaxDouble, other.npMeanMaxDate);
+    meanMaxMerge(vamMeanMaxDouble, vamMeanMaxDate, other.vamMeanMaxDouble, other.vamMeanMaxDate);
+    meanMaxMerge(wattsKgMeanMaxDouble, wattsKgMeanMaxDate, other.wattsKgMeanMaxDouble, other.wattsKgMeanMaxDate);
+    meanMaxMerge(aPowerMeanMaxDouble, aPowerMeanMaxDate, other.aPowerMeanMaxDouble, other.aPowerMeanMaxDate);
+    meanMaxMerge(aPowerKgMeanMaxDouble, aPowerKgMeanMaxDate, other.aPowerKgMeanMaxDouble, other.aPowerKgMeanMaxDate);
+
+    distAggregate(wattsDistributionDouble, other.wattsDistributionDouble);
+    distAggregate(hrDistributionDouble, other.hrDistributionDouble);
+    distAggregate(cadDistributionDouble, other.cadDistributionDouble);
+    distAggregate(gearDistributionDouble, other.gearDistributionDouble);
+    distAggregate(nmDistributionDouble, other.nmDistributionDouble);
+    distAggregate(kphDistributionDouble, other.kphDistributionDouble);
+    distAggregate(xPowerDistributionDouble, other.xPowerDistributionDouble);
+    distAggregate(npDistributionDouble, other.npDistributionDouble);
+    distAggregate(wattsKgDistributionDouble, other.wattsKgDistributionDouble);
+    distAggregate(aPowerDistributionDouble, other.aPowerDistributionDouble);
+    distAggregate(smo2DistributionDouble, other.smo2DistributionDouble);
+    distAggregate(wbalDistributionDouble, other.wbalDistributionDouble);
+
+    for (int i=0; i<10; i++) {
+        paceTimeInZone[i] += other.paceTimeInZone[i];
+        hrTimeInZone[i] += other.hrTimeInZone[i];
+        wattsTimeInZone[i] += other.wattsTimeInZone[i];
+        if (i<4) {
+            paceCPTimeInZone[i] += other.paceCPTimeInZone[i];
+            hrCPTimeInZone[i] += other.hrCPTimeInZone[i];
+            wattsCPTimeInZone[i] += other.wattsCPTimeInZone[i];
+            wbalTimeInZone[i] += other.wbalTimeInZone[i];
         }
-        context->athlete->cpxCache.append(new RideFileCache(this));
     }
 }
 
+void
+RideFileCache::serializeAggregate(QDataStream &out)
+{
+    out << wattsMeanMaxDouble << hrMeanMaxDouble << cadMeanMaxDouble << nmMeanMaxDouble
+        << kphMeanMaxDouble << kphdMeanMaxDouble << wattsdMeanMaxDouble << caddMeanMaxDouble
+        << nmdMeanMaxDouble << hrdMeanMaxDouble << xPowerMeanMaxDouble << npMeanMaxDouble
+        << vamMeanMaxDouble << wattsKgMeanMaxDouble << aPowerMeanMaxDouble << aPowerKgMeanMaxDouble;
+
+    out << wattsMeanMaxDate << hrMeanMaxDate << cadMeanMaxDate << nmMeanMaxDate
+        << kphMeanMaxDate << kphdMeanMaxDate << wattsdMeanMaxDate << caddMeanMaxDate
+        << nmdMeanMaxDate << hrdMeanMaxDate << xPowerMeanMaxDate << npMeanMaxDate
+        << vamMeanMaxDate << wattsKgMeanMaxDate << aPowerMeanMaxDate << aPowerKgMeanMaxDate;
+
+    out << wattsDistributionDouble << hrDistributionDouble << cadDistributionDouble << gearDistributionDouble
+        << nmDistributionDouble << kphDistributionDouble << xPowerDistributionDouble << npDistributionDouble
+        << wattsKgDistributionDouble << aPowerDistributionDouble << smo2DistributionDouble << wbalDistributionDouble;
+
+    out << wattsTimeInZone << wattsCPTimeInZone << hrTimeInZone << hrCPTimeInZone
+        << paceTimeInZone << paceCPTimeInZone << wbalTimeInZone;
+}
+
+void
+RideFileCache::readAggregate(QDataStream &in)
+{
+    in >> wattsMeanMaxDouble >> hrMeanMaxDouble >> cadMeanMaxDouble >> nmMeanMaxDouble
+       >> kphMeanMaxDouble >> kphdMeanMaxDouble >> wattsdMeanMaxDouble >> caddMeanMaxDouble
+       >> nmdMeanMaxDouble >> hrdMeanMaxDouble >> xPowerMeanMaxDouble >> npMeanMaxDouble
+       >> vamMeanMaxDouble >> wattsKgMeanMaxDouble >> aPowerMeanMaxDouble >> aPowerKgMeanMaxDouble;
+
+    in >> wattsMeanMaxDate >> hrMeanMaxDate >> cadMeanMaxDate >> nmMeanMaxDate
+       >> kphMeanMaxDate >> kphdMeanMaxDate >> wattsdMeanMaxDate >> caddMeanMaxDate
+       >> nmdMeanMaxDate >> hrdMeanMaxDate >> xPowerMeanMaxDate >> npMeanMaxDate
+       >> vamMeanMaxDate >> wattsKgMeanMaxDate >> aPowerMeanMaxDate >> aPowerKgMeanMaxDate;
+
+    in >> wattsDistributionDouble >> hrDistributionDouble >> cadDistributionDouble >> gearDistributionDouble
+       >> nmDistributionDouble >> kphDistributionDouble >> xPowerDistributionDouble >> npDistributionDouble
+       >> wattsKgDistributionDouble >> aPowerDistributionDouble >> smo2DistributionDouble >> wbalDistributionDouble;
+
+    in >> wattsTimeInZone >> wattsCPTimeInZone >> hrTimeInZone >> hrCPTimeInZone
+       >> paceTimeInZone >> paceCPTimeInZone >> wbalTimeInZone;
+}
+
 //
 // Get heat mean max -- if an aggregated curve
 //
@@ -1895,6 +1739,7 @@ RideFileCache::serialize(QDataStream *out)
 
     // write header
     head.version = RideFileCacheVersion;
+    head.spare = 0;
     head.crc = crc;
     head.CP = CP;
     head.WPRIME = WPRIME;
@@ -1920,7 +1765,7 @@ RideFileCache::serialize(QDataStream *out)
     head.aPowerKgMeanMaxCount = aPowerKgMeanMax.size();
     head.wattsDistCount = wattsDistribution.size();
     head.xPowerDistCount = xPowerDistribution.size();
-    head.npDistCount = xPowerDistribution.size();
+    head.npDistCount = npDistribution.size();
     head.hrDistCount = hrDistribution.size();
     head.cadDistCount = cadDistribution.size();
     head.gearDistCount = gearDistribution.size();
@@ -1933,38 +1778,43 @@ RideFileCache::serialize(QDataStream *out)
 
     out->writeRawData((const char *) &head, sizeof(head));
 
-    // write meanmax
-    out->writeRawData((const char *) wattsMeanMax.data(), sizeof(float) * wattsMeanMax.size());
-    out->writeRawData((const char *) wattsKgMeanMax.data(), sizeof(float) * wattsKgMeanMax.size());
-    out->writeRawData((const char *) hrMeanMax.data(), sizeof(float) * hrMeanMax.size());
-    out->writeRawData((const char *) cadMeanMax.data(), sizeof(float) * cadMeanMax.size());
-    out->writeRawData((const char *) nmMeanMax.data(), sizeof(float) * nmMeanMax.size());
-    out->writeRawData((const char *) kphMeanMax.data(), sizeof(float) * kphMeanMax.size());
-    out->writeRawData((const char *) kphdMeanMax.data(), sizeof(float) * kphdMeanMax.size());
-    out->writeRawData((const char *) wattsdMeanMax.data(), sizeof(float) * wattsdMeanMax.size());
-    out->writeRawData((const char *) caddMeanMax.data(), sizeof(float) * caddMeanMax.size());
-    out->writeRawData((const char *) nmdMeanMax.data(), sizeof(float) * nmdMeanMax.size());
-    out->writeRawData((const char *) hrdMeanMax.data(), sizeof(float) * hrdMeanMax.size());
-    out->writeRawData((const char *) xPowerMeanMax.data(), sizeof(float) * xPowerMeanMax.size());
-    out->writeRawData((const char *) npMeanMax.data(), sizeof(float) * npMeanMax.size());
-    out->writeRawData((const char *) vamMeanMax.data(), sizeof(float) * vamMeanMax.size());
-    out->writeRawData((const char *) aPowerMeanMax.data(), sizeof(float) * aPowerMeanMax.size());
-    out->writeRawData((const char *) aPowerKgMeanMax.data(), sizeof(float) * aPowerKgMeanMax.size());
-
-
-    // write dist
-    out->writeRawData((const char *) wattsDistribution.data(), sizeof(float) * wattsDistribution.size());
-    out->writeRawData((const char *) hrDistribution.data(), sizeof(float) * hrDistribution.size());
-    out->writeRawData((const char *) cadDistribution.data(), sizeof(float) * cadDistribution.size());
-    out->writeRawData((const char *) gearDistribution.data(), sizeof(float) * gearDistribution.size());
-    out->writeRawData((const char *) nmDistribution.data(), sizeof(float) * nmDistribution.size());
-    out->writeRawData((const char *) kphDistribution.data(), sizeof(float) * kphDistribution.size());
-    out->writeRawData((const char *) xPowerDistribution.data(), sizeof(float) * xPowerDistribution.size());
-    out->writeRawData((const char *) npDistribution.data(), sizeof(float) * npDistribution.size());
-    out->writeRawData((const char *) wattsKgDistribution.data(), sizeof(float) * wattsKgDistribution.size());
-    out->writeRawData((const char *) aPowerDistribution.data(), sizeof(float) * aPowerDistribution.size());
-    out->writeRawData((const char *) smo2Distribution.data(), sizeof(float) * smo2Distribution.size());
-    out->writeRawData((const char *) wbalDistribution.data(), sizeof(float) * wbalDistribution.size());
+    // encode the meanmax and dist arrays, see RideFileCacheReader
+    QList<QByteArray> blocks;
+    blocks << CpxCodec::encodeMeanMax(wattsMeanMax);
+    blocks << CpxCodec::encodeMeanMax(wattsKgMeanMax);
+    blocks << CpxCodec::encodeMeanMax(hrMeanMax);
+    blocks << CpxCodec::encodeMeanMax(cadMeanMax);
+    blocks << CpxCodec::encodeMeanMax(nmMeanMax);
+    blocks << CpxCodec::encodeMeanMax(kphMeanMax);
+    blocks << CpxCodec::encodeMeanMax(kphdMeanMax);
+    blocks << CpxCodec::encodeMeanMax(wattsdMeanMax);
+    blocks << CpxCodec::encodeMeanMax(caddMeanMax);
+    blocks << CpxCodec::encodeMeanMax(nmdMeanMax);
+    blocks << CpxCodec::encodeMeanMax(hrdMeanMax);
+    blocks << CpxCodec::encodeMeanMax(xPowerMeanMax);
+    blocks << CpxCodec::encodeMeanMax(npMeanMax);
+    blocks << CpxCodec::encodeMeanMax(vamMeanMax);
+    blocks << CpxCodec::encodeMeanMax(aPowerMeanMax);
+    blocks << CpxCodec::encodeMeanMax(aPowerKgMeanMax);
+    blocks << CpxCodec::encodeDistribution(wattsDistribution);
+    blocks << CpxCodec::encodeDistribution(hrDistribution);
+    blocks << CpxCodec::encodeDistribution(cadDistribution);
+    blocks << CpxCodec::encodeDistribution(gearDistribution);
+    blocks << CpxCodec::encodeDistribution(nmDistribution);
+    blocks << CpxCodec::encodeDistribution(kphDistribution);
+    blocks << CpxCodec::encodeDistribution(xPowerDistribution);
+    blocks << CpxCodec::encodeDistribution(npDistribution);
+    blocks << CpxCodec::encodeDistribution(wattsKgDistribution);
+    blocks << CpxCodec::encodeDistribution(aPowerDistribution);
+    blocks << CpxCodec::encodeDistribution(smo2Distribution);
+    blocks << CpxCodec::encodeDistribution(wbalDistribution);
+
+    // their lengths so the reader can go straight to one
+    foreach(const QByteArray &block, blocks) {
+        quint32 length = block.size();
+        out->writeRawData((const char *) &length, sizeof(length));
+    }
+    foreach(const QByteArray &block, blocks) out->writeRawData(block.constData(), block.size());
 
     // time in zone
     out->writeRawData((const char *) wattsTimeInZone.data(), sizeof(float) * wattsTimeInZone.size());
@@ -1976,123 +1826,86 @@ RideFileCache::serialize(QDataStream *out)
     out->writeRawData((const char *) wbalTimeInZone.data(), sizeof(float) * wbalTimeInZone.size());
 }
 
+// copy an array out of the mapped cache file
+static void readArray(QVector<float> &into, const float *from, int count)
+{
+    into.resize(count);
+    if (count) memcpy(into.data(), from, count * sizeof(float));
+}
+
 void
-RideFileCache::readCache()
+RideFileCache::readCache(RideFileCacheReader &reader)
 {
-    RideFileCacheHeader head;
-    QFile cacheFile(cacheFileName);
+    // copy the arrays out of the mapped file
+    readArray(wattsMeanMax, reader.meanMaxData(RideFile::watts), reader.meanMaxCount(RideFile::watts));
+    readArray(wattsKgMeanMax, reader.meanMaxData(RideFile::wattsKg), reader.meanMaxCount(RideFile::wattsKg));
+    readArray(hrMeanMax, reader.meanMaxData(RideFile::hr), reader.meanMaxCount(RideFile::hr));
+    readArray(cadMeanMax, reader.meanMaxData(RideFile::cad), reader.meanMaxCount(RideFile::cad));
+    readArray(nmMeanMax, reader.meanMaxData(RideFile::nm), reader.meanMaxCount(RideFile::nm));
+    readArray(kphMeanMax, reader.meanMaxData(RideFile::kph), reader.meanMaxCount(RideFile::kph));
+    readArray(kphdMeanMax, reader.meanMaxData(RideFile::kphd), reader.meanMaxCount(RideFile::kphd));
+    readArray(wattsdMeanMax, reader.meanMaxData(RideFile::wattsd), reader.meanMaxCount(RideFile::wattsd));
+    readArray(caddMeanMax, reader.meanMaxData(RideFile::cadd), reader.meanMaxCount(RideFile::cadd));
+    readArray(nmdMeanMax, reader.meanMaxData(RideFile::nmd), reader.meanMaxCount(RideFile::nmd));
+    readArray(hrdMeanMax, reader.meanMaxData(RideFile::hrd), reader.meanMaxCount(RideFile::hrd));
+    readArray(xPowerMeanMax, reader.meanMaxData(RideFile::xPower), reader.meanMaxCount(RideFile::xPower));
+    readArray(npMeanMax, reader.meanMaxData(RideFile::NP), reader.meanMaxCount(RideFile::NP));
+    readArray(vamMeanMax, reader.meanMaxData(RideFile::vam), reader.meanMaxCount(RideFile::vam));
+    readArray(aPowerMeanMax, reader.meanMaxData(RideFile::aPower), reader.meanMaxCount(RideFile::aPower));
+    readArray(aPowerKgMeanMax, reader.meanMaxData(RideFile::aPowerKg), reader.meanMaxCount(RideFile::aPowerKg));
+
+    readArray(wattsDistribution, reader.distributionData(RideFile::watts), reader.distributionCount(RideFile::watts));
+    readArray(hrDistribution, reader.distributionData(RideFile::hr), reader.distributionCount(RideFile::hr));
+    readArray(cadDistribution, reader.distributionData(RideFile::cad), reader.distributionCount(RideFile::cad));
+    readArray(gearDistribution, reader.distributionData(RideFile::gear), reader.distributionCount(RideFile::gear));
+    readArray(nmDistribution, reader.distributionData(RideFile::nm), reader.distributionCount(RideFile::nm));
+    readArray(kphDistribution, reader.distributionData(RideFile::kph), reader.distributionCount(RideFile::kph));
+    readArray(xPowerDistribution, reader.distributionData(RideFile::xPower), reader.distributionCount(RideFile::xPower));
+    readArray(npDistribution, reader.distributionData(RideFile::NP), reader.distributionCount(RideFile::NP));
+    readArray(wattsKgDistribution, reader.distributionData(RideFile::wattsKg), reader.distributionCount(RideFile::wattsKg));
+    readArray(aPowerDistribution, reader.distributionData(RideFile::aPower), reader.distributionCount(RideFile::aPower));
+    readArray(smo2Distribution, reader.distributionData(RideFile::smo2), reader.distributionCount(RideFile::smo2));
+    readArray(wbalDistribution, reader.distributionData(RideFile::wbal), reader.distributionCount(RideFile::wbal));
 
-    if (cacheFile.open(QIODevice::ReadOnly) == true) {
-        QDataStream inFile(&cacheFile);
-
-        inFile.readRawData((char *) &head, sizeof(head));
-
-        // resize all the arrays to fit
-        wattsMeanMax.resize(head.wattsMeanMaxCount);
-        hrMeanMax.resize(head.hrMeanMaxCount);
-        cadMeanMax.resize(head.cadMeanMaxCount);
-        nmMeanMax.resize(head.nmMeanMaxCount);
-        kphMeanMax.resize(head.kphMeanMaxCount);
-        kphdMeanMax.resize(head.kphdMeanMaxCount);
-        wattsdMeanMax.resize(head.wattsdMeanMaxCount);
-        caddMeanMax.resize(head.caddMeanMaxCount);
-        nmdMeanMax.resize(head.nmdMeanMaxCount);
-        hrdMeanMax.resize(head.hrdMeanMaxCount);
-        npMeanMax.resize(head.npMeanMaxCount);
-        vamMeanMax.resize(head.vamMeanMaxCount);
-        xPowerMeanMax.resize(head.xPowerMeanMaxCount);
-        wattsKgMeanMax.resize(head.wattsKgMeanMaxCount);
-        aPowerMeanMax.resize(head.aPowerMeanMaxCount);
-        aPowerKgMeanMax.resize(head.aPowerKgMeanMaxCount);
-
-        wattsDistribution.resize(head.wattsDistCount);
-        hrDistribution.resize(head.hrDistCount);
-        cadDistribution.resize(head.cadDistCount);
-        gearDistribution.resize(head.gearDistCount);
-        nmDistribution.resize(head.nmDistrCount);
-        kphDistribution.resize(head.kphDistCount);
-        xPowerDistribution.resize(head.xPowerDistCount);
-        npDistribution.resize(head.npDistCount);
-        wattsKgDistribution.resize(head.wattsKgDistCount);
-        aPowerDistribution.resize(head.aPowerDistCount);
-        smo2Distribution.resize(head.smo2DistCount);
-        wbalDistribution.resize(head.wbalDistCount);
-
-        // read in the arrays
-        inFile.readRawData((char *) wattsMeanMax.data(), sizeof(float) * wattsMeanMax.size());
-        inFile.readRawData((char *) wattsKgMeanMax.data(), sizeof(float) * wattsKgMeanMax.size());
-        inFile.readRawData((char *) hrMeanMax.data(), sizeof(float) * hrMeanMax.size());
-        inFile.readRawData((char *) cadMeanMax.data(), sizeof(float) * cadMeanMax.size());
-        inFile.readRawData((char *) nmMeanMax.data(), sizeof(float) * nmMeanMax.size());
-        inFile.readRawData((char *) kphMeanMax.data(), sizeof(float) * kphMeanMax.size());
-        inFile.readRawData((char *) kphdMeanMax.data(), sizeof(float) * kphdMeanMax.size());
-        inFile.readRawData((char *) wattsdMeanMax.data(), sizeof(float) * wattsdMeanMax.size());
-        inFile.readRawData((char *) caddMeanMax.data(), sizeof(float) * caddMeanMax.size());
-        inFile.readRawData((char *) nmdMeanMax.data(), sizeof(float) * nmdMeanMax.size());
-        inFile.readRawData((char *) hrdMeanMax.data(), sizeof(float) * hrdMeanMax.size());
-        inFile.readRawData((char *) xPowerMeanMax.data(), sizeof(float) * xPowerMeanMax.size());
-        inFile.readRawData((char *) npMeanMax.data(), sizeof(float) * npMeanMax.size());
-        inFile.readRawData((char *) vamMeanMax.data(), sizeof(float) * vamMeanMax.size());
-        inFile.readRawData((char *) aPowerMeanMax.data(), sizeof(float) * aPowerMeanMax.size());
-        inFile.readRawData((char *) aPowerKgMeanMax.data(), sizeof(float) * aPowerKgMeanMax.size());
-
-
-        // write dist
-        inFile.readRawData((char *) wattsDistribution.data(), sizeof(float) * wattsDistribution.size());
-        inFile.readRawData((char *) hrDistribution.data(), sizeof(float) * hrDistribution.size());
-        inFile.readRawData((char *) cadDistribution.data(), sizeof(float) * cadDistribution.size());
-        inFile.readRawData((char *) gearDistribution.data(), sizeof(float) * gearDistribution.size());
-        inFile.readRawData((char *) nmDistribution.data(), sizeof(float) * nmDistribution.size());
-        inFile.readRawData((char *) kphDistribution.data(), sizeof(float) * kphDistribution.size());
-        inFile.readRawData((char *) xPowerDistribution.data(), sizeof(float) * xPowerDistribution.size());
-        inFile.readRawData((char *) npDistribution.data(), sizeof(float) * npDistribution.size());
-        inFile.readRawData((char *) wattsKgDistribution.data(), sizeof(float) * wattsKgDistribution.size());
-        inFile.readRawData((char *) aPowerDistribution.data(), sizeof(float) * aPowerDistribution.size());
-        inFile.readRawData((char *) smo2Distribution.data(), sizeof(float) * smo2Distribution.size());
-        inFile.readRawData((char *) wbalDistribution.data(), sizeof(float) * wbalDistribution.size());
-
-        // time in zone
-        inFile.readRawData((char *) wattsTimeInZone.data(), sizeof(float) * 10);
-        inFile.readRawData((char *) wattsCPTimeInZone.data(), sizeof(float) * 4);
-        inFile.readRawData((char *) hrTimeInZone.data(), sizeof(float) * 10);
-        inFile.readRawData((char *) hrCPTimeInZone.data(), sizeof(float) * 4);
-        inFile.readRawData((char *) paceTimeInZone.data(), sizeof(float) * 10);
-        inFile.readRawData((char *) paceCPTimeInZone.data(), sizeof(float) * 4);
-        inFile.readRawData((char *) wbalTimeInZone.data(), sizeof(float) * 4);
-
-        // setup the doubles the users use
-        doubleArray(wattsMeanMaxDouble, wattsMeanMax, RideFile::watts);
-        doubleArray(hrMeanMaxDouble, hrMeanMax, RideFile::hr);
-        doubleArray(cadMeanMaxDouble, cadMeanMax, RideFile::cad);
-        doubleArray(nmMeanMaxDouble, nmMeanMax, RideFile::nm);
-        doubleArray(kphMeanMaxDouble, kphMeanMax, RideFile::kph);
-        doubleArray(kphdMeanMaxDouble, kphdMeanMax, RideFile::kphd);
-        doubleArray(wattsdMeanMaxDouble, wattsdMeanMax, RideFile::wattsd);
-        doubleArray(caddMeanMaxDouble, caddMeanMax, RideFile::cadd);
-        doubleArray(nmdMeanMaxDouble, nmdMeanMax, RideFile::nmd);
-        doubleArray(hrdMeanMaxDouble, hrdMeanMax, RideFile::hrd);
-        doubleArray(npMeanMaxDouble, npMeanMax, RideFile::NP);
-        doubleArray(vamMeanMaxDouble, vamMeanMax, RideFile::vam);
-        doubleArray(xPowerMeanMaxDouble, xPowerMeanMax, RideFile::xPower);
-        doubleArray(wattsKgMeanMaxDouble, wattsKgMeanMax, RideFile::wattsKg);
-        doubleArray(aPowerMeanMaxDouble, aPowerMeanMax, RideFile::aPower);
-        doubleArray(aPowerKgMeanMaxDouble, aPowerKgMeanMax, RideFile::aPowerKg);
-
-        doubleArrayForDistribution(wattsDistributionDouble, wattsDistribution);
-        doubleArrayForDistribution(hrDistributionDouble, hrDistribution);
-        doubleArrayForDistribution(cadDistributionDouble, cadDistribution);
-        doubleArrayForDistribution(gearDistributionDouble, gearDistribution);
-        doubleArrayForDistribution(nmDistributionDouble, nmDistribution);
-        doubleArrayForDistribution(kphDistributionDouble, kphDistribution);
-        doubleArrayForDistribution(xPowerDistributionDouble, xPowerDistribution);
-        doubleArrayForDistribution(npDistributionDouble, npDistribution);
-        doubleArrayForDistribution(wattsKgDistributionDouble, wattsKgDistribution);
-        doubleArrayForDistribution(aPowerDistributionDouble, aPowerDistribution);
-        doubleArrayForDistribution(smo2DistributionDouble, smo2Distribution);
-        doubleArrayForDistribution(wbalDistributionDouble, wbalDistribution);
+    // time in zone
+    readArray(wattsTimeInZone, reader.zoneData(RideFile::watts), 10);
+    readArray(wattsCPTimeInZone, reader.zoneData(RideFile::watts, true), 4);
+    readArray(hrTimeInZone, reader.zoneData(RideFile::hr), 10);
+    readArray(hrCPTimeInZone, reader.zoneData(RideFile::hr, true), 4);
+    readArray(paceTimeInZone, reader.zoneData(RideFile::kph), 10);
+    readArray(paceCPTimeInZone, reader.zoneData(RideFile::kph, true), 4);
+    readArray(wbalTimeInZone, reader.zoneData(RideFile::wbal), 4);
 
-        cacheFile.close();
-    }
+    // setup the doubles the users use
+    doubleArray(wattsMeanMaxDouble, wattsMeanMax, RideFile::watts);
+    doubleArray(hrMeanMaxDouble, hrMeanMax, RideFile::hr);
+    doubleArray(cadMeanMaxDouble, cadMeanMax, RideFile::cad);
+    doubleArray(nmMeanMaxDouble, nmMeanMax, RideFile::nm);
+    doubleArray(kphMeanMaxDouble, kphMeanMax, RideFile::kph);
+    doubleArray(kphdMeanMaxDouble, kphdMeanMax, RideFile::kphd);
+    doubleArray(wattsdMeanMaxDouble, wattsdMeanMax, RideFile::wattsd);
+    doubleArray(caddMeanMaxDouble, caddMeanMax, RideFile::cadd);
+    doubleArray(nmdMeanMaxDouble, nmdMeanMax, RideFile::nmd);
+    doubleArray(hrdMeanMaxDouble, hrdMeanMax, RideFile::hrd);
+    doubleArray(npMeanMaxDouble, npMeanMax, RideFile::NP);
+    doubleArray(vamMeanMaxDouble, vamMeanMax, RideFile::vam);
+    doubleArray(xPowerMeanMaxDouble, xPowerMeanMax, RideFile::xPower);
+    doubleArray(wattsKgMeanMaxDouble, wattsKgMeanMax, RideFile::wattsKg);
+    doubleArray(aPowerMeanMaxDouble, aPowerMeanMax, RideFile::aPower);
+    doubleArray(aPowerKgMeanMaxDouble, aPowerKgMeanMax, RideFile::aPowerKg);
+
+    doubleArrayForDistribution(wattsDistributionDouble, wattsDistribution);
+    doubleArrayForDistribution(hrDistributionDouble, hrDistribution);
+    doubleArrayForDistribution(cadDistributionDouble, cadDistribution);
+    doubleArrayForDistribution(gearDistributionDouble, gearDistribution);
+    doubleArrayForDistribution(nmDistributionDouble, nmDistribution);
+    doubleArrayForDistribution(kphDistributionDouble, kphDistribution);
+    doubleArrayForDistribution(xPowerDistributionDouble, xPowerDistribution);
+    doubleArrayForDistribution(npDistributionDouble, npDistribution);
+    doubleArrayForDistribution(wattsKgDistributionDouble, wattsKgDistribution);
+    doubleArrayForDistribution(aPowerDistributionDouble, aPowerDistribution);
+    doubleArrayForDistribution(smo2DistributionDouble, smo2Distribution);
+    doubleArrayForDistribution(wbalDistributionDouble, wbalDistribution);
 }
 
 // unpack the longs into a double array
@@ -2145,89 +1958,33 @@ int RideFileCache::rank(Context *context, RideFile::SeriesType series, int durat
 double 
 RideFileCache::best(Context *context, QString filename, RideFile::SeriesType series, int duration)
 {
-    // read the header
+    // just the one value is read, out of date or not enough samples is zero
     QFileInfo rideFileInfo(context->athlete->home->activities().canonicalPath() + "/" + filename);
-    QString cacheFileName(context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx");
-    QFileInfo cacheFileInfo(cacheFileName);
-
-    // head
-    RideFileCacheHeader head;
-    QFile cacheFile(cacheFileName);
+    RideFileCacheReader reader(context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx");
 
-    if (cacheFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered) == true) {
-        QDataStream inFile(&cacheFile);
-        inFile.readRawData((char *) &head, sizeof(head));
-
-        // out of date or not enough samples
-        if (head.version != RideFileCacheVersion || duration > countForMeanMax(head, series)) {
-            cacheFile.close();
-            return 0;
-        }
-
-        // jump to correct offset
-        long offset = offsetForMeanMax(head, series) + (sizeof(float) * (duration));
-        inFile.skipRawData(offset);
-
-        float readhere = 0;
-        inFile.readRawData((char*)&readhere, sizeof(float));
-        cacheFile.close();
-
-        double divisor = pow(10, decimalsFor(series)); // ? 10 : 1;
-        return readhere / divisor; // will convert to double
-    }
-
-    return 0;
+    return reader.meanMax(series, duration);
 }
 
 int 
 RideFileCache::tiz(Context *context, QString filename, RideFile::SeriesType series, int zone)
 {
-    if (zone < 1 || zone > 10) return 0;
-
-    // read the header
+    // just the one value is read, out of date is zero
     QFileInfo rideFileInfo(context->athlete->home->activities().canonicalPath() + "/" + filename);
-    QString cacheFileName(context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx");
-    QFileInfo cacheFileInfo(cacheFileName);
+    RideFileCacheReader reader(context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx");
 
-    // head
-    RideFileCacheHeader head;
-    QFile cacheFile(cacheFileName);
-
-    if (cacheFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered) == true) {
-        QDataStream inFile(&cacheFile);
-        inFile.readRawData((char *) &head, sizeof(head));
-
-        // out of date 
-        if (head.version != RideFileCacheVersion) {
-            cacheFile.close();
-            return 0;
-        }
-
-        // jump to correct offset
-        long offset = offsetForTiz(head, series) + (sizeof(float) * (zone-1));
-        inFile.skipRawData(offset);
-
-        float readhere = 0;
-        inFile.readRawData((char*)&readhere, sizeof(float));
-        cacheFile.close();
-
-        return readhere; // will convert to double
-    }
-
-    return 0;
+    return reader.tiz(series, zone);
 }
 
 // get best values (as passed in the list of MetricDetails between the dates specified
 // and return as an array of RideBests)
 //
 // this is to 're-use' the metric api (especially in the LTM code) for passing back multiple
-// bests across multiple rides in one object. We do this so we can optimise the read/seek across
+// bests across multiple rides in one object. We do this so we can optimise the reads across
 // the CPX files within a single call.
 //
-// We order the bests requested in the order they will appear in the CPX file so we can open
-// and seek forward to each value before putting into the summary metric. Since it is placed
-// on the stack as a return parameter we also don't need to worry about memory allocation just
-// like the metric code works.
+// Each CPX file is mapped once and only the values requested are read from it before putting
+// into the summary metric. Since it is placed on the stack as a return parameter we also don't
+// need to worry about memory allocation just like the metric code works.
 // 
 //
 QList<RideBest>
@@ -2245,30 +2002,14 @@ RideFileCache::getAllBestsFor(Context *context, QList<MetricDetail> metrics, Spe
     if (worklist.count() == 0) return results; // no work to do
 
     // get a list of rides & iterate over them
+    RideFileCacheReader reader;
     foreach(RideItem *ride, context->athlete->rideCache->rides()) {
 
         if (!specification.pass(ride)) continue;
 
-        // get the ride cache name
-
-        // CPX ?
+        // CPX ? out of date - just skip
         QFileInfo rideFileInfo(context->athlete->home->activities().canonicalPath() + "/" + ride->fileName);
-        QString cacheFileName(context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx");
-        RideFileCacheHeader head;
-        QFile cacheFile(cacheFileName);
-
-        // open ok ?
-        if (cacheFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered) == false) continue;
-
-        // get header
-        QDataStream inFile(&cacheFile);
-        inFile.readRawData((char *) &head, sizeof(head));
-
-        // out of date - just skip
-        if (head.version != RideFileCacheVersion) {
-            cacheFile.close();
-            continue;
-        }
+        if (!reader.open(context->athlete->home->cache().canonicalPath() + "/" + rideFileInfo.baseName() + ".cpx")) continue;
 
         RideBest add;
         add.setFileName(ride->fileName);
@@ -2277,32 +2018,13 @@ RideFileCache::getAllBestsFor(Context *context, QList<MetricDetail> metrics, Spe
         // work through the worklist adding each best
         foreach (MetricDetail workitem, worklist) {
 
+            // get the values and place into the summarymetric map
             int seconds = workitem.duration * workitem.duration_units;
-            float value;
-
-            if (seconds > countForMeanMax(head, workitem.series)) value=0.0;
-            else {
-
-                // get the values and place into the summarymetric map
-                long offset = offsetForMeanMax(head, workitem.series) + 
-                              (sizeof(head)) +
-                              (sizeof(float) * ((workitem.duration*workitem.duration_units)));
-
-                cacheFile.seek(qint64(offset));
-                inFile.readRawData((char*)&value, sizeof(float));
-                double divisor = pow(10, decimalsFor(workitem.series));
-                value = value / divisor;
-
-            }
-            add.setForSymbol(workitem.bestSymbol, value);
-
+            add.setForSymbol(workitem.bestSymbol, reader.meanMax(workitem.series, seconds));
         }
 
         // add to the results
         results << add;
-
-        // close CPX file
-        cacheFile.close();
     }
 
     // all done, return results
@@ -23,12 +23,20 @@
 #include <QDataStream>
 #include <QVector>
 #include <QThread>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QSharedPointer>
 
 class Context;
 class RideFile;
 class RideBest;
 class MetricDetail;
 class Specification;
+class RideFileCacheReader;
+class RideItem;
 
 #include "GoldenCheetah.h"
 
@@ -41,7 +49,7 @@ typedef double data_t;
 // arrays when plotting CP curves and histograms. It is precoputed
 // to save time and cached in a file .cpx
 //
-static const unsigned int RideFileCacheVersion = 25;
+static const unsigned int RideFileCacheVersion = 27;
 // revision history:
 // version  date         description
 // 1        29-Apr-11    Initial - header, mean-max & distribution data blocks
@@ -68,13 +76,17 @@ static const unsigned int RideFileCacheVersion = 25;
 // 23       14-Jun-15    Added W'bal TiZ and Distribution
 // 24       15-Jun-15    Fix percentify error on W'bal Distribution
 // 25       19-Dec-16    Added aPower
+// 26       14-Mar-17    Compact encoding of meanmax and distribution blocks
+// 27       28-Mar-17    64 bit hash of the ride file in place of the crc
 
 // The cache file (.cpx) has a binary format:
 // 1 x Header data - describing the version and contents of the cache
-// n x Blocks - meanmax or distribution arrays
-// 1 x Watts TIZ - 10 floats
-// 1 x Heartrate TIZ - 10 floats
-// 1 x W'Bal TIX - 10 floats
+// 28 x Block lengths - in bytes, for each of the blocks that follow
+// n x Blocks - encoded meanmax or distribution arrays, see RideFileCacheReader
+// 1 x Watts TIZ - 10 floats (+4 polarized)
+// 1 x Heartrate TIZ - 10 floats (+4 polarized)
+// 1 x Pace TIZ - 10 floats (+4 polarized)
+// 1 x W'Bal TIZ - 4 floats
 
 // The header is written directly to disk, the only
 // field which is endian sensitive is the count field
@@ -83,7 +95,8 @@ static const unsigned int RideFileCacheVersion = 25;
 struct RideFileCacheHeader {
 
     unsigned int version;
-    unsigned int crc;
+    unsigned int spare;
+    quint64 crc; // RideFile::computeFileHash()
 
     unsigned int wattsMeanMaxCount,
                  hrMeanMaxCount,
@@ -123,13 +136,14 @@ struct RideFileCacheHeader {
 };
 
 
-// Each block of data is an array of uint32_t (32-bit "local-endian")
-// integers so the "count" setting within the block definition tells
-// us how long it is so we can read in one instruction and reference
-// it directly. Of course, this means that for data series that require
-// decimal places (e.g. speed) they are stored multiplied by 10^dp.
-// so 27.1 is stored as 271, 27.454 is stored as 27454, 100.0001 is
-// stored as 1000001.
+// Each block of data holds an array of floats, the "count" setting
+// in the header tells us how long it is once decoded. Of course, for
+// data series that require decimal places (e.g. speed) the meanmax
+// values are stored multiplied by 10^dp. so 27.1 is stored as 271,
+// 27.454 is stored as 27454, 100.0001 is stored as 1000001.
+// The blocks are encoded to keep the cache small, meanmax beyond an
+// hour is only kept for durations about 1% apart and those in between
+// are interpolated, see RideFileCacheReader for the details.
 
 // So that none of the plots need to understand the format of this
 // cache file this class is repsonsible for supplying the pre-computed
@@ -147,7 +161,7 @@ class RideFileCache
         enum cachetype { meanmax, distribution, none };
         typedef enum cachetype CacheType;
         QDate start, end;
-        unsigned int crc;
+        quint64 crc;
         bool incomplete; // skipped over data
 
         // Construct from a ridefile or its filename
@@ -169,9 +183,15 @@ class RideFileCache
         // are we stale ?
         static bool checkStale(Context *context, RideItem*item);
 
+        // open the cache file if it is up to date with the ride file, see RideFileCacheReader
+        static bool openCurrent(RideFileCacheReader &reader, QString rideFileName, QString cacheFileName, double weight);
+        static bool openCurrent(RideFileCacheReader &reader, Context *context, RideItem *item);
+
         // Just get mean max values for power & wpk for a ride
         static QVector<float> meanMaxPowerFor(Context *context, QVector<float>&wpk, QDate from, QDate to, bool wantruns=true);
         static QVector<float> meanMaxPowerFor(Context *context, QVector<float>&wpk, QString filename);
+        // .. for the rides passed, complete is set false if any had no up to date cache
+        static QVector<float> meanMaxPowerFor(Context *context, QVector<float>&wpk, const QList<RideItem*> &rides, bool *complete = NULL);
 
         // Fast standalone search reads input and outputs into ride_bests
         static void fastSearch(QVector<int>&input, QVector<int>&ride_bests, QVector<int>&ride_offsets);
@@ -187,7 +207,7 @@ class RideFileCache
         RideFileCache(RideFile*);
 
         // get a single best or time in zone value from the cache file
-        // intended to be very fast (using lseek to jump direct to the value requested
+        // intended to be very fast (mapping the file to read just the value requested)
         static int rank(Context *context, RideFile::SeriesType series, int duration, 
                         double value, Specification spec, int &of);
         static double best(Context *context, QString fileName, RideFile::SeriesType series, int duration);
@@ -204,6 +224,8 @@ class RideFileCache
 
         // get data
         static QList<RideFile::SeriesType> meanMaxList(); // list of types available as meanmax arrays
+        static QList<RideFile::SeriesType> computedList(); // every series compute() reads from a ride
+        static void inputs(QList<RideFile::SeriesType> &series, QStringList &xdata); // adds what compute() reads from a ride
         QVector<double> &meanMaxArray(RideFile::SeriesType); // return meanmax array for the given series
         QVector<QDate> &meanMaxDates(RideFile::SeriesType series); // the dates of the bests
         QVector<double> &distributionArray(RideFile::SeriesType); // return distribution array for the given series
@@ -232,15 +254,25 @@ class RideFileCache
     protected:
 
         void refreshCache();              // compute arrays and update cache
-        void readCache();                 // just read from saved file and setup arrays
+        void readCache(RideFileCacheReader &); // just read from saved file and setup arrays
         void serialize(QDataStream *out); // write to file
 
         void compute();             // compute all arrays
 
         // NOW replaced computeMeanMax with MeanMaxComputer class see bottom of file
         //void computeMeanMax(QVector<float>&, RideFile::SeriesType);      // compute mean max arrays
+        friend class DistributionComputer;
         void computeDistribution(QVector<float>&, RideFile::SeriesType); // compute the distributions
 
+        // date range aggregates, the index keeps them for weeks, months and years
+        friend class RideFileCacheIndex;
+        RideFileCache(Context *context);                // an empty aggregate
+        void resetAggregate();                          // set all the arrays empty
+        void aggregate(RideFileCacheReader &reader, QDate rideDate); // add an activity
+        void merge(const RideFileCache &other);         // add another aggregate
+        void serializeAggregate(QDataStream &out);      // write aggregate arrays
+        void readAggregate(QDataStream &in);            // read them back
+
 
     private:
 
@@ -404,8 +436,49 @@ struct cpintdata {
     cpintdata() : rec_int_ms(0) {}
 };
 
-// the mean-max computer ... runs in a thread
-class MeanMaxComputer : public QThread
+// The mean-max and distribution arrays for a ride are independent of
+// each other, so compute() adds a task for each to a RideFileCacheTasks
+// and runs them together on a pool shared by all rides, rather than
+// starting a thread for each one. The thread that runs them works
+// through the tasks too, so it never just sits waiting on a pool it
+// may itself be running on (e.g. from RideCache::refresh)
+class RideFileCacheTasks
+{
+    public:
+        RideFileCacheTasks() : state(new State) {}
+
+        void add(QRunnable *task);  // takes ownership
+        void run();                 // run them all, returns when they are done
+
+        // the shared pool, GC_REFRESH_THREADS sets how many threads
+        // it and the ride refresh may use between them, 0 (the default)
+        // is one per core
+        static QThreadPool *pool();
+        static int threads();
+        static void configure(); // from the setting, on the gui thread
+        static void reserve(int workers); // used by the refresh, on the gui thread
+
+        struct State {
+            State() : next(0), done(0) {}
+            ~State() { qDeleteAll(tasks); }
+
+            QList<QRunnable*> tasks;
+            QAtomicInt next; // next task to be claimed
+            int done;        // tasks completed, protected by lock
+            QMutex lock;
+            QWaitCondition finished;
+        };
+
+        // claim and run tasks until there are none left
+        static void work(State *state);
+
+    private:
+        // shared with any pool threads still to start
+        QSharedPointer<State> state;
+};
+
+// the mean-max computer ... runs as a task
+class MeanMaxComputer : public QRunnable
 {
     public:
         MeanMaxComputer(RideFile *ride, QVector<float>&array, RideFile::SeriesType series)
@@ -420,4 +493,19 @@ class MeanMaxComputer : public QThread
 
         RideFile::SeriesType series;
 };
+
+// the distribution computer ... runs as a task
+class DistributionComputer : public QRunnable
+{
+    public:
+        DistributionComputer(RideFileCache *cache, QVector<float>&array, RideFile::SeriesType series)
+        : cache(cache), array(array), series(series) {}
+        void run() { cache->computeDistribution(array, series); }
+
+    private:
+
+        RideFileCache *cache;
+        QVector<float> &array;
+        RideFile::SeriesType series;
+};
 #endif // _GC_RideFileCache_h
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideFileCacheIndex.h"
+#include "RideFileCache.h"
+#include "RideFileCacheReader.h"
+#include "Context.h"
+#include "Athlete.h"
+#include "RideCache.h"
+#include "RideItem.h"
+
+#include <QDir>
+#include <QFile>
+#include <QDataStream>
+
+// bump when the layout of the saved aggregates changes
+static const quint32 indexVersion = 1;
+
+// years, months and weeks kept in memory, enough for a few
+// seasons of weeks and months and all the years
+static const int maxNodes = 64;
+
+RideFileCacheIndex::RideFileCacheIndex(Context *context) : context(context), lock(QMutex::Recursive)
+{
+    nodes.setMaxCost(maxNodes);
+}
+
+RideFileCacheIndex::~RideFileCacheIndex()
+{
+    // the nodes are deleted with the cache
+}
+
+//
+// PERIODS
+//
+QDate
+RideFileCacheIndex::periodStart(PeriodType type, QDate date)
+{
+    switch (type) {
+    case Year: return QDate(date.year(), 1, 1);
+    case Month: return QDate(date.year(), date.month(), 1);
+    default:
+    case Week:
+        {
+            // monday, or the 1st if the week started last month
+            QDate monday = date.addDays(1 - date.dayOfWeek());
+            QDate first = periodStart(Month, date);
+            return monday < first ? first : monday;
+        }
+    }
+}
+
+QDate
+RideFileCacheIndex::periodEnd(PeriodType type, QDate date)
+{
+    switch (type) {
+    case Year: return QDate(date.year(), 12, 31);
+    case Month: return QDate(date.year(), date.month(), date.daysInMonth());
+    default:
+    case Week:
+        {
+            // sunday, or the end of the month if sooner
+            QDate sunday = date.addDays(7 - date.dayOfWeek());
+            QDate last = periodEnd(Month, date);
+            return sunday > last ? last : sunday;
+        }
+    }
+}
+
+QString
+RideFileCacheIndex::key(PeriodType type, QDate date)
+{
+    switch (type) {
+    case Year: return periodStart(Year, date).toString("'y'yyyy");
+    case Month: return periodStart(Month, date).toString("'m'yyyyMM");
+    default:
+    case Week: return periodStart(Week, date).toString("'w'yyyyMMdd");
+    }
+}
+
+//
+// AGGREGATING
+//
+bool
+RideFileCacheIndex::aggregate(RideFileCache *into, QDate start, QDate end)
+{
+    QMutexLocker locker(&lock);
+
+    bool complete = true;
+
+    // nothing to do outside the activities we have
+    QVector<RideItem*> &rides = context->athlete->rideCache->rides();
+    if (rides.isEmpty()) return complete;
+    if (start < rides.first()->dateTime.date()) start = rides.first()->dateTime.date();
+    if (end > rides.last()->dateTime.date()) end = rides.last()->dateTime.date();
+
+    // walk through the range, a year, month or week at a time if we
+    // can, otherwise the activities up to the end of the week
+    QDate date = start;
+    while (date <= end) {
+
+        bool used = false;
+        PeriodType types[] = { Year, Month, Week };
+        for (int i=0; i<3 && !used; i++) {
+            if (periodStart(types[i], date) == date && periodEnd(types[i], date) <= end) {
+                RideFileCache *period = node(types[i], date);
+                into->merge(*period);
+                if (period->incomplete) complete = false;
+                date = periodEnd(types[i], date).addDays(1);
+                used = true;
+            }
+        }
+
+        if (!used) {
+            QDate to = periodEnd(Week, date);
+            if (to > end) to = end;
+            if (aggregateRides(into, date, to) == false) complete = false;
+            date = to.addDays(1);
+        }
+    }
+    return complete;
+}
+
+RideFileCache *
+RideFileCacheIndex::node(PeriodType type, QDate date)
+{
+    QString name = key(type, date);
+
+    // already got it ?
+    RideFileCache *have = nodes.object(name);
+    if (have) return have;
+
+    QDate from = periodStart(type, date);
+    QDate to = periodEnd(type, date);
+    unsigned int print = fingerprint(from, to);
+
+    // saved from last time ?
+    RideFileCache *returning = load(name, print);
+
+    if (returning == NULL) {
+
+        returning = new RideFileCache(context);
+
+        switch (type) {
+        case Year:
+        case Month:
+            {
+                // from the months or weeks in it, oldest first
+                PeriodType child = type == Year ? Month : Week;
+                for (QDate d = from; d <= to; d = periodEnd(child, d).addDays(1))
+                    returning->merge(*node(child, d));
+            }
+            break;
+
+        case Week:
+            if (aggregateRides(returning, from, to) == false) returning->incomplete = true;
+            break;
+        }
+
+        // the activities will be refreshed and we'll be invalidated
+        // when their .cpx is written, so only save if complete
+        if (!returning->incomplete) save(name, print, returning);
+    }
+
+    returning->start = from;
+    returning->end = to;
+
+    // the least recently used go if there are too many, never this
+    // one, and the callers merge it before asking for another
+    nodes.insert(name, returning);
+    return returning;
+}
+
+int
+RideFileCacheIndex::firstRide(QDate date)
+{
+    QVector<RideItem*> &rides = context->athlete->rideCache->rides();
+
+    // they are in date order
+    int low = 0, high = rides.count();
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (rides[mid]->dateTime.date() < date) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+bool
+RideFileCacheIndex::aggregateRides(RideFileCache *into, QDate from, QDate to)
+{
+    bool complete = true;
+    QVector<RideItem*> &rides = context->athlete->rideCache->rides();
+
+    RideFileCacheReader reader;
+    for (int i=firstRide(from); i<rides.count() && rides[i]->dateTime.date() <= to; i++) {
+
+        RideItem *item = rides[i];
+
+        // its cached values (will NOT! refresh if needed...)
+        // ack, data not available !
+        if (RideFileCache::openCurrent(reader, context, item) == false) complete = false;
+        else into->aggregate(reader, item->dateTime.date());
+    }
+    return complete;
+}
+
+void
+RideFileCacheIndex::invalidate(QDate date)
+{
+    QMutexLocker locker(&lock);
+
+    PeriodType types[] = { Year, Month, Week };
+    for (int i=0; i<3; i++) {
+        QString name = key(types[i], date);
+        delete nodes.take(name); // NULL if not there
+        QFile::remove(fileName(name));
+    }
+}
+
+//
+// SAVED AGGREGATES
+//
+unsigned int
+RideFileCacheIndex::fingerprint(QDate from, QDate to)
+{
+    // just the activities in the period
+    QList<RideItem*> period;
+    QVector<RideItem*> &rides = context->athlete->rideCache->rides();
+    for (int i=firstRide(from); i<rides.count() && rides[i]->dateTime.date() <= to; i++)
+        period << rides[i];
+
+    return RideCache::fingerprint(period);
+}
+
+QString
+RideFileCacheIndex::fileName(QString key)
+{
+    return context->athlete->home->cache().canonicalPath() + "/bests/" + key + ".bests";
+}
+
+RideFileCache *
+RideFileCacheIndex::load(QString key, unsigned int fingerprint)
+{
+    QFile file(fileName(key));
+    if (!file.open(QIODevice::ReadOnly)) return NULL;
+
+    QDataStream in(&file);
+    quint32 version, cpxversion, print;
+    in >> version >> cpxversion >> print;
+
+    // out of date
+    if (version != indexVersion || cpxversion != RideFileCacheVersion || print != fingerprint) return NULL;
+
+    RideFileCache *returning = new RideFileCache(context);
+    returning->readAggregate(in);
+
+    if (in.status() != QDataStream::Ok) {
+        delete returning;
+        return NULL;
+    }
+    return returning;
+}
+
+void
+RideFileCacheIndex::save(QString key, unsigned int fingerprint, RideFileCache *node)
+{
+    QDir cache = context->athlete->home->cache();
+    if (!cache.exists("bests")) cache.mkdir("bests");
+
+    QFile file(fileName(key));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return;
+
+    QDataStream out(&file);
+    out << quint32(indexVersion) << quint32(RideFileCacheVersion) << quint32(fingerprint);
+    node->serializeAggregate(out);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideFileCacheIndex_h
+#define _GC_RideFileCacheIndex_h 1
+#include "GoldenCheetah.h"
+
+#include <QDate>
+#include <QCache>
+#include <QMutex>
+#include <QString>
+
+class Context;
+class RideFileCache;
+
+//
+// A date range RideFileCache aggregates the mean-max and distribution
+// arrays of every activity in the range, which means reading the .cpx
+// of each one. To avoid that, the aggregates for each year, month and
+// week are kept, in memory and in cache/bests, and a range is built
+// from the largest of these that fit inside it; only the activities
+// at either end are read from their .cpx files.
+//
+// Weeks start on a Monday but are split at the end of a month, so
+// weeks fit inside months and months fit inside years. Weeks are built
+// from the activities in them, months from their weeks and years from
+// their months.
+//
+// When an activity's .cpx is refreshed, or it is added or deleted, the
+// week, month and year it is in are dropped, to be rebuilt when next
+// used. Those saved to disk carry a fingerprint of the activities in
+// them so they are not used if the activities changed in the meantime.
+//
+// Each one holds full length arrays for every series, so only the most
+// recently used are kept in memory, the rest are read back from disk.
+//
+class RideFileCacheIndex
+{
+    public:
+        RideFileCacheIndex(Context *context);
+        ~RideFileCacheIndex();
+
+        // add the activities from start to end to the aggregate,
+        // returns false if any of them had no .cpx
+        bool aggregate(RideFileCache *into, QDate start, QDate end);
+
+        // the activities on this date changed
+        void invalidate(QDate date);
+
+    private:
+
+        enum PeriodType { Year, Month, Week };
+
+        static QDate periodStart(PeriodType type, QDate date);
+        static QDate periodEnd(PeriodType type, QDate date);
+        static QString key(PeriodType type, QDate date);
+
+        // the aggregate for the period containing date, built if needed
+        RideFileCache *node(PeriodType type, QDate date);
+
+        // read the activities' .cpx files, returns false if any were missing
+        bool aggregateRides(RideFileCache *into, QDate from, QDate to);
+
+        // index of the first activity on or after date
+        int firstRide(QDate date);
+
+        // so saved aggregates are only used if the activities are unchanged
+        unsigned int fingerprint(QDate from, QDate to);
+        QString fileName(QString key);
+        RideFileCache *load(QString key, unsigned int fingerprint);
+        void save(QString key, unsigned int fingerprint, RideFileCache *node);
+
+        Context *context;
+        QMutex lock;
+        QCache<QString, RideFileCache> nodes; // most recently used
+};
+
+#endif // _GC_RideFileCacheIndex_h
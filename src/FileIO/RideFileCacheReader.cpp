@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideFileCacheReader.h"
+#include "CpxCodec.h"
+
+#include <cmath> // for pow()
+#include <string.h> // for memcpy()
+
+// the arrays in the order RideFileCache::serialize() writes them
+struct CacheBlock {
+    RideFile::SeriesType series;
+    unsigned int RideFileCacheHeader::*count;
+};
+
+static const CacheBlock meanMaxOrder[] = {
+    { RideFile::watts, &RideFileCacheHeader::wattsMeanMaxCount },
+    { RideFile::wattsKg, &RideFileCacheHeader::wattsKgMeanMaxCount },
+    { RideFile::hr, &RideFileCacheHeader::hrMeanMaxCount },
+    { RideFile::cad, &RideFileCacheHeader::cadMeanMaxCount },
+    { RideFile::nm, &RideFileCacheHeader::nmMeanMaxCount },
+    { RideFile::kph, &RideFileCacheHeader::kphMeanMaxCount },
+    { RideFile::kphd, &RideFileCacheHeader::kphdMeanMaxCount },
+    { RideFile::wattsd, &RideFileCacheHeader::wattsdMeanMaxCount },
+    { RideFile::cadd, &RideFileCacheHeader::caddMeanMaxCount },
+    { RideFile::nmd, &RideFileCacheHeader::nmdMeanMaxCount },
+    { RideFile::hrd, &RideFileCacheHeader::hrdMeanMaxCount },
+    { RideFile::xPower, &RideFileCacheHeader::xPowerMeanMaxCount },
+    { RideFile::NP, &RideFileCacheHeader::npMeanMaxCount },
+    { RideFile::vam, &RideFileCacheHeader::vamMeanMaxCount },
+    { RideFile::aPower, &RideFileCacheHeader::aPowerMeanMaxCount },
+    { RideFile::aPowerKg, &RideFileCacheHeader::aPowerKgMeanMaxCount }
+};
+
+static const CacheBlock distOrder[] = {
+    { RideFile::watts, &RideFileCacheHeader::wattsDistCount },
+    { RideFile::hr, &RideFileCacheHeader::hrDistCount },
+    { RideFile::cad, &RideFileCacheHeader::cadDistCount },
+    { RideFile::gear, &RideFileCacheHeader::gearDistCount },
+    { RideFile::nm, &RideFileCacheHeader::nmDistrCount },
+    { RideFile::kph, &RideFileCacheHeader::kphDistCount },
+    { RideFile::xPower, &RideFileCacheHeader::xPowerDistCount },
+    { RideFile::NP, &RideFileCacheHeader::npDistCount },
+    { RideFile::wattsKg, &RideFileCacheHeader::wattsKgDistCount },
+    { RideFile::aPower, &RideFileCacheHeader::aPowerDistCount },
+    { RideFile::smo2, &RideFileCacheHeader::smo2DistCount },
+    { RideFile::wbal, &RideFileCacheHeader::wbalDistCount }
+};
+
+//
+// READING
+//
+RideFileCacheReader::RideFileCacheReader() : mapped(NULL), data(NULL)
+{
+}
+
+RideFileCacheReader::RideFileCacheReader(QString cacheFileName) : mapped(NULL), data(NULL)
+{
+    open(cacheFileName);
+}
+
+RideFileCacheReader::~RideFileCacheReader()
+{
+    close();
+}
+
+bool
+RideFileCacheReader::open(QString cacheFileName)
+{
+    close();
+
+    file.setFileName(cacheFileName);
+    if (file.open(QIODevice::ReadOnly) == false) return false;
+
+    // header and block lengths
+    qint64 size = file.size();
+    qint64 fixed = sizeof(head) + blocks * sizeof(quint32) + tizCount * sizeof(float);
+    if (size < fixed) {
+        close();
+        return false;
+    }
+
+    mapped = file.map(0, size);
+    if (mapped == NULL) {
+        close();
+        return false;
+    }
+
+    // the header isn't necessarily aligned for us, so copy it
+    memcpy(&head, mapped, sizeof(head));
+    if (head.version != RideFileCacheVersion) {
+        close();
+        return false;
+    }
+
+    quint32 length[blocks];
+    memcpy(length, mapped + sizeof(head), sizeof(length));
+
+    // where everything is, and is it all there ?
+    qint64 total = fixed;
+    for (int i=0; i<blocks; i++) total += length[i];
+    if (total != size) {
+        close();
+        return false;
+    }
+
+    const uchar *p = mapped + sizeof(head) + sizeof(length);
+    for (int i=0; i<blocks; i++) {
+
+        const CacheBlock &order = i < meanMaxBlocks ? meanMaxOrder[i] : distOrder[i - meanMaxBlocks];
+
+        Block block;
+        block.start = p;
+        block.end = p + length[i];
+        block.count = head.*(order.count);
+        p = block.end;
+
+        if (block.count < 0) {
+            close();
+            return false;
+        }
+
+        if (i < meanMaxBlocks) meanMaxBlock.insert(order.series, block);
+        else distBlock.insert(order.series, block);
+    }
+    memcpy(tizData, p, sizeof(tizData));
+
+    data = mapped + sizeof(head);
+    return true;
+}
+
+void
+RideFileCacheReader::close()
+{
+    if (mapped) file.unmap(mapped);
+    file.close();
+    mapped = NULL;
+    data = NULL;
+    meanMaxBlock.clear();
+    distBlock.clear();
+    meanMaxFloat.clear();
+    distFloat.clear();
+    meanMaxDouble.clear();
+    distDouble.clear();
+}
+
+//
+// MEAN MAX
+//
+int
+RideFileCacheReader::meanMaxCount(RideFile::SeriesType series) const
+{
+    return meanMaxBlock.value(series).count;
+}
+
+const float *
+RideFileCacheReader::meanMaxData(RideFile::SeriesType series) const
+{
+    int count = meanMaxCount(series);
+    if (count == 0) return NULL;
+
+    QMap<int, QVector<float> >::iterator it = meanMaxFloat.find(series);
+    if (it == meanMaxFloat.end()) {
+        it = meanMaxFloat.insert(series, QVector<float>(count));
+
+        const Block block = meanMaxBlock.value(series);
+        if (!CpxCodec::decodeMeanMax(block.start, block.end, count, count-1, it.value().data()))
+            it.value().fill(0);
+    }
+    return it.value().constData();
+}
+
+double
+RideFileCacheReader::meanMax(RideFile::SeriesType series, int duration) const
+{
+    if (duration < 0 || duration >= meanMaxCount(series)) return 0;
+
+    double divisor = pow(10, RideFileCache::decimalsFor(series));
+
+    // already decoded ?
+    if (meanMaxFloat.contains(series)) return meanMaxData(series)[duration] / divisor;
+
+    // only decode as far as we need
+    QVector<float> upto(duration+1);
+    const Block block = meanMaxBlock.value(series);
+    if (!CpxCodec::decodeMeanMax(block.start, block.end, block.count, duration, upto.data())) return 0;
+    return upto[duration] / divisor;
+}
+
+const QVector<double> &
+RideFileCacheReader::meanMax(RideFile::SeriesType series)
+{
+    int count = meanMaxCount(series);
+    if (count == 0) return empty;
+
+    QMap<int, QVector<double> >::iterator it = meanMaxDouble.find(series);
+    if (it == meanMaxDouble.end()) {
+        it = meanMaxDouble.insert(series, QVector<double>(count));
+
+        const float *from = meanMaxData(series);
+        double divisor = pow(10, RideFileCache::decimalsFor(series));
+        double *into = it.value().data();
+        for (int i=0; i<count; i++) into[i] = double(from[i]) / divisor;
+    }
+    return it.value();
+}
+
+//
+// DISTRIBUTION
+//
+int
+RideFileCacheReader::distributionCount(RideFile::SeriesType series) const
+{
+    return distBlock.value(series).count;
+}
+
+const float *
+RideFileCacheReader::distributionData(RideFile::SeriesType series) const
+{
+    int count = distributionCount(series);
+    if (count == 0) return NULL;
+
+    QMap<int, QVector<float> >::iterator it = distFloat.find(series);
+    if (it == distFloat.end()) {
+        it = distFloat.insert(series, QVector<float>(count));
+
+        const Block block = distBlock.value(series);
+        if (!CpxCodec::decodeDistribution(block.start, block.end, count, it.value().data()))
+            it.value().fill(0);
+    }
+    return it.value().constData();
+}
+
+const QVector<double> &
+RideFileCacheReader::distribution(RideFile::SeriesType series)
+{
+    int count = distributionCount(series);
+    if (count == 0) return empty;
+
+    QMap<int, QVector<double> >::iterator it = distDouble.find(series);
+    if (it == distDouble.end()) {
+        it = distDouble.insert(series, QVector<double>(count));
+
+        const float *from = distributionData(series);
+        double *into = it.value().data();
+        for (int i=0; i<count; i++) into[i] = double(from[i]);
+    }
+    return it.value();
+}
+
+//
+// TIME IN ZONE
+//
+const float *
+RideFileCacheReader::zoneData(RideFile::SeriesType series, bool polarized) const
+{
+    if (!isValid()) return NULL;
+
+    // watts(10)/CPwatts(4)/HR(10)/CPhr(4)/PACE(10)/CPpace(4)/wbal(4)
+    int extra = polarized ? 10 : 0;
+
+    switch (series) {
+    case RideFile::watts: return tizData + extra;
+    case RideFile::hr: return tizData + (10+4) + extra;
+    case RideFile::kph: return tizData + 2*(10+4) + extra;
+    case RideFile::wbal: return tizData + 3*(10+4);
+    default: return NULL;
+    }
+}
+
+float
+RideFileCacheReader::tiz(RideFile::SeriesType series, int zone) const
+{
+    const float *zones = zoneData(series);
+    int count = series == RideFile::wbal ? 4 : 10;
+
+    if (zones == NULL || zone < 1 || zone > count) return 0;
+    return zones[zone-1];
+}
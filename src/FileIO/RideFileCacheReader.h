@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideFileCacheReader_h
+#define _GC_RideFileCacheReader_h 1
+#include "GoldenCheetah.h"
+
+#include "RideFile.h"
+#include "RideFileCache.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QMap>
+#include <QVector>
+
+//
+// Reads a .cpx file in place by mapping it into memory, rather than
+// reading every array into a RideFileCache. Only the pages holding
+// the values asked for are read from disk, so looking up a single
+// best or time in zone, or just the power mean max, is cheap.
+//
+// The header is checked against RideFileCacheVersion and the block
+// lengths after it against the size of the file, so the arrays can be
+// trusted once isValid() returns true.
+//
+// Each array is stored as an encoded block (see CpxCodec) and is only
+// decoded when it is first asked for. The raw arrays are as computed, i.e. mean max values are
+// multiplied by 10^RideFileCache::decimalsFor(series). The converted
+// arrays are what RideFileCache provides and are also made on first use.
+//
+class RideFileCacheReader
+{
+    public:
+        RideFileCacheReader();
+        RideFileCacheReader(QString cacheFileName);
+        ~RideFileCacheReader();
+
+        // map the file and check the header, returns isValid()
+        bool open(QString cacheFileName);
+        void close();
+
+        bool isValid() const { return data != NULL; }
+        const RideFileCacheHeader &header() const { return head; }
+
+        // raw mean max values, NULL if there are none
+        int meanMaxCount(RideFile::SeriesType series) const;
+        const float *meanMaxData(RideFile::SeriesType series) const;
+
+        // converted, the best for a single duration or the whole array
+        double meanMax(RideFile::SeriesType series, int duration) const;
+        const QVector<double> &meanMax(RideFile::SeriesType series);
+
+        // distributions are times in seconds so need no conversion
+        int distributionCount(RideFile::SeriesType series) const;
+        const float *distributionData(RideFile::SeriesType series) const;
+        const QVector<double> &distribution(RideFile::SeriesType series);
+
+        // time in zone for watts, hr, kph (pace) and wbal, zones
+        // has 10 entries and polarized zones 4 (wbal has only 4)
+        const float *zoneData(RideFile::SeriesType series, bool polarized=false) const;
+        float tiz(RideFile::SeriesType series, int zone) const; // zone from 1
+
+        // the blocks in a .cpx file, in the order they are written
+        enum { meanMaxBlocks = 16, distBlocks = 12, blocks = meanMaxBlocks + distBlocks };
+        enum { tizCount = 3*(10+4) + 4 };
+
+    private:
+        struct Block {
+            const uchar *start, *end;
+            int count;
+            Block() : start(NULL), end(NULL), count(0) {}
+        };
+
+        QFile file;
+        RideFileCacheHeader head;
+        uchar *mapped;
+        const uchar *data; // just past the header
+
+        QMap<int, Block> meanMaxBlock, distBlock;
+        float tizData[tizCount];
+
+        // decoded when first used
+        mutable QMap<int, QVector<float> > meanMaxFloat, distFloat;
+        QMap<int, QVector<double> > meanMaxDouble, distDouble;
+        QVector<double> empty;
+};
+
+#endif // _GC_RideFileCacheReader_h
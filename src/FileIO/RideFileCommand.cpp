@@ -545,12 +545,12 @@ RemoveXDataSeriesCommand::doCommand()
     values.resize(series->datapoints.count());
     for(int i=0; i<series->datapoints.count(); i++) {
         values[i] = series->datapoints[i]->number[index];
-        series->datapoints[i]->number[index] = 0;
+        series->datapoints[i]->number.set(index, 0);
 
         // shift the values down
         for(int j=index+1; j<8; j++) {
-            series->datapoints[i]->number[j-1] =
-            series->datapoints[i]->number[j];
+            series->datapoints[i]->number.set(j-1,
+            series->datapoints[i]->number[j]);
         }
     }
 
@@ -575,10 +575,10 @@ RemoveXDataSeriesCommand::undoCommand()
     for(int i=0; i<series->datapoints.count(); i++) {
         // shift the values right
         for(int j=index; j<7; j++) {
-            series->datapoints[i]->number[j+1] =
-            series->datapoints[i]->number[j];
+            series->datapoints[i]->number.set(j+1,
+            series->datapoints[i]->number[j]);
         }
-        series->datapoints[i]->number[index] = values[i];
+        series->datapoints[i]->number.set(index, values[i]);
     }
     return true;
 }
@@ -604,7 +604,7 @@ AddXDataSeriesCommand::doCommand()
 
     // Clear the value
     for(int i=0; i<series->datapoints.count(); i++) {
-        series->datapoints[i]->number[index] = 0;
+        series->datapoints[i]->number.set(index, 0);
     }
 
     return true;
@@ -642,7 +642,7 @@ SetXDataPointValueCommand::doCommand()
         case 1:
         series->datapoints[row]->km = newvalue;
         default:
-        series->datapoints[row]->number[col-2] = newvalue;
+        series->datapoints[row]->number.set(col-2, newvalue);
         }
     }
     return true;
@@ -658,7 +658,7 @@ SetXDataPointValueCommand::undoCommand()
         case 1:
         series->datapoints[row]->km = oldvalue;
         default:
-        series->datapoints[row]->number[col-2] = oldvalue;
+        series->datapoints[row]->number.set(col-2, oldvalue);
         }
     }
     return true;
@@ -272,9 +272,9 @@ SmlParser::endElement(const QString&, const QString&, const QString& qName)
             XDataPoint *p = new XDataPoint();
             p->secs = lastLength;
             p->km = lastDistance;
-            p->number[0] = (distance > lastDistance) ? 1 + style : 0;
-            p->number[1] = time - lastLength;
-            p->number[2] = (distance > lastDistance) ? strokes : 0;
+            p->number.set(0, (distance > lastDistance) ? 1 + style : 0);
+            p->number.set(1, time - lastLength);
+            p->number.set(2, (distance > lastDistance) ? strokes : 0);
             swimXdata->datapoints.append(p);
 
             if (distance > lastDistance) {
@@ -324,7 +324,7 @@ SmlParser::endElement(const QString&, const QString&, const QString& qName)
             XDataPoint *p = new XDataPoint();
             p->secs = secs;
             p->km = 0;
-            p->number[0] = rr * 1000.0;
+            p->number.set(0, rr * 1000.0);
             hrvXdata->datapoints.append(p);
         }
         if (ewmaRR >= 0.0 && !rideFile->isDataPresent(rideFile->hr))
@@ -269,8 +269,8 @@ TcxParser::endElement( const QString&, const QString&, const QString& qName)
                     XDataPoint *p = new XDataPoint();
                     p->secs = lastLength;
                     p->km = last_distance;
-                    p->number[0] = deltaDist > 0 ? 1 : 0;
-                    p->number[1] = deltaSecs;
+                    p->number.set(0, deltaDist > 0 ? 1 : 0);
+                    p->number.set(1, deltaSecs);
                     swimXdata->datapoints.append(p);
 
                     for (int i = rideFile->timeIndex(lastLength);
@@ -294,8 +294,8 @@ TcxParser::endElement( const QString&, const QString&, const QString& qName)
                     XDataPoint *p = new XDataPoint();
                     p->secs = prevPoint->secs;
                     p->km = last_distance;
-                    p->number[0] = deltaDist > 0 ? 1 : 0;
-                    p->number[1] = deltaSecs;
+                    p->number.set(0, deltaDist > 0 ? 1 : 0);
+                    p->number.set(1, deltaSecs);
                     swimXdata->datapoints.append(p);
                     lastLength = p->secs + deltaSecs;
                 }
@@ -358,8 +358,8 @@ TcxParser::endElement( const QString&, const QString&, const QString& qName)
             XDataPoint *p = new XDataPoint();
             p->secs = secs;
             p->km = last_distance;
-            p->number[0] = 0;
-            p->number[1] = round(lapSecs);
+            p->number.set(0, 0);
+            p->number.set(1, round(lapSecs));
             swimXdata->datapoints.append(p);
             lastLength = secs + round(lapSecs);
         }
@@ -558,7 +558,7 @@ RideFile *TxtFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
             XDataPoint *p = new XDataPoint();
             p->secs = secs;
             p->km = 0;
-            p->number[0] = rr * 1000.0;
+            p->number.set(0, rr * 1000.0);
             hrvXdata->datapoints.append(p);
 
             secs += rr;
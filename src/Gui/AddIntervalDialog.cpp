@@ -27,6 +27,7 @@
 #include "Colors.h"
 #include "WPrime.h"
 #include "HelpWhatsThis.h"
+#include "PeakFinder.h"
 #include <QMap>
 #include <cmath>
 
@@ -470,29 +471,6 @@ intervalDistance(const RideFilePoint *start, const RideFilePoint *stop, const Ri
     return 1000*(stop->km - start->km);// + (ride->recIntSecs()*stop->kph/3600));
 }
 
-static bool
-intervalsOverlap(const AddIntervalDialog::AddedInterval &a,
-                 const AddIntervalDialog::AddedInterval &b)
-{
-    if ((a.start <= b.start) && (a.stop > b.start))
-        return true;
-    if ((b.start <= a.start) && (b.stop > a.start))
-        return true;
-    return false;
-}
-
-struct CompareBests {
-    // Sort by decreasing power and increasing start time.
-    bool operator()(const AddIntervalDialog::AddedInterval &a,
-                    const AddIntervalDialog::AddedInterval &b) const {
-        if (a.avg > b.avg)
-            return true;
-        if (b.avg > a.avg)
-            return false;
-        return a.start < b.start;
-    }
-};
-
 void
 AddIntervalDialog::createClicked()
 {
@@ -824,22 +802,104 @@ AddIntervalDialog::findFirsts(bool typeTime, const RideFile *ride, double window
 
 }
 
+// name the peaks found and add them to the results
+static void
+namePeaks(Context *context, bool typeTime, const RideFile *ride, RideFile::SeriesType series,
+          RideFile::Conversion conversion, double windowSize, int maxIntervals,
+          const QList<PeakFinder::Peak> &peaks, QList<AddIntervalDialog::AddedInterval> &results,
+          QString prefixe, QString overideName)
+{
+    int count = 0;
+    foreach(const PeakFinder::Peak &peak, peaks) {
+        AddIntervalDialog::AddedInterval candidate(peak.start, peak.stop, peak.avg);
+        count++;
+
+        QString name = overideName;
+        if (overideName == "") {
+            name = AddIntervalDialog::tr("%1 %3%4 %2");
+
+            if (prefixe == "")
+                name = name.arg(AddIntervalDialog::tr("Peak"));
+            else
+                name = name.arg(prefixe);
+
+            if (maxIntervals>1)
+                name = name.arg(QString("#%1").arg(count));
+            else
+                name = name.arg("");
+
+            if (typeTime)  {
+                // best n mins
+                if (windowSize < 60) {
+                    // whole seconds
+                    name = name.arg(windowSize);
+                    name = name.arg("sec");
+                } else if (windowSize >= 60 && !(((int)windowSize)%60)) {
+                    // whole minutes
+                    name = name.arg(windowSize/60);
+                    name = name.arg("min");
+                } else {
+                    double secs = windowSize;
+                    double mins = ((int) secs) / 60;
+                    secs = secs - mins * 60.0;
+                    double hrs = ((int) mins) / 60;
+                    mins = mins - hrs * 60.0;
+                    QString tm = "%1:%2:%3";
+                    tm = tm.arg(hrs, 0, 'f', 0);
+                    tm = tm.arg(mins, 2, 'f', 0, QLatin1Char('0'));
+                    tm = tm.arg(secs, 2, 'f', 0, QLatin1Char('0'));
+
+                    // mins and secs
+                    name = name.arg(tm);
+                    name = name.arg("");
+                }
+            } else {
+                // best n mins
+                if (windowSize < 1000) {
+                    // whole seconds
+                    name = name.arg(windowSize);
+                    name = name.arg("m");
+                } else {
+                    double dist = windowSize;
+                    double kms = ((int) dist) / 1000;
+                    dist = dist - kms * 1000.0;
+                    double ms = dist;
+
+                    QString tm = "%1,%2";
+                    tm = tm.arg(kms);
+                    tm = tm.arg(ms);
+
+                    // km and m
+                    name = name.arg(tm);
+                    name = name.arg("km");
+                }
+            }
+        }
+        name += " (%4)";
+        name = name.arg(ride->formatValueWithUnit(round(candidate.avg), series, conversion, context, ride->isSwim()));
+
+        candidate.name = name;
+        name = "";
+        results.append(candidate);
+    }
+}
+
 void
 AddIntervalDialog::findPeakPowerStandard(Context *context, const RideFile *ride, QList<AddedInterval> &results)
 {
     QString prefix = tr("Peak");
 
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 5, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 10, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 20, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 30, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 60, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 120, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 300, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 600, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 1200, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 1800, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 3600, 1, results, prefix, "");
+    // all found in one pass
+    static const double durations[] = { 5, 10, 20, 30, 60, 120, 300, 600, 1200, 1800, 3600, 0 };
+    QVector<double> secs;
+    for (int i=0; durations[i]; i++) secs << durations[i];
+
+    QVector<PeakFinder::Peak> peaks = PeakFinder(ride, Specification(), RideFile::watts).best(secs);
+    for (int i=0; i<peaks.count(); i++) {
+        if (peaks[i].found)
+            namePeaks(context, true, ride, RideFile::watts, RideFile::original, secs[i], 1,
+                      QList<PeakFinder::Peak>() << peaks[i], results, prefix, "");
+    }
 }
 
 void
@@ -847,125 +907,8 @@ AddIntervalDialog::findPeaks(Context *context, bool typeTime, const RideFile *ri
                              RideFile::SeriesType series, RideFile::Conversion conversion, double windowSize,
                               int maxIntervals, QList<AddedInterval> &results, QString prefixe, QString overideName)
 {
-    QList<AddedInterval> bests;
-    QList<AddedInterval> _results;
-
-    double secsDelta = ride->recIntSecs();
-    double total = 0.0;
-    QList<const RideFilePoint*> window;
-
-    // ride is shorter than the window size!
-    if (typeTime && windowSize > ride->dataPoints().last()->secs + secsDelta) return;
-    if (!typeTime && windowSize > ride->dataPoints().last()->km*1000) return;
-
-    // We're looking for intervals with durations in [windowSizeSecs, windowSizeSecs + secsDelta).
-    RideFileIterator it(const_cast<RideFile*>(ride), spec);
-    while (it.hasNext()) {
-        struct RideFilePoint *point = it.next();
-
-        // Discard points until interval duration is < windowSizeSecs + secsDelta.
-        while ((typeTime && !window.empty() && intervalDuration(window.first(), point, ride) >= windowSize + secsDelta) ||
-               (!typeTime && window.length()>1 && intervalDistance(window.at(1), point, ride) >= windowSize)) {
-            total -= window.first()->value(series);
-            window.takeFirst();
-        }
-        // Add points until interval duration or distance is >= windowSize.
-        total += point->value(series);
-        window.append(point);
-        double duration = intervalDuration(window.first(), window.last(), ride);
-        double distance = intervalDistance(window.first(), window.last(), ride);
-
-        if ((typeTime && duration >= windowSize) ||
-            (!typeTime && distance >= windowSize)) {
-            double start = window.first()->secs;
-            double stop = window.last()->secs; //start + duration;
-            double avg = total * secsDelta / duration;
-            bests.append(AddedInterval(start, stop, avg));
-        }
-    }
-
-    std::sort(bests.begin(), bests.end(), CompareBests());
-
-    while (!bests.empty() && (_results.size() < maxIntervals)) {
-        AddedInterval candidate = bests.takeFirst();
-        bool overlaps = false;
-        foreach (const AddedInterval &existing, _results) {
-            if (intervalsOverlap(candidate, existing)) {
-                overlaps = true;
-                break;
-            }
-        }
-        if (!overlaps) {
-            QString name = overideName;
-            if (overideName == "") {
-                name = tr("%1 %3%4 %2");
-
-                if (prefixe == "")
-                    name = name.arg(tr("Peak"));
-                else
-                    name = name.arg(prefixe);
-
-                if (maxIntervals>1)
-                    name = name.arg(QString("#%1").arg(_results.count()+1));
-                else
-                    name = name.arg("");
-
-                if (typeTime)  {
-                    // best n mins
-                    if (windowSize < 60) {
-                        // whole seconds
-                        name = name.arg(windowSize);
-                        name = name.arg("sec");
-                    } else if (windowSize >= 60 && !(((int)windowSize)%60)) {
-                        // whole minutes
-                        name = name.arg(windowSize/60);
-                        name = name.arg("min");
-                    } else {
-                        double secs = windowSize;
-                        double mins = ((int) secs) / 60;
-                        secs = secs - mins * 60.0;
-                        double hrs = ((int) mins) / 60;
-                        mins = mins - hrs * 60.0;
-                        QString tm = "%1:%2:%3";
-                        tm = tm.arg(hrs, 0, 'f', 0);
-                        tm = tm.arg(mins, 2, 'f', 0, QLatin1Char('0'));
-                        tm = tm.arg(secs, 2, 'f', 0, QLatin1Char('0'));
-
-                        // mins and secs
-                        name = name.arg(tm);
-                        name = name.arg("");
-                    }
-                } else {
-                    // best n mins
-                    if (windowSize < 1000) {
-                        // whole seconds
-                        name = name.arg(windowSize);
-                        name = name.arg("m");
-                    } else {
-                        double dist = windowSize;
-                        double kms = ((int) dist) / 1000;
-                        dist = dist - kms * 1000.0;
-                        double ms = dist;
-
-                        QString tm = "%1,%2";
-                        tm = tm.arg(kms);
-                        tm = tm.arg(ms);
-
-                        // km and m
-                        name = name.arg(tm);
-                        name = name.arg("km");
-                    }
-                }
-            }
-            name += " (%4)";
-            name = name.arg(ride->formatValueWithUnit(round(candidate.avg), series, conversion, context, ride->isSwim()));
-
-            candidate.name = name;
-            name = "";
-            _results.append(candidate);
-        }
-    }
-    results.append(_results);
+    QList<PeakFinder::Peak> peaks = PeakFinder(ride, spec, series, typeTime).best(windowSize, maxIntervals);
+    namePeaks(context, typeTime, ride, series, conversion, windowSize, maxIntervals, peaks, results, prefixe, overideName);
 }
 
 void
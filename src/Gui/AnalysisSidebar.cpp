@@ -815,6 +815,7 @@ AnalysisSidebar::editRoute()
                     if (interval->route == activeInterval->route) {
                         //Make stale
                         ride->isstale = true;
+                        ride->staleconfig = 0;
                     }
                 }
             }
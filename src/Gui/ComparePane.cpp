@@ -769,10 +769,8 @@ ComparePane::dropEvent(QDropEvent *event)
                         addp->km = p->km - offsetKM;
                         addp->secs = p->secs - offset;
 
-                        for(int i=0; i< XDATA_MAXVALUES; i++) {
-                            addp->number[i] = p->number[i];
-                            addp->string[i] = p->string[i];
-                        }
+                        addp->number = p->number;
+                        addp->string = p->string;
 
                         x->datapoints.append(addp);
                     }
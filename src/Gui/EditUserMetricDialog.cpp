@@ -305,7 +305,7 @@ EditUserMetricDialog::refreshStats()
     UserMetric test(context, here);
 
     // no spec and no deps, pass empty on stack
-    test.compute(context->rideItem(), Specification(), QHash<QString,RideMetric*>());
+    test.compute(context->rideItem(), Specification(), RideMetricDeps());
 
     // get the value out
     mValue->setText(test.toString(true));
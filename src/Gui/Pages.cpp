@@ -168,6 +168,15 @@ GeneralPage::GeneralPage(Context *context) : context(context)
     warnOnExit->setChecked(appsettings->value(NULL, GC_WARNEXIT, true).toBool());
     configLayout->addWidget(warnOnExit, 6,1, Qt::AlignLeft);
 
+    //
+    // Threads used to compute the CPX caches, 0 is one per core
+    QLabel *threadsLabel = new QLabel(tr("Refresh threads (0 for one per core)"));
+    refreshThreads = new QSpinBox(this);
+    refreshThreads->setRange(0, 64);
+    refreshThreads->setValue(appsettings->value(NULL, GC_REFRESH_THREADS, 0).toInt());
+    configLayout->addWidget(threadsLabel, 7,0, Qt::AlignRight);
+    configLayout->addWidget(refreshThreads, 7,1, Qt::AlignLeft);
+
     //
     // Run API web services when running
     //
@@ -176,12 +185,12 @@ GeneralPage::GeneralPage(Context *context) : context(context)
     offset += 1;
     startHttp = new QCheckBox(tr("Enable API Web Services"), this);
     startHttp->setChecked(appsettings->value(NULL, GC_START_HTTP, false).toBool());
-    configLayout->addWidget(startHttp, 7,1, Qt::AlignLeft);
+    configLayout->addWidget(startHttp, 8,1, Qt::AlignLeft);
 #endif
 #ifdef GC_WANT_R
     embedR = new QCheckBox(tr("Enable R"), this);
     embedR->setChecked(appsettings->value(NULL, GC_EMBED_R, true).toBool());
-    configLayout->addWidget(embedR, 7+offset,1, Qt::AlignLeft);
+    configLayout->addWidget(embedR, 8+offset,1, Qt::AlignLeft);
     offset += 1;
     connect(embedR, SIGNAL(stateChanged(int)), this, SLOT(embedRchanged(int)));
 #endif
@@ -197,9 +206,9 @@ GeneralPage::GeneralPage(Context *context) : context(context)
     athleteBrowseButton = new QPushButton(tr("Browse"));
     //XXathleteBrowseButton->setFixedWidth(120);
 
-    configLayout->addWidget(athleteLabel, 7 + offset,0, Qt::AlignRight);
-    configLayout->addWidget(athleteDirectory, 7 + offset,1);
-    configLayout->addWidget(athleteBrowseButton, 7 + offset,2);
+    configLayout->addWidget(athleteLabel, 8 + offset,0, Qt::AlignRight);
+    configLayout->addWidget(athleteDirectory, 8 + offset,1);
+    configLayout->addWidget(athleteBrowseButton, 8 + offset,2);
 
     connect(athleteBrowseButton, SIGNAL(clicked()), this, SLOT(browseAthleteDir()));
 
@@ -215,9 +224,9 @@ GeneralPage::GeneralPage(Context *context) : context(context)
     workoutBrowseButton = new QPushButton(tr("Browse"));
     //XXworkoutBrowseButton->setFixedWidth(120);
 
-    configLayout->addWidget(workoutLabel, 8 + offset,0, Qt::AlignRight);
-    configLayout->addWidget(workoutDirectory, 8 + offset,1);
-    configLayout->addWidget(workoutBrowseButton, 8 + offset,2);
+    configLayout->addWidget(workoutLabel, 9 + offset,0, Qt::AlignRight);
+    configLayout->addWidget(workoutDirectory, 9 + offset,1);
+    configLayout->addWidget(workoutBrowseButton, 9 + offset,2);
 
     connect(workoutBrowseButton, SIGNAL(clicked()), this, SLOT(browseWorkoutDir()));
     offset++;
@@ -235,9 +244,9 @@ GeneralPage::GeneralPage(Context *context) : context(context)
     rBrowseButton = new QPushButton(tr("Browse"));
     //XXrBrowseButton->setFixedWidth(120);
 
-    configLayout->addWidget(rLabel, 8 + offset,0, Qt::AlignRight);
-    configLayout->addWidget(rDirectory, 8 + offset,1);
-    configLayout->addWidget(rBrowseButton, 8 + offset,2);
+    configLayout->addWidget(rLabel, 9 + offset,0, Qt::AlignRight);
+    configLayout->addWidget(rDirectory, 9 + offset,1);
+    configLayout->addWidget(rBrowseButton, 9 + offset,2);
     offset++;
 
     connect(rBrowseButton, SIGNAL(clicked()), this, SLOT(browseRDir()));
@@ -248,6 +257,7 @@ GeneralPage::GeneralPage(Context *context) : context(context)
     b4.hyst = elevationHysteresis.toFloat();
     b4.wbal = wbalForm->currentIndex();
     b4.warn = warnOnExit->isChecked();
+    b4.threads = refreshThreads->value();
 #ifdef GC_WANT_HTTP
     b4.starthttp = startHttp->isChecked();
 #endif
@@ -279,6 +289,9 @@ GeneralPage::saveClicked()
     // save on exit
     appsettings->setValue(GC_WARNEXIT, warnOnExit->isChecked());
 
+    // refresh threads
+    appsettings->setValue(GC_REFRESH_THREADS, refreshThreads->value());
+
     // Directories
     appsettings->setValue(GC_WORKOUTDIR, workoutDirectory->text());
     appsettings->setValue(GC_HOMEDIR, athleteDirectory->text());
@@ -317,6 +330,10 @@ GeneralPage::saveClicked()
 #endif
         state += CONFIG_GENERAL;
 
+    // the refresh pools are sized from it
+    if (b4.threads != refreshThreads->value())
+        state |= CONFIG_GENERAL;
+
     if (b4.wbal != wbalForm->currentIndex())
         state += CONFIG_WBAL;
 
@@ -5603,6 +5620,11 @@ PaceZonePage::saveClicked()
     qint32 changed = 0;
     // write it
     for (int i=0; i < nSports; i++) {
+
+        // pace shown in the other units, converted values change
+        if (appsettings->value(this, paceZones[i]->paceSetting(), true).toBool() != cvPages[i]->metric->isChecked())
+            changed |= CONFIG_UNITS;
+
         appsettings->setValue(paceZones[i]->paceSetting(), cvPages[i]->metric->isChecked());
         paceZones[i]->setScheme(schemePages[i]->getScheme());
         paceZones[i]->write(context->athlete->home->config());
@@ -5613,7 +5635,7 @@ PaceZonePage::saveClicked()
 
         // did we change ?
         if (paceZones[i]->getFingerprint() != b4Fingerprint[i])
-            changed = CONFIG_ZONES;
+            changed |= CONFIG_ZONES;
     }
     return changed;
 }
@@ -108,6 +108,7 @@ class GeneralPage : public QWidget
 #endif
         QLineEdit *garminHWMarkedit;
         QLineEdit *hystedit;
+        QSpinBox *refreshThreads;
         QLineEdit *athleteDirectory;
         QLineEdit *workoutDirectory;
         QPushButton *workoutBrowseButton;
@@ -129,6 +130,7 @@ class GeneralPage : public QWidget
             float hyst;
             int wbal;
             bool warn;
+            int threads;
 #ifdef GC_WANT_HTTP
             bool starthttp;
 #endif
@@ -205,6 +205,18 @@ ProgressLine::ProgressLine(QWidget *parent, Context *context) : QWidget(parent),
     connect(context, SIGNAL(refreshEnd()), this, SLOT(hide()));
     connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(show())); // we might miss 1st one
     connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(repaint()));
+    connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(refreshUpdate()));
+}
+
+void
+ProgressLine::refreshUpdate()
+{
+    RideCache *cache = context->athlete->rideCache;
+    setToolTip(QString(tr("Refreshing %1%, %2 activities/sec, about %3 secs to go, found in %4 secs"))
+               .arg(cache->progress(), 0, 'f', 0)
+               .arg(cache->throughput(), 0, 'f', 1)
+               .arg(cache->remaining(), 0, 'f', 0)
+               .arg(cache->scanTime(), 0, 'f', 1));
 }
 
 void
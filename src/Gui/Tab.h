@@ -113,6 +113,7 @@ class ProgressLine : public QWidget
 
     public slots:
         void paintEvent (QPaintEvent *event);
+        void refreshUpdate(); // tooltip with how it is going
 
     private:
         Context *context;
@@ -117,7 +117,7 @@ DiaryView::setRide(RideItem*ride)
 void
 DiaryView::dateRangeChanged(DateRange dr)
 {
-    context->dr_ = dr;
+    context->notifyDateRangeChanged(dr);
     page()->setProperty("dateRange", QVariant::fromValue<DateRange>(dr));
 }
 
@@ -161,7 +161,7 @@ HomeView::compareChanged(bool state)
 void
 HomeView::dateRangeChanged(DateRange dr)
 {
-    context->dr_ = dr;
+    context->notifyDateRangeChanged(dr);
     page()->setProperty("dateRange", QVariant::fromValue<DateRange>(dr));
 }
 bool
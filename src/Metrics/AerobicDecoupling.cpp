@@ -39,7 +39,7 @@
 // either half that have a non-zero heart rate.  I then calculate the change
 // in heart rate to power ratio as described by Friel.
 
-class AerobicDecoupling : public RideMetric {
+class AerobicDecoupling : public RideMetricCopyable<AerobicDecoupling> {
     Q_DECLARE_TR_FUNCTIONS(AerobicDecoupling)
 
     double percent;
@@ -50,6 +50,7 @@ class AerobicDecoupling : public RideMetric {
     {
         setSymbol("aerobic_decoupling");
         setInternalName("Aerobic Decoupling");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::hr << RideFile::kph << RideFile::watts);
     }
 
     void initialize() {
@@ -61,7 +62,7 @@ class AerobicDecoupling : public RideMetric {
         setDescription(tr("Aerobic decoupling is a measure of how much heart rate rises or how much power/pace falls off during the course of a long ride/run."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &){
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &){
 
         // how many samples .. to find half way
         RideFileIterator it(item->ride(), spec);
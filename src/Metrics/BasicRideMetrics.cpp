@@ -17,6 +17,7 @@
  */
 
 #include "RideMetric.h"
+#include "RideMetricSweep.h"
 #include "Athlete.h"
 #include "Context.h"
 #include "Settings.h"
@@ -31,7 +32,7 @@
 #include <QVector>
 #include <QApplication>
 
-class RideCount : public RideMetric {
+class RideCount : public RideMetricCopyable<RideCount> {
     Q_DECLARE_TR_FUNCTIONS(RideCount)
     public:
 
@@ -39,6 +40,7 @@ class RideCount : public RideMetric {
     {
         setSymbol("ride_count");
         setInternalName("Activities");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("Activities"));
@@ -47,7 +49,7 @@ class RideCount : public RideMetric {
         setDescription(tr("Activity Count"));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *, Specification, const RideMetricDeps &) {
         setValue(1);
     }
     MetricClass classification() const { return Undefined; }
@@ -61,7 +63,7 @@ static bool countAdded =
 //////////////////////////////////////////////////////////////////////////////
 
 
-class ToExhaustion : public RideMetric {
+class ToExhaustion : public RideMetricCopyable<ToExhaustion> {
     Q_DECLARE_TR_FUNCTIONS(ToExhaustion)
     public:
 
@@ -69,6 +71,7 @@ class ToExhaustion : public RideMetric {
     {
         setSymbol("ride_te");
         setInternalName("To Exhaustion");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("To Exhaustion"));
@@ -77,7 +80,7 @@ class ToExhaustion : public RideMetric {
         setDescription(tr("Count of exhaustion points marked by the user in an activity"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
         int c=0;
         if (item && item->ride()) {
             foreach(RideFilePoint *rp, item->ride()->referencePoints()) {
@@ -94,7 +97,7 @@ class ToExhaustion : public RideMetric {
 static bool teAdded =
     RideMetricFactory::instance().addMetric(ToExhaustion());
 
-class ElapsedTime : public RideMetric {
+class ElapsedTime : public RideMetricCopyable<ElapsedTime> {
     Q_DECLARE_TR_FUNCTIONS(ElapsedTime)
     public:
 
@@ -102,6 +105,7 @@ class ElapsedTime : public RideMetric {
     {
         setSymbol("elapsed_time");
         setInternalName("Elapsed Time");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("Elapsed Time"));
@@ -110,7 +114,7 @@ class ElapsedTime : public RideMetric {
         setDescription(tr("Only useful for intervals, time the interval started"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
         Q_UNUSED(item)
 
         setValue(0);
@@ -125,7 +129,7 @@ static bool etAdded =
     RideMetricFactory::instance().addMetric(ElapsedTime());
 
 //////////////////////////////////////////////////////////////////////////////
-class WorkoutTime : public RideMetric {
+class WorkoutTime : public RideMetricCopyable<WorkoutTime> {
     Q_DECLARE_TR_FUNCTIONS(WorkoutTime)
     double seconds;
 
@@ -135,6 +139,7 @@ class WorkoutTime : public RideMetric {
     {
         setSymbol("workout_time");
         setInternalName("Duration");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     bool isTime() const { return true; }
@@ -146,7 +151,7 @@ class WorkoutTime : public RideMetric {
         setDescription(tr("Total Duration"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -176,7 +181,7 @@ static bool workoutTimeAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class TimeRiding : public RideMetric {
+class TimeRiding : public RideMetricCopyable<TimeRiding> {
     Q_DECLARE_TR_FUNCTIONS(TimeRiding)
     double secsMovingOrPedaling;
 
@@ -186,6 +191,7 @@ class TimeRiding : public RideMetric {
     {
         setSymbol("time_riding");
         setInternalName("Time Moving");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::cad << RideFile::kph);
     }
 
     bool isTime() const { return true; }
@@ -197,7 +203,7 @@ class TimeRiding : public RideMetric {
         setDescription(tr("Time with speed or cadence different from zero"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -232,7 +238,7 @@ static bool timeRidingAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class TimeCarrying : public RideMetric {
+class TimeCarrying : public RideMetricCopyable<TimeCarrying> {
     Q_DECLARE_TR_FUNCTIONS(TimeCarrying)
     double secsCarrying;
     double prevalt;
@@ -243,6 +249,7 @@ class TimeCarrying : public RideMetric {
     {
         setSymbol("time_carrying");
         setInternalName("Time Carrying");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::cad << RideFile::kph << RideFile::watts << RideFile::alt);
     }
 
     bool isTime() const { return true; }
@@ -254,7 +261,7 @@ class TimeCarrying : public RideMetric {
         setDescription(tr("Time with low speed and elevation gain but no power nor cadence"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -313,7 +320,7 @@ static bool timeCarryingAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class ElevationGainCarrying : public RideMetric {
+class ElevationGainCarrying : public RideMetricCopyable<ElevationGainCarrying> {
     Q_DECLARE_TR_FUNCTIONS(ElevationGain)
     double elegain;
     double prevalt;
@@ -324,6 +331,7 @@ class ElevationGainCarrying : public RideMetric {
     {
         setSymbol("elevation_gain_carrying");
         setInternalName("Elevation Gain Carrying");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::cad << RideFile::kph << RideFile::watts << RideFile::alt);
     }
 
     void initialize() {
@@ -335,7 +343,7 @@ class ElevationGainCarrying : public RideMetric {
         setDescription(tr("Elevation gained at low speed with no power nor cadence"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -388,7 +396,7 @@ static bool elevationGainCarryingAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class TotalDistance : public RideMetric {
+class TotalDistance : public RideMetricCopyable<TotalDistance> {
     Q_DECLARE_TR_FUNCTIONS(TotalDistance)
     double km;
 
@@ -398,6 +406,7 @@ class TotalDistance : public RideMetric {
     {
         setSymbol("total_distance");
         setInternalName("Distance");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::kph);
     }
 
     void initialize() {
@@ -410,7 +419,7 @@ class TotalDistance : public RideMetric {
         setDescription(tr("Total Distance in km or miles"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -452,7 +461,7 @@ static bool totalDistanceAdded =
 
 // climb rating is essentially elev gain ^2 / distance
 // a concept raised by Dan Conelly on his blog
-class ClimbRating : public RideMetric {
+class ClimbRating : public RideMetricCopyable<ClimbRating> {
     Q_DECLARE_TR_FUNCTIONS(ClimbRating)
     double secsMoving;
     double km;
@@ -463,6 +472,7 @@ class ClimbRating : public RideMetric {
     {
         setSymbol("climb_rating");
         setInternalName("Climb Rating");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::alt);
     }
 
     void initialize() {
@@ -474,7 +484,7 @@ class ClimbRating : public RideMetric {
         setDescription(tr("According to Dan Conelly: Elevation Gain ^2 / Distance / 1000, 100 is HARD"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         double rating = 0.0f;
         double distance = deps.value("total_distance")->value(true);
@@ -504,7 +514,7 @@ static bool climbRatingAdded =
         ClimbRating(), &(QVector<QString>() << "total_distance" << "elevation_gain"));
 
 
-class AthleteWeight : public RideMetric {
+class AthleteWeight : public RideMetricCopyable<AthleteWeight> {
     Q_DECLARE_TR_FUNCTIONS(AthleteWeight)
     double kg;
 
@@ -514,6 +524,8 @@ class AthleteWeight : public RideMetric {
     {
         setSymbol("athlete_weight");
         setInternalName("Athlete Weight");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(WeightInput);
     }
 
     void initialize() {
@@ -526,7 +538,7 @@ class AthleteWeight : public RideMetric {
         setDescription(tr("Weight in kg or lbs: first from Athlete body measurements, then from Activity metadata and last from Athlete configuration with 75kg default"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         // body measures first
         double weight = item->context->athlete->getBodyMeasure(item->dateTime.date());
@@ -553,7 +565,7 @@ static bool athleteWeightAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AthleteFat : public RideMetric {
+class AthleteFat : public RideMetricCopyable<AthleteFat> {
     Q_DECLARE_TR_FUNCTIONS(AthleteFat)
     double kg;
 
@@ -563,6 +575,8 @@ class AthleteFat : public RideMetric {
     {
         setSymbol("athlete_fat");
         setInternalName("Athlete Bodyfat");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(WeightInput);
     }
 
     void initialize() {
@@ -575,7 +589,7 @@ class AthleteFat : public RideMetric {
         setDescription(tr("Athlete bodyfat in kg or lbs from body measurements"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         BodyMeasure here;
 
@@ -594,7 +608,7 @@ static bool athleteFatAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AthleteBones : public RideMetric {
+class AthleteBones : public RideMetricCopyable<AthleteBones> {
     Q_DECLARE_TR_FUNCTIONS(AthleteBones)
     double kg;
 
@@ -604,6 +618,8 @@ class AthleteBones : public RideMetric {
     {
         setSymbol("athlete_bones");
         setInternalName("Athlete Bones");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(WeightInput);
     }
 
     void initialize() {
@@ -616,7 +632,7 @@ class AthleteBones : public RideMetric {
         setDescription(tr("Athlete bones in kg or lbs from body measurements"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         BodyMeasure here;
 
@@ -635,7 +651,7 @@ static bool athleteBonesAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AthleteMuscles : public RideMetric {
+class AthleteMuscles : public RideMetricCopyable<AthleteMuscles> {
     Q_DECLARE_TR_FUNCTIONS(AthleteMuscles)
     double kg;
 
@@ -645,6 +661,8 @@ class AthleteMuscles : public RideMetric {
     {
         setSymbol("athlete_muscles");
         setInternalName("Athlete Muscles");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(WeightInput);
     }
 
     void initialize() {
@@ -657,7 +675,7 @@ class AthleteMuscles : public RideMetric {
         setDescription(tr("Athlete muscles in kg or lbs from body measurements"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         BodyMeasure here;
 
@@ -676,7 +694,7 @@ static bool athleteMusclesAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AthleteLean : public RideMetric {
+class AthleteLean : public RideMetricCopyable<AthleteLean> {
     Q_DECLARE_TR_FUNCTIONS(AthleteLean)
     double kg;
 
@@ -686,6 +704,8 @@ class AthleteLean : public RideMetric {
     {
         setSymbol("athlete_lean");
         setInternalName("Athlete Lean Weight");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(WeightInput);
     }
 
     void initialize() {
@@ -698,7 +718,7 @@ class AthleteLean : public RideMetric {
         setDescription(tr("Lean Weight in kg or lbs from body measurements"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         BodyMeasure here;
 
@@ -717,7 +737,7 @@ static bool athleteLeanAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AthleteFatP : public RideMetric {
+class AthleteFatP : public RideMetricCopyable<AthleteFatP> {
     Q_DECLARE_TR_FUNCTIONS(AthleteFatP)
     double kg;
 
@@ -727,6 +747,8 @@ class AthleteFatP : public RideMetric {
     {
         setSymbol("athlete_fat_percent");
         setInternalName("Athlete Bodyfat Percent");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(WeightInput);
     }
 
     void initialize() {
@@ -738,7 +760,7 @@ class AthleteFatP : public RideMetric {
         setDescription(tr("Bodyfat in Percent from body measurements"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         BodyMeasure here;
 
@@ -757,7 +779,7 @@ static bool athleteFatPAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class ElevationGain : public RideMetric {
+class ElevationGain : public RideMetricCopyable<ElevationGain> {
     Q_DECLARE_TR_FUNCTIONS(ElevationGain)
     double elegain;
     double prevalt;
@@ -768,6 +790,7 @@ class ElevationGain : public RideMetric {
     {
         setSymbol("elevation_gain");
         setInternalName("Elevation Gain");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::alt);
     }
 
     void initialize() {
@@ -779,7 +802,7 @@ class ElevationGain : public RideMetric {
         setDescription(tr("Elevation Gain in meters of feets"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -824,7 +847,7 @@ static bool elevationGainAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class ElevationLoss : public RideMetric {
+class ElevationLoss : public RideMetricCopyable<ElevationLoss> {
     Q_DECLARE_TR_FUNCTIONS(ElevationLoss)
     double eleLoss;
     double prevalt;
@@ -835,6 +858,7 @@ class ElevationLoss : public RideMetric {
     {
         setSymbol("elevation_loss");
         setInternalName("Elevation Loss");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::alt);
     }
 
     void initialize() {
@@ -847,7 +871,7 @@ class ElevationLoss : public RideMetric {
     }
 
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -891,7 +915,7 @@ static bool elevationLossAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class TotalWork : public RideMetric {
+class TotalWork : public RideMetricCopyable<TotalWork> {
     Q_DECLARE_TR_FUNCTIONS(TotalWork)
     double joules;
 
@@ -901,6 +925,7 @@ class TotalWork : public RideMetric {
     {
         setSymbol("total_work");
         setInternalName("Work");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
     }
 
     void initialize() {
@@ -910,7 +935,7 @@ class TotalWork : public RideMetric {
         setDescription(tr("Total Work in kJ computed from power data"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -942,7 +967,7 @@ static bool totalWorkAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgSpeed : public RideMetric {
+class AvgSpeed : public RideMetricCopyable<AvgSpeed> {
     Q_DECLARE_TR_FUNCTIONS(AvgSpeed)
     double secsMoving;
     double km;
@@ -953,6 +978,7 @@ class AvgSpeed : public RideMetric {
     {
         setSymbol("average_speed");
         setInternalName("Average Speed");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::kph);
     }
 
     void initialize() {
@@ -965,7 +991,7 @@ class AvgSpeed : public RideMetric {
         setDescription(tr("Average Speed in kph or mph, computed from distance over time when speed not zero"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &deps) {
 
         assert(deps.contains("total_distance"));
         km = deps.value("total_distance")->value(true);
@@ -1003,17 +1029,16 @@ static bool avgSpeedAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct AvgPower : public RideMetric {
+struct AvgPower : public RideMetricCopyable<AvgPower, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(AvgPower)
 
-    double count, total;
-
     public:
 
     AvgPower()
     {
         setSymbol("average_power");
         setInternalName("Average Power");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
     }
 
     void initialize() {
@@ -1024,28 +1049,23 @@ struct AvgPower : public RideMetric {
         setDescription(tr("Average Power from all samples with power greater than or equal to zero"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::watts, RideMetricSweep::NonNegative);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (item->ride() == NULL || !item->ride()->areDataPresent()->watts || item->ride()->dataPoints().count() == 0) {
+        RideFile *ride = sweep.ride();
+        if (ride == NULL || !ride->areDataPresent()->watts || ride->dataPoints().count() == 0) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        total = count = 0;
-    
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-
-            if (point->watts >= 0.0) {
-                total += point->watts;
-                ++count;
-            }
-        }
-        setValue(count > 0 ? total / count : 0);
-        setCount(count);
+        const RideMetricSweep::Stats &watts = sweep.stats(RideFile::watts, RideMetricSweep::NonNegative);
+        setValue(watts.mean());
+        setCount(watts.count);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("P") || (!ride->isSwim && !ride->isRun); }
@@ -1059,17 +1079,16 @@ static bool avgPowerAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct AvgSmO2 : public RideMetric {
+struct AvgSmO2 : public RideMetricCopyable<AvgSmO2, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(AvgSmO2)
 
-    double count, total;
-
     public:
 
     AvgSmO2()
     {
         setSymbol("average_smo2");
         setInternalName("Average SmO2");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::smo2);
     }
 
     void initialize() {
@@ -1080,28 +1099,23 @@ struct AvgSmO2 : public RideMetric {
         setDescription(tr("Average Muscle Oxygen Saturation, the percentage of hemoglobin that is carrying oxygen."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::smo2, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (item->ride() == NULL || !item->ride()->areDataPresent()->smo2 || item->ride()->dataPoints().count() == 0) {
+        RideFile *ride = sweep.ride();
+        if (ride == NULL || !ride->areDataPresent()->smo2 || ride->dataPoints().count() == 0) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        total = count = 0;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-
-            if (point->smo2 > 0.0f) {  // SmO2 should always be > 0.0f
-                total += point->smo2;
-                ++count;
-            }
-        }
-        setValue(count > 0 ? total / count : 0);
-        setCount(count);
+        const RideMetricSweep::Stats &smo2 = sweep.stats(RideFile::smo2, RideMetricSweep::Positive);
+        setValue(smo2.mean());
+        setCount(smo2.count);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("O"); }
@@ -1114,17 +1128,16 @@ struct AvgSmO2 : public RideMetric {
 static bool avgSmO2Added =
     RideMetricFactory::instance().addMetric(AvgSmO2());
 
-struct AvgtHb : public RideMetric {
+struct AvgtHb : public RideMetricCopyable<AvgtHb, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(AvgtHb)
 
-    double count, total;
-
     public:
 
     AvgtHb()
     {
         setSymbol("average_tHb");
         setInternalName("Average tHb");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::thb);
     }
 
     void initialize() {
@@ -1136,27 +1149,23 @@ struct AvgtHb : public RideMetric {
         setDescription(tr("Average total hemoglobin concentration. The total grams of hemoglobin per deciliter."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::thb, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (item->ride() == NULL || !item->ride()->areDataPresent()->thb || item->ride()->dataPoints().count() == 0) {
+        RideFile *ride = sweep.ride();
+        if (ride == NULL || !ride->areDataPresent()->thb || ride->dataPoints().count() == 0) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        total = count = 0.0f;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->thb > 0.0f) {
-                total += point->thb;
-                ++count;
-            }
-        }
-        setValue(count > 0.0f ? total / count : 0.0f);
-        setCount(count);
+        const RideMetricSweep::Stats &thb = sweep.stats(RideFile::thb, RideMetricSweep::Positive);
+        setValue(thb.mean());
+        setCount(thb.count);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("O"); }
@@ -1171,17 +1180,16 @@ static bool avgtHbAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct AAvgPower : public RideMetric {
+struct AAvgPower : public RideMetricCopyable<AAvgPower, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(AAvgPower)
 
-    double count, total;
-
     public:
 
     AAvgPower()
     {
         setSymbol("average_apower");
         setInternalName("Average aPower");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::aPower);
     }
 
     void initialize() {
@@ -1192,27 +1200,22 @@ struct AAvgPower : public RideMetric {
         setDescription(tr("Average altitude power. Recorded power adjusted to take into account the effect of altitude on vo2max and thus power output."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::aPower, RideMetricSweep::NonNegative);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        total = count = 0;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->apower >= 0.0) {
-                total += point->apower;
-                ++count;
-            }
-        }
-        setValue(count > 0 ? total / count : 0);
-        setCount(count);
+        const RideMetricSweep::Stats &aPower = sweep.stats(RideFile::aPower, RideMetricSweep::NonNegative);
+        setValue(aPower.mean());
+        setCount(aPower.count);
     }
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("P") || (!ride->isSwim && !ride->isRun); }
     MetricClass classification() const { return Undefined; }
@@ -1225,17 +1228,16 @@ static bool aavgPowerAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct NonZeroPower : public RideMetric {
+struct NonZeroPower : public RideMetricCopyable<NonZeroPower, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(NonZeroPower)
 
-    double count, total;
-
     public:
 
     NonZeroPower()
     {
         setSymbol("nonzero_power");
         setInternalName("Nonzero Average Power");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
     }
 
     void initialize() {
@@ -1246,27 +1248,23 @@ struct NonZeroPower : public RideMetric {
         setDescription(tr("Average Power without zero values, it gives inflated values when frecuent coasting is present"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::watts, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (item->ride() == NULL || !item->ride()->areDataPresent()->watts || item->ride()->dataPoints().count() == 0) {
+        RideFile *ride = sweep.ride();
+        if (ride == NULL || !ride->areDataPresent()->watts || ride->dataPoints().count() == 0) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        total = count = 0;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->watts > 0.0) {
-                total += point->watts;
-                ++count;
-            }
-        }
-        setValue(count > 0 ? total / count : 0);
-        setCount(count);
+        const RideMetricSweep::Stats &watts = sweep.stats(RideFile::watts, RideMetricSweep::Positive);
+        setValue(watts.mean());
+        setCount(watts.count);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("P") || (!ride->isSwim && !ride->isRun); }
@@ -1280,17 +1278,16 @@ static bool nonZeroPowerAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct AvgHeartRate : public RideMetric {
+struct AvgHeartRate : public RideMetricCopyable<AvgHeartRate, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(AvgHeartRate)
 
-    double total, count;
-
     public:
 
     AvgHeartRate()
     {
         setSymbol("average_hr");
         setInternalName("Average Heart Rate");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::hr);
     }
 
     void initialize() {
@@ -1301,26 +1298,23 @@ struct AvgHeartRate : public RideMetric {
         setDescription(tr("Average Heart Rate computed for samples when hr is greater than zero"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::hr, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (item->ride() == NULL || !item->ride()->areDataPresent()->hr || item->ride()->dataPoints().count() == 0) {
+        RideFile *ride = sweep.ride();
+        if (ride == NULL || !ride->areDataPresent()->hr || ride->dataPoints().count() == 0) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        total = count = 0;
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->hr > 0) {
-                total += point->hr;
-                ++count;
-            }
-        }
-        setValue(count > 0 ? total / count : 0);
-        setCount(count);
+        const RideMetricSweep::Stats &hr = sweep.stats(RideFile::hr, RideMetricSweep::Positive);
+        setValue(hr.mean());
+        setCount(hr.count);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("H"); }
@@ -1333,11 +1327,9 @@ struct AvgHeartRate : public RideMetric {
 static bool avgHeartRateAdded =
     RideMetricFactory::instance().addMetric(AvgHeartRate());
 
-struct AvgCoreTemp : public RideMetric {
+struct AvgCoreTemp : public RideMetricCopyable<AvgCoreTemp, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(AvgCoreTemp)
 
-    double total, count;
-
     public:
 
     AvgCoreTemp()
@@ -1345,6 +1337,7 @@ struct AvgCoreTemp : public RideMetric {
         setSymbol("average_ct");
         setInternalName("Average Core Temperature");
         setPrecision(1);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::tcore);
     }
 
     void initialize() {
@@ -1355,28 +1348,22 @@ struct AvgCoreTemp : public RideMetric {
         setDescription(tr("Average Core Temperature. The core body temperature estimate is based on HR data"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::tcore, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        total = count = 0;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-
-            if (point->tcore > 0) {
-                total += point->tcore;
-                ++count;
-            }
-        }
-        setValue(count > 0 ? total / count : 0);
-        setCount(count);
+        const RideMetricSweep::Stats &tcore = sweep.stats(RideFile::tcore, RideMetricSweep::Positive);
+        setValue(tcore.mean());
+        setCount(tcore.count);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("H"); }
@@ -1391,17 +1378,16 @@ static bool avgCTAdded =
 
 ///////////////////////////////////////////////////////////////////////////////
 
-struct HeartBeats : public RideMetric {
+struct HeartBeats : public RideMetricCopyable<HeartBeats, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(HeartBeats)
 
-    double total;
-
     public:
 
     HeartBeats()
     {
         setSymbol("heartbeats");
         setInternalName("Heartbeats");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::hr);
     }
     void initialize() {
         setName(tr("Heartbeats"));
@@ -1411,23 +1397,20 @@ struct HeartBeats : public RideMetric {
         setDescription(tr("Total Heartbeats"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::hr);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        total = 0;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            total += (point->hr / 60) * item->ride()->recIntSecs();
-        }
-        setValue(total);
+        setValue(sweep.stats(RideFile::hr).total / 60 * sweep.ride()->recIntSecs());
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("H"); }
@@ -1442,7 +1425,7 @@ static bool hbAdded =
 
 ////////////////////////////////////////////////////////////////////////////////
 
-class HrPw : public RideMetric {
+class HrPw : public RideMetricCopyable<HrPw> {
     Q_DECLARE_TR_FUNCTIONS(HrPw)
 
     public:
@@ -1450,6 +1433,7 @@ class HrPw : public RideMetric {
     {
         setSymbol("hrpw");
         setInternalName("HrPw Ratio");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -1461,7 +1445,7 @@ class HrPw : public RideMetric {
         setDescription(tr("Power to Heart Rate Ratio in watts/bpm"));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         AvgHeartRate *hr = dynamic_cast<AvgHeartRate*>(deps.value("average_hr"));
         AvgPower *pw = dynamic_cast<AvgPower*>(deps.value("average_power"));
@@ -1491,7 +1475,7 @@ static bool hrpwAdded = addHrPw();
 
 ////////////////////////////////////////////////////////////////////////////////
 
-class Workbeat : public RideMetric {
+class Workbeat : public RideMetricCopyable<Workbeat> {
     Q_DECLARE_TR_FUNCTIONS(Workbeats)
 
     public:
@@ -1499,6 +1483,7 @@ class Workbeat : public RideMetric {
     {
         setSymbol("wb");
         setInternalName("Workbeat stress");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -1510,7 +1495,7 @@ class Workbeat : public RideMetric {
         setDescription(tr("Work * Heartbeats / 100000"));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         TotalWork *work = dynamic_cast<TotalWork*>(deps.value("total_work"));
         HeartBeats *hb = dynamic_cast<HeartBeats*>(deps.value("heartbeats"));
@@ -1538,7 +1523,7 @@ static bool workbeatAdded = addWorkbeat();
 
 //////////////////////////////////////////////////////////////////////
 
-class WattsRPE : public RideMetric {
+class WattsRPE : public RideMetricCopyable<WattsRPE> {
     Q_DECLARE_TR_FUNCTIONS(WattsRPE)
 
     public:
@@ -1546,6 +1531,7 @@ class WattsRPE : public RideMetric {
     {
         setSymbol("wattsRPE");
         setInternalName("Watts:RPE Ratio");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -1557,7 +1543,7 @@ class WattsRPE : public RideMetric {
         setDescription(tr("Watts to RPE ratio"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         double ratio = 0.0f;
         AvgPower *pw = dynamic_cast<AvgPower*>(deps.value("average_power"));
@@ -1586,7 +1572,7 @@ static bool wattsRPEAdded = addWattsRPE();
 
 ///////////////////////////////////////////////////////////////////////////////
 
-class APPercent : public RideMetric {
+class APPercent : public RideMetricCopyable<APPercent> {
     Q_DECLARE_TR_FUNCTIONS(APPercent)
 
     public:
@@ -1594,6 +1580,8 @@ class APPercent : public RideMetric {
     {
         setSymbol("ap_percent_max");
         setInternalName("Power Percent of Max");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PowerZonesInput);
     }
 
     void initialize() {
@@ -1605,7 +1593,7 @@ class APPercent : public RideMetric {
         setDescription(tr("Power as percent of Pmax according to Power Zones"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         double percent = 0.0f;
         AvgPower *pw = dynamic_cast<AvgPower*>(deps.value("average_power"));
@@ -1638,7 +1626,7 @@ static bool APPercentAdded = addAPPercent();
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-class HrNp : public RideMetric {
+class HrNp : public RideMetricCopyable<HrNp> {
     Q_DECLARE_TR_FUNCTIONS(HrNp)
 
     public:
@@ -1646,6 +1634,7 @@ class HrNp : public RideMetric {
     {
         setSymbol("hrnp");
         setInternalName("HrNp Ratio");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -1657,7 +1646,7 @@ class HrNp : public RideMetric {
         setDescription(tr("Normalized Power to Average Heart Rate ratio in watts/bpm"));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         AvgHeartRate *hr = dynamic_cast<AvgHeartRate*>(deps.value("average_hr"));
         RideMetric *pw = dynamic_cast<RideMetric*>(deps.value("coggan_np"));
@@ -1688,17 +1677,16 @@ static bool hrnpAdded = addHrNp();
 
 ///////////////////////////////////////////////////////////////////////////////
 
-struct AvgCadence : public RideMetric {
+struct AvgCadence : public RideMetricCopyable<AvgCadence, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(AvgCadence)
 
-    double total, count;
-
     public:
 
     AvgCadence()
     {
         setSymbol("average_cad");
         setInternalName("Average Cadence");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::cad);
     }
 
     void initialize() {
@@ -1709,27 +1697,22 @@ struct AvgCadence : public RideMetric {
         setDescription(tr("Average Cadence, computed when Cadence > 0"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::cad, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        total = count = 0;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->cad > 0) {
-                total += point->cad;
-                ++count;
-            }
-        }
-        setValue(count > 0 ? total / count : count);
-        setCount(count);
+        const RideMetricSweep::Stats &cad = sweep.stats(RideFile::cad, RideMetricSweep::Positive);
+        setValue(cad.mean());
+        setCount(cad.count);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("C") && !ride->isRun; }
@@ -1744,7 +1727,7 @@ static bool avgCadenceAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct AvgTemp : public RideMetric {
+struct AvgTemp : public RideMetricCopyable<AvgTemp> {
     Q_DECLARE_TR_FUNCTIONS(AvgTemp)
 
     double total, count;
@@ -1755,6 +1738,7 @@ struct AvgTemp : public RideMetric {
     {
         setSymbol("average_temp");
         setInternalName("Average Temp");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::temp);
     }
 
     // we DO aggregate zero, its -255 we ignore !
@@ -1778,7 +1762,7 @@ struct AvgTemp : public RideMetric {
     }
 
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (item->ride() == NULL || !item->ride()->areDataPresent()->temp || item->ride()->dataPoints().count() == 0) {
@@ -1812,14 +1796,14 @@ static bool avgTempAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MaxPower : public RideMetric {
+class MaxPower : public RideMetricCopyable<MaxPower, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(MaxPower)
-    double max;
     public:
-    MaxPower() : max(0.0)
+    MaxPower()
     {
         setSymbol("max_power");
         setInternalName("Max Power");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
     }
 
     void initialize() {
@@ -1830,22 +1814,21 @@ class MaxPower : public RideMetric {
         setDescription(tr("Maximum Power"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::watts, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->watts >= max)
-                max = point->watts;
-        }
-        setValue(max);
+        const RideMetricSweep::Stats &watts = sweep.stats(RideFile::watts, RideMetricSweep::Positive);
+        setValue(watts.max);
     }
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("P") || (!ride->isSwim && !ride->isRun); }
     MetricClass classification() const { return Undefined; }
@@ -1858,14 +1841,14 @@ static bool maxPowerAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MaxSmO2 : public RideMetric {
+class MaxSmO2 : public RideMetricCopyable<MaxSmO2, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(MaxSmO2)
-    double max;
     public:
-    MaxSmO2() : max(0.0)
+    MaxSmO2()
     {
         setSymbol("max_smo2");
         setInternalName("Max SmO2");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::smo2);
     }
 
     void initialize() {
@@ -1876,22 +1859,21 @@ class MaxSmO2 : public RideMetric {
         setDescription(tr("Maximum Muscle Oxygen Saturation, the percentage of hemoglobin that is carrying oxygen."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::smo2, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->smo2 >= max)
-                max = point->smo2;
-        }
-        setValue(max);
+        const RideMetricSweep::Stats &smo2 = sweep.stats(RideFile::smo2, RideMetricSweep::Positive);
+        setValue(smo2.max);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("O"); }
@@ -1904,14 +1886,14 @@ class MaxSmO2 : public RideMetric {
 static bool maxSmO2Added =
     RideMetricFactory::instance().addMetric(MaxSmO2());
 
-class MaxtHb : public RideMetric {
+class MaxtHb : public RideMetricCopyable<MaxtHb, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(MaxtHb)
-    double max;
     public:
-    MaxtHb() : max(0.0)
+    MaxtHb()
     {
         setSymbol("max_tHb");
         setInternalName("Max tHb");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::thb);
     }
 
     void initialize() {
@@ -1923,23 +1905,21 @@ class MaxtHb : public RideMetric {
         setDescription(tr("Maximum total hemoglobin concentration. The total grams of hemoglobin per deciliter."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::thb, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-
-            if (point->thb >= max)
-                max = point->thb;
-        }
-        setValue(max);
+        const RideMetricSweep::Stats &thb = sweep.stats(RideFile::thb, RideMetricSweep::Positive);
+        setValue(thb.max);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("O"); }
@@ -1954,7 +1934,7 @@ static bool maxtHbAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MinSmO2 : public RideMetric {
+class MinSmO2 : public RideMetricCopyable<MinSmO2> {
     Q_DECLARE_TR_FUNCTIONS(MinSmO2)
     double min;
     public:
@@ -1962,6 +1942,7 @@ class MinSmO2 : public RideMetric {
     {
         setSymbol("min_smo2");
         setInternalName("Min SmO2");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::smo2);
     }
     void initialize() {
         setName(tr("Min SmO2"));
@@ -1971,7 +1952,7 @@ class MinSmO2 : public RideMetric {
         setDescription(tr("Minimum Muscle Oxygen Saturation, the percentage of hemoglobin that is carrying oxygen."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -2003,7 +1984,7 @@ class MinSmO2 : public RideMetric {
 static bool minSmO2Added =
     RideMetricFactory::instance().addMetric(MinSmO2());
 
-class MintHb : public RideMetric {
+class MintHb : public RideMetricCopyable<MintHb> {
     Q_DECLARE_TR_FUNCTIONS(MintHb)
     double min;
     public:
@@ -2011,6 +1992,7 @@ class MintHb : public RideMetric {
     {
         setSymbol("min_tHb");
         setInternalName("Min tHb");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::thb);
     }
 
     void initialize() {
@@ -2022,7 +2004,7 @@ class MintHb : public RideMetric {
         setDescription(tr("Minimum total hemoglobin concentration. The total grams of hemoglobin per deciliter."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -2053,14 +2035,14 @@ static bool mintHb =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MaxHr : public RideMetric {
+class MaxHr : public RideMetricCopyable<MaxHr, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(MaxHr)
-    double max;
     public:
-    MaxHr() : max(0.0)
+    MaxHr()
     {
         setSymbol("max_heartrate");
         setInternalName("Max Heartrate");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::hr);
     }
 
     void initialize() {
@@ -2071,22 +2053,21 @@ class MaxHr : public RideMetric {
         setDescription(tr("Maximum Heart Rate."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::hr, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->hr >= max)
-                max = point->hr;
-        }
-        setValue(max);
+        const RideMetricSweep::Stats &hr = sweep.stats(RideFile::hr, RideMetricSweep::Positive);
+        setValue(hr.max);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("H"); }
@@ -2101,14 +2082,14 @@ static bool maxHrAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MinHr : public RideMetric {
+class MinHr : public RideMetricCopyable<MinHr, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(MinHr)
-    double min;
     public:
-    MinHr() : min(0.0)
+    MinHr()
     {
         setSymbol("min_heartrate");
         setInternalName("Min Heartrate");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::hr);
     }
 
     void initialize() {
@@ -2119,28 +2100,21 @@ class MinHr : public RideMetric {
         setDescription(tr("Minimum Heart Rate."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::hr, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        bool notset = true;
-        min = 0;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-
-            if (point->hr > 0 && (notset || point->hr < min)) {
-                min = point->hr;
-                notset = false;
-            }
-        }
-        setValue(min);
+        const RideMetricSweep::Stats &hr = sweep.stats(RideFile::hr, RideMetricSweep::Positive);
+        setValue(hr.min);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("H"); }
@@ -2155,15 +2129,15 @@ static bool minHrAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MaxCT : public RideMetric {
+class MaxCT : public RideMetricCopyable<MaxCT, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(MaxCT)
-    double max;
     public:
-    MaxCT() : max(0.0)
+    MaxCT()
     {
         setSymbol("max_ct");
         setInternalName("Max Core Temperature");
         setPrecision(1);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::tcore);
     }
 
     void initialize() {
@@ -2174,23 +2148,21 @@ class MaxCT : public RideMetric {
         setDescription(tr("Maximum Core Temperature. The core body temperature estimate is based on HR data"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::tcore, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-
-            if (point->tcore >= max)
-                max = point->tcore;
-        }
-        setValue(max);
+        const RideMetricSweep::Stats &tcore = sweep.stats(RideFile::tcore, RideMetricSweep::Positive);
+        setValue(tcore.max);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("H"); }
@@ -2205,7 +2177,7 @@ static bool maxCTAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MaxSpeed : public RideMetric {
+class MaxSpeed : public RideMetricCopyable<MaxSpeed, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(MaxSpeed)
     public:
 
@@ -2213,6 +2185,7 @@ class MaxSpeed : public RideMetric {
     {
         setSymbol("max_speed");
         setInternalName("Max Speed");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::kph);
     }
 
     void initialize() {
@@ -2226,25 +2199,23 @@ class MaxSpeed : public RideMetric {
     }
 
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::kph, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
         double max = 0.0;
+        if (sweep.ride()->areDataPresent()->kph)
+            max = sweep.stats(RideFile::kph, RideMetricSweep::Positive).max;
 
-        if (item->ride()->areDataPresent()->kph) {
-
-            RideFileIterator it(item->ride(), spec);
-            while (it.hasNext()) {
-                struct RideFilePoint *point = it.next();
-                    if (point->kph > max) max = point->kph;
-            }
-        }
         setValue(max);
     }
 
@@ -2258,7 +2229,7 @@ static bool maxSpeedAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MaxCadence : public RideMetric {
+class MaxCadence : public RideMetricCopyable<MaxCadence, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(MaxCadence)
     public:
 
@@ -2266,6 +2237,7 @@ class MaxCadence : public RideMetric {
     {
         setSymbol("max_cadence");
         setInternalName("Max Cadence");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::cad);
     }
 
     void initialize() {
@@ -2276,24 +2248,21 @@ class MaxCadence : public RideMetric {
         setDescription(tr("Maximum Cadence"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::cad, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        double max = 0.0;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->cad > max) max = point->cad;
-        }
-
-        setValue(max);
+        const RideMetricSweep::Stats &cad = sweep.stats(RideFile::cad, RideMetricSweep::Positive);
+        setValue(cad.max);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("C") && !ride->isRun; }
@@ -2308,7 +2277,7 @@ static bool maxCadenceAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MaxTemp : public RideMetric {
+class MaxTemp : public RideMetricCopyable<MaxTemp> {
     Q_DECLARE_TR_FUNCTIONS(MaxTemp)
     public:
 
@@ -2316,6 +2285,7 @@ class MaxTemp : public RideMetric {
     {
         setSymbol("max_temp");
         setInternalName("Max Temp");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::temp);
     }
 
     void initialize() {
@@ -2335,7 +2305,7 @@ class MaxTemp : public RideMetric {
         return RideMetric::toString(useMetricUnits);
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->temp) {
@@ -2364,7 +2334,7 @@ static bool maxTempAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MinTemp : public RideMetric {
+class MinTemp : public RideMetricCopyable<MinTemp> {
     Q_DECLARE_TR_FUNCTIONS(MinTemp)
     public:
 
@@ -2372,6 +2342,7 @@ class MinTemp : public RideMetric {
     {
         setSymbol("min_temp");
         setInternalName("Min Temp");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::temp);
     }
 
     void initialize() {
@@ -2391,7 +2362,7 @@ class MinTemp : public RideMetric {
         return RideMetric::toString(useMetricUnits);
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->temp) {
@@ -2420,7 +2391,7 @@ static bool minTempAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class NinetyFivePercentHeartRate : public RideMetric {
+class NinetyFivePercentHeartRate : public RideMetricCopyable<NinetyFivePercentHeartRate> {
     Q_DECLARE_TR_FUNCTIONS(NinetyFivePercentHeartRate)
     double hr;
     public:
@@ -2428,6 +2399,7 @@ class NinetyFivePercentHeartRate : public RideMetric {
     {
         setSymbol("ninety_five_percent_hr");
         setInternalName("95% Heartrate");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::hr);
     }
 
     void initialize() {
@@ -2438,7 +2410,7 @@ class NinetyFivePercentHeartRate : public RideMetric {
         setDescription(tr("Heart Rate for which 95% of activity samples has lower HR values"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -2471,7 +2443,7 @@ static bool ninetyFivePercentHeartRateAdded =
 
 ///////////////////////////////////////////////////////////////////////////////
 
-class VAM : public RideMetric {
+class VAM : public RideMetricCopyable<VAM> {
     Q_DECLARE_TR_FUNCTIONS(VAM)
 
     public:
@@ -2479,6 +2451,7 @@ class VAM : public RideMetric {
     {
         setSymbol("vam");
         setInternalName("VAM");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -2489,7 +2462,7 @@ class VAM : public RideMetric {
         setDescription(tr("Velocita Ascensionale Media, average ascent speed in vertical meters per hour"));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         ElevationGain *el = dynamic_cast<ElevationGain*>(deps.value("elevation_gain"));
         WorkoutTime *wt = dynamic_cast<WorkoutTime*>(deps.value("workout_time"));
@@ -2514,7 +2487,7 @@ static bool vamAdded = addVam();
 
 ///////////////////////////////////////////////////////////////////////////////
 
-class EOA : public RideMetric {
+class EOA : public RideMetricCopyable<EOA> {
     Q_DECLARE_TR_FUNCTIONS(EOA)
 
     public:
@@ -2522,6 +2495,7 @@ class EOA : public RideMetric {
     {
         setSymbol("eoa");
         setInternalName("EOA");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -2532,7 +2506,7 @@ class EOA : public RideMetric {
         setDescription(tr("Relationship between altitude adjusted power and recorded power"));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         AAvgPower *aap = dynamic_cast<AAvgPower*>(deps.value("average_apower"));
         AvgPower *ap = dynamic_cast<AvgPower*>(deps.value("average_power"));
@@ -2559,7 +2533,7 @@ static bool eoaAdded = addEOA();
 
 ///////////////////////////////////////////////////////////////////////////////
 
-class Gradient : public RideMetric {
+class Gradient : public RideMetricCopyable<Gradient> {
     Q_DECLARE_TR_FUNCTIONS(Gradient)
 
     public:
@@ -2567,6 +2541,7 @@ class Gradient : public RideMetric {
     {
         setSymbol("gradient");
         setInternalName("Gradient");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -2578,7 +2553,7 @@ class Gradient : public RideMetric {
         setDescription(tr("Elevation Gain to Total Distance percent ratio"));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         ElevationGain *el = dynamic_cast<ElevationGain*>(deps.value("elevation_gain"));
         TotalDistance *td = dynamic_cast<TotalDistance*>(deps.value("total_distance"));
@@ -2607,7 +2582,7 @@ static bool gradientAdded = addGradient();
 
 ///////////////////////////////////////////////////////////////////////////////
 
-class MeanPowerVariance : public RideMetric {
+class MeanPowerVariance : public RideMetricCopyable<MeanPowerVariance> {
     Q_DECLARE_TR_FUNCTIONS(MeanPowerVariance)
 
     public:
@@ -2617,6 +2592,7 @@ class MeanPowerVariance : public RideMetric {
     {
         setSymbol("meanpowervariance");
         setInternalName("Average Power Variance");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
     }
 
     void initialize() {
@@ -2628,7 +2604,7 @@ class MeanPowerVariance : public RideMetric {
         setDescription(tr("Mean Power Deviation with respect to 30sec Moving Average"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -2679,7 +2655,7 @@ static bool meanPowerVarianceAdded = addMeanPowerVariance();
 
 ///////////////////////////////////////////////////////////////////////////////
 
-class MaxPowerVariance : public RideMetric {
+class MaxPowerVariance : public RideMetricCopyable<MaxPowerVariance> {
     Q_DECLARE_TR_FUNCTIONS(MaxPowerVariance)
 
     public:
@@ -2687,6 +2663,7 @@ class MaxPowerVariance : public RideMetric {
     {
         setSymbol("maxpowervariance");
         setInternalName("Max Power Variance");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -2698,7 +2675,7 @@ class MaxPowerVariance : public RideMetric {
         setDescription(tr("Maximum Power Deviation with respect to 30sec Moving Average"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &deps) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -2739,7 +2716,7 @@ static bool maxPowerVarianceAdded = addMaxPowerVariance();
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgLTE : public RideMetric {
+class AvgLTE : public RideMetricCopyable<AvgLTE, SweptRideMetric> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgLTE)
 
@@ -2749,6 +2726,7 @@ class AvgLTE : public RideMetric {
     {
         setSymbol("average_lte");
         setInternalName("Average Left Torque Effectiveness");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::lte);
     }
 
     void initialize() {
@@ -2760,29 +2738,22 @@ class AvgLTE : public RideMetric {
         setDescription(tr("It measures how much of the power delivered to the left pedal is pushing it forward, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::lte, RideMetricSweep::NonZero);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->lte) {
+        if (sweep.isEmpty() || !sweep.ride()->areDataPresent()->lte) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        double total = 0.0f;
-        double samples = 0.0f;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-
-            if (point->lte) {
-                samples ++;
-                total += point->lte;
-            }
-        }
+        const RideMetricSweep::Stats &lte = sweep.stats(RideFile::lte, RideMetricSweep::NonZero);
 
-        if (total > 0.0f && samples > 0.0f) setValue(total / samples);
+        if (lte.total > 0.0f && lte.count > 0.0f) setValue(lte.mean());
         else setValue(0.0);
 
     }
@@ -2794,7 +2765,7 @@ class AvgLTE : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgRTE : public RideMetric {
+class AvgRTE : public RideMetricCopyable<AvgRTE, SweptRideMetric> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgRTE)
 
@@ -2804,6 +2775,7 @@ class AvgRTE : public RideMetric {
     {
         setSymbol("average_rte");
         setInternalName("Average Right Torque Effectiveness");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::rte);
     }
 
     void initialize() {
@@ -2815,28 +2787,22 @@ class AvgRTE : public RideMetric {
         setDescription(tr("It measures how much of the power delivered to the right pedal is pushing it forward, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::rte, RideMetricSweep::NonZero);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->rte) {
+        if (sweep.isEmpty() || !sweep.ride()->areDataPresent()->rte) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        double total = 0.0f;
-        double samples = 0.0f;
+        const RideMetricSweep::Stats &rte = sweep.stats(RideFile::rte, RideMetricSweep::NonZero);
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->rte) {
-                samples ++;
-                total += point->rte;
-            }
-        }
-
-        if (total > 0.0f && samples > 0.0f) setValue(total / samples);
+        if (rte.total > 0.0f && rte.count > 0.0f) setValue(rte.mean());
         else setValue(0.0);
 
     }
@@ -2848,7 +2814,7 @@ class AvgRTE : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgLPS : public RideMetric {
+class AvgLPS : public RideMetricCopyable<AvgLPS, SweptRideMetric> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgLPS)
 
@@ -2858,6 +2824,7 @@ class AvgLPS : public RideMetric {
     {
         setSymbol("average_lps");
         setInternalName("Average Left Pedal Smoothness");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::lps);
     }
 
     void initialize() {
@@ -2869,29 +2836,24 @@ class AvgLPS : public RideMetric {
         setDescription(tr("It measures how smoothly power is delivered to the left pedal throughout the revolution, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::lps, RideMetricSweep::NonZero);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->lps) {
+        if (sweep.isEmpty() || !sweep.ride()->areDataPresent()->lps) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        double total = 0.0f;
-        double samples = 0.0f;
+        const RideMetricSweep::Stats &lps = sweep.stats(RideFile::lps, RideMetricSweep::NonZero);
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->lps) {
-                samples ++;
-                total += point->lps;
-            }
-        }
-
-        if (total > 0.0f && samples > 0.0f) setValue(total / samples);
+        if (lps.total > 0.0f && lps.count > 0.0f) setValue(lps.mean());
         else setValue(0.0);
+
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return !ride->isSwim && !ride->isRun; }
@@ -2902,7 +2864,7 @@ class AvgLPS : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgRPS : public RideMetric {
+class AvgRPS : public RideMetricCopyable<AvgRPS, SweptRideMetric> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgRPS)
 
@@ -2912,6 +2874,7 @@ class AvgRPS : public RideMetric {
     {
         setSymbol("average_rps");
         setInternalName("Average Right Pedal Smoothness");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::rps);
     }
 
     void initialize() {
@@ -2923,29 +2886,24 @@ class AvgRPS : public RideMetric {
         setDescription(tr("It measures how smoothly power is delivered to the right pedal throughout the revolution, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::rps, RideMetricSweep::NonZero);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->rps) {
+        if (sweep.isEmpty() || !sweep.ride()->areDataPresent()->rps) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        double total = 0.0f;
-        double samples = 0.0f;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->rps) {
-                samples ++;
-                total += point->rps;
-            }
-        }
+        const RideMetricSweep::Stats &rps = sweep.stats(RideFile::rps, RideMetricSweep::NonZero);
 
-        if (total > 0.0f && samples > 0.0f) setValue(total / samples);
+        if (rps.total > 0.0f && rps.count > 0.0f) setValue(rps.mean());
         else setValue(0.0);
+
     }
     bool isRelevantForRide(const RideItem *ride) const { return !ride->isSwim && !ride->isRun; }
     MetricClass classification() const { return Undefined; }
@@ -2955,7 +2913,7 @@ class AvgRPS : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgLPCO : public RideMetric {
+class AvgLPCO : public RideMetricCopyable<AvgLPCO, SweptRideMetric> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgLPCO)
 
@@ -2965,6 +2923,7 @@ class AvgLPCO : public RideMetric {
     {
         setSymbol("average_lpco");
         setInternalName("Average Left Pedal Center Offset");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::cad << RideFile::lpco);
     }
 
     void initialize() {
@@ -2977,28 +2936,24 @@ class AvgLPCO : public RideMetric {
         setDescription(tr("Platform center offset is the location on the left pedal platform where you apply force, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::lpco, RideMetricSweep::All, RideFile::cad);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->lpco) {
+        if (sweep.isEmpty() || !sweep.ride()->areDataPresent()->lpco) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        double total = 0.0f;
-        double secs = 0.0f;
+        // whilst pedalling
+        const RideMetricSweep::Stats &lpco = sweep.stats(RideFile::lpco, RideMetricSweep::All, RideFile::cad);
+        double secs = lpco.count * sweep.ride()->recIntSecs();
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->cad) {
-                secs += item->ride()->recIntSecs();
-                total += point->lpco;
-            }
-        }
-
-        if (secs > 0.0f) setValue(total / secs);
+        if (secs > 0.0f) setValue(lpco.total / secs);
         else setValue(0.0);
     }
 
@@ -3010,7 +2965,7 @@ class AvgLPCO : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgRPCO : public RideMetric {
+class AvgRPCO : public RideMetricCopyable<AvgRPCO, SweptRideMetric> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgRPCO)
 
@@ -3020,6 +2975,7 @@ class AvgRPCO : public RideMetric {
     {
         setSymbol("average_rpco");
         setInternalName("Average Right Pedal Center Offset");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::cad << RideFile::rpco);
     }
 
     void initialize() {
@@ -3032,28 +2988,24 @@ class AvgRPCO : public RideMetric {
         setDescription(tr("Platform center offset is the location on the right pedal platform where you apply force, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::rpco, RideMetricSweep::All, RideFile::cad);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->rpco) {
+        if (sweep.isEmpty() || !sweep.ride()->areDataPresent()->rpco) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        double total = 0.0f;
-        double secs = 0.0f;
+        // whilst pedalling
+        const RideMetricSweep::Stats &rpco = sweep.stats(RideFile::rpco, RideMetricSweep::All, RideFile::cad);
+        double secs = rpco.count * sweep.ride()->recIntSecs();
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->cad) {
-                secs += item->ride()->recIntSecs();
-                total += point->rpco;
-            }
-        }
-
-        if (secs > 0.0f) setValue(total / secs);
+        if (secs > 0.0f) setValue(rpco.total / secs);
         else setValue(0.0);
     }
     bool isRelevantForRide(const RideItem *ride) const { return !ride->isSwim && !ride->isRun; }
@@ -3064,7 +3016,7 @@ class AvgRPCO : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgLPPB : public RideMetric {
+class AvgLPPB : public RideMetricCopyable<AvgLPPB> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgLPPB)
 
@@ -3074,6 +3026,7 @@ class AvgLPPB : public RideMetric {
     {
         setSymbol("average_lppb");
         setInternalName("Average Left Power Phase Start");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::lppb << RideFile::lppe);
     }
 
     void initialize() {
@@ -3084,7 +3037,7 @@ class AvgLPPB : public RideMetric {
         setDescription(tr("It is the left pedal stroke angle where you start producing positive power, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->lppb) {
@@ -3116,7 +3069,7 @@ class AvgLPPB : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgRPPB : public RideMetric {
+class AvgRPPB : public RideMetricCopyable<AvgRPPB> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgRTPP)
 
@@ -3126,6 +3079,7 @@ class AvgRPPB : public RideMetric {
     {
         setSymbol("average_rppb");
         setInternalName("Average Right Power Phase Start");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::rppb << RideFile::rppe);
     }
 
     void initialize() {
@@ -3136,7 +3090,7 @@ class AvgRPPB : public RideMetric {
         setDescription(tr("It is the right pedal stroke angle where you start producing positive power, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->rppb) {
@@ -3170,7 +3124,7 @@ class AvgRPPB : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgLPPE : public RideMetric {
+class AvgLPPE : public RideMetricCopyable<AvgLPPE> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgLPPE)
 
@@ -3180,6 +3134,7 @@ class AvgLPPE : public RideMetric {
     {
         setSymbol("average_lppe");
         setInternalName("Average Left Power Phase End");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::lppe);
     }
 
     void initialize() {
@@ -3190,7 +3145,7 @@ class AvgLPPE : public RideMetric {
         setDescription(tr("It is the left pedal stroke angle where you end producing positive power, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->lppe) {
@@ -3222,7 +3177,7 @@ class AvgLPPE : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgRPPE : public RideMetric {
+class AvgRPPE : public RideMetricCopyable<AvgRPPE> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgRPPE)
 
@@ -3232,6 +3187,7 @@ class AvgRPPE : public RideMetric {
     {
         setSymbol("average_rppe");
         setInternalName("Average Right Power Phase End");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::rppe);
     }
 
     void initialize() {
@@ -3242,7 +3198,7 @@ class AvgRPPE : public RideMetric {
         setDescription(tr("It is the right pedal stroke angle where you end producing positive power, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->rppe) {
@@ -3276,7 +3232,7 @@ class AvgRPPE : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgLPPPB : public RideMetric {
+class AvgLPPPB : public RideMetricCopyable<AvgLPPPB> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgLPPPB)
 
@@ -3286,6 +3242,7 @@ class AvgLPPPB : public RideMetric {
     {
         setSymbol("average_lpppb");
         setInternalName("Average Left Peak Power Phase Start");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::lpppb << RideFile::lpppe);
     }
     void initialize() {
         setName(tr("Average Left Peak Power Phase Start"));
@@ -3295,7 +3252,7 @@ class AvgLPPPB : public RideMetric {
         setDescription(tr("It is the left pedal stroke angle where you start producing peak power, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->lpppb) {
@@ -3328,7 +3285,7 @@ class AvgLPPPB : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgRPPPB : public RideMetric {
+class AvgRPPPB : public RideMetricCopyable<AvgRPPPB> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgRPPPB)
 
@@ -3338,6 +3295,7 @@ class AvgRPPPB : public RideMetric {
     {
         setSymbol("average_rpppb");
         setInternalName("Average Right Peak Power Phase Start");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::rpppb << RideFile::rpppe);
     }
 
     void initialize() {
@@ -3348,7 +3306,7 @@ class AvgRPPPB : public RideMetric {
         setDescription(tr("It is the right pedal stroke angle where you start producing peak power, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->rpppb) {
@@ -3382,7 +3340,7 @@ class AvgRPPPB : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgLPPPE : public RideMetric {
+class AvgLPPPE : public RideMetricCopyable<AvgLPPPE> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgLPPPE)
 
@@ -3392,6 +3350,7 @@ class AvgLPPPE : public RideMetric {
     {
         setSymbol("average_lpppe");
         setInternalName("Average Left Peak Power Phase End");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::lppe << RideFile::lpppe);
     }
 
     void initialize() {
@@ -3402,7 +3361,7 @@ class AvgLPPPE : public RideMetric {
         setDescription(tr("It is the left pedal stroke angle where you end producing peak power, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->lppe) {
@@ -3434,7 +3393,7 @@ class AvgLPPPE : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgRPPPE : public RideMetric {
+class AvgRPPPE : public RideMetricCopyable<AvgRPPPE> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgRPPPE)
 
@@ -3444,6 +3403,7 @@ class AvgRPPPE : public RideMetric {
     {
         setSymbol("average_rpppe");
         setInternalName("Average Right Peak Power Phase End");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::rpppe);
     }
 
     void initialize() {
@@ -3454,7 +3414,7 @@ class AvgRPPPE : public RideMetric {
         setDescription(tr("It is the right pedal stroke angle where you end producing peak power, on average."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->rpppe) {
@@ -3487,7 +3447,7 @@ class AvgRPPPE : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgLPP : public RideMetric {
+class AvgLPP : public RideMetricCopyable<AvgLPP> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgLPP)
     double average_lppb;
@@ -3499,6 +3459,7 @@ class AvgLPP : public RideMetric {
     {
         setSymbol("average_lpp");
         setInternalName("Average Left Power Phase Length");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -3509,7 +3470,7 @@ class AvgLPP : public RideMetric {
         setDescription(tr("It is the left pedal stroke region length where you produce positive power, on average."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         average_lppb = deps.value("average_lppb")->value(true);
         average_lppe = deps.value("average_lppe")->value(true);
@@ -3533,7 +3494,7 @@ class AvgLPP : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgRPP : public RideMetric {
+class AvgRPP : public RideMetricCopyable<AvgRPP> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgRPP)
     double average_rppb;
@@ -3545,6 +3506,7 @@ class AvgRPP : public RideMetric {
     {
         setSymbol("average_rpp");
         setInternalName("Average Right Power Phase Length");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -3555,7 +3517,7 @@ class AvgRPP : public RideMetric {
         setDescription(tr("It is the right pedal stroke region length where you produce positive power, on average."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         average_rppb = deps.value("average_rppb")->value(true);
         average_rppe = deps.value("average_rppe")->value(true);
@@ -3577,7 +3539,7 @@ class AvgRPP : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgLPPP : public RideMetric {
+class AvgLPPP : public RideMetricCopyable<AvgLPPP> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgLPPP)
     double average_lpppb;
@@ -3589,6 +3551,7 @@ class AvgLPPP : public RideMetric {
     {
         setSymbol("average_lppp");
         setInternalName("Average Peak Left Power Phase Length");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -3599,7 +3562,7 @@ class AvgLPPP : public RideMetric {
         setDescription(tr("It is the left pedal stroke region length where you produce peak power, on average."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         average_lpppb = deps.value("average_lpppb")->value(true);
         average_lpppe = deps.value("average_lpppe")->value(true);
@@ -3623,7 +3586,7 @@ class AvgLPPP : public RideMetric {
 
 //////////////////////////////////////////////////////////////////////////////
 
-class AvgRPPP : public RideMetric {
+class AvgRPPP : public RideMetricCopyable<AvgRPPP> {
 
     Q_DECLARE_TR_FUNCTIONS(AvgRPPP)
     double average_rpppb;
@@ -3635,6 +3598,7 @@ class AvgRPPP : public RideMetric {
     {
         setSymbol("average_rppp");
         setInternalName("Average Right Peak Power Phase Length");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -3645,7 +3609,7 @@ class AvgRPPP : public RideMetric {
         setDescription(tr("It is the right pedal stroke region length where you produce peak power, on average."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         average_rpppb = deps.value("average_rpppb")->value(true);
         average_rpppe = deps.value("average_rpppe")->value(true);
@@ -3701,7 +3665,7 @@ static bool addLeftRight()
 static bool leftRightAdded = addLeftRight();
 //////////////////////////////////////////////////////////////////////////////
 
-struct TotalCalories : public RideMetric {
+struct TotalCalories : public RideMetricCopyable<TotalCalories> {
     Q_DECLARE_TR_FUNCTIONS(TotalCalories)
 
     private:
@@ -3713,6 +3677,7 @@ struct TotalCalories : public RideMetric {
     {
         setSymbol("total_kcalories");
         setInternalName("Calories");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -3723,7 +3688,7 @@ struct TotalCalories : public RideMetric {
         setDescription(tr("Total Calories estimated from Time Moving, Heart Rate, Weight, Sex and Age"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         average_hr = deps.value("average_hr")->value(true);
         athlete_weight = deps.value("athlete_weight")->value(true);
@@ -3770,7 +3735,7 @@ static bool totalCaloriesAdded = addTotalCalories();
 ///////////////////////////////////////////////////////////////////////////////
 
 
-struct ActivityCRC : public RideMetric {
+struct ActivityCRC : public RideMetricCopyable<ActivityCRC> {
     Q_DECLARE_TR_FUNCTIONS(ActivityCRC)
 
     private:
@@ -3782,6 +3747,7 @@ struct ActivityCRC : public RideMetric {
     {
         setSymbol("activity_crc");
         setInternalName("Checksum");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -3792,9 +3758,10 @@ struct ActivityCRC : public RideMetric {
         setDescription(tr("A checksum for the activity, can be used to trigger cache refresh in R scripts."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
-        setValue(item->crc + item->metacrc + item->dateTime.toMSecsSinceEpoch());
+        // the file hash folded to 32 bits, so the sum stays exact as a double
+        setValue(quint32(item->crc ^ (item->crc >> 32)) + item->metacrc + item->dateTime.toMSecsSinceEpoch());
     }
 
     bool isRelevantForRide(const RideItem *) const { return true; }
@@ -36,7 +36,7 @@
 // The weighting factors for the exponentially weighted average are taken from
 // a spreadsheet provided by Dr. Skiba.
 
-class XPower : public RideMetric {
+class XPower : public RideMetricCopyable<XPower> {
     Q_DECLARE_TR_FUNCTIONS(XPower)
     double xpower;
     double secs;
@@ -47,6 +47,7 @@ class XPower : public RideMetric {
     {
         setSymbol("skiba_xpower");
         setInternalName("xPower");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
     }
 
     void initialize() {
@@ -57,7 +58,7 @@ class XPower : public RideMetric {
         setDescription(tr("xPower is an estimate of the power that you could have maintained for the same physiological 'cost' if your power output had been perfectly constant, similar to NP."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || item->ride()->recIntSecs()==0) {
@@ -109,7 +110,7 @@ class XPower : public RideMetric {
     RideMetric *clone() const { return new XPower(*this); }
 };
 
-class VariabilityIndex : public RideMetric {
+class VariabilityIndex : public RideMetricCopyable<VariabilityIndex> {
     Q_DECLARE_TR_FUNCTIONS(VariabilityIndex)
     double vi;
     double secs;
@@ -120,6 +121,7 @@ class VariabilityIndex : public RideMetric {
     {
         setSymbol("skiba_variability_index");
         setInternalName("Skiba VI");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -131,7 +133,7 @@ class VariabilityIndex : public RideMetric {
         setDescription(tr("Skiba Variability Index is the ratio between xPower and Average Power."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         assert(deps.contains("skiba_xpower"));
         assert(deps.contains("average_power"));
@@ -150,7 +152,7 @@ class VariabilityIndex : public RideMetric {
     RideMetric *clone() const { return new VariabilityIndex(*this); }
 };
 
-class RelativeIntensity : public RideMetric {
+class RelativeIntensity : public RideMetricCopyable<RelativeIntensity> {
     Q_DECLARE_TR_FUNCTIONS(RelativeIntensity)
     double reli;
     double secs;
@@ -161,6 +163,8 @@ class RelativeIntensity : public RideMetric {
     {
         setSymbol("skiba_relative_intensity");
         setInternalName("Relative Intensity");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PowerZonesInput);
     }
 
     void initialize() {
@@ -172,7 +176,7 @@ class RelativeIntensity : public RideMetric {
         setDescription(tr("Relative Intensity is the ratio between xPower and the Critical Power (CP) configured in Power Zones, similar to IF."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         if (item->context->athlete->zones(item->isRun) && item->zoneRange >= 0) {
             assert(deps.contains("skiba_xpower"));
@@ -192,7 +196,7 @@ class RelativeIntensity : public RideMetric {
     RideMetric *clone() const { return new RelativeIntensity(*this); }
 };
 
-class CriticalPower : public RideMetric {
+class CriticalPower : public RideMetricCopyable<CriticalPower> {
     Q_DECLARE_TR_FUNCTIONS(CriticalPower)
 
     public:
@@ -201,6 +205,8 @@ class CriticalPower : public RideMetric {
     {
         setSymbol("cp_setting");
         setInternalName("CP setting");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PowerZonesInput);
     }
 
     void initialize() {
@@ -212,7 +218,7 @@ class CriticalPower : public RideMetric {
         setDescription(tr("Critical Power (CP) configured in Power Zones."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         // did user override for this ride?
         int cp = item->getText("CP","0").toInt();
@@ -231,7 +237,7 @@ class CriticalPower : public RideMetric {
     RideMetric *clone() const { return new CriticalPower(*this); }
 };
 
-class aTISS : public RideMetric {
+class aTISS : public RideMetricCopyable<aTISS> {
     Q_DECLARE_TR_FUNCTIONS(aTISS)
 
     public:
@@ -240,6 +246,8 @@ class aTISS : public RideMetric {
     {
         setSymbol("atiss_score");
         setInternalName("Aerobic TISS");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
 
     void initialize() {
@@ -249,7 +257,7 @@ class aTISS : public RideMetric {
         setDescription(tr("Aerobic Training Impact Scoring System. It's a metric to quantify the training strain or response on the aerobic system"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
 	    if (!item->context->athlete->zones(item->isRun) || item->zoneRange < 0) return;
 
@@ -288,7 +296,7 @@ class aTISS : public RideMetric {
     RideMetric *clone() const { return new aTISS(*this); }
 };
 
-class anTISS : public RideMetric {
+class anTISS : public RideMetricCopyable<anTISS> {
     Q_DECLARE_TR_FUNCTIONS(aTISS)
 
     public:
@@ -297,6 +305,8 @@ class anTISS : public RideMetric {
     {
         setSymbol("antiss_score");
         setInternalName("Anaerobic TISS");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
 
     void initialize() {
@@ -306,7 +316,7 @@ class anTISS : public RideMetric {
         setDescription(tr("Anaerobic Training Impact Scoring System. It's a metric to quantify the training strain or response on the anaerobic system"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -346,7 +356,7 @@ class anTISS : public RideMetric {
     RideMetric *clone() const { return new anTISS(*this); }
 };
 
-class dTISS : public RideMetric {
+class dTISS : public RideMetricCopyable<dTISS> {
     Q_DECLARE_TR_FUNCTIONS(dTISS)
 
     public:
@@ -356,6 +366,8 @@ class dTISS : public RideMetric {
         setSymbol("tiss_delta");
         setInternalName("TISS Aerobicity");
         setType(RideMetric::Average);
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PowerZonesInput);
     }
 
     void initialize() {
@@ -365,7 +377,7 @@ class dTISS : public RideMetric {
         setDescription(tr("TISS Aerobicity is a percentage of Aerobic TISS of the total TISS"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
 	    if (!item->context->athlete->zones(item->isRun) || item->zoneRange < 0) return;
 
@@ -385,7 +397,7 @@ class dTISS : public RideMetric {
     RideMetric *clone() const { return new dTISS(*this); }
 };
 
-class BikeScore : public RideMetric {
+class BikeScore : public RideMetricCopyable<BikeScore> {
     Q_DECLARE_TR_FUNCTIONS(BikeScore)
     double score;
 
@@ -395,6 +407,8 @@ class BikeScore : public RideMetric {
     {
         setSymbol("skiba_bike_score");
         setInternalName("BikeScore&#8482;");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PowerZonesInput);
     }
 
     void initialize() {
@@ -404,7 +418,7 @@ class BikeScore : public RideMetric {
         setDescription(tr("Skiba's stress score taking into account both the intensity and the duration of the training session, similar to TSS it can be computed as 100 * hours * (Relative Intensity)^2"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // no zones
         if (item->context->athlete->zones(item->isRun)==NULL || item->zoneRange < 0) {
@@ -433,7 +447,7 @@ class BikeScore : public RideMetric {
     RideMetric *clone() const { return new BikeScore(*this); }
 };
 
-class ResponseIndex : public RideMetric {
+class ResponseIndex : public RideMetricCopyable<ResponseIndex> {
     Q_DECLARE_TR_FUNCTIONS(ResponseIndex)
     double ri;
 
@@ -443,6 +457,7 @@ class ResponseIndex : public RideMetric {
     {
         setSymbol("skiba_response_index");
         setInternalName("Response Index");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -454,7 +469,7 @@ class ResponseIndex : public RideMetric {
         setDescription(tr("The ratio between xPower and Average HR, similar to Efficiency Factor"));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         assert(deps.contains("skiba_xpower"));
         assert(deps.contains("average_hr"));
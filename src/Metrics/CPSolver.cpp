@@ -266,7 +266,7 @@ CPSolver::stop()
 // Metric of best 'R' for first exhaustion point in a ride
 // if there are no exhaustion points we set to NA
 
-class BestR : public RideMetric {
+class BestR : public RideMetricCopyable<BestR> {
     Q_DECLARE_TR_FUNCTIONS(BestR);
 
     public:
@@ -275,6 +275,8 @@ class BestR : public RideMetric {
     {
         setSymbol("cpsolver_best_r");
         setInternalName("Exhaustion Best R");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     void initialize() {
         setName(tr("Exhaustion Best R"));
@@ -285,7 +287,7 @@ class BestR : public RideMetric {
         setDescription(tr("Best value for R in differential model for exhaustion point."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
         // does it even have an exhaustion point?
         double returning = RideFile::NA;
 
@@ -18,6 +18,7 @@
 
 #include "Context.h"
 #include "RideMetric.h"
+#include "RideMetricSweep.h"
 #include "RideItem.h"
 #include "Zones.h"
 #include "Settings.h"
@@ -29,7 +30,7 @@
 #include <QApplication>
 
 
-class NP : public RideMetric {
+class NP : public RideMetricCopyable<NP, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(NP)
     double np;
     double secs;
@@ -40,6 +41,7 @@ class NP : public RideMetric {
     {
         setSymbol("coggan_np");
         setInternalName("NP");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
     }
     void initialize() {
         setName("NP");
@@ -50,50 +52,34 @@ class NP : public RideMetric {
         setDescription(tr("Normalized Power is an estimate of the power that you could have maintained for the same physiological 'cost' if your power output had been perfectly constant."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
-
-        // no ride or no samples
-        if (spec.isEmpty(item->ride()) || item->ride()->recIntSecs() == 0) {
-            setValue(RideFile::NIL);
-            setCount(0);
-            return;
-        }
-
-        int rollingwindowsize = 30 / item->ride()->recIntSecs();
-
-        double total = 0;
-        int count = 0;
+    static int windowSize(RideFile *ride) {
+        if (ride == NULL || ride->recIntSecs() == 0) return 0;
+        return 30 / ride->recIntSecs();
+    }
 
+    void accumulate(RideMetricSweep &sweep) const {
         // no point doing a rolling average if the
         // sample rate is greater than the rolling average
         // window!!
-        if (rollingwindowsize > 1) {
-
-            QVector<double> rolling(rollingwindowsize);
-            int index = 0;
-            double sum = 0;
-
-            // loop over the data and convert to a rolling
-            // average for the given windowsize
-            RideFileIterator it(item->ride(), spec);
-            while (it.hasNext()) {
-                struct RideFilePoint *point = it.next();
+        int rollingwindowsize = windowSize(sweep.ride());
+        if (rollingwindowsize > 1) sweep.addWindow(RideFile::watts, rollingwindowsize, 4);
+    }
 
-                sum += point->watts;
-                sum -= rolling[index];
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
-                rolling[index] = point->watts;
+        // no ride or no samples
+        if (sweep.isEmpty() || sweep.ride()->recIntSecs() == 0) {
+            setValue(RideFile::NIL);
+            setCount(0);
+            return;
+        }
 
-                total += pow(sum/rollingwindowsize,4); // raise rolling average to 4th power
-                count ++;
+        // the rolling average raised to 4th power
+        const RideMetricSweep::Stats &rolling = sweep.window(RideFile::watts, windowSize(sweep.ride()), 4);
 
-                // move index on/round
-                index = (index >= rollingwindowsize-1) ? 0 : index+1;
-            }
-        }
-        if (count) {
-            np = pow(total / (count), 0.25);
-            secs = count * item->ride()->recIntSecs();
+        if (rolling.count) {
+            np = pow(rolling.total / rolling.count, 0.25);
+            secs = rolling.count * sweep.ride()->recIntSecs();
         } else {
             np = secs = 0;
         }
@@ -108,7 +94,7 @@ class NP : public RideMetric {
     RideMetric *clone() const { return new NP(*this); }
 };
 
-class VI : public RideMetric {
+class VI : public RideMetricCopyable<VI> {
     Q_DECLARE_TR_FUNCTIONS(VI)
     double vi;
     double secs;
@@ -119,6 +105,7 @@ class VI : public RideMetric {
     {
         setSymbol("coggam_variability_index");
         setInternalName("VI");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -128,7 +115,7 @@ class VI : public RideMetric {
         setDescription(tr("Variability Index is the ratio between NP and Average Power."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         assert(deps.contains("coggan_np"));
         assert(deps.contains("average_power"));
@@ -149,7 +136,7 @@ class VI : public RideMetric {
     RideMetric *clone() const { return new VI(*this); }
 };
 
-class IntensityFactor : public RideMetric {
+class IntensityFactor : public RideMetricCopyable<IntensityFactor> {
     Q_DECLARE_TR_FUNCTIONS(IntensityFactor)
     double rif;
     double secs;
@@ -160,6 +147,8 @@ class IntensityFactor : public RideMetric {
     {
         setSymbol("coggan_if");
         setInternalName("IF");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PowerZonesInput);
     }
 
     void initialize() {
@@ -169,7 +158,7 @@ class IntensityFactor : public RideMetric {
         setDescription(tr("Intensity Factor is the ratio between NP and the Functional Threshold Power (FTP) configured in Power Zones."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // no zones
         if (!item->context->athlete->zones(item->isRun) || item->zoneRange < 0) {
@@ -207,7 +196,7 @@ class IntensityFactor : public RideMetric {
     RideMetric *clone() const { return new IntensityFactor(*this); }
 };
 
-class TSS : public RideMetric {
+class TSS : public RideMetricCopyable<TSS> {
     Q_DECLARE_TR_FUNCTIONS(TSS)
     double score;
 
@@ -217,6 +206,8 @@ class TSS : public RideMetric {
     {
         setSymbol("coggan_tss");
         setInternalName("TSS");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PowerZonesInput);
     }
 
     void initialize() {
@@ -225,7 +216,7 @@ class TSS : public RideMetric {
         setDescription(tr("Training Stress Score takes into account both the intensity and the duration of the training session, it can be computed as 100 * hours * IF^2"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // run, swim or no zones
         if (item->isSwim || item->isRun ||
@@ -267,7 +258,7 @@ class TSS : public RideMetric {
     RideMetric *clone() const { return new TSS(*this); }
 };
 
-class TSSPerHour : public RideMetric {
+class TSSPerHour : public RideMetricCopyable<TSSPerHour> {
     Q_DECLARE_TR_FUNCTIONS(TSSPerHour)
     double points;
     double hours;
@@ -278,6 +269,7 @@ class TSSPerHour : public RideMetric {
     {
         setSymbol("coggan_tssperhour");
         setInternalName("TSS per hour");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -287,7 +279,7 @@ class TSSPerHour : public RideMetric {
         setDescription(tr("Training Stress Score divided by Duration in hours"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // doesn't apply to swims or runs
         if (item->isSwim || item->isRun) {
@@ -322,7 +314,7 @@ class TSSPerHour : public RideMetric {
 };
 
 /* Running update based on: http://www.joefrielsblog.com/2014/11/the-efficiency-factor-in-running.html */
-class EfficiencyFactor : public RideMetric {
+class EfficiencyFactor : public RideMetricCopyable<EfficiencyFactor> {
     Q_DECLARE_TR_FUNCTIONS(EfficiencyFactor)
     double ef;
 
@@ -332,6 +324,7 @@ class EfficiencyFactor : public RideMetric {
     {
         setSymbol("friel_efficiency_factor");
         setInternalName("Efficiency Factor");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -343,7 +336,7 @@ class EfficiencyFactor : public RideMetric {
         setDescription(tr("The ratio between NP and Average HR for Cycling and xPace (in yd/min) and Average HR for Running"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         assert(deps.contains("coggan_np"));
         assert(deps.contains("xPace"));
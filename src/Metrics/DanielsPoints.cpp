@@ -35,7 +35,7 @@
 //               points per second = 33/3600 * (watts / FTP) ^ 4.
 
 
-class DanielsPoints : public RideMetric {
+class DanielsPoints : public RideMetricCopyable<DanielsPoints> {
     Q_DECLARE_TR_FUNCTIONS(DanielsPoints)
 
     double score;
@@ -51,6 +51,8 @@ class DanielsPoints : public RideMetric {
     {
         setSymbol("daniels_points");
         setInternalName("Daniels Points");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
 
     void initialize() {
@@ -61,7 +63,7 @@ class DanielsPoints : public RideMetric {
         setDescription(tr("Daniels Points adapted for cycling using power instead of pace and assuming VO2max-power=1.2*CP, normalized to assign 100 points to 1 hour at CP."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) ||
@@ -118,7 +120,7 @@ class DanielsPoints : public RideMetric {
 // Choose K such that 1 hour at FTP yields a score of 100.
 const double DanielsPoints::K = 100.0 / 3600.0;
 
-class DanielsEquivalentPower : public RideMetric {
+class DanielsEquivalentPower : public RideMetricCopyable<DanielsEquivalentPower> {
     Q_DECLARE_TR_FUNCTIONS(DanielsEquivalentPower)
     double watts;
 
@@ -128,6 +130,8 @@ class DanielsEquivalentPower : public RideMetric {
     {
         setSymbol("daniels_equivalent_power");
         setInternalName("Daniels EqP");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PowerZonesInput);
     }
 
     void initialize() {
@@ -138,7 +142,7 @@ class DanielsEquivalentPower : public RideMetric {
         setDescription(tr("Daniels EqP is the constant power which would produce equivalent Daniels Points."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // no zones
         if (item->context->athlete->zones(item->isRun) == NULL || item->zoneRange < 0) {
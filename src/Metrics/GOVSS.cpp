@@ -58,7 +58,7 @@ static inline double running_power( double weight, double height,
 }
 
 // Lactate Normalized Power, used for GOVSS and xPace calculation
-class LNP : public RideMetric {
+class LNP : public RideMetricCopyable<LNP> {
     Q_DECLARE_TR_FUNCTIONS(LNP)
     double lnp;
     double secs;
@@ -69,6 +69,8 @@ class LNP : public RideMetric {
     {
         setSymbol("govss_lnp");
         setInternalName("LNP");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::kph << RideFile::slope);
+        setConfigInputs(WeightInput);
     }
 
     void initialize() {
@@ -80,7 +82,7 @@ class LNP : public RideMetric {
         setDescription(tr("Lactate Normalized Power as defined by Dr. Skiba in GOVSS algorithm"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) ||
@@ -165,7 +167,7 @@ class LNP : public RideMetric {
 };
 
 // xPace: constant Pace which, on flat surface, gives same Lactate Normalized Power
-class XPace : public RideMetric {
+class XPace : public RideMetricCopyable<XPace> {
     Q_DECLARE_TR_FUNCTIONS(XPace)
     double xPace;
 
@@ -175,6 +177,8 @@ class XPace : public RideMetric {
     {
         setSymbol("xPace");
         setInternalName("xPace");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(WeightInput);
     }
 
     // xPace ordering is reversed
@@ -186,9 +190,8 @@ class XPace : public RideMetric {
         return RideMetric::units(metricRunPace);
     }
 
-    double value(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_PACE, true).toBool();
-        return RideMetric::value(metricRunPace);
+    bool metricUnits(bool) const {
+        return appsettings->value(NULL, GC_PACE, true).toBool();
     }
 
     QString toString(bool metric) const {
@@ -205,7 +208,7 @@ class XPace : public RideMetric {
         setDescription(tr("Normalized pace in min/km or min/mile, defined as the constant pace in flat surface which requires the same LNP"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // no ride or no samples
         if (!item->isRun) {
@@ -250,7 +253,7 @@ class XPace : public RideMetric {
 };
 
 // Running Threshold Power based on CV, used for GOVSS calculation
-class RTP : public RideMetric {
+class RTP : public RideMetricCopyable<RTP> {
     Q_DECLARE_TR_FUNCTIONS(RTP)
 
     public:
@@ -259,6 +262,8 @@ class RTP : public RideMetric {
     {
         setSymbol("govss_rtp");
         setInternalName("RTP");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PaceZonesInput | WeightInput);
     }
 
     void initialize() {
@@ -270,7 +275,7 @@ class RTP : public RideMetric {
         setDescription(tr("Run Threshold Power, computed from Critical Velocity using the GOVSS related algorithm"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         // no ride or no samples
         if (!item->isRun) {
@@ -305,7 +310,7 @@ class RTP : public RideMetric {
 };
 
 // Intensity Weighting Factor, used for GOVSS calculation
-class IWF : public RideMetric {
+class IWF : public RideMetricCopyable<IWF> {
     Q_DECLARE_TR_FUNCTIONS(IWF)
     double reli;
     double secs;
@@ -316,6 +321,7 @@ class IWF : public RideMetric {
     {
         setSymbol("govss_iwf");
         setInternalName("IWF");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -327,7 +333,7 @@ class IWF : public RideMetric {
         setDescription(tr("Intensity Weigthting Factor, part of GOVSS calculation, defined as LNP/RTP"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // no ride or no samples
         if (!item->isRun) {
@@ -355,7 +361,7 @@ class IWF : public RideMetric {
 };
 
 // GOVSS Metric for running
-class GOVSS : public RideMetric {
+class GOVSS : public RideMetricCopyable<GOVSS> {
     Q_DECLARE_TR_FUNCTIONS(GOVSS)
     double score;
 
@@ -365,6 +371,8 @@ class GOVSS : public RideMetric {
     {
         setSymbol("govss");
         setInternalName("GOVSS");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(WeightInput);
     }
 
     void initialize() {
@@ -374,7 +382,7 @@ class GOVSS : public RideMetric {
     }
 
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // no ride or no samples
         if (!item->isRun) {
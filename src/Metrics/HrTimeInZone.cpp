@@ -18,6 +18,7 @@
  */
 
 #include "RideMetric.h"
+#include "RideMetricSweep.h"
 #include "RideItem.h"
 #include "HrZones.h"
 #include "Context.h"
@@ -27,50 +28,46 @@
 #include <assert.h>
 #include <QApplication>
 
-class HrZoneTime : public RideMetric {
+class HrZoneTime : public RideMetricCopyable<HrZoneTime, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(HrZoneTime)
     int level;
-    double seconds;
 
     QList<int> lo;
     QList<int> hi;
 
 public:
 
-    HrZoneTime() : level(0), seconds(0.0)
+    HrZoneTime() : level(0)
     {
         setType(RideMetric::Total);
         setMetricUnits(tr("seconds"));
         setImperialUnits(tr("seconds"));
         setPrecision(0);
         setConversion(1.0);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::hr);
+        setConfigInputs(HrZonesInput);
     }
 
     bool isTime() const { return true; }
 
     void setLevel(int level) { this->level=level-1; } // zones start from zero not 1
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addZones(RideFile::hr);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        seconds = 0;
-
-        // get zone ranges
-        if (item->context->athlete->hrZones(item->isRun) && item->hrZoneRange >= 0 && item->ride()->areDataPresent()->hr) {
-            // iterate and compute
-            RideFileIterator it(item->ride(), spec);
-            while (it.hasNext()) {
-                struct RideFilePoint *point = it.next();
-                if (item->context->athlete->hrZones(item->isRun)->whichZone(item->hrZoneRange, point->hr) == level)
-                    seconds += item->ride()->recIntSecs();
-            }
-        }
+        // zero if there are no zones or no hr
+        double seconds = 0;
+        if (sweep.ride()->areDataPresent()->hr) seconds = sweep.zoneSeconds(RideFile::hr, level);
         setValue(seconds);
     }
 
@@ -81,7 +78,7 @@ public:
     RideMetric *clone() const { return new HrZoneTime(*this); }
 };
 
-class HrZoneTime1 : public HrZoneTime {
+class HrZoneTime1 : public RideMetricCopyable<HrZoneTime1, HrZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(HrZoneTime1)
 
 public:
@@ -103,7 +100,7 @@ public:
     RideMetric *clone() const { return new HrZoneTime1(*this); }
 };
 
-class HrZoneTime2 : public HrZoneTime {
+class HrZoneTime2 : public RideMetricCopyable<HrZoneTime2, HrZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(HrZoneTime2)
 
 public:
@@ -125,7 +122,7 @@ public:
     RideMetric *clone() const { return new HrZoneTime2(*this); }
 };
 
-class HrZoneTime3 : public HrZoneTime {
+class HrZoneTime3 : public RideMetricCopyable<HrZoneTime3, HrZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(HrZoneTime3)
 
 public:
@@ -147,7 +144,7 @@ public:
     RideMetric *clone() const { return new HrZoneTime3(*this); }
 };
 
-class HrZoneTime4 : public HrZoneTime {
+class HrZoneTime4 : public RideMetricCopyable<HrZoneTime4, HrZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(HrZoneTime4)
 
 public:
@@ -169,7 +166,7 @@ public:
     RideMetric *clone() const { return new HrZoneTime4(*this); }
 };
 
-class HrZoneTime5 : public HrZoneTime {
+class HrZoneTime5 : public RideMetricCopyable<HrZoneTime5, HrZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(HrZoneTime5)
 
 public:
@@ -191,7 +188,7 @@ public:
     RideMetric *clone() const { return new HrZoneTime5(*this); }
 };
 
-class HrZoneTime6 : public HrZoneTime {
+class HrZoneTime6 : public RideMetricCopyable<HrZoneTime6, HrZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(HrZoneTime6)
 
 public:
@@ -213,7 +210,7 @@ public:
     RideMetric *clone() const { return new HrZoneTime6(*this); }
 };
 
-class HrZoneTime7 : public HrZoneTime {
+class HrZoneTime7 : public RideMetricCopyable<HrZoneTime7, HrZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(HrZoneTime7)
 
 public:
@@ -235,7 +232,7 @@ public:
     RideMetric *clone() const { return new HrZoneTime7(*this); }
 };
 
-class HrZoneTime8 : public HrZoneTime {
+class HrZoneTime8 : public RideMetricCopyable<HrZoneTime8, HrZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(HrZoneTime8)
 
 public:
@@ -257,7 +254,7 @@ public:
     RideMetric *clone() const { return new HrZoneTime8(*this); }
 };
 
-class HrZoneTime9 : public HrZoneTime {
+class HrZoneTime9 : public RideMetricCopyable<HrZoneTime9, HrZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(HrZoneTime9)
 
 public:
@@ -278,7 +275,7 @@ public:
     MetricValidity validity() const { return Unknown; }
     RideMetric *clone() const { return new HrZoneTime9(*this); }
 };
-class HrZoneTime10 : public HrZoneTime {
+class HrZoneTime10 : public RideMetricCopyable<HrZoneTime10, HrZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(HrZoneTime10)
 
 public:
@@ -301,7 +298,7 @@ public:
 };
 
 // Now for Time In Zone as a Percentage of Ride Time
-class HrZonePTime1 : public RideMetric {
+class HrZonePTime1 : public RideMetricCopyable<HrZonePTime1> {
 
         Q_DECLARE_TR_FUNCTIONS(HrZonePTime1)
 
@@ -316,6 +313,7 @@ class HrZonePTime1 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -324,7 +322,7 @@ class HrZonePTime1 : public RideMetric {
             setDescription(tr("Percent of Time in Heart Rate Zone 1."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_H1"));
             assert(deps.contains("workout_time"));
@@ -345,7 +343,7 @@ class HrZonePTime1 : public RideMetric {
         RideMetric *clone() const { return new HrZonePTime1(*this); }
 };
 
-class HrZonePTime2 : public RideMetric {
+class HrZonePTime2 : public RideMetricCopyable<HrZonePTime2> {
 
         Q_DECLARE_TR_FUNCTIONS(HrZonePTime2)
 
@@ -360,6 +358,7 @@ class HrZonePTime2 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -368,7 +367,7 @@ class HrZonePTime2 : public RideMetric {
             setDescription(tr("Percent of Time in Heart Rate Zone 2."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_H2"));
             assert(deps.contains("workout_time"));
@@ -389,7 +388,7 @@ class HrZonePTime2 : public RideMetric {
         RideMetric *clone() const { return new HrZonePTime2(*this); }
 };
 
-class HrZonePTime3 : public RideMetric {
+class HrZonePTime3 : public RideMetricCopyable<HrZonePTime3> {
 
         Q_DECLARE_TR_FUNCTIONS(HrZonePTime3)
 
@@ -404,6 +403,7 @@ class HrZonePTime3 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -412,7 +412,7 @@ class HrZonePTime3 : public RideMetric {
             setDescription(tr("Percent of Time in Heart Rate Zone 3."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_H3"));
             assert(deps.contains("workout_time"));
@@ -433,7 +433,7 @@ class HrZonePTime3 : public RideMetric {
         RideMetric *clone() const { return new HrZonePTime3(*this); }
 };
 
-class HrZonePTime4 : public RideMetric {
+class HrZonePTime4 : public RideMetricCopyable<HrZonePTime4> {
 
         Q_DECLARE_TR_FUNCTIONS(HrZonePTime4)
 
@@ -448,6 +448,7 @@ class HrZonePTime4 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -456,7 +457,7 @@ class HrZonePTime4 : public RideMetric {
             setDescription(tr("Percent of Time in Heart Rate Zone 4."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_H4"));
             assert(deps.contains("workout_time"));
@@ -477,7 +478,7 @@ class HrZonePTime4 : public RideMetric {
         RideMetric *clone() const { return new HrZonePTime4(*this); }
 };
 
-class HrZonePTime5 : public RideMetric {
+class HrZonePTime5 : public RideMetricCopyable<HrZonePTime5> {
 
         Q_DECLARE_TR_FUNCTIONS(HrZonePTime5)
 
@@ -492,6 +493,7 @@ class HrZonePTime5 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -500,7 +502,7 @@ class HrZonePTime5 : public RideMetric {
             setDescription(tr("Percent of Time in Heart Rate Zone 5."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_H5"));
             assert(deps.contains("workout_time"));
@@ -521,7 +523,7 @@ class HrZonePTime5 : public RideMetric {
         RideMetric *clone() const { return new HrZonePTime5(*this); }
 };
 
-class HrZonePTime6 : public RideMetric {
+class HrZonePTime6 : public RideMetricCopyable<HrZonePTime6> {
 
         Q_DECLARE_TR_FUNCTIONS(HrZonePTime6)
 
@@ -536,6 +538,7 @@ class HrZonePTime6 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -544,7 +547,7 @@ class HrZonePTime6 : public RideMetric {
             setDescription(tr("Percent of Time in Heart Rate Zone 6."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_H6"));
             assert(deps.contains("workout_time"));
@@ -565,7 +568,7 @@ class HrZonePTime6 : public RideMetric {
         RideMetric *clone() const { return new HrZonePTime6(*this); }
 };
 
-class HrZonePTime7 : public RideMetric {
+class HrZonePTime7 : public RideMetricCopyable<HrZonePTime7> {
 
         Q_DECLARE_TR_FUNCTIONS(HrZonePTime7)
 
@@ -580,6 +583,7 @@ class HrZonePTime7 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -588,7 +592,7 @@ class HrZonePTime7 : public RideMetric {
             setDescription(tr("Percent of Time in Heart Rate Zone 7."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_H7"));
             assert(deps.contains("workout_time"));
@@ -609,7 +613,7 @@ class HrZonePTime7 : public RideMetric {
         RideMetric *clone() const { return new HrZonePTime7(*this); }
 };
 
-class HrZonePTime8 : public RideMetric {
+class HrZonePTime8 : public RideMetricCopyable<HrZonePTime8> {
 
         Q_DECLARE_TR_FUNCTIONS(HrZonePTime8)
 
@@ -624,6 +628,7 @@ class HrZonePTime8 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -632,7 +637,7 @@ class HrZonePTime8 : public RideMetric {
             setDescription(tr("Percent of Time in Heart Rate Zone 8."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_H8"));
             assert(deps.contains("workout_time"));
@@ -652,7 +657,7 @@ class HrZonePTime8 : public RideMetric {
     MetricValidity validity() const { return Unknown; }
         RideMetric *clone() const { return new HrZonePTime8(*this); }
 };
-class HrZonePTime9 : public RideMetric {
+class HrZonePTime9 : public RideMetricCopyable<HrZonePTime9> {
 
         Q_DECLARE_TR_FUNCTIONS(HrZonePTime9)
 
@@ -667,6 +672,7 @@ class HrZonePTime9 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -675,7 +681,7 @@ class HrZonePTime9 : public RideMetric {
             setDescription(tr("Percent of Time in Heart Rate Zone 9."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_H9"));
             assert(deps.contains("workout_time"));
@@ -695,7 +701,7 @@ class HrZonePTime9 : public RideMetric {
     MetricValidity validity() const { return Unknown; }
         RideMetric *clone() const { return new HrZonePTime9(*this); }
 };
-class HrZonePTime10 : public RideMetric {
+class HrZonePTime10 : public RideMetricCopyable<HrZonePTime10> {
 
         Q_DECLARE_TR_FUNCTIONS(HrZonePTime10)
 
@@ -710,6 +716,7 @@ class HrZonePTime10 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -718,7 +725,7 @@ class HrZonePTime10 : public RideMetric {
             setDescription(tr("Percent of Time in Heart Rate Zone 10."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_H10"));
             assert(deps.contains("workout_time"));
@@ -23,7 +23,7 @@
 
 #define ABS(x) ((x) >= 0 ? (x) : -(x))
 
-class RRNormalFraction : public RideMetric {
+class RRNormalFraction : public RideMetricCopyable<RRNormalFraction> {
     Q_DECLARE_TR_FUNCTIONS(RRNormalFraction)
 
     // NN/RR is the fraction of total RR intervals that are classified
@@ -35,6 +35,8 @@ public:
     {
         setSymbol("nn_rr_fraction");
         setInternalName("NN/RR fraction");
+        setInputs(QList<RideFile::SeriesType>());
+        setXDataInputs(QStringList() << "HRV");
     }
 
     void initialize()
@@ -46,7 +48,7 @@ public:
         setDescription(tr("Measure of RR readability"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
         double total, count;
 
         bool this_state;
@@ -89,7 +91,7 @@ static bool nnrrFractionAdded =
     RideMetricFactory::instance().addMetric(RRNormalFraction());
 
 
-class avnn : public RideMetric {
+class avnn : public RideMetricCopyable<avnn> {
     Q_DECLARE_TR_FUNCTIONS(avnn)
 
 public:
@@ -98,6 +100,8 @@ public:
     {
         setSymbol("AVNN");
         setInternalName("AVNN_HRV");
+        setInputs(QList<RideFile::SeriesType>());
+        setXDataInputs(QStringList() << "HRV");
     }
 
     void initialize()
@@ -109,7 +113,7 @@ public:
         setDescription(tr("Average of all NN intervals"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         double total, count;
         bool last_state = false;
@@ -151,7 +155,7 @@ static bool avnnAdded =
     RideMetricFactory::instance().addMetric(avnn());
 
 
-class sdnn : public RideMetric {
+class sdnn : public RideMetricCopyable<sdnn> {
     Q_DECLARE_TR_FUNCTIONS(sdnn)
 
 private:
@@ -165,6 +169,8 @@ public:
         setSymbol("SDNN");
         setInternalName("SDNN_HRV");
         stdmean_ = 0.0f;
+        setInputs(QList<RideFile::SeriesType>());
+        setXDataInputs(QStringList() << "HRV");
     }
 
     void initialize()
@@ -176,7 +182,7 @@ public:
         setDescription(tr("Standard deviation of all NN intervals"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
         double sum, sum2, count;
         bool last_state = false;
         bool this_state;
@@ -229,7 +235,7 @@ static bool sdnnAdded =
     RideMetricFactory::instance().addMetric(sdnn());
 
 
-class sdann : public RideMetric {
+class sdann : public RideMetricCopyable<sdann> {
     Q_DECLARE_TR_FUNCTIONS(sdann)
 
 private:
@@ -243,6 +249,8 @@ public:
         setSymbol("SDANN");
         setInternalName("SDANN_HRV");
         stdmean_ = 0.0f;
+        setInputs(QList<RideFile::SeriesType>());
+        setXDataInputs(QStringList() << "HRV");
     }
 
     void initialize()
@@ -254,7 +262,7 @@ public:
         setDescription(tr("Standard deviation of all NN intervals in all 5-minute segments of a 24-hour recording"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
         double sum, sum2, total, count, n;
         bool last_state = false;
         bool this_state;
@@ -328,7 +336,7 @@ static bool sdannAdded =
     RideMetricFactory::instance().addMetric(sdann());
 
 
-class sdnnidx : public RideMetric {
+class sdnnidx : public RideMetricCopyable<sdnnidx> {
     Q_DECLARE_TR_FUNCTIONS(sdnnidx)
 
 public:
@@ -337,6 +345,8 @@ public:
     {
         setSymbol("SDNNIDX");
         setInternalName("SDNNIDX_HRV");
+        setInputs(QList<RideFile::SeriesType>());
+        setXDataInputs(QStringList() << "HRV");
     }
 
     void initialize()
@@ -348,7 +358,7 @@ public:
         setDescription(tr("Average of the standard deviations of NN intervals in all 5-minute segments of a 24-hour recording"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         double sum, sum2, total, count, n;
         bool last_state = false;
@@ -410,7 +420,7 @@ static bool sdnnidxAdded =
     RideMetricFactory::instance().addMetric(sdnnidx());
 
 
-class rmssd : public RideMetric {
+class rmssd : public RideMetricCopyable<rmssd> {
     Q_DECLARE_TR_FUNCTIONS(rmssd)
 
 public:
@@ -419,6 +429,8 @@ public:
     {
         setSymbol("rMSSD");
         setInternalName("rMSSD_HRV");
+        setInputs(QList<RideFile::SeriesType>());
+        setXDataInputs(QStringList() << "HRV");
     }
 
     void initialize()
@@ -430,7 +442,7 @@ public:
         setDescription(tr("Square root of the mean of the squares of differences between adjacent NN intervals"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
         double sum, count;
 
         XDataSeries *series = item->ride()->xdata("HRV");
@@ -469,7 +481,7 @@ static bool rmssdAdded =
     RideMetricFactory::instance().addMetric(rmssd());
 
 
-class pnnx : public RideMetric {
+class pnnx : public RideMetricCopyable<pnnx> {
     Q_DECLARE_TR_FUNCTIONS(pnnx)
 
 public:
@@ -480,9 +492,11 @@ public:
         msec = msec_val;
         setSymbol(QString("pNN").append(QString::number(msec, 'f', 0)));
         setInternalName(QString("pNN_HRV").insert(3, QString::number(msec, 'f', 0)));
+        setInputs(QList<RideFile::SeriesType>());
+        setXDataInputs(QStringList() << "HRV");
     };
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
         int nnx, count;
         XDataSeries *series = item->ride()->xdata("HRV");
 
@@ -541,7 +555,7 @@ static bool pnnxadded = addPnnx();
 
 // HRV Measures for the date of the ride or the closer available
 
-class rest_hr : public RideMetric {
+class rest_hr : public RideMetricCopyable<rest_hr> {
     Q_DECLARE_TR_FUNCTIONS(rest_hr)
 
 public:
@@ -550,6 +564,8 @@ public:
     {
         setSymbol("Rest_HR");
         setInternalName("Rest HR");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(HrvInput);
     }
 
     void initialize()
@@ -561,7 +577,7 @@ public:
         setDescription(tr("Average HR measured at rest"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &)
+    void compute(RideItem *item, Specification, const RideMetricDeps &)
     {
         setValue(item->getHrvMeasure(HrvMeasure::HR));
         setCount(0);
@@ -577,7 +593,7 @@ public:
 static bool rest_hrAdded =
     RideMetricFactory::instance().addMetric(rest_hr());
 
-class rest_avnn : public RideMetric {
+class rest_avnn : public RideMetricCopyable<rest_avnn> {
     Q_DECLARE_TR_FUNCTIONS(rest_avnn)
 
 public:
@@ -586,6 +602,8 @@ public:
     {
         setSymbol("Rest_AVNN");
         setInternalName("Rest AVNN");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(HrvInput);
     }
 
     void initialize()
@@ -597,7 +615,7 @@ public:
         setDescription(tr("Average of all NN intervals measured at rest"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &)
+    void compute(RideItem *item, Specification, const RideMetricDeps &)
     {
         setValue(item->getHrvMeasure(HrvMeasure::AVNN));
         setCount(0);
@@ -614,7 +632,7 @@ static bool rest_avnnAdded =
     RideMetricFactory::instance().addMetric(rest_avnn());
 
 
-class rest_sdnn : public RideMetric {
+class rest_sdnn : public RideMetricCopyable<rest_sdnn> {
     Q_DECLARE_TR_FUNCTIONS(rest_sdnn)
 
 public:
@@ -623,6 +641,8 @@ public:
     {
         setSymbol("Rest_SDNN");
         setInternalName("Rest SDNN");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(HrvInput);
     }
 
     void initialize()
@@ -634,7 +654,7 @@ public:
         setDescription(tr("Standard deviation of all NN intervals measured at rest"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &)
+    void compute(RideItem *item, Specification, const RideMetricDeps &)
     {
         setValue(item->getHrvMeasure(HrvMeasure::SDNN));
         setCount(0);
@@ -651,7 +671,7 @@ static bool rest_sdnnAdded =
     RideMetricFactory::instance().addMetric(rest_sdnn());
 
 
-class rest_rmssd : public RideMetric {
+class rest_rmssd : public RideMetricCopyable<rest_rmssd> {
     Q_DECLARE_TR_FUNCTIONS(rest_rmssd)
 
 public:
@@ -660,6 +680,8 @@ public:
     {
         setSymbol("Rest_rMSSD");
         setInternalName("Rest rMSSD");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(HrvInput);
     }
 
     void initialize()
@@ -671,7 +693,7 @@ public:
         setDescription(tr("Square root of the mean of the squares of differences between adjacent NN intervals, measured at rest"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &)
+    void compute(RideItem *item, Specification, const RideMetricDeps &)
     {
         setValue(item->getHrvMeasure(HrvMeasure::RMSSD));
         setCount(0);
@@ -688,7 +710,7 @@ static bool rest_rmssdAdded =
     RideMetricFactory::instance().addMetric(rest_rmssd());
 
 
-class rest_pNN50 : public RideMetric {
+class rest_pNN50 : public RideMetricCopyable<rest_pNN50> {
     Q_DECLARE_TR_FUNCTIONS(rest_pNN50)
 
 public:
@@ -697,6 +719,8 @@ public:
     {
         setSymbol("Rest_PNN50");
         setInternalName("Rest PNN50");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(HrvInput);
     }
 
     void initialize()
@@ -708,7 +732,7 @@ public:
         setDescription(tr("Percentage of differences between adjacent NN intervals that are greater than 50 ms, measured at rest"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &)
+    void compute(RideItem *item, Specification, const RideMetricDeps &)
     {
         setValue(item->getHrvMeasure(HrvMeasure::PNN50));
         setCount(0);
@@ -725,7 +749,7 @@ static bool rest_pNN50Added =
     RideMetricFactory::instance().addMetric(rest_pNN50());
 
 
-class rest_lf : public RideMetric {
+class rest_lf : public RideMetricCopyable<rest_lf> {
     Q_DECLARE_TR_FUNCTIONS(rest_lf)
 
 public:
@@ -734,6 +758,8 @@ public:
     {
         setSymbol("Rest_LF");
         setInternalName("Rest LF");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(HrvInput);
     }
 
     void initialize()
@@ -745,7 +771,7 @@ public:
         setDescription(tr("Low Frequency Power HRV, measured at rest"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &)
+    void compute(RideItem *item, Specification, const RideMetricDeps &)
     {
         setValue(item->getHrvMeasure(HrvMeasure::LF));
         setCount(0);
@@ -762,7 +788,7 @@ static bool rest_lfAdded =
     RideMetricFactory::instance().addMetric(rest_lf());
 
 
-class rest_hf : public RideMetric {
+class rest_hf : public RideMetricCopyable<rest_hf> {
     Q_DECLARE_TR_FUNCTIONS(rest_hf)
 
 public:
@@ -771,6 +797,8 @@ public:
     {
         setSymbol("Rest_HF");
         setInternalName("Rest HF");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(HrvInput);
     }
 
     void initialize()
@@ -782,7 +810,7 @@ public:
         setDescription(tr("High Frequency Power HRV, measured at rest"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &)
+    void compute(RideItem *item, Specification, const RideMetricDeps &)
     {
         setValue(item->getHrvMeasure(HrvMeasure::HF));
         setCount(0);
@@ -799,7 +827,7 @@ static bool rest_hfAdded =
     RideMetricFactory::instance().addMetric(rest_hf());
 
 
-class hrv_recovery_points : public RideMetric {
+class hrv_recovery_points : public RideMetricCopyable<hrv_recovery_points> {
     Q_DECLARE_TR_FUNCTIONS(hrv_recovery_points)
 
 public:
@@ -808,6 +836,8 @@ public:
     {
         setSymbol("HRV_Recovery_Points");
         setInternalName("HRV Recovery Points");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(HrvInput);
     }
 
     void initialize()
@@ -820,7 +850,7 @@ public:
         setDescription(tr("Natural Log transform of rMSSD, measured at rest"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &)
+    void compute(RideItem *item, Specification, const RideMetricDeps &)
     {
         if (item->getHrvMeasure(HrvMeasure::RECOVERY_POINTS) > 0)
             setValue(item->getHrvMeasure(HrvMeasure::RECOVERY_POINTS));
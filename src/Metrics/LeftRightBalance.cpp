@@ -17,6 +17,7 @@
  */
 
 #include "RideMetric.h"
+#include "RideMetricSweep.h"
 #include "Zones.h"
 #include "RideItem.h"
 #include "Context.h"
@@ -25,9 +26,8 @@
 #include <cmath>
 #include <QApplication>
 
-class LeftRightBalance : public RideMetric {
+class LeftRightBalance : public RideMetricCopyable<LeftRightBalance, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(LeftRightBalance)
-    double count, total;
 
     public:
 
@@ -35,6 +35,7 @@ class LeftRightBalance : public RideMetric {
     {
         setSymbol("left_right_balance");
         setInternalName("Left/Right Balance");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::cad << RideFile::lrbalance);
     }
 
     void initialize() {
@@ -46,28 +47,23 @@ class LeftRightBalance : public RideMetric {
         setDescription(tr("Left/Right Balance shows the proportion of power coming from each pedal."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::lrbalance, RideMetricSweep::Positive, RideFile::cad);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        total = count = 0;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->cad && point->lrbalance > 0.0f) {
-                total += point->lrbalance;
-                ++count;
-            }
-
-        }
-        setValue(count > 0 ? total / count : 0);
-        setCount(count);
+        // whilst pedalling
+        const RideMetricSweep::Stats &lrbalance = sweep.stats(RideFile::lrbalance, RideMetricSweep::Positive, RideFile::cad);
+        setValue(lrbalance.mean());
+        setCount(lrbalance.count);
     }
 
     QString toString(bool useMetricUnits) const
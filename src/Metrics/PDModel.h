@@ -53,6 +53,10 @@
 //
 // 6. The setIntervals method can be used to setup the intervals the
 //    base derviceCPparameters will use
+//
+// 7. Fitting only touches the instance, so different instances can be
+//    fitted at the same time on different threads (see PDEstimateFit
+//    in RideCache.cpp), don't add statics or shared state to it
 
 #define PDMODEL_MAXT 18000 // maximum value for t we will provide p(t) for
 #define PDMODEL_INTERVAL 1 // intervals used in seconds; 0t, 1t, 2t .. 18000t
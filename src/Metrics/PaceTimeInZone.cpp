@@ -28,7 +28,7 @@
 #include <assert.h>
 #include <QApplication>
 
-class PaceZoneTime : public RideMetric {
+class PaceZoneTime : public RideMetricCopyable<PaceZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(PaceZoneTime)
     int level;
     double seconds;
@@ -45,12 +45,14 @@ class PaceZoneTime : public RideMetric {
         setImperialUnits(tr("seconds"));
         setPrecision(0);
         setConversion(1.0);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::kph);
+        setConfigInputs(PaceZonesInput);
     }
 
     bool isTime() const { return true; }
     void setLevel(int level) { this->level=level-1; } // zones start from zero not 1
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) &&
@@ -86,7 +88,7 @@ class PaceZoneTime : public RideMetric {
     RideMetric *clone() const { return new PaceZoneTime(*this); }
 };
 
-class PaceZoneTime1 : public PaceZoneTime {
+class PaceZoneTime1 : public RideMetricCopyable<PaceZoneTime1, PaceZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(PaceZoneTime1)
 
     public:
@@ -108,7 +110,7 @@ class PaceZoneTime1 : public PaceZoneTime {
         RideMetric *clone() const { return new PaceZoneTime1(*this); }
 };
 
-class PaceZoneTime2 : public PaceZoneTime {
+class PaceZoneTime2 : public RideMetricCopyable<PaceZoneTime2, PaceZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(PaceZoneTime2)
 
     public:
@@ -130,7 +132,7 @@ class PaceZoneTime2 : public PaceZoneTime {
         RideMetric *clone() const { return new PaceZoneTime2(*this); }
 };
 
-class PaceZoneTime3 : public PaceZoneTime {
+class PaceZoneTime3 : public RideMetricCopyable<PaceZoneTime3, PaceZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(PaceZoneTime3)
 
     public:
@@ -152,7 +154,7 @@ class PaceZoneTime3 : public PaceZoneTime {
         RideMetric *clone() const { return new PaceZoneTime3(*this); }
 };
 
-class PaceZoneTime4 : public PaceZoneTime {
+class PaceZoneTime4 : public RideMetricCopyable<PaceZoneTime4, PaceZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(PaceZoneTime4)
 
     public:
@@ -176,7 +178,7 @@ class PaceZoneTime4 : public PaceZoneTime {
         RideMetric *clone() const { return new PaceZoneTime4(*this); }
 };
 
-class PaceZoneTime5 : public PaceZoneTime {
+class PaceZoneTime5 : public RideMetricCopyable<PaceZoneTime5, PaceZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(PaceZoneTime5)
 
     public:
@@ -198,7 +200,7 @@ class PaceZoneTime5 : public PaceZoneTime {
         RideMetric *clone() const { return new PaceZoneTime5(*this); }
 };
 
-class PaceZoneTime6 : public PaceZoneTime {
+class PaceZoneTime6 : public RideMetricCopyable<PaceZoneTime6, PaceZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(PaceZoneTime6)
 
     public:
@@ -220,7 +222,7 @@ class PaceZoneTime6 : public PaceZoneTime {
         RideMetric *clone() const { return new PaceZoneTime6(*this); }
 };
 
-class PaceZoneTime7 : public PaceZoneTime {
+class PaceZoneTime7 : public RideMetricCopyable<PaceZoneTime7, PaceZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(PaceZoneTime7)
 
     public:
@@ -242,7 +244,7 @@ class PaceZoneTime7 : public PaceZoneTime {
         RideMetric *clone() const { return new PaceZoneTime7(*this); }
 };
 
-class PaceZoneTime8 : public PaceZoneTime {
+class PaceZoneTime8 : public RideMetricCopyable<PaceZoneTime8, PaceZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(PaceZoneTime8)
 
     public:
@@ -264,7 +266,7 @@ class PaceZoneTime8 : public PaceZoneTime {
         RideMetric *clone() const { return new PaceZoneTime8(*this); }
 };
 
-class PaceZoneTime9 : public PaceZoneTime {
+class PaceZoneTime9 : public RideMetricCopyable<PaceZoneTime9, PaceZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(PaceZoneTime9)
 
     public:
@@ -286,7 +288,7 @@ class PaceZoneTime9 : public PaceZoneTime {
         RideMetric *clone() const { return new PaceZoneTime9(*this); }
 };
 
-class PaceZoneTime10 : public PaceZoneTime {
+class PaceZoneTime10 : public RideMetricCopyable<PaceZoneTime10, PaceZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(PaceZoneTime10)
 
     public:
@@ -309,7 +311,7 @@ class PaceZoneTime10 : public PaceZoneTime {
 };
 
 // Now for Time In Zone as a Percentage of Ride Time
-class PaceZonePTime1 : public RideMetric {
+class PaceZonePTime1 : public RideMetricCopyable<PaceZonePTime1> {
 
         Q_DECLARE_TR_FUNCTIONS(PaceZonePTime1)
 
@@ -324,6 +326,7 @@ class PaceZonePTime1 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -332,7 +335,7 @@ class PaceZonePTime1 : public RideMetric {
             setDescription(tr("Percent of Time in Pace Zone 1."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_P1"));
             assert(deps.contains("workout_time"));
@@ -353,7 +356,7 @@ class PaceZonePTime1 : public RideMetric {
         RideMetric *clone() const { return new PaceZonePTime1(*this); }
 };
 
-class PaceZonePTime2 : public RideMetric {
+class PaceZonePTime2 : public RideMetricCopyable<PaceZonePTime2> {
 
         Q_DECLARE_TR_FUNCTIONS(PaceZonePTime2)
 
@@ -368,6 +371,7 @@ class PaceZonePTime2 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -376,7 +380,7 @@ class PaceZonePTime2 : public RideMetric {
             setDescription(tr("Percent of Time in Pace Zone 2."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_P2"));
             assert(deps.contains("workout_time"));
@@ -397,7 +401,7 @@ class PaceZonePTime2 : public RideMetric {
         RideMetric *clone() const { return new PaceZonePTime2(*this); }
 };
 
-class PaceZonePTime3 : public RideMetric {
+class PaceZonePTime3 : public RideMetricCopyable<PaceZonePTime3> {
 
         Q_DECLARE_TR_FUNCTIONS(PaceZonePTime3)
 
@@ -412,6 +416,7 @@ class PaceZonePTime3 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -420,7 +425,7 @@ class PaceZonePTime3 : public RideMetric {
             setDescription(tr("Percent of Time in Pace Zone 3."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_P3"));
             assert(deps.contains("workout_time"));
@@ -441,7 +446,7 @@ class PaceZonePTime3 : public RideMetric {
         RideMetric *clone() const { return new PaceZonePTime3(*this); }
 };
 
-class PaceZonePTime4 : public RideMetric {
+class PaceZonePTime4 : public RideMetricCopyable<PaceZonePTime4> {
 
         Q_DECLARE_TR_FUNCTIONS(PaceZonePTime4)
 
@@ -456,6 +461,7 @@ class PaceZonePTime4 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -464,7 +470,7 @@ class PaceZonePTime4 : public RideMetric {
             setDescription(tr("Percent of Time in Pace Zone 4."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_P4"));
             assert(deps.contains("workout_time"));
@@ -485,7 +491,7 @@ class PaceZonePTime4 : public RideMetric {
         RideMetric *clone() const { return new PaceZonePTime4(*this); }
 };
 
-class PaceZonePTime5 : public RideMetric {
+class PaceZonePTime5 : public RideMetricCopyable<PaceZonePTime5> {
 
         Q_DECLARE_TR_FUNCTIONS(PaceZonePTime5)
 
@@ -500,6 +506,7 @@ class PaceZonePTime5 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -508,7 +515,7 @@ class PaceZonePTime5 : public RideMetric {
             setDescription(tr("Percent of Time in Pace Zone 5."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_P5"));
             assert(deps.contains("workout_time"));
@@ -529,7 +536,7 @@ class PaceZonePTime5 : public RideMetric {
         RideMetric *clone() const { return new PaceZonePTime5(*this); }
 };
 
-class PaceZonePTime6 : public RideMetric {
+class PaceZonePTime6 : public RideMetricCopyable<PaceZonePTime6> {
 
         Q_DECLARE_TR_FUNCTIONS(PaceZonePTime6)
 
@@ -544,6 +551,7 @@ class PaceZonePTime6 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -552,7 +560,7 @@ class PaceZonePTime6 : public RideMetric {
             setDescription(tr("Percent of Time in Pace Zone 6."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_P6"));
             assert(deps.contains("workout_time"));
@@ -573,7 +581,7 @@ class PaceZonePTime6 : public RideMetric {
         RideMetric *clone() const { return new PaceZonePTime6(*this); }
 };
 
-class PaceZonePTime7 : public RideMetric {
+class PaceZonePTime7 : public RideMetricCopyable<PaceZonePTime7> {
 
         Q_DECLARE_TR_FUNCTIONS(PaceZonePTime7)
 
@@ -588,6 +596,7 @@ class PaceZonePTime7 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -596,7 +605,7 @@ class PaceZonePTime7 : public RideMetric {
             setDescription(tr("Percent of Time in Pace Zone 7."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_P7"));
             assert(deps.contains("workout_time"));
@@ -617,7 +626,7 @@ class PaceZonePTime7 : public RideMetric {
         RideMetric *clone() const { return new PaceZonePTime7(*this); }
 };
 
-class PaceZonePTime8 : public RideMetric {
+class PaceZonePTime8 : public RideMetricCopyable<PaceZonePTime8> {
 
         Q_DECLARE_TR_FUNCTIONS(PaceZonePTime8)
 
@@ -632,6 +641,7 @@ class PaceZonePTime8 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -640,7 +650,7 @@ class PaceZonePTime8 : public RideMetric {
             setDescription(tr("Percent of Time in Pace Zone 8."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_P8"));
             assert(deps.contains("workout_time"));
@@ -661,7 +671,7 @@ class PaceZonePTime8 : public RideMetric {
         RideMetric *clone() const { return new PaceZonePTime8(*this); }
 };
 
-class PaceZonePTime9 : public RideMetric {
+class PaceZonePTime9 : public RideMetricCopyable<PaceZonePTime9> {
 
         Q_DECLARE_TR_FUNCTIONS(PaceZonePTime9)
 
@@ -676,6 +686,7 @@ class PaceZonePTime9 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -684,7 +695,7 @@ class PaceZonePTime9 : public RideMetric {
             setDescription(tr("Percent of Time in Pace Zone 9."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_P9"));
             assert(deps.contains("workout_time"));
@@ -705,7 +716,7 @@ class PaceZonePTime9 : public RideMetric {
         RideMetric *clone() const { return new PaceZonePTime9(*this); }
 };
 
-class PaceZonePTime10 : public RideMetric {
+class PaceZonePTime10 : public RideMetricCopyable<PaceZonePTime10> {
 
         Q_DECLARE_TR_FUNCTIONS(PaceZonePTime10)
 
@@ -720,6 +731,7 @@ class PaceZonePTime10 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -728,7 +740,7 @@ class PaceZonePTime10 : public RideMetric {
             setDescription(tr("Percent of Time in Pace Zone 10."));
         }
 
-        void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+        void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_P10"));
             assert(deps.contains("workout_time"));
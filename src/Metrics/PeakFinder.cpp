@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "PeakFinder.h"
+#include "RideItem.h"
+
+#include <algorithm> // for std::make_heap et al
+
+// the durations used by the peak metrics and interval discovery, when
+// one of these is asked for they are all found together and cached
+static const double standardSecs[] = { 1, 5, 10, 15, 20, 30, 60, 120, 180, 300, 480, 600,
+                                       1200, 1800, 2700, 3600, 5400, 0 };
+static const double standardMeters[] = { 50, 100, 200, 400, 500, 800, 1000, 1500, 2000, 3000,
+                                         4000, 5000, 10000, 15000, 20000, 21097.5, 30000,
+                                         40000, 42195, 0 };
+
+// Sort by decreasing average and increasing start time, as a heap
+// ordering, so the best is at the top
+struct WorsePeak {
+    bool operator()(const PeakFinder::Peak &a, const PeakFinder::Peak &b) const {
+        if (a.avg < b.avg) return true;
+        if (b.avg < a.avg) return false;
+        return a.start > b.start;
+    }
+};
+
+static bool
+peaksOverlap(const PeakFinder::Peak &a, const PeakFinder::Peak &b)
+{
+    if ((a.start <= b.start) && (a.stop > b.start))
+        return true;
+    if ((b.start <= a.start) && (b.stop > a.start))
+        return true;
+    return false;
+}
+
+PeakFinder::PeakFinder(const RideFile *ride, Specification spec, RideFile::SeriesType series, bool typeTime) :
+    typeTime(typeTime), secsDelta(0), rideSecs(0), rideMeters(0)
+{
+    if (ride == NULL || ride->dataPoints().isEmpty()) return;
+
+    // nothing longer than the ride can be found
+    secsDelta = ride->recIntSecs();
+    rideSecs = ride->dataPoints().last()->secs + secsDelta;
+    rideMeters = ride->dataPoints().last()->km * 1000;
+
+    // the samples in the spec are a contiguous run
+    RideFileIterator it(const_cast<RideFile*>(ride), spec);
+    int start = it.firstIndex();
+    int stop = it.lastIndex();
+    if (start < 0 || stop < start) return;
+    int n = stop - start + 1;
+
+    RideFileSeries values = ride->series(series).mid(start, n);
+    RideFileSeries time = ride->series(RideFile::secs).mid(start, n);
+    RideFileSeries distance = ride->series(RideFile::km).mid(start, n);
+
+    secs.resize(n);
+    km.resize(n);
+    total.resize(n+1);
+
+    total[0] = 0;
+    for (int i=0; i<n; i++) {
+        secs[i] = time[i];
+        km[i] = distance[i];
+        total[i+1] = total[i] + (values.isEmpty() ? 0 : values[i]);
+    }
+}
+
+bool
+PeakFinder::tooLong(double duration) const
+{
+    return typeTime ? duration > rideSecs : duration > rideMeters;
+}
+
+inline bool
+PeakFinder::window(int &i, int j, double duration, Peak &peak) const
+{
+    if (typeTime) {
+
+        // discard samples until interval duration is < duration + secsDelta
+        while (i < j && secs[j] - secs[i] + secsDelta >= duration + secsDelta) i++;
+        if (secs[j] - secs[i] + secsDelta < duration) return false;
+
+    } else {
+
+        // discard samples whilst the window would still be long enough without them
+        while (j - i > 1 && 1000 * (km[j] - km[i+1]) >= duration) i++;
+        if (1000 * (km[j] - km[i]) < duration) return false;
+    }
+
+    double length = secs[j] - secs[i] + secsDelta;
+    peak = Peak(secs[i], secs[j], (total[j+1] - total[i]) * secsDelta / length);
+    return true;
+}
+
+QVector<PeakFinder::Peak>
+PeakFinder::best(const QVector<double> &durations) const
+{
+    int d = durations.count();
+    QVector<Peak> returning(d);
+
+    // where each window starts, they only ever move forward
+    QVector<int> from(d, 0);
+    QVector<bool> possible(d);
+    for (int k=0; k<d; k++) possible[k] = !tooLong(durations[k]);
+
+    Peak candidate;
+    for (int j=0; j<secs.count(); j++) {
+        for (int k=0; k<d; k++) {
+            if (possible[k] && window(from[k], j, durations[k], candidate) &&
+                (!returning[k].found || candidate.avg > returning[k].avg))
+                returning[k] = candidate;
+        }
+    }
+    return returning;
+}
+
+QList<PeakFinder::Peak>
+PeakFinder::best(double duration, int count) const
+{
+    QList<Peak> returning;
+    if (count < 1 || tooLong(duration)) return returning;
+
+    // just the best is a single pass
+    if (count == 1) {
+        Peak peak = best(QVector<double>() << duration).first();
+        if (peak.found) returning << peak;
+        return returning;
+    }
+
+    // otherwise every window goes on a heap and we take the
+    // best off the top till we have enough that don't overlap
+    QVector<Peak> candidates;
+    candidates.reserve(secs.count());
+
+    int i=0;
+    Peak candidate;
+    for (int j=0; j<secs.count(); j++)
+        if (window(i, j, duration, candidate)) candidates << candidate;
+
+    std::make_heap(candidates.begin(), candidates.end(), WorsePeak());
+
+    QVector<Peak>::iterator end = candidates.end();
+    while (end != candidates.begin() && returning.count() < count) {
+
+        std::pop_heap(candidates.begin(), end, WorsePeak());
+        --end;
+
+        bool overlaps = false;
+        foreach(const Peak &existing, returning) {
+            if (peaksOverlap(*end, existing)) {
+                overlaps = true;
+                break;
+            }
+        }
+        if (!overlaps) returning << *end;
+    }
+    return returning;
+}
+
+PeakFinder::Peak
+PeakFinder::peak(RideItem *item, Specification spec, RideFile::SeriesType series, double duration, bool typeTime)
+{
+    // never opens the ride, callers already have
+    RideFile *ride = item->ride(false);
+    if (ride == NULL || ride->dataPoints().isEmpty()) return Peak();
+
+    // the same samples, series and type share a pass
+    QString key = QString("%1:%2:%3:%4:").arg(series).arg(typeTime ? 1 : 0)
+                  .arg(QString::number(spec.secsStart(), 'g', 15))
+                  .arg(QString::number(spec.secsEnd(), 'g', 15));
+
+    QMutexLocker locker(&item->peakLock);
+
+    QMap<QString, Peak>::const_iterator cached = item->peakCache.constFind(key + QString::number(duration, 'g', 15));
+    if (cached != item->peakCache.constEnd()) return cached.value();
+
+    // all the standard durations, or just this one if it isn't
+    QVector<double> durations;
+    for (const double *d = typeTime ? standardSecs : standardMeters; *d; d++) durations << *d;
+    if (!durations.contains(duration)) durations = QVector<double>() << duration;
+
+    QVector<Peak> found = PeakFinder(ride, spec, series, typeTime).best(durations);
+    for (int i=0; i<durations.count(); i++)
+        item->peakCache.insert(key + QString::number(durations[i], 'g', 15), found[i]);
+
+    return found[durations.indexOf(duration)];
+}
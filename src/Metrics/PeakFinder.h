@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_PeakFinder_h
+#define _GC_PeakFinder_h 1
+#include "GoldenCheetah.h"
+
+#include "RideFile.h"
+#include "Specification.h"
+
+#include <QVector>
+#include <QList>
+
+class RideItem;
+
+//
+// Finds the peak average of a data series over a window of a given
+// duration (seconds) or distance (metres), e.g. the best 5 minute power.
+//
+// The window sums come from a running total so each window costs the
+// same regardless of its size, and any number of durations are found
+// together in a single pass over the samples. This is what the peak
+// metrics, interval discovery and the add interval dialog all use.
+//
+// The windows matched and averages returned are the same as the
+// original AddIntervalDialog::findPeaks; a window is the shortest run
+// of samples at least as long as the duration asked for and the
+// average is over the duration of the window.
+//
+class PeakFinder
+{
+    public:
+
+        struct Peak {
+            double start, stop, avg; // start and stop are secs in the ride
+            bool found;
+            Peak() : start(0), stop(0), avg(0), found(false) {}
+            Peak(double start, double stop, double avg) : start(start), stop(stop), avg(avg), found(true) {}
+        };
+
+        // the samples of ride selected by spec, when typeTime is false
+        // durations are distances in metres rather than seconds
+        PeakFinder(const RideFile *ride, Specification spec, RideFile::SeriesType series, bool typeTime=true);
+
+        // the best window for each of the durations, all in one pass,
+        // found is false for those longer than the ride
+        QVector<Peak> best(const QVector<double> &durations) const;
+
+        // the best count windows for one duration that do not overlap,
+        // best first with ties going to the earliest
+        QList<Peak> best(double duration, int count) const;
+
+        // the best window for a duration within an item. The durations
+        // used by the peak metrics are all found together in one pass
+        // the first time any of them is asked for, and cached with the
+        // ride item until its data changes
+        static Peak peak(RideItem *item, Specification spec, RideFile::SeriesType series,
+                         double duration, bool typeTime=true);
+
+    private:
+
+        // is there a window of duration ending at sample j, moving
+        // the start of the window on as needed
+        inline bool window(int &i, int j, double duration, Peak &peak) const;
+        bool tooLong(double duration) const;
+
+        bool typeTime;
+        double secsDelta;
+        double rideSecs, rideMeters;
+
+        QVector<double> secs, km;
+        QVector<double> total; // running total, total[i] is sum of first i samples
+};
+
+#endif
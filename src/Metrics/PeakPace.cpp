@@ -18,7 +18,7 @@
  */
 
 #include "RideMetric.h"
-#include "AddIntervalDialog.h"
+#include "PeakFinder.h"
 #include "RideItem.h"
 #include "Context.h"
 #include "Athlete.h"
@@ -28,7 +28,7 @@
 #include <cmath>
 #include <QApplication>
 
-class PeakPace : public RideMetric {
+class PeakPace : public RideMetricCopyable<PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace)
     double pace;
     double secs;
@@ -38,6 +38,7 @@ class PeakPace : public RideMetric {
     PeakPace() : pace(0.0), secs(0.0)
     {
         setType(RideMetric::Low);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::kph);
     }
     // Pace ordering is reversed
     bool isLowerBetter() const { return true; }
@@ -46,16 +47,15 @@ class PeakPace : public RideMetric {
         bool metricRunPace = appsettings->value(NULL, GC_PACE, true).toBool();
         return RideMetric::units(metricRunPace);
     }
-    double value(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_PACE, true).toBool();
-        return RideMetric::value(metricRunPace);
+    bool metricUnits(bool) const {
+        return appsettings->value(NULL, GC_PACE, true).toBool();
     }
     QString toString(bool metric) const {
         return time_to_string(value(metric)*60, true);
     }
     void setSecs(double secs) { this->secs=secs; }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->isRun) {
@@ -64,9 +64,8 @@ class PeakPace : public RideMetric {
             return;
         }
 
-        QList<AddIntervalDialog::AddedInterval> results;
-        AddIntervalDialog::findPeaks(item->context, true, item->ride(), spec, RideFile::kph, RideFile::original, secs, 1, results, "", "");
-        if (results.count() > 0 && results.first().avg > 0 && results.first().avg < 36) pace = 60.0 / results.first().avg;
+        PeakFinder::Peak peak = PeakFinder::peak(item, spec, RideFile::kph, secs);
+        if (peak.found && peak.avg > 0 && peak.avg < 36) pace = 60.0 / peak.avg;
         else pace = 0.0;
 
         setValue(pace);
@@ -77,7 +76,7 @@ class PeakPace : public RideMetric {
     RideMetric *clone() const { return new PeakPace(*this); }
 };
 
-class PeakPace10s : public PeakPace {
+class PeakPace10s : public RideMetricCopyable<PeakPace10s, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace10s)
     public:
         PeakPace10s()
@@ -98,7 +97,7 @@ class PeakPace10s : public PeakPace {
         RideMetric *clone() const { return new PeakPace10s(*this); }
 };
 
-class PeakPace15s : public PeakPace {
+class PeakPace15s : public RideMetricCopyable<PeakPace15s, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace15s)
     public:
         PeakPace15s()
@@ -119,7 +118,7 @@ class PeakPace15s : public PeakPace {
         RideMetric *clone() const { return new PeakPace15s(*this); }
 };
 
-class PeakPace20s : public PeakPace {
+class PeakPace20s : public RideMetricCopyable<PeakPace20s, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace20s)
     public:
         PeakPace20s()
@@ -140,7 +139,7 @@ class PeakPace20s : public PeakPace {
         RideMetric *clone() const { return new PeakPace20s(*this); }
 };
 
-class PeakPace30s : public PeakPace {
+class PeakPace30s : public RideMetricCopyable<PeakPace30s, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace30s)
     public:
         PeakPace30s()
@@ -161,7 +160,7 @@ class PeakPace30s : public PeakPace {
         RideMetric *clone() const { return new PeakPace30s(*this); }
 };
 
-class PeakPace1m : public PeakPace {
+class PeakPace1m : public RideMetricCopyable<PeakPace1m, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace1m)
     public:
         PeakPace1m()
@@ -182,7 +181,7 @@ class PeakPace1m : public PeakPace {
         RideMetric *clone() const { return new PeakPace1m(*this); }
 };
 
-class PeakPace2m : public PeakPace {
+class PeakPace2m : public RideMetricCopyable<PeakPace2m, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace2m)
     public:
         PeakPace2m()
@@ -203,7 +202,7 @@ class PeakPace2m : public PeakPace {
         RideMetric *clone() const { return new PeakPace2m(*this); }
 };
 
-class PeakPace3m : public PeakPace {
+class PeakPace3m : public RideMetricCopyable<PeakPace3m, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace3m)
     public:
         PeakPace3m()
@@ -224,7 +223,7 @@ class PeakPace3m : public PeakPace {
         RideMetric *clone() const { return new PeakPace3m(*this); }
 };
 
-class PeakPace5m : public PeakPace {
+class PeakPace5m : public RideMetricCopyable<PeakPace5m, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace5m)
     public:
         PeakPace5m()
@@ -245,7 +244,7 @@ class PeakPace5m : public PeakPace {
         RideMetric *clone() const { return new PeakPace5m(*this); }
 };
 
-class PeakPace8m : public PeakPace {
+class PeakPace8m : public RideMetricCopyable<PeakPace8m, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace8m)
     public:
         PeakPace8m()
@@ -266,7 +265,7 @@ class PeakPace8m : public PeakPace {
         RideMetric *clone() const { return new PeakPace8m(*this); }
 };
 
-class PeakPace10m : public PeakPace {
+class PeakPace10m : public RideMetricCopyable<PeakPace10m, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace10m)
     public:
         PeakPace10m()
@@ -287,7 +286,7 @@ class PeakPace10m : public PeakPace {
         RideMetric *clone() const { return new PeakPace10m(*this); }
 };
 
-class PeakPace20m : public PeakPace {
+class PeakPace20m : public RideMetricCopyable<PeakPace20m, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace20m)
     public:
         PeakPace20m()
@@ -308,7 +307,7 @@ class PeakPace20m : public PeakPace {
         RideMetric *clone() const { return new PeakPace20m(*this); }
 };
 
-class PeakPace30m : public PeakPace {
+class PeakPace30m : public RideMetricCopyable<PeakPace30m, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace30m)
     public:
         PeakPace30m()
@@ -329,7 +328,7 @@ class PeakPace30m : public PeakPace {
         RideMetric *clone() const { return new PeakPace30m(*this); }
 };
 
-class PeakPace60m : public PeakPace {
+class PeakPace60m : public RideMetricCopyable<PeakPace60m, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace60m)
     public:
         PeakPace60m()
@@ -350,7 +349,7 @@ class PeakPace60m : public PeakPace {
         RideMetric *clone() const { return new PeakPace60m(*this); }
 };
 
-class PeakPace90m : public PeakPace {
+class PeakPace90m : public RideMetricCopyable<PeakPace90m, PeakPace> {
     Q_DECLARE_TR_FUNCTIONS(PeakPace90m)
     public:
         PeakPace90m()
@@ -371,7 +370,7 @@ class PeakPace90m : public PeakPace {
         RideMetric *clone() const { return new PeakPace90m(*this); }
 };
 
-class PeakPaceSwim : public RideMetric {
+class PeakPaceSwim : public RideMetricCopyable<PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim)
     double pace;
     double secs;
@@ -381,6 +380,7 @@ class PeakPaceSwim : public RideMetric {
     PeakPaceSwim() : pace(0.0), secs(0.0)
     {
         setType(RideMetric::Low);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::kph);
     }
     // Swim Pace ordering is reversed
     bool isLowerBetter() const { return true; }
@@ -389,16 +389,15 @@ class PeakPaceSwim : public RideMetric {
         bool metricSwimPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
         return RideMetric::units(metricSwimPace);
     }
-    double value(bool) const {
-        bool metricSwimPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
-        return RideMetric::value(metricSwimPace);
+    bool metricUnits(bool) const {
+        return appsettings->value(NULL, GC_SWIMPACE, true).toBool();
     }
     QString toString(bool metric) const {
         return time_to_string(value(metric)*60, true);
     }
     void setSecs(double secs) { this->secs=secs; }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->isSwim) {
@@ -407,9 +406,8 @@ class PeakPaceSwim : public RideMetric {
             return;
         }
 
-        QList<AddIntervalDialog::AddedInterval> results;
-        AddIntervalDialog::findPeaks(item->context, true, item->ride(), spec, RideFile::kph, RideFile::original, secs, 1, results, "", "");
-        if (results.count() > 0 && results.first().avg > 0 && results.first().avg < 9) pace = 6.0 / results.first().avg;
+        PeakFinder::Peak peak = PeakFinder::peak(item, spec, RideFile::kph, secs);
+        if (peak.found && peak.avg > 0 && peak.avg < 9) pace = 6.0 / peak.avg;
         else pace = 0.0;
         setValue(pace);
     }
@@ -419,7 +417,7 @@ class PeakPaceSwim : public RideMetric {
     RideMetric *clone() const { return new PeakPaceSwim(*this); }
 };
 
-class PeakPaceSwim10s : public PeakPaceSwim {
+class PeakPaceSwim10s : public RideMetricCopyable<PeakPaceSwim10s, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim10s)
     public:
         PeakPaceSwim10s()
@@ -440,7 +438,7 @@ class PeakPaceSwim10s : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim10s(*this); }
 };
 
-class PeakPaceSwim15s : public PeakPaceSwim {
+class PeakPaceSwim15s : public RideMetricCopyable<PeakPaceSwim15s, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim15s)
     public:
         PeakPaceSwim15s()
@@ -461,7 +459,7 @@ class PeakPaceSwim15s : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim15s(*this); }
 };
 
-class PeakPaceSwim20s : public PeakPaceSwim {
+class PeakPaceSwim20s : public RideMetricCopyable<PeakPaceSwim20s, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim20s)
     public:
         PeakPaceSwim20s()
@@ -482,7 +480,7 @@ class PeakPaceSwim20s : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim20s(*this); }
 };
 
-class PeakPaceSwim30s : public PeakPaceSwim {
+class PeakPaceSwim30s : public RideMetricCopyable<PeakPaceSwim30s, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim30s)
     public:
         PeakPaceSwim30s()
@@ -503,7 +501,7 @@ class PeakPaceSwim30s : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim30s(*this); }
 };
 
-class PeakPaceSwim1m : public PeakPaceSwim {
+class PeakPaceSwim1m : public RideMetricCopyable<PeakPaceSwim1m, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim1m)
     public:
         PeakPaceSwim1m()
@@ -524,7 +522,7 @@ class PeakPaceSwim1m : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim1m(*this); }
 };
 
-class PeakPaceSwim2m : public PeakPaceSwim {
+class PeakPaceSwim2m : public RideMetricCopyable<PeakPaceSwim2m, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim2m)
     public:
         PeakPaceSwim2m()
@@ -545,7 +543,7 @@ class PeakPaceSwim2m : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim2m(*this); }
 };
 
-class PeakPaceSwim3m : public PeakPaceSwim {
+class PeakPaceSwim3m : public RideMetricCopyable<PeakPaceSwim3m, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim3m)
     public:
         PeakPaceSwim3m()
@@ -566,7 +564,7 @@ class PeakPaceSwim3m : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim3m(*this); }
 };
 
-class PeakPaceSwim5m : public PeakPaceSwim {
+class PeakPaceSwim5m : public RideMetricCopyable<PeakPaceSwim5m, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim5m)
     public:
         PeakPaceSwim5m()
@@ -587,7 +585,7 @@ class PeakPaceSwim5m : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim5m(*this); }
 };
 
-class PeakPaceSwim8m : public PeakPaceSwim {
+class PeakPaceSwim8m : public RideMetricCopyable<PeakPaceSwim8m, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim8m)
     public:
         PeakPaceSwim8m()
@@ -608,7 +606,7 @@ class PeakPaceSwim8m : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim8m(*this); }
 };
 
-class PeakPaceSwim10m : public PeakPaceSwim {
+class PeakPaceSwim10m : public RideMetricCopyable<PeakPaceSwim10m, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim10m)
     public:
         PeakPaceSwim10m()
@@ -629,7 +627,7 @@ class PeakPaceSwim10m : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim10m(*this); }
 };
 
-class PeakPaceSwim20m : public PeakPaceSwim {
+class PeakPaceSwim20m : public RideMetricCopyable<PeakPaceSwim20m, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim20m)
     public:
         PeakPaceSwim20m()
@@ -650,7 +648,7 @@ class PeakPaceSwim20m : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim20m(*this); }
 };
 
-class PeakPaceSwim30m : public PeakPaceSwim {
+class PeakPaceSwim30m : public RideMetricCopyable<PeakPaceSwim30m, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim30m)
     public:
         PeakPaceSwim30m()
@@ -671,7 +669,7 @@ class PeakPaceSwim30m : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim30m(*this); }
 };
 
-class PeakPaceSwim60m : public PeakPaceSwim {
+class PeakPaceSwim60m : public RideMetricCopyable<PeakPaceSwim60m, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim60m)
     public:
         PeakPaceSwim60m()
@@ -692,7 +690,7 @@ class PeakPaceSwim60m : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim60m(*this); }
 };
 
-class PeakPaceSwim90m : public PeakPaceSwim {
+class PeakPaceSwim90m : public RideMetricCopyable<PeakPaceSwim90m, PeakPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceSwim90m)
     public:
         PeakPaceSwim90m()
@@ -713,7 +711,7 @@ class PeakPaceSwim90m : public PeakPaceSwim {
         RideMetric *clone() const { return new PeakPaceSwim90m(*this); }
 };
 
-class BestTime : public RideMetric {
+class BestTime : public RideMetricCopyable<BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime)
     double meters;
     double secs;
@@ -723,6 +721,7 @@ class BestTime : public RideMetric {
     BestTime() : meters(0.0)
     {
         setType(RideMetric::Low);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::kph);
     }
     // BestTime ordering is reversed
     bool isLowerBetter() const { return true; }
@@ -731,7 +730,7 @@ class BestTime : public RideMetric {
     }
     void setMeters(double meters) { this->meters=meters; }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -740,9 +739,8 @@ class BestTime : public RideMetric {
             return;
         }
 
-        QList<AddIntervalDialog::AddedInterval> results;
-        AddIntervalDialog::findPeaks(item->context, false, item->ride(), spec, RideFile::kph, RideFile::original, meters, 1, results, "", "");
-        if (results.count() > 0) secs = results.first().stop - results.first().start;
+        PeakFinder::Peak peak = PeakFinder::peak(item, spec, RideFile::kph, meters, false);
+        if (peak.found) secs = peak.stop - peak.start;
         else secs = 0.0;
 
         setValue(secs / 60.0);
@@ -753,7 +751,7 @@ class BestTime : public RideMetric {
     RideMetric *clone() const { return new BestTime(*this); }
 };
 
-class BestTime50m : public BestTime {
+class BestTime50m : public RideMetricCopyable<BestTime50m, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime50m)
     public:
         BestTime50m()
@@ -772,7 +770,7 @@ class BestTime50m : public BestTime {
         RideMetric *clone() const { return new BestTime50m(*this); }
 };
 
-class BestTime100m : public BestTime {
+class BestTime100m : public RideMetricCopyable<BestTime100m, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime100m)
     public:
         BestTime100m()
@@ -791,7 +789,7 @@ class BestTime100m : public BestTime {
         RideMetric *clone() const { return new BestTime100m(*this); }
 };
 
-class BestTime200m : public BestTime {
+class BestTime200m : public RideMetricCopyable<BestTime200m, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime200m)
     public:
         BestTime200m()
@@ -810,7 +808,7 @@ class BestTime200m : public BestTime {
         RideMetric *clone() const { return new BestTime200m(*this); }
 };
 
-class BestTime400m : public BestTime {
+class BestTime400m : public RideMetricCopyable<BestTime400m, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime400m)
     public:
         BestTime400m()
@@ -829,7 +827,7 @@ class BestTime400m : public BestTime {
         RideMetric *clone() const { return new BestTime400m(*this); }
 };
 
-class BestTime500m : public BestTime {
+class BestTime500m : public RideMetricCopyable<BestTime500m, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime500m)
     public:
         BestTime500m()
@@ -848,7 +846,7 @@ class BestTime500m : public BestTime {
         RideMetric *clone() const { return new BestTime500m(*this); }
 };
 
-class BestTime800m : public BestTime {
+class BestTime800m : public RideMetricCopyable<BestTime800m, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime800m)
     public:
         BestTime800m()
@@ -867,7 +865,7 @@ class BestTime800m : public BestTime {
         RideMetric *clone() const { return new BestTime800m(*this); }
 };
 
-class BestTime1000m : public BestTime {
+class BestTime1000m : public RideMetricCopyable<BestTime1000m, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime1000m)
     public:
         BestTime1000m()
@@ -886,7 +884,7 @@ class BestTime1000m : public BestTime {
         RideMetric *clone() const { return new BestTime1000m(*this); }
 };
 
-class BestTime1500m : public BestTime {
+class BestTime1500m : public RideMetricCopyable<BestTime1500m, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime1500m)
     public:
         BestTime1500m()
@@ -905,7 +903,7 @@ class BestTime1500m : public BestTime {
         RideMetric *clone() const { return new BestTime1500m(*this); }
 };
 
-class BestTime2000m : public BestTime {
+class BestTime2000m : public RideMetricCopyable<BestTime2000m, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime2000m)
     public:
         BestTime2000m()
@@ -924,7 +922,7 @@ class BestTime2000m : public BestTime {
         RideMetric *clone() const { return new BestTime2000m(*this); }
 };
 
-class BestTime3000m : public BestTime {
+class BestTime3000m : public RideMetricCopyable<BestTime3000m, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime3000m)
     public:
         BestTime3000m()
@@ -943,7 +941,7 @@ class BestTime3000m : public BestTime {
         RideMetric *clone() const { return new BestTime3000m(*this); }
 };
 
-class BestTime4000m : public BestTime {
+class BestTime4000m : public RideMetricCopyable<BestTime4000m, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime4000m)
     public:
         BestTime4000m()
@@ -962,7 +960,7 @@ class BestTime4000m : public BestTime {
         RideMetric *clone() const { return new BestTime4000m(*this); }
 };
 
-class BestTime5000m : public BestTime {
+class BestTime5000m : public RideMetricCopyable<BestTime5000m, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime5000m)
     public:
         BestTime5000m()
@@ -981,7 +979,7 @@ class BestTime5000m : public BestTime {
         RideMetric *clone() const { return new BestTime5000m(*this); }
 };
 
-class BestTime10km : public BestTime {
+class BestTime10km : public RideMetricCopyable<BestTime10km, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime10km)
     public:
         BestTime10km()
@@ -1000,7 +998,7 @@ class BestTime10km : public BestTime {
         RideMetric *clone() const { return new BestTime10km(*this); }
 };
 
-class BestTime15km : public BestTime {
+class BestTime15km : public RideMetricCopyable<BestTime15km, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime15km)
     public:
         BestTime15km()
@@ -1019,7 +1017,7 @@ class BestTime15km : public BestTime {
         RideMetric *clone() const { return new BestTime15km(*this); }
 };
 
-class BestTime20km : public BestTime {
+class BestTime20km : public RideMetricCopyable<BestTime20km, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime20km)
     public:
         BestTime20km()
@@ -1038,7 +1036,7 @@ class BestTime20km : public BestTime {
         RideMetric *clone() const { return new BestTime20km(*this); }
 };
 
-class BestTimeHalfMarathon : public BestTime {
+class BestTimeHalfMarathon : public RideMetricCopyable<BestTimeHalfMarathon, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTimeHalfMarathon)
     public:
         BestTimeHalfMarathon()
@@ -1057,7 +1055,7 @@ class BestTimeHalfMarathon : public BestTime {
         RideMetric *clone() const { return new BestTimeHalfMarathon(*this); }
 };
 
-class BestTime30km : public BestTime {
+class BestTime30km : public RideMetricCopyable<BestTime30km, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime30km)
     public:
         BestTime30km()
@@ -1076,7 +1074,7 @@ class BestTime30km : public BestTime {
         RideMetric *clone() const { return new BestTime30km(*this); }
 };
 
-class BestTime40km : public BestTime {
+class BestTime40km : public RideMetricCopyable<BestTime40km, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTime40km)
     public:
         BestTime40km()
@@ -1095,7 +1093,7 @@ class BestTime40km : public BestTime {
         RideMetric *clone() const { return new BestTime40km(*this); }
 };
 
-class BestTimeMarathon : public BestTime {
+class BestTimeMarathon : public RideMetricCopyable<BestTimeMarathon, BestTime> {
     Q_DECLARE_TR_FUNCTIONS(BestTimeMarathon)
     public:
         BestTimeMarathon()
@@ -1114,7 +1112,7 @@ class BestTimeMarathon : public BestTime {
         RideMetric *clone() const { return new BestTimeMarathon(*this); }
 };
 
-class PeakPaceHr : public RideMetric {
+class PeakPaceHr : public RideMetricCopyable<PeakPaceHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceHr)
 
     double hr;
@@ -1125,10 +1123,11 @@ class PeakPaceHr : public RideMetric {
     PeakPaceHr() : hr(0.0), secs(0.0)
     {
         setType(RideMetric::Peak);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::hr << RideFile::kph);
     }
     void setSecs(double secs) { this->secs=secs; }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples or not a run nor a swim
         if (spec.isEmpty(item->ride()) || !(item->isRun || item->isSwim)) {
@@ -1138,15 +1137,14 @@ class PeakPaceHr : public RideMetric {
         }
 
         // find peak pace interval
-        QList<AddIntervalDialog::AddedInterval> results;
-        AddIntervalDialog::findPeaks(item->context, true, item->ride(), spec, RideFile::kph, RideFile::original, secs, 1, results, "", "");
+        PeakFinder::Peak peak = PeakFinder::peak(item, spec, RideFile::kph, secs);
 
         // work out average hr during that interval
-        if (results.count() > 0) {
+        if (peak.found) {
 
             // start and stop is in seconds within the ride
-            double start = results.first().start;
-            double stop = results.first().stop;
+            double start = peak.start;
+            double stop = peak.stop;
             int points = 0;
 
             RideFileIterator it(item->ride(), spec);
@@ -1167,7 +1165,7 @@ class PeakPaceHr : public RideMetric {
     RideMetric *clone() const { return new PeakPaceHr(*this); }
 };
 
-class PeakPaceHr1m : public PeakPaceHr {
+class PeakPaceHr1m : public RideMetricCopyable<PeakPaceHr1m, PeakPaceHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceHr1m)
 
     public:
@@ -1188,7 +1186,7 @@ class PeakPaceHr1m : public PeakPaceHr {
         RideMetric *clone() const { return new PeakPaceHr1m(*this); }
 };
 
-class PeakPaceHr5m : public PeakPaceHr {
+class PeakPaceHr5m : public RideMetricCopyable<PeakPaceHr5m, PeakPaceHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceHr5m)
 
     public:
@@ -1209,7 +1207,7 @@ class PeakPaceHr5m : public PeakPaceHr {
         RideMetric *clone() const { return new PeakPaceHr5m(*this); }
 };
 
-class PeakPaceHr10m : public PeakPaceHr {
+class PeakPaceHr10m : public RideMetricCopyable<PeakPaceHr10m, PeakPaceHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceHr10m)
 
     public:
@@ -1230,7 +1228,7 @@ class PeakPaceHr10m : public PeakPaceHr {
         RideMetric *clone() const { return new PeakPaceHr10m(*this); }
 };
 
-class PeakPaceHr20m : public PeakPaceHr {
+class PeakPaceHr20m : public RideMetricCopyable<PeakPaceHr20m, PeakPaceHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceHr20m)
 
     public:
@@ -1251,7 +1249,7 @@ class PeakPaceHr20m : public PeakPaceHr {
         RideMetric *clone() const { return new PeakPaceHr20m(*this); }
 };
 
-class PeakPaceHr30m : public PeakPaceHr {
+class PeakPaceHr30m : public RideMetricCopyable<PeakPaceHr30m, PeakPaceHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceHr30m)
 
     public:
@@ -1272,7 +1270,7 @@ class PeakPaceHr30m : public PeakPaceHr {
         RideMetric *clone() const { return new PeakPaceHr30m(*this); }
 };
 
-class PeakPaceHr60m : public PeakPaceHr {
+class PeakPaceHr60m : public RideMetricCopyable<PeakPaceHr60m, PeakPaceHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPaceHr30m)
 
     public:
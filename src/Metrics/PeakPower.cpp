@@ -18,7 +18,7 @@
 
 #include "RideMetric.h"
 #include "RideItem.h"
-#include "AddIntervalDialog.h"
+#include "PeakFinder.h"
 #include "Context.h"
 #include "Athlete.h"
 #include "Specification.h"
@@ -26,7 +26,7 @@
 #include <cmath>
 #include <QApplication>
 
-class PeakPercent : public RideMetric {
+class PeakPercent : public RideMetricCopyable<PeakPercent> {
 
     Q_DECLARE_TR_FUNCTIONS(PeakPercent)
     double maxp;
@@ -39,6 +39,8 @@ class PeakPercent : public RideMetric {
         setType(RideMetric::Average);
         setSymbol("peak_percent");
         setInternalName("MMP Percentage");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     void initialize ()
     {
@@ -51,7 +53,7 @@ class PeakPercent : public RideMetric {
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("P"); }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // no ride or no samples
         if (!item->ride()->areDataPresent()->watts) {
@@ -96,7 +98,7 @@ class PeakPercent : public RideMetric {
     RideMetric *clone() const { return new PeakPercent(*this); }
 };
 
-class PowerZone : public RideMetric {
+class PowerZone : public RideMetricCopyable<PowerZone> {
 
     Q_DECLARE_TR_FUNCTIONS(PowerZone)
     double maxp;
@@ -109,6 +111,8 @@ class PowerZone : public RideMetric {
         setType(RideMetric::Average);
         setSymbol("power_zone");
         setInternalName("Power Zone");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     void initialize ()
     {
@@ -126,7 +130,7 @@ class PowerZone : public RideMetric {
 
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("P"); }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // no zones
         const Zones* zones = item->context->athlete->zones(item->isRun);
@@ -170,7 +174,7 @@ class PowerZone : public RideMetric {
     RideMetric *clone() const { return new PowerZone(*this); }
 };
 
-class FatigueIndex : public RideMetric {
+class FatigueIndex : public RideMetricCopyable<FatigueIndex> {
     Q_DECLARE_TR_FUNCTIONS(FatigueIndex)
     double maxp;
     double minp;
@@ -182,6 +186,7 @@ class FatigueIndex : public RideMetric {
         setType(RideMetric::Average);
         setSymbol("power_fatigue_index");
         setInternalName("Fatigue Index");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
     }
     void initialize ()
     {
@@ -192,7 +197,7 @@ class FatigueIndex : public RideMetric {
         setDescription(tr("Fatigue Index is power decay from Max Power to Min Power as a percent of Max Power."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->watts) {
@@ -225,7 +230,7 @@ class FatigueIndex : public RideMetric {
     RideMetric *clone() const { return new FatigueIndex(*this); }
 };
 
-class PacingIndex : public RideMetric {
+class PacingIndex : public RideMetricCopyable<PacingIndex> {
     Q_DECLARE_TR_FUNCTIONS(PacingIndex)
 
     double maxp;
@@ -238,6 +243,7 @@ class PacingIndex : public RideMetric {
         setType(RideMetric::Average);
         setSymbol("power_pacing_index");
         setInternalName("Pacing Index");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
     }
     void initialize ()
     {
@@ -248,7 +254,7 @@ class PacingIndex : public RideMetric {
         setDescription(tr("Pacing Index is Average Power as a percent of Maximal Power"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -275,7 +281,7 @@ class PacingIndex : public RideMetric {
     RideMetric *clone() const { return new PacingIndex(*this); }
 };
 
-class PeakPower : public RideMetric {
+class PeakPower : public RideMetricCopyable<PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower)
     double watts;
     double secs;
@@ -285,10 +291,11 @@ class PeakPower : public RideMetric {
     PeakPower() : watts(0.0), secs(0.0)
     {
         setType(RideMetric::Peak);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
     }
     void setSecs(double secs) { this->secs=secs; }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->watts) {
@@ -297,9 +304,8 @@ class PeakPower : public RideMetric {
             return;
         }
 
-        QList<AddIntervalDialog::AddedInterval> results;
-        AddIntervalDialog::findPeaks(item->context, true, item->ride(), spec, RideFile::watts, RideFile::original, secs, 1, results, "", "");
-        if (results.count() > 0 && results.first().avg < 3000) watts = results.first().avg;
+        PeakFinder::Peak peak = PeakFinder::peak(item, spec, RideFile::watts, secs);
+        if (peak.found && peak.avg < 3000) watts = peak.avg;
         else watts = 0.0;
 
         setValue(watts);
@@ -309,7 +315,7 @@ class PeakPower : public RideMetric {
     RideMetric *clone() const { return new PeakPower(*this); }
 };
 
-class PeakPower60m : public PeakPower {
+class PeakPower60m : public RideMetricCopyable<PeakPower60m, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower60m)
     public:
         PeakPower60m()
@@ -328,7 +334,7 @@ class PeakPower60m : public PeakPower {
         RideMetric *clone() const { return new PeakPower60m(*this); }
 };
 
-class PeakPower1s : public PeakPower {
+class PeakPower1s : public RideMetricCopyable<PeakPower1s, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower1s)
     public:
         PeakPower1s()
@@ -347,7 +353,7 @@ class PeakPower1s : public PeakPower {
         RideMetric *clone() const { return new PeakPower1s(*this); }
 };
 
-class PeakPower5s : public PeakPower {
+class PeakPower5s : public RideMetricCopyable<PeakPower5s, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower5s)
     public:
         PeakPower5s()
@@ -366,7 +372,7 @@ class PeakPower5s : public PeakPower {
         RideMetric *clone() const { return new PeakPower5s(*this); }
 };
 
-class PeakPower10s : public PeakPower {
+class PeakPower10s : public RideMetricCopyable<PeakPower10s, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower10s)
     public:
         PeakPower10s()
@@ -385,7 +391,7 @@ class PeakPower10s : public PeakPower {
         RideMetric *clone() const { return new PeakPower10s(*this); }
 };
 
-class PeakPower15s : public PeakPower {
+class PeakPower15s : public RideMetricCopyable<PeakPower15s, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower15s)
     public:
         PeakPower15s()
@@ -404,7 +410,7 @@ class PeakPower15s : public PeakPower {
         RideMetric *clone() const { return new PeakPower15s(*this); }
 };
 
-class PeakPower20s : public PeakPower {
+class PeakPower20s : public RideMetricCopyable<PeakPower20s, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower20s)
     public:
         PeakPower20s()
@@ -423,7 +429,7 @@ class PeakPower20s : public PeakPower {
         RideMetric *clone() const { return new PeakPower20s(*this); }
 };
 
-class PeakPower30s : public PeakPower {
+class PeakPower30s : public RideMetricCopyable<PeakPower30s, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower30s)
     public:
         PeakPower30s()
@@ -442,7 +448,7 @@ class PeakPower30s : public PeakPower {
         RideMetric *clone() const { return new PeakPower30s(*this); }
 };
 
-class PeakPower1m : public PeakPower {
+class PeakPower1m : public RideMetricCopyable<PeakPower1m, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower1m)
     public:
         PeakPower1m()
@@ -461,7 +467,7 @@ class PeakPower1m : public PeakPower {
         RideMetric *clone() const { return new PeakPower1m(*this); }
 };
 
-class PeakPower2m : public PeakPower {
+class PeakPower2m : public RideMetricCopyable<PeakPower2m, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower2m)
     public:
         PeakPower2m()
@@ -480,7 +486,7 @@ class PeakPower2m : public PeakPower {
         RideMetric *clone() const { return new PeakPower2m(*this); }
 };
 
-class PeakPower3m : public PeakPower {
+class PeakPower3m : public RideMetricCopyable<PeakPower3m, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower3m)
     public:
         PeakPower3m()
@@ -499,7 +505,7 @@ class PeakPower3m : public PeakPower {
         RideMetric *clone() const { return new PeakPower3m(*this); }
 };
 
-class PeakPower5m : public PeakPower {
+class PeakPower5m : public RideMetricCopyable<PeakPower5m, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower5m)
     public:
         PeakPower5m()
@@ -518,7 +524,7 @@ class PeakPower5m : public PeakPower {
         RideMetric *clone() const { return new PeakPower5m(*this); }
 };
 
-class PeakPower8m : public PeakPower {
+class PeakPower8m : public RideMetricCopyable<PeakPower8m, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower8m)
     public:
         PeakPower8m()
@@ -537,7 +543,7 @@ class PeakPower8m : public PeakPower {
         RideMetric *clone() const { return new PeakPower8m(*this); }
 };
 
-class PeakPower10m : public PeakPower {
+class PeakPower10m : public RideMetricCopyable<PeakPower10m, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower10m)
     public:
         PeakPower10m()
@@ -556,7 +562,7 @@ class PeakPower10m : public PeakPower {
         RideMetric *clone() const { return new PeakPower10m(*this); }
 };
 
-class PeakPower20m : public PeakPower {
+class PeakPower20m : public RideMetricCopyable<PeakPower20m, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower20m)
     public:
         PeakPower20m()
@@ -575,7 +581,7 @@ class PeakPower20m : public PeakPower {
         RideMetric *clone() const { return new PeakPower20m(*this); }
 };
 
-class PeakPower30m : public PeakPower {
+class PeakPower30m : public RideMetricCopyable<PeakPower30m, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower30m)
     public:
         PeakPower30m()
@@ -594,7 +600,7 @@ class PeakPower30m : public PeakPower {
         RideMetric *clone() const { return new PeakPower30m(*this); }
 };
 
-class PeakPower90m : public PeakPower {
+class PeakPower90m : public RideMetricCopyable<PeakPower90m, PeakPower> {
     Q_DECLARE_TR_FUNCTIONS(PeakPower90m)
     public:
         PeakPower90m()
@@ -613,7 +619,7 @@ class PeakPower90m : public PeakPower {
         RideMetric *clone() const { return new PeakPower90m(*this); }
 };
 
-class PeakPowerHr : public RideMetric {
+class PeakPowerHr : public RideMetricCopyable<PeakPowerHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPowerHr)
 
     double hr;
@@ -624,10 +630,11 @@ class PeakPowerHr : public RideMetric {
     PeakPowerHr() : hr(0.0), secs(0.0)
     {
         setType(RideMetric::Peak);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::hr << RideFile::watts);
     }
     void setSecs(double secs) { this->secs=secs; }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -637,15 +644,14 @@ class PeakPowerHr : public RideMetric {
         }
 
         // find peak power interval
-        QList<AddIntervalDialog::AddedInterval> results;
-        AddIntervalDialog::findPeaks(item->context, true, item->ride(), spec, RideFile::watts, RideFile::original, secs, 1, results, "", "");
+        PeakFinder::Peak peak = PeakFinder::peak(item, spec, RideFile::watts, secs);
 
         // work out average hr during that interval
-        if (results.count() > 0) {
+        if (peak.found) {
 
             // start and stop is in seconds within the ride
-            double start = results.first().start;
-            double stop = results.first().stop;
+            double start = peak.start;
+            double stop = peak.stop;
             int points = 0;
 
             RideFileIterator it(item->ride(), spec);
@@ -665,7 +671,7 @@ class PeakPowerHr : public RideMetric {
     RideMetric *clone() const { return new PeakPowerHr(*this); }
 };
 
-class PeakPowerHr1m : public PeakPowerHr {
+class PeakPowerHr1m : public RideMetricCopyable<PeakPowerHr1m, PeakPowerHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPowerHr1m)
 
     public:
@@ -686,7 +692,7 @@ class PeakPowerHr1m : public PeakPowerHr {
         RideMetric *clone() const { return new PeakPowerHr1m(*this); }
 };
 
-class PeakPowerHr5m : public PeakPowerHr {
+class PeakPowerHr5m : public RideMetricCopyable<PeakPowerHr5m, PeakPowerHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPowerHr5m)
 
     public:
@@ -707,7 +713,7 @@ class PeakPowerHr5m : public PeakPowerHr {
         RideMetric *clone() const { return new PeakPowerHr5m(*this); }
 };
 
-class PeakPowerHr10m : public PeakPowerHr {
+class PeakPowerHr10m : public RideMetricCopyable<PeakPowerHr10m, PeakPowerHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPowerHr10m)
 
     public:
@@ -728,7 +734,7 @@ class PeakPowerHr10m : public PeakPowerHr {
         RideMetric *clone() const { return new PeakPowerHr10m(*this); }
 };
 
-class PeakPowerHr20m : public PeakPowerHr {
+class PeakPowerHr20m : public RideMetricCopyable<PeakPowerHr20m, PeakPowerHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPowerHr20m)
 
     public:
@@ -749,7 +755,7 @@ class PeakPowerHr20m : public PeakPowerHr {
         RideMetric *clone() const { return new PeakPowerHr20m(*this); }
 };
 
-class PeakPowerHr30m : public PeakPowerHr {
+class PeakPowerHr30m : public RideMetricCopyable<PeakPowerHr30m, PeakPowerHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPowerHr30m)
 
     public:
@@ -771,7 +777,7 @@ class PeakPowerHr30m : public PeakPowerHr {
 };
 
 
-class PeakPowerHr60m : public PeakPowerHr {
+class PeakPowerHr60m : public RideMetricCopyable<PeakPowerHr60m, PeakPowerHr> {
     Q_DECLARE_TR_FUNCTIONS(PeakPowerHr60m)
 
     public:
@@ -17,6 +17,7 @@
  */
 
 #include "RideMetric.h"
+#include "RideMetricSweep.h"
 #include "RideItem.h"
 #include "IntervalItem.h"
 #include "Specification.h"
@@ -25,6 +26,10 @@
 #include "Zones.h"
 #include "HrZones.h"
 
+#include <QMutex>
+#include <QThreadStorage>
+#include <QScopedPointer>
+
 // DB Schema Version - YOU MUST UPDATE THIS IF THE SCHEMA VERSION CHANGES!!!
 // Schema version will change if a) the default metadata.xml is updated
 //                            or b) new metrics are added / old changed
@@ -171,28 +176,169 @@ RideMetric::userMetricFingerprint(QList<UserMetricSettings> these)
     return qChecksum(fingers.constData(), fingers.size());
 }
 
-QHash<QString,RideMetricPtr>
-RideMetric::computeMetrics(RideItem *item, Specification spec, const QStringList &metrics)
+//
+// The order to compute a set of metrics in is the same every time, so it
+// is worked out once and kept; the metrics and everything they depend on,
+// each after its dependencies, with the user metrics at the end since they
+// don't have explicit dependencies set, yet.
+//
+// The plans are kept for each set of metrics asked for, and thrown away
+// when metrics are added or removed (e.g. the user metrics change).
+//
+struct RideMetricStep {
+    const RideMetric *metric;   // the factory one, we clone it
+    const SweptRideMetric *swept; // or NULL if it isn't
+    QString symbol;
+    int index;                  // of the metric
+    QVector<QString> dependencies; // as declared, see RideMetricDeps::declared()
+    QVector<int> dependencyIndexes;
+    bool requested;             // in the results, or just a dependency
+    bool declaresInputs;
+    QList<RideFile::SeriesType> inputs;
+};
+
+struct RideMetricPlan {
+    QVector<RideMetricStep> steps;
+    bool user;                  // any user metrics
+    bool swept;                 // any swept metrics
+};
+
+static void
+addToPlan(const RideMetricFactory &factory, QString symbol, RideMetricPlan &plan, QHash<QString,int> &added)
 {
-    const RideMetricFactory &factory = RideMetricFactory::instance();
+    if (added.contains(symbol) || !factory.haveMetric(symbol)) return;
+    added.insert(symbol, -1); // in progress, stops a loop
+
+    foreach(QString dep, factory.dependencies(symbol))
+        addToPlan(factory, dep, plan, added);
+
+    RideMetricStep step;
+    step.metric = factory.rideMetric(symbol);
+    step.swept = dynamic_cast<const SweptRideMetric*>(step.metric);
+    step.symbol = symbol;
+    step.index = step.metric->index();
+    step.dependencies = factory.dependencies(symbol);
+    foreach(QString dep, step.dependencies) {
+        const RideMetric *m = factory.rideMetric(dep);
+        step.dependencyIndexes << (m ? m->index() : -1);
+    }
+    step.requested = false;
+    step.declaresInputs = step.metric->declaresInputs();
+    step.inputs = step.metric->inputs();
 
-    // generate worklist from metrics we know
-    // bear in mind this can change as users add
-    // and remove user metrics
-    // builtin User metrics are computed after builtins
-    // since they don't have explicit dependencies set, yet.
-    QStringList builtin;
-    QStringList user;
-    foreach(QString metric, metrics)
-        if (factory.haveMetric(metric)) {
-            if (factory.rideMetric(metric)->isUser())
-                user << metric;
-            else
-                builtin << metric;
+    added.insert(symbol, plan.steps.count());
+    plan.steps << step;
+    if (step.swept) plan.swept = true;
+}
+
+static QSharedPointer<RideMetricPlan>
+planFor(const RideMetricFactory &factory, const QStringList &metrics)
+{
+    static QMutex mutex;
+    static QHash<QString, QSharedPointer<RideMetricPlan> > plans;
+    static int generation = -1;
+
+    // nearly always all of them
+    QString key = &metrics == &factory.allMetrics() ? QString("*") : metrics.join(",");
+
+    QMutexLocker locker(&mutex);
+
+    if (generation != factory.generation()) {
+        plans.clear();
+        generation = factory.generation();
+    }
+
+    QSharedPointer<RideMetricPlan> plan = plans.value(key);
+    if (plan) return plan;
+
+    plan = QSharedPointer<RideMetricPlan>(new RideMetricPlan);
+    plan->user = false;
+    plan->swept = false;
+
+    // builtins first then user defined
+    QHash<QString,int> added;
+    foreach(QString symbol, metrics)
+        if (factory.haveMetric(symbol) && !factory.rideMetric(symbol)->isUser())
+            addToPlan(factory, symbol, *plan, added);
+
+    foreach(QString symbol, metrics)
+        if (factory.haveMetric(symbol) && factory.rideMetric(symbol)->isUser()) {
+            addToPlan(factory, symbol, *plan, added);
+            plan->user = true;
         }
 
-    // this is what we've completed as we go
-    QHash<QString,RideMetric*> done;
+    foreach(QString symbol, metrics)
+        if (added.value(symbol, -1) >= 0) plan->steps[added.value(symbol)].requested = true;
+
+    plans.insert(key, plan);
+    return plan;
+}
+
+//
+// Each thread keeps a clone of every metric it computes, and puts it back
+// as it was cloned with resetFrom() for the next ride or interval, rather
+// than cloning them all every time. A metric might compute metrics, so
+// there is a pool of them for each level of that.
+//
+struct RideMetricPool {
+    RideMetricPool() : generation(-1) {}
+    ~RideMetricPool() { qDeleteAll(metrics); }
+
+    int generation;               // of the factory they were cloned from
+    QVector<RideMetric*> metrics; // by index
+    RideMetricDeps done;          // computed so far
+};
+
+struct RideMetricWorkspace {
+    ~RideMetricWorkspace() { qDeleteAll(free); }
+    QList<RideMetricPool*> free;
+};
+static QThreadStorage<RideMetricWorkspace*> workspaces;
+
+static RideMetricPool *
+takePool(const RideMetricFactory &factory)
+{
+    if (!workspaces.hasLocalData()) workspaces.setLocalData(new RideMetricWorkspace);
+    RideMetricWorkspace *workspace = workspaces.localData();
+    RideMetricPool *pool = workspace->free.isEmpty() ? new RideMetricPool : workspace->free.takeLast();
+
+    // the same index may be a different metric now
+    if (pool->generation != factory.generation()) {
+        qDeleteAll(pool->metrics);
+        pool->metrics.fill(NULL, factory.metricCount());
+        pool->generation = factory.generation();
+    }
+    pool->done.clear();
+    return pool;
+}
+
+static void
+givePool(RideMetricPool *pool)
+{
+    workspaces.localData()->free << pool;
+}
+
+// ready to compute, as if just cloned from the factory's
+static RideMetric *
+pooled(RideMetricPool *pool, const RideMetricStep &step)
+{
+    if (step.index >= pool->metrics.count()) pool->metrics.resize(step.index + 1);
+
+    RideMetric *&m = pool->metrics[step.index];
+    if (m == NULL || !m->resetFrom(step.metric)) {
+        delete m;
+        m = step.metric->clone();
+    }
+    m->setValue(0.0);
+    m->setCount(0);
+    return m;
+}
+
+// work through the plan, the results are left in pool->done
+static void
+computePlan(RideItem *item, Specification spec, const RideMetricPlan &plan, RideMetricPool *pool)
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
 
     // resize the metric array in the interval if needed
     if (spec.interval() && spec.interval()->metrics().size() < factory.metricCount()) 
@@ -202,90 +348,158 @@ RideMetric::computeMetrics(RideItem *item, Specification spec, const QStringList
     if (!spec.interval() && item->metrics().size() < factory.metricCount())
         item->metrics().resize(factory.metricCount());
 
-    // working through the todo list...
-    while (!builtin.isEmpty() || !user.isEmpty()) {
+    // derived series are computed on demand so make sure
+    // the ones each metric reads from the data points are
+    RideFile *ride = item->ride(false);
+
+    // override the computed value if set by user, but not for intervals
+    RideFile *overrides = spec.interval() ? NULL : item->ride();
+    if (overrides && overrides->metricOverrides.isEmpty()) overrides = NULL;
+
+    // the metrics that only need totals, zone times and such over
+    // the samples have them gathered in a single pass up front
+    QScopedPointer<RideMetricSweep> sweep;
+    if (plan.swept) {
+        sweep.reset(new RideMetricSweep(item, spec));
+        foreach(const RideMetricStep &step, plan.steps)
+            if (step.swept) step.swept->accumulate(*sweep);
+        sweep->run();
+    }
 
-        // next one to do, builtins first then user defined
-        QString symbol = builtin.isEmpty() ? user.takeFirst() :
-                                             builtin.takeFirst();
+    // working through the plan, dependencies are always done first
+    for (int i=0; i<plan.steps.count(); i++) {
 
-        // doesn't exist !
-        if (!factory.haveMetric(symbol)) continue;
+        const RideMetricStep &step = plan.steps.at(i);
 
-        // does this one have any dependencies?
-        const QVector<QString> &deps = factory.dependencies(symbol);
+        // each thread has its own, so we remain thread safe
+        RideMetric *m = pooled(pool, step);
 
-        bool ready = true;
+        if (ride) {
+            if (step.declaresInputs) foreach(RideFile::SeriesType x, step.inputs) ride->deriveSeries(x);
+            else ride->recalculateDerivedSeries();
+        }
 
-        // if the dependencies aren't done yet add to the end of the list
-        foreach (QString dep, deps) {
-            if (!done.contains(dep)) {
-                ready = false;
-                if (!builtin.contains(dep))
-                    builtin.append(dep);
-            }
+        pool->done.declared(&step.dependencies, &step.dependencyIndexes);
+        if (step.swept) static_cast<SweptRideMetric*>(m)->computeSwept(*sweep, pool->done);
+        else m->compute(item, spec, pool->done);
+        pool->done.declared(NULL, NULL);
+
+        if (overrides && overrides->metricOverrides.contains(step.symbol))
+            m->override(overrides->metricOverrides.value(step.symbol));
+
+        // available to those that depend on it
+        pool->done.insert(m);
+
+        // put into value array too. user metrics will interrogate
+        // this for symbol values, rather than the metric pointer
+        // this is crucial, even though RideItem and IntervalItem both
+        // update their values directly. But only need to bother if the
+        // user has defined any local metrics.
+        if (plan.user) {
+            if (spec.interval()) spec.interval()->metrics()[m->index()] = m->value();
+            else item->metrics()[m->index()] = m->value();
         }
+    }
+}
 
-        // if all our depencies are computed we can do this one
-        if (ready) {
-
-            // we clone so we can remain thread safe
-            // do not be tempted to change this (!)
-            RideMetric *m = factory.newMetric(symbol);
-            m->setValue(0.0);
-            m->setCount(0);
-            m->compute(item, spec, done);
-
-            // override the computed value if set by user, but not for intervals
-            if (!spec.interval() && item->ride() && item->ride()->metricOverrides.contains(symbol))
-                m->override(item->ride()->metricOverrides.value(symbol));
-
-            // all computed add to the return list
-            done.insert(symbol, m);
-
-            // put into value array too. user metrics will interrogate
-            // this for symbol values, rather than the metric pointer
-            // this is crucial, even though RideItem and IntervalItem both
-            // update their values directly. But only need to bother if the
-            // user has defined any local metrics.
-            if (user.count()) {
-                if (spec.interval()) spec.interval()->metrics()[m->index()] = m->value();
-                else item->metrics()[m->index()] = m->value();
-            }
+QHash<QString,RideMetricPtr>
+RideMetric::computeMetrics(RideItem *item, Specification spec, const QStringList &metrics)
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
 
-        } else {
+    // generate worklist from metrics we know
+    // bear in mind this can change as users add
+    // and remove user metrics
+    QSharedPointer<RideMetricPlan> plan = planFor(factory, metrics);
 
-            // we need to wait for our dependencies so add
-            // to the back of the list 
-            if (!builtin.contains(symbol))
-                builtin.append(symbol);
-        }
-    }
+    RideMetricPool *pool = takePool(factory);
+    computePlan(item, spec, *plan, pool);
 
-    // lets prepate the results using a shared pointer
-    // which is deleted when reference count 0 and goes out of scope
+    // the pool keeps its own, so those asked for are copied
     QHash<QString,RideMetricPtr> result;
-    foreach (QString symbol, metrics) {
-        if (factory.haveMetric(symbol)) {
-            result.insert(symbol, QSharedPointer<RideMetric>(done.value(symbol)));
-            done.remove(symbol);
+    foreach(const RideMetricStep &step, plan->steps)
+        if (step.requested) result.insert(step.symbol, RideMetricPtr(pool->done.at(step.index)->clone()));
+
+    // and we're done
+    givePool(pool);
+    return result;
+}
+
+void
+RideMetric::computeMetrics(RideItem *item, Specification spec, const QStringList &metrics,
+                           QVector<double> &values, QVector<double> &counts,
+                           QMap<int,double> &stdmeans, QMap<int,double> &stdvariances)
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+    QSharedPointer<RideMetricPlan> plan = planFor(factory, metrics);
+
+    RideMetricPool *pool = takePool(factory);
+    computePlan(item, spec, *plan, pool);
+
+    // straight from the pool, nothing is copied
+    if (values.size() < factory.metricCount()) values.resize(factory.metricCount());
+    if (counts.size() < factory.metricCount()) counts.resize(factory.metricCount());
+    foreach(const RideMetricStep &step, plan->steps) {
+        if (!step.requested) continue;
+
+        RideMetric *m = pool->done.at(step.index);
+        values[step.index] = m->value();
+        counts[step.index] = m->count();
+        double stdmean = m->stdmean();
+        double stdvariance = m->stdvariance();
+        if (stdmean || stdvariance) {
+            stdmeans.insert(step.index, stdmean);
+            stdvariances.insert(step.index, stdvariance);
         }
     }
 
-    // delete the cloned metrics, no memory leak here :)
-    foreach (QString symbol, done.keys())
-        delete done.value(symbol);
+    givePool(pool);
+}
 
-    // and we're done
-    return result;
+RideMetric *
+RideMetricDeps::value(const char *symbol) const
+{
+    if (names) {
+        QLatin1String name(symbol);
+        for (int i=0; i<names->count(); i++)
+            if (names->at(i) == name) return at(indexes->at(i));
+    }
+    return value(QString(symbol));
+}
+
+RideMetric *
+RideMetricDeps::value(const QString &symbol) const
+{
+    if (names) {
+        int i = names->indexOf(symbol);
+        if (i >= 0) return at(indexes->at(i));
+    }
+    const RideMetric *m = RideMetricFactory::instance().rideMetric(symbol);
+    return m ? at(m->index()) : NULL;
+}
+
+void
+RideMetricDeps::insert(RideMetric *metric)
+{
+    int index = metric->index();
+    if (index >= metrics.count()) metrics.resize(index + 1);
+    if (metrics[index] == NULL) set << index;
+    metrics[index] = metric;
+}
+
+void
+RideMetricDeps::clear()
+{
+    foreach(int index, set) metrics[index] = NULL;
+    set.clear();
 }
 
 double 
-RideMetric::getForSymbol(QString symbol, const QHash<QString,RideMetric*> *p)
+RideMetric::getForSymbol(QString symbol, const RideMetricDeps *p)
 {
     if (p == NULL ) return RideFile::NIL;
 
-    RideMetric *m=p->value(symbol, NULL);
+    RideMetric *m=p->value(symbol);
 
     if (m == NULL) return RideFile::NIL;
 
@@ -293,6 +507,158 @@ RideMetric::getForSymbol(QString symbol, const QHash<QString,RideMetric*> *p)
     return m->value();
 }
 
+bool
+RideMetric::inputsFor(const QStringList &metrics, QList<RideFile::SeriesType> &series, QStringList &xdata)
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+
+    series.clear();
+    xdata.clear();
+
+    // walk the metrics and their dependencies
+    QStringList todo = metrics;
+    QSet<QString> seen;
+    while (!todo.isEmpty()) {
+
+        QString symbol = todo.takeFirst();
+        if (seen.contains(symbol)) continue;
+        seen.insert(symbol);
+
+        const RideMetric *m = factory.rideMetric(symbol);
+        if (m == NULL) continue;
+
+        if (!m->declaresInputs()) return false;
+        foreach(QString name, m->xdataInputs())
+            if (!xdata.contains(name)) xdata << name;
+
+        // derived series are computed from the recorded ones
+        foreach(RideFile::SeriesType input, m->inputs())
+            foreach(RideFile::SeriesType recorded, RideFile::inputsFor(input))
+                if (!series.contains(recorded)) series << recorded;
+
+        foreach(QString dep, factory.dependencies(symbol)) todo << dep;
+    }
+    return true;
+}
+
+// the config a metric reads, also through the series it reads since
+// W'bal and TISS are computed with CP and W', and w/kg with the weight
+static int
+configReadBy(const RideMetric *m)
+{
+    int config = m->configInputs();
+    if (m->declaresInputs()) {
+        foreach(RideFile::SeriesType x, m->inputs()) {
+            switch (x) {
+            case RideFile::wbal:
+            case RideFile::wprime:
+            case RideFile::aTISS:
+            case RideFile::anTISS: config |= RideMetric::PowerZonesInput; break;
+            case RideFile::wattsKg:
+            case RideFile::aPowerKg: config |= RideMetric::WeightInput; break;
+            default: break;
+            }
+        }
+    }
+    return config;
+}
+
+static bool
+readsConfig(const RideMetricFactory &factory, QString symbol, int config, QHash<QString,bool> &known)
+{
+    QHash<QString,bool>::const_iterator it = known.constFind(symbol);
+    if (it != known.constEnd()) return it.value();
+    known.insert(symbol, false); // in progress, stops a loop
+
+    // user metrics can read anything
+    const RideMetric *m = factory.rideMetric(symbol);
+    bool reads = m && (m->isUser() || (configReadBy(m) & config));
+
+    foreach(QString dep, factory.dependencies(symbol))
+        if (!reads && readsConfig(factory, dep, config, known)) reads = true;
+
+    known.insert(symbol, reads);
+    return reads;
+}
+
+QStringList
+RideMetric::metricsReading(int config)
+{
+    static QMutex mutex;
+    static QHash<int, QStringList> reading;
+    static int generation = -1;
+
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+
+    QMutexLocker locker(&mutex);
+
+    if (generation != factory.generation()) {
+        reading.clear();
+        generation = factory.generation();
+    }
+
+    QHash<int, QStringList>::const_iterator it = reading.constFind(config);
+    if (it != reading.constEnd()) return it.value();
+
+    QStringList metrics;
+    QHash<QString,bool> known;
+    foreach(QString symbol, factory.allMetrics())
+        if (readsConfig(factory, symbol, config, known)) metrics << symbol;
+
+    reading.insert(config, metrics);
+    return metrics;
+}
+
+int MetricHandle::units = 0;
+
+MetricHandle::MetricHandle() :
+    useMetricUnits_(true), metric_(NULL), index_(-1), generation_(-1), units_(-1), conversion_(1), conversionSum_(0)
+{
+}
+
+MetricHandle::MetricHandle(QString symbol, bool useMetricUnits) :
+    symbol_(symbol), useMetricUnits_(useMetricUnits)
+{
+    resolve(RideMetricFactory::instance().rideMetric(symbol));
+}
+
+MetricHandle::MetricHandle(const RideMetric *metric, bool useMetricUnits) :
+    symbol_(metric ? metric->symbol() : QString()), useMetricUnits_(useMetricUnits)
+{
+    resolve(metric);
+}
+
+void
+MetricHandle::resolve(const RideMetric *metric)
+{
+    metric_ = metric;
+    index_ = metric ? metric->index() : -1;
+    generation_ = RideMetricFactory::instance().generation();
+    units_ = units;
+
+    // stored values are metric, converted as value(useMetricUnits) would,
+    // pace metrics follow the pace setting whatever units are asked for
+    if (metric && !metric->metricUnits(useMetricUnits_)) {
+        conversion_ = metric->conversion();
+        conversionSum_ = metric->conversionSum();
+    } else {
+        conversion_ = 1;
+        conversionSum_ = 0;
+    }
+}
+
+bool
+MetricHandle::isStale() const
+{
+    return generation_ != RideMetricFactory::instance().generation() || units_ != units;
+}
+
+void
+MetricHandle::unitsChanged()
+{
+    units++;
+}
+
 QString 
 RideMetric::toString(bool useMetricUnits) const
 {
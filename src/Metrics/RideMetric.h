@@ -49,6 +49,47 @@ extern quint16 UserMetricSchemaVersion;
 
 typedef QSharedPointer<RideMetric> RideMetricPtr;
 
+//
+// The metrics computed so far, passed to each metric as it is computed
+// so it can use those it depends upon. They are held by RideMetric::index()
+// rather than in a hash, so they can be emptied and filled again for every
+// ride and interval without rehashing, and looked up directly by index.
+// Looking up by symbol finds it amongst the dependencies declared by the
+// metric being computed, whose indexes were found once for the plan, and
+// only goes through the factory for one that wasn't declared.
+//
+class RideMetricDeps {
+
+    public:
+        RideMetricDeps() : names(NULL), indexes(NULL) {}
+
+        // computed ones only, one not computed is NULL
+        bool contains(const char *symbol) const { return value(symbol) != NULL; }
+        bool contains(const QString &symbol) const { return value(symbol) != NULL; }
+        RideMetric *value(const char *symbol) const; // a literal, not converted to a QString
+        RideMetric *value(const QString &symbol) const;
+        RideMetric *at(int index) const { return index >= 0 && index < metrics.count() ? metrics.at(index) : NULL; }
+
+        // the dependencies of the metric being computed, and their indexes
+        void declared(const QVector<QString> *names, const QVector<int> *indexes) {
+            this->names = names;
+            this->indexes = indexes;
+        }
+
+        int count() const { return set.count(); }
+        bool isEmpty() const { return set.isEmpty(); }
+
+        void insert(RideMetric *metric);
+        void clear(); // keeps the space
+
+    private:
+        QVector<RideMetric*> metrics; // by index
+        QVector<int> set;             // the indexes that aren't NULL
+
+        const QVector<QString> *names; // see declared()
+        const QVector<int> *indexes;
+};
+
 class RideMetric {
     Q_DECLARE_TR_FUNCTIONS(RideMetric)
 
@@ -88,6 +129,8 @@ public:
         count_ = 1;
         value_ = 0.0;
         index_ = -1;
+        declaresInputs_ = false;
+        configInputs_ = 0;
     }
     virtual ~RideMetric() {}
 
@@ -137,8 +180,12 @@ public:
     // value of a RideMetric.
     virtual int precision() const { return precision_; }
 
+    // The units value() is in when metric units are or aren't wanted,
+    // e.g. paces follow their own setting instead.
+    virtual bool metricUnits(bool metric) const { return metric; }
+
     // The actual value of this ride metric, in the units above.
-    virtual double value(bool metric) const { return metric ? value_ : (value_ * conversion_ + conversionSum_); }
+    virtual double value(bool metric) const { return metricUnits(metric) ? value_ : (value_ * conversion_ + conversionSum_); }
     virtual double value(double v, bool metric) const { return metric ? v : (v * conversion_ + conversionSum_); }
 
     // The internal value of this ride metric, useful to cache and then setValue.
@@ -157,13 +204,32 @@ public:
     // is this metric relevant
     virtual bool isRelevantForRide(const RideItem *) const { return true; }
 
+    // The series and XDATA compute() reads from the ride; secs, km and
+    // interval are always available. Metrics that don't declare their
+    // inputs are given the whole ride.
+    virtual bool declaresInputs() const { return declaresInputs_; }
+    virtual QList<RideFile::SeriesType> inputs() const { return inputs_; }
+    virtual QStringList xdataInputs() const { return xdataInputs_; }
+
+    // The athlete config compute() reads besides the ride, so when some of
+    // it changes only the metrics that read it are computed again. CP, W'
+    // and FTP come with the power zones. Metrics that don't declare their
+    // inputs read all of it.
+    enum configinput { PowerZonesInput=0x01, HrZonesInput=0x02, PaceZonesInput=0x04,
+                       WeightInput=0x08, HrvInput=0x10, RoutesInput=0x20, DiscoveryInput=0x40,
+                       AllConfigInputs=0x7f };
+    typedef enum configinput ConfigInput;
+    static const int ConfigInputCount = 7;
+
+    virtual int configInputs() const { return declaresInputs_ ? configInputs_ : AllConfigInputs; }
+
     // Factor to multiple value to convert from metric to imperial
     virtual double conversion() const { return conversion_; }
     // And sum for example Fahrenheit from CentigradE
     virtual double conversionSum() const { return conversionSum_; }
 
     // Compute the ride metric from a file.
-    virtual void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &deps) = 0;
+    virtual void compute(RideItem *item, Specification spec, const RideMetricDeps &deps) = 0;
 
     // is a time value, ie. render as hh:mm:ss
     virtual bool isTime() const { return false; }
@@ -217,11 +283,31 @@ public:
     // members from source and reference count them to be space efficient
     virtual RideMetric *clone() const { return NULL; }
 
+    // and computeMetrics() keeps the clones for each thread, this puts one
+    // back as it was when it was cloned from the factory's, returns false
+    // if it can't, then it is cloned afresh each time
+    virtual bool resetFrom(const RideMetric *) { return false; }
+
     static QHash<QString,RideMetricPtr>
     computeMetrics(RideItem *item, Specification spec, const QStringList &metrics);
 
+    // the same, but just the values of those asked for, set at
+    // RideMetric::index() in the arrays
+    static void
+    computeMetrics(RideItem *item, Specification spec, const QStringList &metrics,
+                   QVector<double> &values, QVector<double> &counts,
+                   QMap<int,double> &stdmeans, QMap<int,double> &stdvariances);
+
     // get the value for metric m from precomputed values stored at p
-    static double getForSymbol(QString m, const QHash<QString,RideMetric*> *p);
+    static double getForSymbol(QString m, const RideMetricDeps *p);
+
+    // the series needed to compute the metrics (and their dependencies)
+    // returns false if any of them need the entire ride
+    static bool inputsFor(const QStringList &metrics, QList<RideFile::SeriesType> &series, QStringList &xdata);
+
+    // the metrics that read any of the config, themselves or through
+    // the series or metrics they depend upon, and all the user metrics
+    static QStringList metricsReading(int config);
 
     // generate a CRC based upon the user metric settings
     // using the currently loaded _userMetrics
@@ -240,6 +326,9 @@ public:
     void setDescription(QString x) { description_ = x; }
     void setSymbol(QString x) { symbol_ = x; }
     void setType(MetricType x) { type_ = x; }
+    void setInputs(QList<RideFile::SeriesType> x) { inputs_ = x; declaresInputs_ = true; }
+    void setXDataInputs(QStringList x) { xdataInputs_ = x; }
+    void setConfigInputs(int x) { configInputs_ = x; }
 
     protected:
         double  value_,
@@ -251,6 +340,27 @@ public:
         QString metricUnits_, imperialUnits_;
         QString name_, symbol_, internalName_, description_;
         MetricType type_;
+
+        QList<RideFile::SeriesType> inputs_;
+        QStringList xdataInputs_;
+        bool declaresInputs_;
+        int configInputs_;
+};
+
+//
+// Metrics derive from this rather than RideMetric, or whichever metric
+// they extend, e.g. RideMetricCopyable<PeakPower1s, PeakPower>, so
+// resetFrom() is implemented once by copying the metric it was cloned
+// from over the one being reused.
+//
+template <class T, class Base = RideMetric>
+class RideMetricCopyable : public Base {
+
+    public:
+        bool resetFrom(const RideMetric *from) {
+            *static_cast<T*>(this) = *static_cast<const T*>(from);
+            return true;
+        }
 };
 
 
@@ -308,13 +418,17 @@ public:
     bool isRelevantForRide(const RideItem *) const; 
 
     // Compute the ride metric from a file.
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &deps);
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &deps);
 
     // is a time value, ie. render as hh:mm:ss
     bool isTime() const;
 
     RideMetric *clone() const; 
 
+    // the metrics their programs use are looked up again once
+    // they have all been added, see DataFilter::resolveMetrics()
+    static void resolveMetrics();
+
     // WE DO NOT REIMPLEMENT THE STANDARD toString() METHOD
     // virtual QString toString(bool useMetricUnits) const;
 
@@ -345,6 +459,49 @@ public:
 
 };
 
+//
+// A metric looked up once for a query, so the values of many rides can
+// be read by index without looking the symbol up for each of them, see
+// RideItem::getForSymbol(). It converts stored values, which are always
+// in metric units, to the units wanted itself, rather than by setting
+// the value of the shared metric and asking for it back.
+//
+// Metrics added or removed, or the units or pace settings changing,
+// after it was resolved make it stale.
+//
+class MetricHandle {
+
+    public:
+        MetricHandle(); // no metric
+        explicit MetricHandle(QString symbol, bool useMetricUnits=true);
+        explicit MetricHandle(const RideMetric *metric, bool useMetricUnits=true);
+
+        bool isValid() const { return metric_ != NULL; }
+        bool isStale() const; // resolve again by symbol
+
+        // units or pace settings changed, all handles are stale
+        static void unitsChanged();
+
+        QString symbol() const { return symbol_; }
+        bool useMetricUnits() const { return useMetricUnits_; }
+        const RideMetric *metric() const { return metric_; }
+        int index() const { return index_; }
+
+        // stored value in the units wanted
+        double value(double stored) const { return stored * conversion_ + conversionSum_; }
+
+    private:
+        void resolve(const RideMetric *metric);
+
+        QString symbol_;
+        bool useMetricUnits_;
+        const RideMetric *metric_;
+        int index_, generation_, units_;
+        double conversion_, conversionSum_;
+
+        static int units; // bumped by unitsChanged()
+};
+
 class RideMetricFactory {
 
     static RideMetricFactory *_instance;
@@ -355,8 +512,9 @@ class RideMetricFactory {
     QHash<QString,RideMetric*> metrics;
     QHash<QString,QVector<QString>*> dependencyMap;
     bool dependenciesChecked;
+    int generation_;
 
-    RideMetricFactory() : dependenciesChecked(false) {}
+    RideMetricFactory() : dependenciesChecked(false), generation_(0) {}
     RideMetricFactory(const RideMetricFactory &other);
     RideMetricFactory &operator=(const RideMetricFactory &other);
 
@@ -381,6 +539,9 @@ class RideMetricFactory {
     }
 
     int metricCount() const { return metricNames.size(); }
+
+    // changes whenever metrics are added or removed
+    int generation() const { return generation_; }
     QHash<QString,RideMetric*> metricHash() const { return metrics; }
 
     void initialize() {
@@ -423,6 +584,7 @@ class RideMetricFactory {
                 metricNames.takeAt(firstUser);
                 metricTypes.remove(firstUser);
             }
+            generation_++;
         }
     }
 
@@ -434,6 +596,7 @@ class RideMetricFactory {
         metrics.insert(metric.symbol(), newMetric);
         metricNames.append(metric.symbol());
         metricTypes.append(metric.type());
+        generation_++;
         if (deps) {
             QVector<QString> *copy = new QVector<QString>;
             for (int i = 0; i < deps->size(); ++i)
@@ -0,0 +1,468 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideMetricSweep.h"
+#include "RideItem.h"
+#include "Context.h"
+#include "Athlete.h"
+#include "Zones.h"
+#include "HrZones.h"
+
+#include <cmath>
+#include <limits>
+
+// is the sample counted, as filtered and gated
+static inline bool
+counted(int filter, double v, RideFile::SeriesType gate, const double *g, int i)
+{
+    if (gate != RideFile::none && (g == NULL || g[i] == 0)) return false;
+
+    switch (filter) {
+    case RideMetricSweep::NonZero: return v != 0;
+    case RideMetricSweep::NonNegative: return v >= 0;
+    case RideMetricSweep::Positive: return v > 0;
+    default: return true;
+    }
+}
+
+RideMetricSweep::RideMetricSweep(RideItem *item, Specification spec) :
+    item_(item), ride_(item ? item->ride() : NULL), spec_(spec), start(-1), stop(-1)
+{
+    if (ride_ && ride_->dataPoints().count() > 0) {
+        RideFileIterator it(ride_, spec);
+        start = it.firstIndex();
+        stop = it.lastIndex();
+    }
+}
+
+quint64
+RideMetricSweep::key(int kind, int series, int a, int b, int c)
+{
+    return (quint64(kind) << 56) | (quint64(series & 0xff) << 48) | (quint64(a & 0xff) << 40) |
+           (quint64(b & 0xffffff) << 16) | quint64(c & 0xffff);
+}
+
+int
+RideMetricSweep::add(int kind, RideFile::SeriesType series, int a, int b, int c)
+{
+    quint64 k = key(kind, series, a, b, c);
+    QHash<quint64,int>::const_iterator it = index.constFind(k);
+    if (it != index.constEnd()) return it.value();
+
+    Accumulator acc;
+    acc.kind = kind;
+    acc.series = series;
+    acc.gate = RideFile::none;
+    acc.filter = All;
+    acc.samples = acc.power = 0;
+
+    index.insert(k, accumulators.count());
+    accumulators << acc;
+    return accumulators.count()-1;
+}
+
+const RideMetricSweep::Accumulator *
+RideMetricSweep::find(int kind, int series, int a, int b, int c) const
+{
+    QHash<quint64,int>::const_iterator it = index.constFind(key(kind, series, a, b, c));
+    return it == index.constEnd() ? NULL : &accumulators.at(it.value());
+}
+
+void
+RideMetricSweep::addStats(RideFile::SeriesType series, Filter filter, RideFile::SeriesType gate)
+{
+    Accumulator &a = accumulators[add(StatsKind, series, gate, filter, 0)];
+    a.filter = filter;
+    a.gate = gate;
+}
+
+void
+RideMetricSweep::addZones(RideFile::SeriesType series)
+{
+    add(ZonesKind, series, 0, 0, 0);
+}
+
+void
+RideMetricSweep::addWindow(RideFile::SeriesType series, int samples, int power)
+{
+    Accumulator &a = accumulators[add(WindowKind, series, 0, samples, power)];
+    a.samples = samples;
+    a.power = power;
+}
+
+const RideMetricSweep::Stats &
+RideMetricSweep::stats(RideFile::SeriesType series, Filter filter, RideFile::SeriesType gate) const
+{
+    static const Stats none;
+    const Accumulator *a = find(StatsKind, series, gate, filter, 0);
+    return a ? a->stats : none;
+}
+
+double
+RideMetricSweep::zoneSeconds(RideFile::SeriesType series, int zone) const
+{
+    const Accumulator *a = find(ZonesKind, series, 0, 0, 0);
+    return a && zone >= 0 && zone < a->seconds.count() ? a->seconds.at(zone) : 0;
+}
+
+const RideMetricSweep::Stats &
+RideMetricSweep::window(RideFile::SeriesType series, int samples, int power) const
+{
+    static const Stats none;
+    const Accumulator *a = find(WindowKind, series, 0, samples, power);
+    return a ? a->stats : none;
+}
+
+//
+// THE SWEEP
+//
+// What each accumulator reads, worked out before the pass
+struct SweepState {
+    const double *data, *gate;  // NULL if the series is missing, read as zero
+    const Zones *zones;
+    const HrZones *hrZones;
+    int range;
+    QVector<double> rolling;
+    int rindex;
+    double rsum;
+};
+
+void
+RideMetricSweep::run()
+{
+    if (isEmpty() || accumulators.isEmpty()) return;
+
+    // the intervals of a ride share indexes of its samples
+    RideMetricIndex *rideIndex = spec_.interval() ? item_->metricIndex() : NULL;
+
+    double secs = ride_->recIntSecs();
+    QVector<SweepState> state(accumulators.count());
+    QVector<int> walk; // the accumulators that walk the samples
+
+    for (int n=0; n<accumulators.count(); n++) {
+        Accumulator &a = accumulators[n];
+        SweepState &s = state[n];
+
+        if (rideIndex && a.kind == StatsKind) {
+            a.stats = rideIndex->stats(ride_, a.series, a.filter, a.gate, start, stop);
+            continue;
+        }
+        if (rideIndex && a.kind == ZonesKind) {
+            a.seconds = rideIndex->zoneSeconds(item_, a.series, start, stop);
+            continue;
+        }
+        walk << n;
+
+        RideFileSeries series = ride_->series(a.series);
+        s.data = series.count() > stop ? series.constData() : NULL;
+        s.gate = NULL;
+        if (a.gate != RideFile::none) {
+            RideFileSeries gate = ride_->series(a.gate);
+            s.gate = gate.count() > stop ? gate.constData() : NULL;
+        }
+
+        s.zones = NULL;
+        s.hrZones = NULL;
+        s.range = -1;
+        if (a.kind == ZonesKind) {
+            const Athlete *athlete = item_->context->athlete;
+            if (a.series == RideFile::watts && athlete->zones(item_->isRun) && item_->zoneRange >= 0) {
+                s.zones = athlete->zones(item_->isRun);
+                s.range = item_->zoneRange;
+                a.seconds.fill(0, s.zones->numZones(s.range));
+            }
+            if (a.series == RideFile::hr && athlete->hrZones(item_->isRun) && item_->hrZoneRange >= 0) {
+                s.hrZones = athlete->hrZones(item_->isRun);
+                s.range = item_->hrZoneRange;
+                a.seconds.fill(0, s.hrZones->numZones(s.range));
+            }
+        }
+
+        if (a.kind == WindowKind && a.samples > 0) s.rolling.fill(0, a.samples);
+        s.rindex = 0;
+        s.rsum = 0;
+    }
+
+    if (walk.isEmpty()) return;
+
+    // all of them in turn for each sample
+    for (int i=start; i<=stop; i++) {
+        for (int w=0; w<walk.count(); w++) {
+            int n = walk.at(w);
+            Accumulator &a = accumulators[n];
+            SweepState &s = state[n];
+            double v = s.data ? s.data[i] : 0;
+
+            switch (a.kind) {
+
+            case StatsKind:
+                {
+                    if (!counted(a.filter, v, a.gate, s.gate, i)) continue;
+
+                    Stats &st = a.stats;
+                    if (st.count == 0 || v < st.min) st.min = v;
+                    if (st.count == 0 || v > st.max) st.max = v;
+                    st.total += v;
+                    ++st.count;
+                }
+                break;
+
+            case ZonesKind:
+                {
+                    int zone = -1;
+                    if (s.zones) zone = s.zones->whichZone(s.range, v);
+                    else if (s.hrZones) zone = s.hrZones->whichZone(s.range, v);
+                    if (zone >= 0 && zone < a.seconds.count()) a.seconds[zone] += secs;
+                }
+                break;
+
+            case WindowKind:
+                {
+                    if (s.rolling.isEmpty()) continue;
+
+                    s.rsum += v;
+                    s.rsum -= s.rolling[s.rindex];
+                    s.rolling[s.rindex] = v;
+
+                    a.stats.total += pow(s.rsum / a.samples, a.power);
+                    ++a.stats.count;
+
+                    s.rindex = (s.rindex >= a.samples-1) ? 0 : s.rindex+1;
+                }
+                break;
+            }
+        }
+    }
+}
+
+void
+SweptRideMetric::compute(RideItem *item, Specification spec, const RideMetricDeps &deps)
+{
+    RideMetricSweep sweep(item, spec);
+    accumulate(sweep);
+    sweep.run();
+    computeSwept(sweep, deps);
+}
+
+//
+// RIDE INDEXES
+//
+static const int blockSize = 64;
+
+static int
+log2floor(int n)
+{
+    int k = 0;
+    while ((2 << k) <= n) k++;
+    return k;
+}
+
+RideMetricIndex::~RideMetricIndex()
+{
+    qDeleteAll(statsIndexes);
+    qDeleteAll(zonesIndexes);
+}
+
+RideMetricSweep::Stats
+RideMetricIndex::stats(RideFile *ride, RideFile::SeriesType series, int filter,
+                       RideFile::SeriesType gate, int start, int stop)
+{
+    RideMetricSweep::Stats returning;
+
+    int n = ride->dataPoints().count();
+    if (start < 0 || stop < start || stop >= n) return returning;
+
+    QMutexLocker locker(&mutex);
+
+    // columns are built by series() so get them before the revisions
+    RideFileSeries column = ride->series(series);
+    const double *d = column.count() == n ? column.constData() : NULL;
+    const double *g = NULL;
+    int gateRevision = -1;
+    if (gate != RideFile::none) {
+        RideFileSeries gating = ride->series(gate);
+        g = gating.count() == n ? gating.constData() : NULL;
+        gateRevision = ride->seriesRevision(gate);
+    }
+    int revision = ride->seriesRevision(series);
+
+    quint64 key = (quint64(series) << 16) | (quint64(filter) << 8) | quint64(gate);
+    StatsIndex *index = statsIndexes.value(key, NULL);
+
+    if (index == NULL || index->revision != revision || index->gateRevision != gateRevision ||
+        index->count.count() != n+1) {
+
+        if (index == NULL) {
+            index = new StatsIndex;
+            statsIndexes.insert(key, index);
+        }
+        index->revision = revision;
+        index->gateRevision = gateRevision;
+
+        int blocks = (n + blockSize - 1) / blockSize;
+        index->count.resize(n+1);
+        index->total.resize(n+1);
+        index->min.resize(log2floor(blocks) + 1);
+        index->max.resize(index->min.count());
+        index->min[0].fill(std::numeric_limits<double>::infinity(), blocks);
+        index->max[0].fill(-std::numeric_limits<double>::infinity(), blocks);
+
+        int *count = index->count.data();
+        double *total = index->total.data();
+        double *bmin = index->min[0].data();
+        double *bmax = index->max[0].data();
+
+        count[0] = 0;
+        total[0] = 0;
+        for (int i=0; i<n; i++) {
+            double v = d ? d[i] : 0;
+            bool in = counted(filter, v, gate, g, i);
+
+            count[i+1] = count[i] + (in ? 1 : 0);
+            total[i+1] = total[i] + (in ? v : 0);
+            if (in) {
+                int b = i / blockSize;
+                if (v < bmin[b]) bmin[b] = v;
+                if (v > bmax[b]) bmax[b] = v;
+            }
+        }
+
+        // each level covers twice as many blocks as the last
+        for (int k=1; k<index->min.count(); k++) {
+            int span = 1 << k, half = span >> 1;
+            int entries = blocks - span + 1;
+            index->min[k].resize(entries);
+            index->max[k].resize(entries);
+            for (int b=0; b<entries; b++) {
+                index->min[k][b] = qMin(index->min[k-1][b], index->min[k-1][b+half]);
+                index->max[k][b] = qMax(index->max[k-1][b], index->max[k-1][b+half]);
+            }
+        }
+    }
+
+    const int *count = index->count.constData();
+    const double *total = index->total.constData();
+
+    returning.count = count[stop+1] - count[start];
+    returning.total = total[stop+1] - total[start];
+    if (returning.count == 0) return returning;
+
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    // the whole blocks from the table, the part blocks at
+    // either end from the samples that were counted
+    int first = start / blockSize, last = stop / blockSize;
+    int from = first + 1, to = last - 1;
+    if (first == last) from = to + 1;
+
+    if (from <= to) {
+        int k = log2floor(to - from + 1);
+        min = qMin(index->min[k][from], index->min[k][to - (1 << k) + 1]);
+        max = qMax(index->max[k][from], index->max[k][to - (1 << k) + 1]);
+    }
+
+    int partEnd = first == last ? stop : (first + 1) * blockSize - 1;
+    for (int i=start; i<=partEnd; i++) {
+        if (count[i+1] == count[i]) continue;
+        double v = d ? d[i] : 0;
+        if (v < min) min = v;
+        if (v > max) max = v;
+    }
+    if (first != last) {
+        for (int i=last * blockSize; i<=stop; i++) {
+            if (count[i+1] == count[i]) continue;
+            double v = d ? d[i] : 0;
+            if (v < min) min = v;
+            if (v > max) max = v;
+        }
+    }
+
+    returning.min = min;
+    returning.max = max;
+    return returning;
+}
+
+QVector<double>
+RideMetricIndex::zoneSeconds(RideItem *item, RideFile::SeriesType series, int start, int stop)
+{
+    QVector<double> returning;
+
+    RideFile *ride = item->ride();
+    int n = ride->dataPoints().count();
+    if (start < 0 || stop < start || stop >= n) return returning;
+
+    // the zones that apply to the ride
+    const Athlete *athlete = item->context->athlete;
+    const Zones *zones = NULL;
+    const HrZones *hrZones = NULL;
+    int range = -1, zoneCount = 0;
+    quint16 fingerprint = 0;
+    if (series == RideFile::watts && athlete->zones(item->isRun) && item->zoneRange >= 0) {
+        zones = athlete->zones(item->isRun);
+        range = item->zoneRange;
+        zoneCount = zones->numZones(range);
+        fingerprint = zones->getFingerprint(item->dateTime.date());
+    }
+    if (series == RideFile::hr && athlete->hrZones(item->isRun) && item->hrZoneRange >= 0) {
+        hrZones = athlete->hrZones(item->isRun);
+        range = item->hrZoneRange;
+        zoneCount = hrZones->numZones(range);
+        fingerprint = hrZones->getFingerprint(item->dateTime.date());
+    }
+    if (range < 0) return returning;
+
+    QMutexLocker locker(&mutex);
+
+    RideFileSeries column = ride->series(series);
+    const double *d = column.count() == n ? column.constData() : NULL;
+    int revision = ride->seriesRevision(series);
+    const void *from = zones ? static_cast<const void*>(zones) : static_cast<const void*>(hrZones);
+
+    ZonesIndex *index = zonesIndexes.value(series, NULL);
+
+    if (index == NULL || index->revision != revision || index->zones != from || index->range != range ||
+        index->fingerprint != fingerprint || index->count.count() != zoneCount ||
+        (zoneCount && index->count.at(0).count() != n+1)) {
+
+        if (index == NULL) {
+            index = new ZonesIndex;
+            zonesIndexes.insert(series, index);
+        }
+        index->revision = revision;
+        index->zones = from;
+        index->range = range;
+        index->fingerprint = fingerprint;
+        index->count.resize(zoneCount);
+        for (int z=0; z<zoneCount; z++) index->count[z].fill(0, n+1);
+
+        for (int i=0; i<n; i++) {
+            double v = d ? d[i] : 0;
+            int zone = zones ? zones->whichZone(range, v) : hrZones->whichZone(range, v);
+            for (int z=0; z<zoneCount; z++)
+                index->count[z][i+1] = index->count[z][i] + (z == zone ? 1 : 0);
+        }
+    }
+
+    double secs = ride->recIntSecs();
+    returning.resize(zoneCount);
+    for (int z=0; z<zoneCount; z++)
+        returning[z] = (index->count[z][stop+1] - index->count[z][start]) * secs;
+
+    return returning;
+}
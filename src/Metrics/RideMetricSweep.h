@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideMetricSweep_h
+#define _GC_RideMetricSweep_h 1
+#include "GoldenCheetah.h"
+
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+
+#include "RideMetric.h"
+#include "Specification.h"
+
+class Zones;
+class HrZones;
+class RideMetricIndex;
+
+//
+// Most of the builtin metrics are totals, averages, maximums or times
+// in zone over the samples, and each used to walk the samples itself.
+// Instead they can ask a RideMetricSweep for what they need, and
+// computeMetrics() gathers all of it in a single pass over the samples
+// for every metric in one go:
+//
+//   stats    count, total, min and max of a series for the samples that
+//            pass a filter, and optionally only when another series (the
+//            gate) is non-zero, e.g. only whilst pedalling
+//   zones    seconds in each power or heartrate zone
+//   window   count and total of the rolling mean over a number of
+//            samples, raised to a power, as used for NP
+//
+// The same thing asked for by more than one metric is only gathered
+// once. The series are read from their columns, see RideFile::series().
+// For an interval the stats and zones come from a RideMetricIndex of the
+// ride instead, only the windows walk the samples.
+//
+class RideMetricSweep
+{
+    public:
+
+        // which samples are counted
+        enum filter { All=0, NonZero, NonNegative, Positive };
+        typedef enum filter Filter;
+
+        struct Stats {
+            Stats() : count(0), total(0), min(0), max(0) {}
+            double mean() const { return count > 0 ? total / count : 0; }
+
+            // min and max are zero if no samples were counted
+            double count, total, min, max;
+        };
+
+        RideMetricSweep(RideItem *item, Specification spec);
+
+        RideItem *item() const { return item_; }
+        RideFile *ride() const { return ride_; }
+        Specification spec() const { return spec_; }
+
+        // same as spec.isEmpty(ride), no samples
+        bool isEmpty() const { return start < 0 || stop < start; }
+
+        // what is wanted, before run()
+        void addStats(RideFile::SeriesType series, Filter filter=All, RideFile::SeriesType gate=RideFile::none);
+        void addZones(RideFile::SeriesType series); // watts or hr
+        void addWindow(RideFile::SeriesType series, int samples, int power);
+
+        // one pass over the samples
+        void run();
+
+        // and the results, all zero if not asked for
+        const Stats &stats(RideFile::SeriesType series, Filter filter=All, RideFile::SeriesType gate=RideFile::none) const;
+        double zoneSeconds(RideFile::SeriesType series, int zone) const;
+        const Stats &window(RideFile::SeriesType series, int samples, int power) const;
+
+    private:
+
+        enum kind { StatsKind=0, ZonesKind, WindowKind };
+
+        struct Accumulator {
+            int kind;
+            RideFile::SeriesType series, gate;
+            int filter, samples, power;
+
+            Stats stats;
+            QVector<double> seconds; // in each zone
+        };
+
+        static quint64 key(int kind, int series, int a, int b, int c);
+        int add(int kind, RideFile::SeriesType series, int a, int b, int c);
+        const Accumulator *find(int kind, int series, int a, int b, int c) const;
+
+        RideItem *item_;
+        RideFile *ride_;
+        Specification spec_;
+        int start, stop;
+
+        QVector<Accumulator> accumulators;
+        QHash<quint64, int> index;
+};
+
+//
+// A metric computed from a sweep; computeMetrics() asks each of them
+// what they need, sweeps once, then has each compute from the results.
+// Computed on its own, e.g. by compute(), it sweeps just for itself.
+//
+class SweptRideMetric : public RideMetric
+{
+    public:
+
+        // ask for what is needed
+        virtual void accumulate(RideMetricSweep &sweep) const = 0;
+
+        // and compute from it, see sweep.item() and sweep.spec()
+        virtual void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &deps) = 0;
+
+        void compute(RideItem *item, Specification spec, const RideMetricDeps &deps);
+};
+
+//
+// The intervals of a ride each sweep some of the same samples, and
+// discovery adds dozens of intervals to every ride. So for intervals the
+// stats and zone times are answered from indexes of all of the ride's
+// samples, built the first time they are asked for:
+//
+//   stats    prefix sums of the count and total, so any range is a
+//            subtraction, and the min and max of each block of samples
+//            with a sparse table over the blocks, so any range is two
+//            lookups plus the part blocks at either end
+//   zones    prefix counts of the samples in each zone
+//
+// Each RideItem holds one until the ride is closed. An index is built
+// again if the series, gate or zones it was built from have changed
+// since, see RideFile::seriesRevision().
+//
+class RideMetricIndex
+{
+    public:
+        ~RideMetricIndex();
+
+        // for the samples start to stop
+        RideMetricSweep::Stats stats(RideFile *ride, RideFile::SeriesType series, int filter,
+                                     RideFile::SeriesType gate, int start, int stop);
+        QVector<double> zoneSeconds(RideItem *item, RideFile::SeriesType series, int start, int stop);
+
+    private:
+
+        struct StatsIndex {
+            int revision, gateRevision;
+            QVector<int> count;                 // prefix, one more than the samples
+            QVector<double> total;              // prefix
+            QVector<QVector<double> > min, max; // for 1, 2, 4 ... blocks from each block
+        };
+
+        struct ZonesIndex {
+            int revision;
+            const void *zones;
+            int range;
+            quint16 fingerprint;
+            QVector<QVector<int> > count;       // prefix, for each zone
+        };
+
+        QMutex mutex;
+        QHash<quint64, StatsIndex*> statsIndexes;
+        QHash<int, ZonesIndex*> zonesIndexes;
+};
+
+#endif // _GC_RideMetricSweep_h
@@ -17,6 +17,7 @@
  */
 
 #include "RideMetric.h"
+#include "RideMetricSweep.h"
 #include "Athlete.h"
 #include "Context.h"
 #include "Settings.h"
@@ -30,7 +31,7 @@
 #include <QVector>
 #include <QApplication>
 
-struct AvgRunCadence : public RideMetric {
+struct AvgRunCadence : public RideMetricCopyable<AvgRunCadence> {
     Q_DECLARE_TR_FUNCTIONS(AvgRunCadence)
 
     double total, count;
@@ -41,6 +42,7 @@ struct AvgRunCadence : public RideMetric {
     {
         setSymbol("average_run_cad");
         setInternalName("Average Running Cadence");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::cad << RideFile::rcad);
     }
 
     void initialize() {
@@ -51,7 +53,7 @@ struct AvgRunCadence : public RideMetric {
         setDescription(tr("Average Running Cadence, computed when Cadence > 0"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -90,7 +92,7 @@ static bool avgRunCadenceAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MaxRunCadence : public RideMetric {
+class MaxRunCadence : public RideMetricCopyable<MaxRunCadence> {
     Q_DECLARE_TR_FUNCTIONS(MaxRunCadence)
     public:
 
@@ -98,6 +100,7 @@ class MaxRunCadence : public RideMetric {
     {
         setSymbol("max_run_cadence");
         setInternalName("Max Running Cadence");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::cad << RideFile::rcad);
     }
 
     void initialize() {
@@ -108,7 +111,7 @@ class MaxRunCadence : public RideMetric {
         setDescription(tr("Maximum Running Cadence"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -141,17 +144,16 @@ static bool maxRunCadenceAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct AvgRunGroundContactTime : public RideMetric {
+struct AvgRunGroundContactTime : public RideMetricCopyable<AvgRunGroundContactTime, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(AvgRunGroundContactTime)
 
-    double total, count;
-
     public:
 
     AvgRunGroundContactTime()
     {
         setSymbol("average_run_ground_contact");
         setInternalName("Average Ground Contact Time");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::rcontact);
     }
 
     void initialize() {
@@ -162,28 +164,22 @@ struct AvgRunGroundContactTime : public RideMetric {
         setDescription(tr("Average Ground Contact Time"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::rcontact, RideMetricSweep::Positive);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        total = count = 0;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-
-            if (point->rcontact > 0) {
-                total += point->rcontact;
-                ++count;
-            }
-        }
-        setValue(count > 0 ? total / count : count);
-        setCount(count);
+        const RideMetricSweep::Stats &rcontact = sweep.stats(RideFile::rcontact, RideMetricSweep::Positive);
+        setValue(rcontact.mean());
+        setCount(rcontact.count);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return (ride->present.contains("R") && ride->isRun); }
@@ -198,17 +194,16 @@ static bool avgRunGroundContactTimeAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct AvgRunVerticalOscillation  : public RideMetric {
+struct AvgRunVerticalOscillation  : public RideMetricCopyable<AvgRunVerticalOscillation, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(AvgRunVerticalOscillation)
 
-    double total, count;
-
     public:
 
     AvgRunVerticalOscillation()
     {
         setSymbol("average_run_vert_oscillation");
         setInternalName("Average Vertical Oscillation");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::rvert << RideFile::rcontact);
     }
 
     void initialize() {
@@ -221,28 +216,23 @@ struct AvgRunVerticalOscillation  : public RideMetric {
         setDescription(tr("Average Vertical Oscillation"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addStats(RideFile::rvert, RideMetricSweep::All, RideFile::rcontact);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride())) {
+        if (sweep.isEmpty()) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        total = count = 0;
-
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-
-            if (point->rcontact > 0) {
-                total += point->rvert;
-                ++count;
-            }
-        }
-        setValue(count > 0 ? total / count : count);
-        setCount(count);
+        // only with ground contact
+        const RideMetricSweep::Stats &rvert = sweep.stats(RideFile::rvert, RideMetricSweep::All, RideFile::rcontact);
+        setValue(rvert.mean());
+        setCount(rvert.count);
     }
 
     bool isRelevantForRide(const RideItem *ride) const { return (ride->present.contains("R") && ride->isRun); }
@@ -257,7 +247,7 @@ static bool avgRunVerticalOscillationAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class Pace : public RideMetric {
+class Pace : public RideMetricCopyable<Pace> {
     Q_DECLARE_TR_FUNCTIONS(Pace)
     double pace;
 
@@ -267,6 +257,7 @@ class Pace : public RideMetric {
     {
         setSymbol("pace");
         setInternalName("Pace");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     // Pace ordering is reversed
@@ -278,9 +269,8 @@ class Pace : public RideMetric {
         return RideMetric::units(metricRunPace);
     }
 
-    double value(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_PACE, true).toBool();
-        return RideMetric::value(metricRunPace);
+    bool metricUnits(bool) const {
+        return appsettings->value(NULL, GC_PACE, true).toBool();
     }
 
     QString toString(bool metric) const {
@@ -297,7 +287,7 @@ class Pace : public RideMetric {
         setDescription(tr("Average Speed expressed in pace units: min/km or min/mile"));
    }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         RideMetric *as = deps.value("average_speed");
 
@@ -327,7 +317,7 @@ static bool paceAdded = addPace();
 
 //////////////////////////////////////////////////////////////////////////////
 
-class EfficiencyIndex : public RideMetric {
+class EfficiencyIndex : public RideMetricCopyable<EfficiencyIndex> {
     Q_DECLARE_TR_FUNCTIONS(EfficiencyIndex)
 
     public:
@@ -336,6 +326,7 @@ class EfficiencyIndex : public RideMetric {
     {
         setSymbol("efficiency_index");
         setInternalName("Efficiency Index");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -346,7 +337,7 @@ class EfficiencyIndex : public RideMetric {
         setDescription(tr("Efficiency Index : average speed by average power"));
    }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         double avg_power = deps.value("average_power")->value(true);
         double avg_speed = deps.value("average_speed")->value(true);
@@ -383,7 +374,7 @@ static bool efficiencyIndexAdded = addEfficiencyIndex();
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct AvgStrideLength  : public RideMetric {
+struct AvgStrideLength  : public RideMetricCopyable<AvgStrideLength> {
     Q_DECLARE_TR_FUNCTIONS(AvgStrideLength)
 
     double total, count;
@@ -394,6 +385,7 @@ struct AvgStrideLength  : public RideMetric {
     {
         setSymbol("average_stride_length");
         setInternalName("Average Stride Length");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::clength);
     }
 
     void initialize() {
@@ -406,7 +398,7 @@ struct AvgStrideLength  : public RideMetric {
         setDescription(tr("Average Stride Length"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -33,7 +33,7 @@
 
 // all the sustain metrics are filled in when the intervals
 // are updated and will be zero for intervals
-class L1Sustain : public RideMetric {
+class L1Sustain : public RideMetricCopyable<L1Sustain> {
     Q_DECLARE_TR_FUNCTIONS(L1Sustain)
     public:
 
@@ -41,6 +41,7 @@ class L1Sustain : public RideMetric {
     {
         setSymbol("l1_sustain");
         setInternalName("L1 Sustained Time");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("L1 Sustained Time"));
@@ -49,7 +50,7 @@ class L1Sustain : public RideMetric {
         setDescription(tr("Sustained Time in Power Zone 1, based on (sustained) EFFORT intervals."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *, Specification, const RideMetricDeps &) {
         setValue(0);
     }
 
@@ -60,7 +61,7 @@ class L1Sustain : public RideMetric {
 
 static bool l1Added = RideMetricFactory::instance().addMetric(L1Sustain());
 
-class L2Sustain : public RideMetric {
+class L2Sustain : public RideMetricCopyable<L2Sustain> {
     Q_DECLARE_TR_FUNCTIONS(L2Sustain)
     public:
 
@@ -68,6 +69,7 @@ class L2Sustain : public RideMetric {
     {
         setSymbol("l2_sustain");
         setInternalName("L2 Sustained Time");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -77,7 +79,7 @@ class L2Sustain : public RideMetric {
         setDescription(tr("Sustained Time in Power Zone 2, based on (sustained) EFFORT intervals."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *, Specification, const RideMetricDeps &) {
         setValue(0);
     }
     MetricClass classification() const { return Undefined; }
@@ -87,7 +89,7 @@ class L2Sustain : public RideMetric {
 
 static bool l2Added = RideMetricFactory::instance().addMetric(L2Sustain());
 
-class L3Sustain : public RideMetric {
+class L3Sustain : public RideMetricCopyable<L3Sustain> {
     Q_DECLARE_TR_FUNCTIONS(L3Sustain)
     public:
 
@@ -95,6 +97,7 @@ class L3Sustain : public RideMetric {
     {
         setSymbol("l3_sustain");
         setInternalName("L3 Sustained Time");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("L3 Sustained Time"));
@@ -103,7 +106,7 @@ class L3Sustain : public RideMetric {
         setDescription(tr("Sustained Time in Power Zone 3, based on (sustained) EFFORT intervals."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *, Specification, const RideMetricDeps &) {
         setValue(0);
     }
     MetricClass classification() const { return Undefined; }
@@ -113,7 +116,7 @@ class L3Sustain : public RideMetric {
 
 static bool l3Added = RideMetricFactory::instance().addMetric(L3Sustain());
 
-class L4Sustain : public RideMetric {
+class L4Sustain : public RideMetricCopyable<L4Sustain> {
     Q_DECLARE_TR_FUNCTIONS(L4Sustain)
     public:
 
@@ -121,6 +124,7 @@ class L4Sustain : public RideMetric {
     {
         setSymbol("l4_sustain");
         setInternalName("L4 Sustained Time");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("L4 Sustained Time"));
@@ -129,7 +133,7 @@ class L4Sustain : public RideMetric {
         setDescription(tr("Sustained Time in Power Zone 4, based on (sustained) EFFORT intervals."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *, Specification, const RideMetricDeps &) {
         setValue(0);
     }
     MetricClass classification() const { return Undefined; }
@@ -139,7 +143,7 @@ class L4Sustain : public RideMetric {
 
 static bool l4Added = RideMetricFactory::instance().addMetric(L4Sustain());
 
-class L5Sustain : public RideMetric {
+class L5Sustain : public RideMetricCopyable<L5Sustain> {
     Q_DECLARE_TR_FUNCTIONS(L5Sustain)
     public:
 
@@ -147,6 +151,7 @@ class L5Sustain : public RideMetric {
     {
         setSymbol("l5_sustain");
         setInternalName("L5 Sustained Time");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("L5 Sustained Time"));
@@ -155,7 +160,7 @@ class L5Sustain : public RideMetric {
         setDescription(tr("Sustained Time in Power Zone 5, based on (sustained) EFFORT intervals."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *, Specification, const RideMetricDeps &) {
         setValue(0);
     }
     MetricClass classification() const { return Undefined; }
@@ -165,7 +170,7 @@ class L5Sustain : public RideMetric {
 
 static bool l5Added = RideMetricFactory::instance().addMetric(L5Sustain());
 
-class L6Sustain : public RideMetric {
+class L6Sustain : public RideMetricCopyable<L6Sustain> {
     Q_DECLARE_TR_FUNCTIONS(L6Sustain)
     public:
 
@@ -173,6 +178,7 @@ class L6Sustain : public RideMetric {
     {
         setSymbol("l6_sustain");
         setInternalName("L6 Sustained Time");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("L6 Sustained Time"));
@@ -181,7 +187,7 @@ class L6Sustain : public RideMetric {
         setDescription(tr("Sustained Time in Power Zone 6, based on (sustained) EFFORT intervals."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *, Specification, const RideMetricDeps &) {
         setValue(0);
     }
     MetricClass classification() const { return Undefined; }
@@ -191,7 +197,7 @@ class L6Sustain : public RideMetric {
 
 static bool l6Added = RideMetricFactory::instance().addMetric(L6Sustain());
 
-class L7Sustain : public RideMetric {
+class L7Sustain : public RideMetricCopyable<L7Sustain> {
     Q_DECLARE_TR_FUNCTIONS(L7Sustain)
     public:
 
@@ -199,6 +205,7 @@ class L7Sustain : public RideMetric {
     {
         setSymbol("l7_sustain");
         setInternalName("L7 Sustained Time");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("L7 Sustained Time"));
@@ -207,7 +214,7 @@ class L7Sustain : public RideMetric {
         setDescription(tr("Sustained Time in Power Zone 7, based on (sustained) EFFORT intervals."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *, Specification, const RideMetricDeps &) {
         setValue(0);
     }
     MetricClass classification() const { return Undefined; }
@@ -217,7 +224,7 @@ class L7Sustain : public RideMetric {
 
 static bool l7Added = RideMetricFactory::instance().addMetric(L7Sustain());
 
-class L8Sustain : public RideMetric {
+class L8Sustain : public RideMetricCopyable<L8Sustain> {
     Q_DECLARE_TR_FUNCTIONS(L8Sustain)
     public:
 
@@ -225,6 +232,7 @@ class L8Sustain : public RideMetric {
     {
         setSymbol("l8_sustain");
         setInternalName("L8 Sustained Time");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("L8 Sustained Time"));
@@ -233,7 +241,7 @@ class L8Sustain : public RideMetric {
         setDescription(tr("Sustained Time in Power Zone 8, based on (sustained) EFFORT intervals."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *, Specification, const RideMetricDeps &) {
         setValue(0);
     }
     MetricClass classification() const { return Undefined; }
@@ -243,7 +251,7 @@ class L8Sustain : public RideMetric {
 
 static bool l8Added = RideMetricFactory::instance().addMetric(L8Sustain());
 
-class L9Sustain : public RideMetric {
+class L9Sustain : public RideMetricCopyable<L9Sustain> {
     Q_DECLARE_TR_FUNCTIONS(L9Sustain)
     public:
 
@@ -251,6 +259,7 @@ class L9Sustain : public RideMetric {
     {
         setSymbol("l9_sustain");
         setInternalName("L9 Sustained Time");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("L9 Sustained Time"));
@@ -259,7 +268,7 @@ class L9Sustain : public RideMetric {
         setDescription(tr("Sustained Time in Power Zone 9, based on (sustained) EFFORT intervals."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *, Specification, const RideMetricDeps &) {
         setValue(0);
     }
     MetricClass classification() const { return Undefined; }
@@ -269,7 +278,7 @@ class L9Sustain : public RideMetric {
 
 static bool l9Added = RideMetricFactory::instance().addMetric(L9Sustain());
 
-class L10Sustain : public RideMetric {
+class L10Sustain : public RideMetricCopyable<L10Sustain> {
     Q_DECLARE_TR_FUNCTIONS(L10Sustain)
     public:
 
@@ -277,6 +286,7 @@ class L10Sustain : public RideMetric {
     {
         setSymbol("l10_sustain");
         setInternalName("L10 Sustained Time");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("L10 Sustained Time"));
@@ -285,7 +295,7 @@ class L10Sustain : public RideMetric {
         setDescription(tr("Sustained Time in Power Zone 10, based on (sustained) EFFORT intervals."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *, Specification, const RideMetricDeps &) {
         setValue(0);
     }
     MetricClass classification() const { return Undefined; }
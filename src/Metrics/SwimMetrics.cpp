@@ -29,7 +29,7 @@
 #include <QApplication>
 
 // DistanceSwim is TotalDistance in swim units, relevant for swims in yards //
-class DistanceSwim : public RideMetric {
+class DistanceSwim : public RideMetricCopyable<DistanceSwim> {
     Q_DECLARE_TR_FUNCTIONS(DistanceSwim)
     double mts;
 
@@ -39,15 +39,15 @@ class DistanceSwim : public RideMetric {
     {
         setSymbol("distance_swim");
         setInternalName("Distance Swim");
+        setInputs(QList<RideFile::SeriesType>());
     }
     // Overrides to use Swim Pace units setting
     QString units(bool) const {
         bool metricSwPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
         return RideMetric::units(metricSwPace);
     }
-    double value(bool) const {
-        bool metricSwPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
-        return RideMetric::value(metricSwPace);
+    bool metricUnits(bool) const {
+        return appsettings->value(NULL, GC_SWIMPACE, true).toBool();
     }
     void initialize() {
         setName(tr("Distance Swim"));
@@ -59,7 +59,7 @@ class DistanceSwim : public RideMetric {
         setDescription(tr("Total Distance in meters or yards"));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         RideMetric *distance = deps.value("total_distance");
 
@@ -86,7 +86,7 @@ static bool addDistanceSwim()
 static bool distanceSwimAdded = addDistanceSwim();
 
 //////////////////////////////////////////////////////////////////////////////
-class PaceSwim : public RideMetric {
+class PaceSwim : public RideMetricCopyable<PaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(PaceSwim)
     double pace;
 
@@ -96,6 +96,7 @@ class PaceSwim : public RideMetric {
     {
         setSymbol("pace_swim");
         setInternalName("Pace Swim");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     // Swim Pace ordering is reversed
@@ -107,9 +108,8 @@ class PaceSwim : public RideMetric {
         return RideMetric::units(metricRunPace);
     }
 
-    double value(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
-        return RideMetric::value(metricRunPace);
+    bool metricUnits(bool) const {
+        return appsettings->value(NULL, GC_SWIMPACE, true).toBool();
     }
 
     QString toString(bool metric) const {
@@ -126,7 +126,7 @@ class PaceSwim : public RideMetric {
         setDescription(tr("Average Speed expressed in swim pace units: min/100m or min/100yd"));
    }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         RideMetric *as = deps.value("average_speed");
 
@@ -155,7 +155,7 @@ static bool addPaceSwim()
 static bool paceSwimAdded = addPaceSwim();
 
 ///////////////////////////////////////////////////////////////////////////////
-class SwimPace : public RideMetric {
+class SwimPace : public RideMetricCopyable<SwimPace> {
     Q_DECLARE_TR_FUNCTIONS(SwimPace)
 
     double total, count;
@@ -166,6 +166,7 @@ class SwimPace : public RideMetric {
     {
         setSymbol("swim_pace");
         setInternalName("Swim Pace");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::cad << RideFile::kph);
     }
 
     // Swim Pace ordering is reversed
@@ -177,9 +178,8 @@ class SwimPace : public RideMetric {
         return RideMetric::units(metric);
     }
 
-    double value(bool) const {
-        bool metric = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
-        return RideMetric::value(metric);
+    bool metricUnits(bool) const {
+        return appsettings->value(NULL, GC_SWIMPACE, true).toBool();
     }
 
     QString toString(bool metric) const {
@@ -196,7 +196,7 @@ class SwimPace : public RideMetric {
         setDescription(tr("Average Swim Pace, computed only when Cadence > 0 to avoid kick/drill lengths"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples or not a swim
         if (spec.isEmpty(item->ride()) || !item->isSwim) {
@@ -230,7 +230,7 @@ static bool swimPaceAdded =
     RideMetricFactory::instance().addMetric(SwimPace());
 
 //////////////////////////////////////////////////////////////////////////////
-class StrokeRate : public RideMetric {
+class StrokeRate : public RideMetricCopyable<StrokeRate> {
     Q_DECLARE_TR_FUNCTIONS(StrokeRate)
     double stroke_rate;
 
@@ -240,6 +240,7 @@ class StrokeRate : public RideMetric {
     {
         setSymbol("stroke_rate");
         setInternalName("Stroke Rate");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -253,7 +254,7 @@ class StrokeRate : public RideMetric {
         setDescription(tr("Stroke Rate in strokes/min, counting both arms for freestyle/backstroke, corrected by 3m push-off length for pool swims"));
    }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &deps) {
 
         // no ride or no samples or not a swim
         if (spec.isEmpty(item->ride()) || !item->isSwim) {
@@ -295,7 +296,7 @@ static bool addStrokeRate()
 static bool strokeRateAdded = addStrokeRate();
 
 //////////////////////////////////////////////////////////////////////////////
-class StrokesPerLength : public RideMetric {
+class StrokesPerLength : public RideMetricCopyable<StrokesPerLength> {
     Q_DECLARE_TR_FUNCTIONS(StrokesPerLength)
     double spl;
 
@@ -305,6 +306,7 @@ class StrokesPerLength : public RideMetric {
     {
         setSymbol("strokes_per_length");
         setInternalName("Strokes Per Length");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -318,7 +320,7 @@ class StrokesPerLength : public RideMetric {
         setDescription(tr("Strokes per length, counting the arm using the watch, Pool Length defaults to 50m for open water swims"));
    }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &deps) {
 
         // no ride or no samples or not a swim
         if (spec.isEmpty(item->ride()) || !item->isSwim) {
@@ -365,7 +367,7 @@ static bool addStrokesPerLength()
 static bool strokesPerLengthAdded = addStrokesPerLength();
 
 //////////////////////////////////////////////////////////////////////////////
-class SWolf : public RideMetric {
+class SWolf : public RideMetricCopyable<SWolf> {
     Q_DECLARE_TR_FUNCTIONS(SWolf)
     double swolf;
 
@@ -375,6 +377,7 @@ class SWolf : public RideMetric {
     {
         setSymbol("swolf");
         setInternalName("SWolf");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -388,7 +391,7 @@ class SWolf : public RideMetric {
         setDescription(tr("Strokes per length, counting the arm using the watch plus time in seconds, Pool Length defaults to 50m for open water swims"));
    }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &deps) {
 
         // no ride or no samples or not a swim
         if (spec.isEmpty(item->ride()) || !item->isSwim) {
@@ -435,7 +438,7 @@ static bool addSWolf()
 static bool swolfAdded = addSWolf();
 
 ///////////////////////////////////////////////////////////////////////////////
-class SwimPaceStroke : public RideMetric {
+class SwimPaceStroke : public RideMetricCopyable<SwimPaceStroke> {
     Q_DECLARE_TR_FUNCTIONS(SwimPaceStroke)
 
     public:
@@ -449,6 +452,8 @@ class SwimPaceStroke : public RideMetric {
         setType(RideMetric::Average);
         setPrecision(1);
         setConversion(METERS_PER_YARD);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::kph);
+        setXDataInputs(QStringList() << "SWIM");
     }
 
     // Swim Pace ordering is reversed
@@ -460,9 +465,8 @@ class SwimPaceStroke : public RideMetric {
         return RideMetric::units(metric);
     }
 
-    double value(bool) const {
-        bool metric = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
-        return RideMetric::value(metric);
+    bool metricUnits(bool) const {
+        return appsettings->value(NULL, GC_SWIMPACE, true).toBool();
     }
 
     QString toString(bool metric) const {
@@ -476,7 +480,7 @@ class SwimPaceStroke : public RideMetric {
         setDescription(tr("Average Swim Pace, computed only when Cadence > 0 to avoid kick/drill lengths"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         setValue(RideFile::NIL);
         setCount(0);
@@ -531,7 +535,7 @@ class SwimPaceStroke : public RideMetric {
     double total, count;
 };
 
-class SwimPaceFree : public SwimPaceStroke {
+class SwimPaceFree : public RideMetricCopyable<SwimPaceFree, SwimPaceStroke> {
     Q_DECLARE_TR_FUNCTIONS(SwimPaceFree)
 
     public:
@@ -552,7 +556,7 @@ class SwimPaceFree : public SwimPaceStroke {
         RideMetric *clone() const { return new SwimPaceFree(*this); }
 };
 
-class SwimPaceBack : public SwimPaceStroke {
+class SwimPaceBack : public RideMetricCopyable<SwimPaceBack, SwimPaceStroke> {
     Q_DECLARE_TR_FUNCTIONS(SwimPaceBack)
 
     public:
@@ -573,7 +577,7 @@ class SwimPaceBack : public SwimPaceStroke {
         RideMetric *clone() const { return new SwimPaceBack(*this); }
 };
 
-class SwimPaceBreast : public SwimPaceStroke {
+class SwimPaceBreast : public RideMetricCopyable<SwimPaceBreast, SwimPaceStroke> {
     Q_DECLARE_TR_FUNCTIONS(SwimPaceBreast)
 
     public:
@@ -594,7 +598,7 @@ class SwimPaceBreast : public SwimPaceStroke {
         RideMetric *clone() const { return new SwimPaceBreast(*this); }
 };
 
-class SwimPaceFly : public SwimPaceStroke {
+class SwimPaceFly : public RideMetricCopyable<SwimPaceFly, SwimPaceStroke> {
     Q_DECLARE_TR_FUNCTIONS(SwimPaceFly)
 
     public:
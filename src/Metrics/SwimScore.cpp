@@ -53,7 +53,7 @@ static inline double swimming_speed( double weight, double power ) {
 }
 
 // XPowerSwim, used for SwimScore and xPaceSwim calculation
-class XPowerSwim : public RideMetric {
+class XPowerSwim : public RideMetricCopyable<XPowerSwim> {
     Q_DECLARE_TR_FUNCTIONS(XPowerSwim)
     double xpower;
     double secs;
@@ -64,6 +64,8 @@ class XPowerSwim : public RideMetric {
     {
         setSymbol("swimscore_xpower");
         setInternalName("xPower Swim");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::kph);
+        setConfigInputs(WeightInput);
     }
     void initialize() {
         setName(tr("xPower Swim"));
@@ -73,7 +75,7 @@ class XPowerSwim : public RideMetric {
         setDescription(tr("Swimming power normalized for variations in speed as defined by Dr. Skiba in the SwimScore algorithm"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) ||
@@ -129,7 +131,7 @@ class XPowerSwim : public RideMetric {
 };
 
 // xPaceSwim: constant Pace which requires the same xPowerSwim
-class XPaceSwim : public RideMetric {
+class XPaceSwim : public RideMetricCopyable<XPaceSwim> {
     Q_DECLARE_TR_FUNCTIONS(XPaceSwim)
     double xPaceSwim;
 
@@ -139,6 +141,8 @@ class XPaceSwim : public RideMetric {
     {
         setSymbol("swimscore_xpace");
         setInternalName("xPace Swim");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(WeightInput);
     }
     // Swim Pace ordering is reversed
     bool isLowerBetter() const { return true; }
@@ -147,9 +151,8 @@ class XPaceSwim : public RideMetric {
         bool metricRunPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
         return RideMetric::units(metricRunPace);
     }
-    double value(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
-        return RideMetric::value(metricRunPace);
+    bool metricUnits(bool) const {
+        return appsettings->value(NULL, GC_SWIMPACE, true).toBool();
     }
     QString toString(bool metric) const {
         return time_to_string(value(metric)*60);
@@ -165,7 +168,7 @@ class XPaceSwim : public RideMetric {
     }
 
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // xPowerSwim only makes sense for running and it needs recIntSecs > 0
         if (!item->isSwim || item->ride()->recIntSecs() == 0) {
@@ -195,7 +198,7 @@ class XPaceSwim : public RideMetric {
 };
 
 // Swimming Threshold Power based on CV, used for SwimScore calculation
-class STP : public RideMetric {
+class STP : public RideMetricCopyable<STP> {
     Q_DECLARE_TR_FUNCTIONS(STP)
 
     public:
@@ -204,6 +207,8 @@ class STP : public RideMetric {
     {
         setSymbol("swimscore_tp");
         setInternalName("STP");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PaceZonesInput | WeightInput);
     }
     void initialize() {
         setName(tr("STP"));
@@ -214,7 +219,7 @@ class STP : public RideMetric {
         setDescription(tr("Swimming Threshold Power based on Swimming Critical Velocity, used for SwimScore calculation"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         // xPowerSwim only makes sense for running and it needs recIntSecs > 0
         if (!item->isSwim || item->ride()->recIntSecs() == 0) {
@@ -248,7 +253,7 @@ class STP : public RideMetric {
 };
 
 // Swimming Relative Intensity
-class SRI : public RideMetric {
+class SRI : public RideMetricCopyable<SRI> {
     Q_DECLARE_TR_FUNCTIONS(SRI)
     double reli;
     double secs;
@@ -259,6 +264,7 @@ class SRI : public RideMetric {
     {
         setSymbol("swimscore_ri");
         setInternalName("SRI");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("SRI"));
@@ -269,7 +275,7 @@ class SRI : public RideMetric {
         setDescription(tr("Swimming Relative Intensity, used for SwimScore calculation, defined as xPowerSwim/STP"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // xPowerSwim only makes sense for running and it needs recIntSecs > 0
         if (!item->isSwim || item->ride()->recIntSecs() == 0) {
@@ -297,7 +303,7 @@ class SRI : public RideMetric {
 };
 
 // SwimScore Metric for swimming
-class SwimScore : public RideMetric {
+class SwimScore : public RideMetricCopyable<SwimScore> {
     Q_DECLARE_TR_FUNCTIONS(SwimScore)
     double score;
 
@@ -307,6 +313,8 @@ class SwimScore : public RideMetric {
     {
         setSymbol("swimscore");
         setInternalName("SwimScore");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(WeightInput);
     }
     void initialize() {
         setName("SwimScore");
@@ -314,7 +322,7 @@ class SwimScore : public RideMetric {
         setDescription(tr("SwimScore swimming stress metric as defined by Dr. Skiba"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // xPowerSwim only makes sense for running and it needs recIntSecs > 0
         if (!item->isSwim || item->ride()->recIntSecs() == 0) {
@@ -373,7 +381,7 @@ static bool addAllSwimScore() {
 static bool SwimScoreAdded = addAllSwimScore();
 
 // TriScore Metric for triathlon
-class TriScore : public RideMetric {
+class TriScore : public RideMetricCopyable<TriScore> {
     Q_DECLARE_TR_FUNCTIONS(TriScore)
     double score;
 
@@ -383,13 +391,14 @@ class TriScore : public RideMetric {
     {
         setSymbol("triscore");
         setInternalName("TriScore");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName("TriScore");
         setType(RideMetric::Total);
         setDescription(tr("TriScore combined stress metric based on Dr. Skiba stress metrics, defined as BikeScore for cycling, GOVSS for running and SwimScore for swimming"));
     }
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         if (item->isSwim) {
             assert(deps.contains("swimscore"));
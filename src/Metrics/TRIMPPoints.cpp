@@ -36,7 +36,7 @@
 // Ksex = 1.92 for man and 1.67 for woman
 // RHR = resting heart rate
 //
-class TRIMPPoints : public RideMetric {
+class TRIMPPoints : public RideMetricCopyable<TRIMPPoints> {
     Q_DECLARE_TR_FUNCTIONS(TRIMPPoints)
 
     double score;
@@ -49,6 +49,8 @@ class TRIMPPoints : public RideMetric {
     {
         setSymbol("trimp_points");
         setInternalName("TRIMP Points");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(HrZonesInput);
     }
     void initialize() {
         setName(tr("TRIMP Points"));
@@ -58,7 +60,7 @@ class TRIMPPoints : public RideMetric {
         setDescription(tr("Training Impulse according to Morton/Banister with Green et al coefficient."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         if (!item->context->athlete->hrZones(item->isRun) || item->hrZoneRange < 0) {
             setValue(RideFile::NIL);
@@ -105,7 +107,7 @@ class TRIMPPoints : public RideMetric {
 
 
 
-class TRIMP100Points : public RideMetric {
+class TRIMP100Points : public RideMetricCopyable<TRIMP100Points> {
     Q_DECLARE_TR_FUNCTIONS(TRIMP100Points)
 
     double score;
@@ -118,6 +120,8 @@ public:
     {
         setSymbol("trimp_100_points");
         setInternalName("TRIMP(100) Points");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(HrZonesInput);
     }
     void initialize() {
         setName(tr("TRIMP(100) Points"));
@@ -127,7 +131,7 @@ public:
         setDescription(tr("TRIMP Points normalized to assign 100 points to 1 hour at threshold heart rate."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         if (!item->context->athlete->hrZones(item->isRun) || item->hrZoneRange < 0) {
             setValue(RideFile::NIL);
@@ -170,7 +174,7 @@ public:
 // 0, 68, 83, 94, 105 of LT for LT 80% Max-> 0, 55, 66, 75, 84
 // 0.9 (zone 1 0-55%), 1.1 (zone 2 55-66%), 1.2 (zone 3 66-75%), 2 (zone 4 75-84%), and 5 (zone 5 84-100%)
 
-class TRIMPZonalPoints : public RideMetric {
+class TRIMPZonalPoints : public RideMetricCopyable<TRIMPZonalPoints> {
     Q_DECLARE_TR_FUNCTIONS(TRIMPZonalPoints)
 
     double score;
@@ -183,6 +187,8 @@ public:
     {
         setSymbol("trimp_zonal_points");
         setInternalName("TRIMP Zonal Points");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(HrZonesInput);
     }
     void initialize() {
         setName(tr("TRIMP Zonal Points"));
@@ -192,7 +198,7 @@ public:
         setDescription(tr("Training Impulse with time in zones weighted according to coefficients defined in Heart Rate Zones."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         if (!item->context->athlete->hrZones(item->isRun) || item->hrZoneRange < 0) {
             setValue(RideFile::NIL);
@@ -315,7 +321,7 @@ public:
 //    - external load (bikescore/TSS)
 //    - perceived load (session RPE)
 //
-class SessionRPE : public RideMetric {
+class SessionRPE : public RideMetricCopyable<SessionRPE> {
     Q_DECLARE_TR_FUNCTIONS(SessionRPE)
 
     double score;
@@ -326,6 +332,8 @@ class SessionRPE : public RideMetric {
     {
         setSymbol("session_rpe");
         setInternalName("Session RPE");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(HrZonesInput);
     }
     void initialize() {
         setName(tr("Session RPE"));
@@ -335,7 +343,7 @@ class SessionRPE : public RideMetric {
         setDescription(tr("Session RPE is the product of RPE * minutes, where RPE is the rate of perceived exercion (10 point modified borg scale) and minutes is Time Moving if available or Duration otherwise."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         if (!item->context->athlete->hrZones(item->isRun) || item->hrZoneRange < 0) {
             setValue(RideFile::NIL);
@@ -18,6 +18,7 @@
  */
 
 #include "RideMetric.h"
+#include "RideMetricSweep.h"
 #include "RideItem.h"
 #include "Context.h"
 #include "Athlete.h"
@@ -27,49 +28,47 @@
 #include <assert.h>
 #include <QApplication>
 
-class ZoneTime : public RideMetric {
+class ZoneTime : public RideMetricCopyable<ZoneTime, SweptRideMetric> {
     Q_DECLARE_TR_FUNCTIONS(ZoneTime)
     int level;
-    double seconds;
 
     QList<int> lo;
     QList<int> hi;
 
     public:
 
-    ZoneTime() : level(0), seconds(0.0)
+    ZoneTime() : level(0)
     {
         setType(RideMetric::Total);
         setMetricUnits(tr("seconds"));
         setImperialUnits(tr("seconds"));
         setPrecision(0);
         setConversion(1.0);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
 
     bool isTime() const { return true; }
     void setLevel(int level) { this->level=level-1; } // zones start from zero not 1
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void accumulate(RideMetricSweep &sweep) const {
+        sweep.addZones(RideFile::watts);
+    }
+
+    void computeSwept(const RideMetricSweep &sweep, const RideMetricDeps &) {
+
+        RideItem *item = sweep.item();
 
         // no ride or no samples
-        if (spec.isEmpty(item->ride()) ||
+        if (sweep.isEmpty() ||
             item->context->athlete->zones(item->isRun) == NULL || item->zoneRange < 0 ||
-            !item->ride()->areDataPresent()->watts) {
+            !sweep.ride()->areDataPresent()->watts) {
             setValue(RideFile::NIL);
             setCount(0);
             return;
         }
 
-        seconds = 0;
-
-        // iterate and compute
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (item->context->athlete->zones(item->isRun)->whichZone(item->zoneRange, point->watts) == level)
-                seconds += item->ride()->recIntSecs();
-        }
-        setValue(seconds);
+        setValue(sweep.zoneSeconds(RideFile::watts, level));
     }
 
     MetricClass classification() const { return Undefined; }
@@ -77,7 +76,7 @@ class ZoneTime : public RideMetric {
     RideMetric *clone() const { return new ZoneTime(*this); }
 };
 
-class ZoneTime1 : public ZoneTime {
+class ZoneTime1 : public RideMetricCopyable<ZoneTime1, ZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(ZoneTime1)
 
     public:
@@ -99,7 +98,7 @@ class ZoneTime1 : public ZoneTime {
         RideMetric *clone() const { return new ZoneTime1(*this); }
 };
 
-class ZoneTime2 : public ZoneTime {
+class ZoneTime2 : public RideMetricCopyable<ZoneTime2, ZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(ZoneTime2)
 
     public:
@@ -121,7 +120,7 @@ class ZoneTime2 : public ZoneTime {
         RideMetric *clone() const { return new ZoneTime2(*this); }
 };
 
-class ZoneTime3 : public ZoneTime {
+class ZoneTime3 : public RideMetricCopyable<ZoneTime3, ZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(ZoneTime3)
 
     public:
@@ -143,7 +142,7 @@ class ZoneTime3 : public ZoneTime {
         RideMetric *clone() const { return new ZoneTime3(*this); }
 };
 
-class ZoneTime4 : public ZoneTime {
+class ZoneTime4 : public RideMetricCopyable<ZoneTime4, ZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(ZoneTime4)
 
     public:
@@ -167,7 +166,7 @@ class ZoneTime4 : public ZoneTime {
         RideMetric *clone() const { return new ZoneTime4(*this); }
 };
 
-class ZoneTime5 : public ZoneTime {
+class ZoneTime5 : public RideMetricCopyable<ZoneTime5, ZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(ZoneTime5)
 
     public:
@@ -189,7 +188,7 @@ class ZoneTime5 : public ZoneTime {
         RideMetric *clone() const { return new ZoneTime5(*this); }
 };
 
-class ZoneTime6 : public ZoneTime {
+class ZoneTime6 : public RideMetricCopyable<ZoneTime6, ZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(ZoneTime6)
 
     public:
@@ -211,7 +210,7 @@ class ZoneTime6 : public ZoneTime {
         RideMetric *clone() const { return new ZoneTime6(*this); }
 };
 
-class ZoneTime7 : public ZoneTime {
+class ZoneTime7 : public RideMetricCopyable<ZoneTime7, ZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(ZoneTime7)
 
     public:
@@ -233,7 +232,7 @@ class ZoneTime7 : public ZoneTime {
         RideMetric *clone() const { return new ZoneTime7(*this); }
 };
 
-class ZoneTime8 : public ZoneTime {
+class ZoneTime8 : public RideMetricCopyable<ZoneTime8, ZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(ZoneTime8)
 
     public:
@@ -255,7 +254,7 @@ class ZoneTime8 : public ZoneTime {
         RideMetric *clone() const { return new ZoneTime8(*this); }
 };
 
-class ZoneTime9 : public ZoneTime {
+class ZoneTime9 : public RideMetricCopyable<ZoneTime9, ZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(ZoneTime9)
 
     public:
@@ -277,7 +276,7 @@ class ZoneTime9 : public ZoneTime {
         RideMetric *clone() const { return new ZoneTime9(*this); }
 };
 
-class ZoneTime10 : public ZoneTime {
+class ZoneTime10 : public RideMetricCopyable<ZoneTime10, ZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(ZoneTime10)
 
     public:
@@ -300,7 +299,7 @@ class ZoneTime10 : public ZoneTime {
 };
 
 // Now for Time In Zone as a Percentage of Ride Time
-class ZonePTime1 : public RideMetric {
+class ZonePTime1 : public RideMetricCopyable<ZonePTime1> {
 
         Q_DECLARE_TR_FUNCTIONS(ZonePTime1)
 
@@ -315,6 +314,7 @@ class ZonePTime1 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -323,7 +323,7 @@ class ZonePTime1 : public RideMetric {
             setDescription(tr("Percent of Time in Power Zone 1."));
         }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_L1"));
             assert(deps.contains("workout_time"));
@@ -342,7 +342,7 @@ class ZonePTime1 : public RideMetric {
         RideMetric *clone() const { return new ZonePTime1(*this); }
 };
 
-class ZonePTime2 : public RideMetric {
+class ZonePTime2 : public RideMetricCopyable<ZonePTime2> {
 
         Q_DECLARE_TR_FUNCTIONS(ZonePTime2)
 
@@ -357,6 +357,7 @@ class ZonePTime2 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -365,7 +366,7 @@ class ZonePTime2 : public RideMetric {
             setDescription(tr("Percent of Time in Power Zone 2."));
         }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_L2"));
             assert(deps.contains("workout_time"));
@@ -384,7 +385,7 @@ class ZonePTime2 : public RideMetric {
         RideMetric *clone() const { return new ZonePTime2(*this); }
 };
 
-class ZonePTime3 : public RideMetric {
+class ZonePTime3 : public RideMetricCopyable<ZonePTime3> {
 
         Q_DECLARE_TR_FUNCTIONS(ZonePTime3)
 
@@ -399,6 +400,7 @@ class ZonePTime3 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -407,7 +409,7 @@ class ZonePTime3 : public RideMetric {
             setDescription(tr("Percent of Time in Power Zone 3."));
         }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_L3"));
             assert(deps.contains("workout_time"));
@@ -426,7 +428,7 @@ class ZonePTime3 : public RideMetric {
         RideMetric *clone() const { return new ZonePTime3(*this); }
 };
 
-class ZonePTime4 : public RideMetric {
+class ZonePTime4 : public RideMetricCopyable<ZonePTime4> {
 
         Q_DECLARE_TR_FUNCTIONS(ZonePTime4)
 
@@ -441,6 +443,7 @@ class ZonePTime4 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -449,7 +452,7 @@ class ZonePTime4 : public RideMetric {
             setDescription(tr("Percent of Time in Power Zone 4."));
         }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_L4"));
             assert(deps.contains("workout_time"));
@@ -468,7 +471,7 @@ class ZonePTime4 : public RideMetric {
         RideMetric *clone() const { return new ZonePTime4(*this); }
 };
 
-class ZonePTime5 : public RideMetric {
+class ZonePTime5 : public RideMetricCopyable<ZonePTime5> {
 
         Q_DECLARE_TR_FUNCTIONS(ZonePTime5)
 
@@ -483,6 +486,7 @@ class ZonePTime5 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -491,7 +495,7 @@ class ZonePTime5 : public RideMetric {
             setDescription(tr("Percent of Time in Power Zone 5."));
         }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_L5"));
             assert(deps.contains("workout_time"));
@@ -510,7 +514,7 @@ class ZonePTime5 : public RideMetric {
         RideMetric *clone() const { return new ZonePTime5(*this); }
 };
 
-class ZonePTime6 : public RideMetric {
+class ZonePTime6 : public RideMetricCopyable<ZonePTime6> {
 
         Q_DECLARE_TR_FUNCTIONS(ZonePTime6)
 
@@ -525,6 +529,7 @@ class ZonePTime6 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -533,7 +538,7 @@ class ZonePTime6 : public RideMetric {
             setDescription(tr("Percent of Time in Power Zone 6."));
         }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_L6"));
             assert(deps.contains("workout_time"));
@@ -552,7 +557,7 @@ class ZonePTime6 : public RideMetric {
         RideMetric *clone() const { return new ZonePTime6(*this); }
 };
 
-class ZonePTime7 : public RideMetric {
+class ZonePTime7 : public RideMetricCopyable<ZonePTime7> {
 
         Q_DECLARE_TR_FUNCTIONS(ZonePTime7)
 
@@ -567,6 +572,7 @@ class ZonePTime7 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -575,7 +581,7 @@ class ZonePTime7 : public RideMetric {
             setDescription(tr("Percent of Time in Power Zone 7."));
         }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_L7"));
             assert(deps.contains("workout_time"));
@@ -594,7 +600,7 @@ class ZonePTime7 : public RideMetric {
         RideMetric *clone() const { return new ZonePTime7(*this); }
 };
 
-class ZonePTime8 : public RideMetric {
+class ZonePTime8 : public RideMetricCopyable<ZonePTime8> {
 
         Q_DECLARE_TR_FUNCTIONS(ZonePTime8)
 
@@ -609,6 +615,7 @@ class ZonePTime8 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -617,7 +624,7 @@ class ZonePTime8 : public RideMetric {
             setDescription(tr("Percent of Time in Power Zone 8."));
         }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_L8"));
             assert(deps.contains("workout_time"));
@@ -636,7 +643,7 @@ class ZonePTime8 : public RideMetric {
         RideMetric *clone() const { return new ZonePTime8(*this); }
 };
 
-class ZonePTime9 : public RideMetric {
+class ZonePTime9 : public RideMetricCopyable<ZonePTime9> {
 
         Q_DECLARE_TR_FUNCTIONS(ZonePTime9)
 
@@ -651,6 +658,7 @@ class ZonePTime9 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -659,7 +667,7 @@ class ZonePTime9 : public RideMetric {
             setDescription(tr("Percent of Time in Power Zone 9."));
         }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_L9"));
             assert(deps.contains("workout_time"));
@@ -678,7 +686,7 @@ class ZonePTime9 : public RideMetric {
         RideMetric *clone() const { return new ZonePTime9(*this); }
 };
 
-class ZonePTime10 : public RideMetric {
+class ZonePTime10 : public RideMetricCopyable<ZonePTime10> {
 
         Q_DECLARE_TR_FUNCTIONS(ZonePTime10)
 
@@ -693,6 +701,7 @@ class ZonePTime10 : public RideMetric {
             setImperialUnits("%");
             setPrecision(0);
             setConversion(1.0);
+            setInputs(QList<RideFile::SeriesType>());
         }
 
         void initialize ()
@@ -701,7 +710,7 @@ class ZonePTime10 : public RideMetric {
             setDescription(tr("Percent of Time in Power Zone 10."));
         }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
             assert(deps.contains("time_in_zone_L10"));
             assert(deps.contains("workout_time"));
@@ -88,6 +88,16 @@ UserMetric::clone() const
     return new UserMetric(this);
 }
 
+void
+UserMetric::resolveMetrics()
+{
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+    foreach(QString symbol, factory.allMetrics()) {
+        const RideMetric *m = factory.rideMetric(symbol);
+        if (m && m->isUser()) static_cast<const UserMetric*>(m)->program->resolveMetrics();
+    }
+}
+
 void
 UserMetric::initialize()
 {
@@ -194,7 +204,7 @@ UserMetric::isRelevantForRide(const RideItem *item) const
 
 // Compute the ride metric from a file.
 void
-UserMetric::compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &pc)
+UserMetric::compute(RideItem *item, Specification spec, const RideMetricDeps &pc)
 {
     QTime timer;
     timer.start();
@@ -211,7 +221,7 @@ UserMetric::compute(RideItem *item, Specification spec, const QHash<QString,Ride
 
     // if there are no precomputed metrics then just use the values for the rideitem
     // this is a specific use case when testing a user metric in preferences
-    const QHash<QString, RideMetric*> *c = NULL;
+    const RideMetricDeps *c = NULL;
     if (pc.count()) c=&pc;
 
     //qDebug()<<"INIT";
@@ -30,7 +30,7 @@
 #include <QApplication>
 
 // Daniels VDOT
-class VDOT : public RideMetric {
+class VDOT : public RideMetricCopyable<VDOT> {
     Q_DECLARE_TR_FUNCTIONS(VDOT)
     double vdot;
 
@@ -40,6 +40,7 @@ class VDOT : public RideMetric {
     {
         setSymbol("VDOT");
         setInternalName("VDOT");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::kph);
     }
     void initialize() {
         setName(tr("VDOT"));
@@ -50,7 +51,7 @@ class VDOT : public RideMetric {
         setDescription(tr("Daniels' VDOT computed from best average pace for durations from 4 min 4 hr"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         // not a run
         if (!item->isRun) {
@@ -79,7 +80,7 @@ class VDOT : public RideMetric {
 };
 
 // Daniels T-Pace
-class TPace : public RideMetric {
+class TPace : public RideMetricCopyable<TPace> {
     Q_DECLARE_TR_FUNCTIONS(TPace)
     double tPace;
 
@@ -89,6 +90,7 @@ class TPace : public RideMetric {
     {
         setSymbol("TPace");
         setInternalName("TPace");
+        setInputs(QList<RideFile::SeriesType>());
     }
     // TPace ordering is reversed
     bool isLowerBetter() const { return true; }
@@ -97,9 +99,8 @@ class TPace : public RideMetric {
         bool metricRunPace = appsettings->value(NULL, GC_PACE, true).toBool();
         return RideMetric::units(metricRunPace);
     }
-    double value(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_PACE, true).toBool();
-        return RideMetric::value(metricRunPace);
+    bool metricUnits(bool) const {
+        return appsettings->value(NULL, GC_PACE, true).toBool();
     }
     QString toString(bool metric) const {
         return time_to_string(value(metric)*60);
@@ -115,7 +116,7 @@ class TPace : public RideMetric {
     }
 
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // not a run
         if (!item->isRun) {
@@ -734,7 +734,7 @@ WPrime::summarize(int WPRIME, QVector<double> wtiz, QVector<double> wcptiz, QVec
 // Associated Metrics
 //
 
-class MinWPrime : public RideMetric {
+class MinWPrime : public RideMetricCopyable<MinWPrime> {
     Q_DECLARE_TR_FUNCTIONS(MinWPrime);
 
     public:
@@ -743,6 +743,8 @@ class MinWPrime : public RideMetric {
     {
         setSymbol("skiba_wprime_low");
         setInternalName("Minimum W'bal");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     void initialize() {
         setName(tr("Minimum W' bal"));
@@ -753,7 +755,7 @@ class MinWPrime : public RideMetric {
         setDescription(tr("Minimum W' bal, W' bal tracks the level of W' according to CP model during intermitent exercise."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
         if (item->ride() && item->ride()->wprimeData())
             setValue(item->ride()->wprimeData()->minY / 1000.00f);
         else
@@ -766,7 +768,7 @@ class MinWPrime : public RideMetric {
     RideMetric *clone() const { return new MinWPrime(*this); }
 };
 
-class MaxWPrime : public RideMetric {
+class MaxWPrime : public RideMetricCopyable<MaxWPrime> {
     Q_DECLARE_TR_FUNCTIONS(MaxWPrime);
 
     public:
@@ -775,6 +777,8 @@ class MaxWPrime : public RideMetric {
     {
         setSymbol("skiba_wprime_max"); // its expressing min W'bal as as percentage of WPrime
         setInternalName("Max W' Expended");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     void initialize() {
         setName(tr("Max W' Expended"));
@@ -784,7 +788,7 @@ class MaxWPrime : public RideMetric {
         setPrecision(0);
         setDescription(tr("Maximum W' bal Expended expressed as percentage of W', W' bal tracks the level of W' according to CP model during intermitent exercise."));
     }
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         if (item->ride() && item->ride()->wprimeData())
             setValue(item->ride()->wprimeData()->maxE());
@@ -798,7 +802,7 @@ class MaxWPrime : public RideMetric {
     RideMetric *clone() const { return new MaxWPrime(*this); }
 };
 
-class MaxMatch : public RideMetric {
+class MaxMatch : public RideMetricCopyable<MaxMatch> {
     Q_DECLARE_TR_FUNCTIONS(MaxMatch);
 
     public:
@@ -807,6 +811,8 @@ class MaxMatch : public RideMetric {
     {
         setSymbol("skiba_wprime_maxmatch");
         setInternalName("Maximum W'bal Match");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     void initialize() {
         setName(tr("Maximum W'bal Match"));
@@ -816,7 +822,7 @@ class MaxMatch : public RideMetric {
         setPrecision(1);
         setDescription(tr("Maximum W' bal Match, W' bal tracks the level of W' according to CP model during intermitent exercise."));
     }
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         if (item->ride() && item->ride()->wprimeData())
             setValue(item->ride()->wprimeData()->maxMatch()/1000.00f);
@@ -830,7 +836,7 @@ class MaxMatch : public RideMetric {
     RideMetric *clone() const { return new MaxMatch(*this); }
 };
 
-class Matches : public RideMetric {
+class Matches : public RideMetricCopyable<Matches> {
     Q_DECLARE_TR_FUNCTIONS(Matches);
 
     public:
@@ -839,6 +845,8 @@ class Matches : public RideMetric {
     {
         setSymbol("skiba_wprime_matches");
         setInternalName("W'bal Matches > 2KJ");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     void initialize() {
         setName(tr("W'bal Matches"));
@@ -847,7 +855,7 @@ class Matches : public RideMetric {
         setDescription(tr("Number of W' balance Matches higher than 2kJ, W' bal tracks the level of W' according to CP model during intermitent exercise."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         int matches=0;
         if (item->ride() && item->ride()->wprimeData()) {
@@ -864,7 +872,7 @@ class Matches : public RideMetric {
     RideMetric *clone() const { return new Matches(*this); }
 };
 
-class WPrimeTau : public RideMetric {
+class WPrimeTau : public RideMetricCopyable<WPrimeTau> {
     Q_DECLARE_TR_FUNCTIONS(WPrimeTau);
 
     public:
@@ -873,6 +881,8 @@ class WPrimeTau : public RideMetric {
     {
         setSymbol("skiba_wprime_tau");
         setInternalName("W'bal TAU");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     void initialize() {
         setName(tr("W'bal TAU"));
@@ -883,7 +893,7 @@ class WPrimeTau : public RideMetric {
         setDescription(tr("W' bal TAU is the recovery time constant for W' bal, W' bal tracks the level of W' according to CP model during intermitent exercise."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         if (item->ride() && item->ride()->wprimeData())
             setValue(item->ride()->wprimeData()->TAU);
@@ -898,7 +908,7 @@ class WPrimeTau : public RideMetric {
     RideMetric *clone() const { return new WPrimeTau(*this); }
 };
 
-class WPrimeExp : public RideMetric {
+class WPrimeExp : public RideMetricCopyable<WPrimeExp> {
     Q_DECLARE_TR_FUNCTIONS(WPrimeExp);
 
     public:
@@ -907,6 +917,8 @@ class WPrimeExp : public RideMetric {
     {
         setSymbol("skiba_wprime_exp");
         setInternalName("W' Work");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     void initialize() {
         setName(tr("W' Work"));
@@ -917,7 +929,7 @@ class WPrimeExp : public RideMetric {
         setDescription(tr("W' Work is the amount of kJ produced while power is above CP."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         int cp = item->getText("CP","0").toInt();
         if (!cp && item->context->athlete->zones(item->isRun) && item->zoneRange >=0) 
@@ -944,7 +956,7 @@ class WPrimeExp : public RideMetric {
     RideMetric *clone() const { return new WPrimeExp(*this); }
 };
 
-class WPrimeWatts : public RideMetric {
+class WPrimeWatts : public RideMetricCopyable<WPrimeWatts> {
     Q_DECLARE_TR_FUNCTIONS(WPrimeWatts);
 
     public:
@@ -953,6 +965,8 @@ class WPrimeWatts : public RideMetric {
     {
         setSymbol("skiba_wprime_watts");
         setInternalName("W' Watts");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     void initialize() {
         setName(tr("W' Power"));
@@ -963,7 +977,7 @@ class WPrimeWatts : public RideMetric {
         setDescription(tr("W' Power is the average power produce while power is above CP."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         int cp = item->getText("CP","0").toInt();
         if (!cp && item->context->athlete->zones(item->isRun) && item->zoneRange >=0) 
@@ -990,7 +1004,7 @@ class WPrimeWatts : public RideMetric {
     RideMetric *clone() const { return new WPrimeWatts(*this); }
 };
 
-class CPExp : public RideMetric {
+class CPExp : public RideMetricCopyable<CPExp> {
     Q_DECLARE_TR_FUNCTIONS(CPExp);
 
     public:
@@ -999,6 +1013,8 @@ class CPExp : public RideMetric {
     {
         setSymbol("skiba_cp_exp");
         setInternalName("Below CP Work");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     void initialize() {
         setName(tr("Below CP Work"));
@@ -1009,7 +1025,7 @@ class CPExp : public RideMetric {
         setDescription(tr("Below CP Work is the amount of kJ produced while power is below CP."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -1046,7 +1062,7 @@ class CPExp : public RideMetric {
 };
 
 // time in zone
-class WZoneTime : public RideMetric {
+class WZoneTime : public RideMetricCopyable<WZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(WZoneTime)
 
     int level;
@@ -1060,11 +1076,13 @@ class WZoneTime : public RideMetric {
         setImperialUnits(tr("seconds"));
         setPrecision(0);
         setConversion(1.0);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     bool isTime() const { return true; }
     void setLevel(int level) { this->level=level-1; } // zones start from zero not 1
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         double WPRIME = item->zoneRange >= 0 ? item->context->athlete->zones(item->isRun)->getWprime(item->zoneRange) : 20000;
 
@@ -1098,7 +1116,7 @@ class WZoneTime : public RideMetric {
     RideMetric *clone() const { return new WZoneTime(*this); }
 };
 
-class WZoneTime1 : public WZoneTime {
+class WZoneTime1 : public RideMetricCopyable<WZoneTime1, WZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(WZoneTime1)
 
     public:
@@ -1119,7 +1137,7 @@ class WZoneTime1 : public WZoneTime {
     MetricValidity validity() const { return Unknown; }
         RideMetric *clone() const { return new WZoneTime1(*this); }
 };
-class WZoneTime2 : public WZoneTime {
+class WZoneTime2 : public RideMetricCopyable<WZoneTime2, WZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(WZoneTime2)
 
     public:
@@ -1140,7 +1158,7 @@ class WZoneTime2 : public WZoneTime {
     MetricValidity validity() const { return Unknown; }
         RideMetric *clone() const { return new WZoneTime2(*this); }
 };
-class WZoneTime3 : public WZoneTime {
+class WZoneTime3 : public RideMetricCopyable<WZoneTime3, WZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(WZoneTime3)
 
     public:
@@ -1161,7 +1179,7 @@ class WZoneTime3 : public WZoneTime {
     MetricValidity validity() const { return Unknown; }
         RideMetric *clone() const { return new WZoneTime3(*this); }
 };
-class WZoneTime4 : public WZoneTime {
+class WZoneTime4 : public RideMetricCopyable<WZoneTime4, WZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(WZoneTime4)
 
     public:
@@ -1184,7 +1202,7 @@ class WZoneTime4 : public WZoneTime {
 };
 
 // time in zone
-class WCPZoneTime : public RideMetric {
+class WCPZoneTime : public RideMetricCopyable<WCPZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(WCPZoneTime)
 
     int level;
@@ -1198,11 +1216,13 @@ class WCPZoneTime : public RideMetric {
         setImperialUnits(tr("seconds"));
         setPrecision(0);
         setConversion(1.0);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     bool isTime() const { return true; }
     void setLevel(int level) { this->level=level-1; } // zones start from zero not 1
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         double WPRIME = 20000;
         if (item->context->athlete->zones(item->isRun) && item->zoneRange > 0) {
@@ -1248,7 +1268,7 @@ class WCPZoneTime : public RideMetric {
     RideMetric *clone() const { return new WCPZoneTime(*this); }
 };
 
-class WCPZoneTime1 : public WCPZoneTime {
+class WCPZoneTime1 : public RideMetricCopyable<WCPZoneTime1, WCPZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(WCPZoneTime1)
 
     public:
@@ -1269,7 +1289,7 @@ class WCPZoneTime1 : public WCPZoneTime {
     MetricValidity validity() const { return Unknown; }
         RideMetric *clone() const { return new WCPZoneTime1(*this); }
 };
-class WCPZoneTime2 : public WCPZoneTime {
+class WCPZoneTime2 : public RideMetricCopyable<WCPZoneTime2, WCPZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(WCPZoneTime2)
 
     public:
@@ -1290,7 +1310,7 @@ class WCPZoneTime2 : public WCPZoneTime {
     MetricValidity validity() const { return Unknown; }
         RideMetric *clone() const { return new WCPZoneTime2(*this); }
 };
-class WCPZoneTime3 : public WCPZoneTime {
+class WCPZoneTime3 : public RideMetricCopyable<WCPZoneTime3, WCPZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(WCPZoneTime3)
 
     public:
@@ -1311,7 +1331,7 @@ class WCPZoneTime3 : public WCPZoneTime {
     MetricValidity validity() const { return Unknown; }
         RideMetric *clone() const { return new WCPZoneTime3(*this); }
 };
-class WCPZoneTime4 : public WCPZoneTime {
+class WCPZoneTime4 : public RideMetricCopyable<WCPZoneTime4, WCPZoneTime> {
     Q_DECLARE_TR_FUNCTIONS(WCPZoneTime4)
 
     public:
@@ -1334,7 +1354,7 @@ class WCPZoneTime4 : public WCPZoneTime {
 };
 
 // work in zone
-class WZoneWork : public RideMetric {
+class WZoneWork : public RideMetricCopyable<WZoneWork> {
     Q_DECLARE_TR_FUNCTIONS(WZoneWork)
 
     int level;
@@ -1348,11 +1368,13 @@ class WZoneWork : public RideMetric {
         setImperialUnits(tr("kJ"));
         setPrecision(1);
         setConversion(1.0);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(PowerZonesInput);
     }
     bool isTime() const { return false; }
     void setLevel(int level) { this->level=level-1; } // zones start from zero not 1
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &) {
 
         double WPRIME = item->zoneRange >= 0 ? item->context->athlete->zones(item->isRun)->getWprime(item->zoneRange) : 20000;
 
@@ -1389,7 +1411,7 @@ class WZoneWork : public RideMetric {
     RideMetric *clone() const { return new WZoneWork(*this); }
 };
 
-class WZoneWork1 : public WZoneWork {
+class WZoneWork1 : public RideMetricCopyable<WZoneWork1, WZoneWork> {
     Q_DECLARE_TR_FUNCTIONS(WZoneWork1)
 
     public:
@@ -1410,7 +1432,7 @@ class WZoneWork1 : public WZoneWork {
     MetricValidity validity() const { return Unknown; }
         RideMetric *clone() const { return new WZoneWork1(*this); }
 };
-class WZoneWork2 : public WZoneWork {
+class WZoneWork2 : public RideMetricCopyable<WZoneWork2, WZoneWork> {
     Q_DECLARE_TR_FUNCTIONS(WZoneWork2)
 
     public:
@@ -1431,7 +1453,7 @@ class WZoneWork2 : public WZoneWork {
     MetricValidity validity() const { return Unknown; }
         RideMetric *clone() const { return new WZoneWork2(*this); }
 };
-class WZoneWork3 : public WZoneWork {
+class WZoneWork3 : public RideMetricCopyable<WZoneWork3, WZoneWork> {
     Q_DECLARE_TR_FUNCTIONS(WZoneWork3)
 
     public:
@@ -1452,7 +1474,7 @@ class WZoneWork3 : public WZoneWork {
     MetricValidity validity() const { return Unknown; }
         RideMetric *clone() const { return new WZoneWork3(*this); }
 };
-class WZoneWork4 : public WZoneWork {
+class WZoneWork4 : public RideMetricCopyable<WZoneWork4, WZoneWork> {
     Q_DECLARE_TR_FUNCTIONS(WZoneWork4)
 
     public:
@@ -17,7 +17,7 @@
  */
 
 #include "RideMetric.h"
-#include "AddIntervalDialog.h"
+#include "PeakFinder.h"
 #include "RideItem.h"
 #include "Zones.h"
 #include "Context.h"
@@ -28,7 +28,7 @@
 #include <assert.h>
 #include <QApplication>
 
-class AverageWPK : public RideMetric {
+class AverageWPK : public RideMetricCopyable<AverageWPK> {
     Q_DECLARE_TR_FUNCTIONS(AverageWPK)
 
     public:
@@ -37,6 +37,8 @@ class AverageWPK : public RideMetric {
     {
         setSymbol("average_wpk");
         setInternalName("Watts Per Kilogram");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(WeightInput);
     }
     void initialize () {
         setName(tr("Watts Per Kilogram"));
@@ -47,7 +49,7 @@ class AverageWPK : public RideMetric {
         setDescription(tr("Average Power relative to Athlete Weight."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // get thos dependencies
         double secs = deps.value("workout_time")->value(true);
@@ -63,7 +65,7 @@ class AverageWPK : public RideMetric {
     RideMetric *clone() const { return new AverageWPK(*this); }
 };
 
-class PeakWPK : public RideMetric {
+class PeakWPK : public RideMetricCopyable<PeakWPK> {
     Q_DECLARE_TR_FUNCTIONS(PeakWPK)
     double wpk;
     double secs;
@@ -77,10 +79,12 @@ class PeakWPK : public RideMetric {
         setMetricUnits(tr("w/kg"));
         setImperialUnits(tr("w/kg"));
         setPrecision(2);
+        setInputs(QList<RideFile::SeriesType>() << RideFile::watts);
+        setConfigInputs(WeightInput);
     }
     void setSecs(double secs) { this->secs=secs; }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || !item->ride()->areDataPresent()->watts) {
@@ -90,9 +94,8 @@ class PeakWPK : public RideMetric {
         }
 
         weight = item->ride()->getWeight();
-        QList<AddIntervalDialog::AddedInterval> results;
-        AddIntervalDialog::findPeaks(item->context, true, item->ride(), spec, RideFile::watts, RideFile::original, secs, 1, results, "", "");
-        if (results.count() > 0 && results.first().avg < 3000) wpk = results.first().avg / weight;
+        PeakFinder::Peak peak = PeakFinder::peak(item, spec, RideFile::watts, secs);
+        if (peak.found && peak.avg < 3000) wpk = peak.avg / weight;
         else wpk = 0.0;
         setValue(wpk);
     }
@@ -101,7 +104,7 @@ class PeakWPK : public RideMetric {
     RideMetric *clone() const { return new PeakWPK(*this); }
 };
 
-class CPWPK : public PeakWPK {
+class CPWPK : public RideMetricCopyable<CPWPK, PeakWPK> {
     Q_DECLARE_TR_FUNCTIONS(CPWPK)
     public:
         CPWPK()
@@ -119,7 +122,7 @@ class CPWPK : public PeakWPK {
         RideMetric *clone() const { return new CPWPK(*this); }
 };
 
-class PeakWPK1s : public PeakWPK {
+class PeakWPK1s : public RideMetricCopyable<PeakWPK1s, PeakWPK> {
     Q_DECLARE_TR_FUNCTIONS(PeakWPK1s)
     public:
         PeakWPK1s()
@@ -137,7 +140,7 @@ class PeakWPK1s : public PeakWPK {
         RideMetric *clone() const { return new PeakWPK1s(*this); }
 };
 
-class PeakWPK5s : public PeakWPK {
+class PeakWPK5s : public RideMetricCopyable<PeakWPK5s, PeakWPK> {
     Q_DECLARE_TR_FUNCTIONS(PeakWPK5s)
     public:
         PeakWPK5s()
@@ -155,7 +158,7 @@ class PeakWPK5s : public PeakWPK {
         RideMetric *clone() const { return new PeakWPK5s(*this); }
 };
 
-class PeakWPK10s : public PeakWPK {
+class PeakWPK10s : public RideMetricCopyable<PeakWPK10s, PeakWPK> {
     Q_DECLARE_TR_FUNCTIONS(PeakWPK10s)
     public:
         PeakWPK10s()
@@ -173,7 +176,7 @@ class PeakWPK10s : public PeakWPK {
         RideMetric *clone() const { return new PeakWPK10s(*this); }
 };
 
-class PeakWPK15s : public PeakWPK {
+class PeakWPK15s : public RideMetricCopyable<PeakWPK15s, PeakWPK> {
     Q_DECLARE_TR_FUNCTIONS(PeakWPK15s)
     public:
         PeakWPK15s()
@@ -191,7 +194,7 @@ class PeakWPK15s : public PeakWPK {
         RideMetric *clone() const { return new PeakWPK15s(*this); }
 };
 
-class PeakWPK20s : public PeakWPK {
+class PeakWPK20s : public RideMetricCopyable<PeakWPK20s, PeakWPK> {
     Q_DECLARE_TR_FUNCTIONS(PeakWPK20s)
     public:
         PeakWPK20s()
@@ -209,7 +212,7 @@ class PeakWPK20s : public PeakWPK {
         RideMetric *clone() const { return new PeakWPK20s(*this); }
 };
 
-class PeakWPK30s : public PeakWPK {
+class PeakWPK30s : public RideMetricCopyable<PeakWPK30s, PeakWPK> {
     Q_DECLARE_TR_FUNCTIONS(PeakWPK30s)
     public:
         PeakWPK30s()
@@ -227,7 +230,7 @@ class PeakWPK30s : public PeakWPK {
         RideMetric *clone() const { return new PeakWPK30s(*this); }
 };
 
-class PeakWPK1m : public PeakWPK {
+class PeakWPK1m : public RideMetricCopyable<PeakWPK1m, PeakWPK> {
     Q_DECLARE_TR_FUNCTIONS(PeakWPK1m)
     public:
         PeakWPK1m()
@@ -245,7 +248,7 @@ class PeakWPK1m : public PeakWPK {
         RideMetric *clone() const { return new PeakWPK1m(*this); }
 };
 
-class PeakWPK5m : public PeakWPK {
+class PeakWPK5m : public RideMetricCopyable<PeakWPK5m, PeakWPK> {
     Q_DECLARE_TR_FUNCTIONS(PeakWPK5m)
     public:
         PeakWPK5m()
@@ -263,7 +266,7 @@ class PeakWPK5m : public PeakWPK {
         RideMetric *clone() const { return new PeakWPK5m(*this); }
 };
 
-class PeakWPK10m : public PeakWPK {
+class PeakWPK10m : public RideMetricCopyable<PeakWPK10m, PeakWPK> {
     Q_DECLARE_TR_FUNCTIONS(PeakWPK10m)
     public:
         PeakWPK10m()
@@ -281,7 +284,7 @@ class PeakWPK10m : public PeakWPK {
         RideMetric *clone() const { return new PeakWPK10m(*this); }
 };
 
-class PeakWPK20m : public PeakWPK {
+class PeakWPK20m : public RideMetricCopyable<PeakWPK20m, PeakWPK> {
     Q_DECLARE_TR_FUNCTIONS(PeakWPK20m)
     public:
         PeakWPK20m()
@@ -299,7 +302,7 @@ class PeakWPK20m : public PeakWPK {
         RideMetric *clone() const { return new PeakWPK20m(*this); }
 };
 
-class PeakWPK30m : public PeakWPK {
+class PeakWPK30m : public RideMetricCopyable<PeakWPK30m, PeakWPK> {
     Q_DECLARE_TR_FUNCTIONS(PeakWPK30m)
     public:
         PeakWPK30m()
@@ -317,7 +320,7 @@ class PeakWPK30m : public PeakWPK {
         RideMetric *clone() const { return new PeakWPK30m(*this); }
 };
 
-class Vo2max : public RideMetric {
+class Vo2max : public RideMetricCopyable<Vo2max> {
     Q_DECLARE_TR_FUNCTIONS(Vo2max)
     public:
 
@@ -325,6 +328,7 @@ class Vo2max : public RideMetric {
     {
         setSymbol("vo2max");
         setInternalName("Estimated VO2MAX");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize () {
         setName(tr("Estimated VO2MAX"));
@@ -334,7 +338,7 @@ class Vo2max : public RideMetric {
         setDescription(tr("Estimated VO2max from 5 min Peak Power relative to Athlete Weight using new ACSM formula: 10.8 * Watts / KG + 7 (3.5 per leg)."));
     }
 
-    void compute(RideItem* /*item*/, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem* /*item*/, Specification, const RideMetricDeps &deps) {
 
         PeakWPK5m *wpk5m = dynamic_cast<PeakWPK5m*>(deps.value("5m_peak_wpk"));
 
@@ -354,7 +358,7 @@ class Vo2max : public RideMetric {
     RideMetric *clone() const { return new Vo2max(*this); }
 };
 
-class EtimatedAverageWPK_DrF : public RideMetric {
+class EtimatedAverageWPK_DrF : public RideMetricCopyable<EtimatedAverageWPK_DrF> {
     Q_DECLARE_TR_FUNCTIONS(EtimatedAverageWPK_DrF)
 
     public:
@@ -363,6 +367,7 @@ class EtimatedAverageWPK_DrF : public RideMetric {
     {
         setSymbol("estimated_average_wpk_drf");
         setInternalName("estimated Watts Per Kilogram (DrF.)");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize () {
         setName(tr("estimated Watts Per Kilogram (DrF.)"));
@@ -373,7 +378,7 @@ class EtimatedAverageWPK_DrF : public RideMetric {
         setDescription(tr("Estimated Average Power relative to Athlete Weight using Dr Ferrari formula based on VAM for gradient higher than or equal to 7%: VAM / (2 + (gradient/10)) / 100"));
     }
 
-    void compute(RideItem* /*item*/, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem* /*item*/, Specification, const RideMetricDeps &deps) {
 
         // get thos dependencies
         double vam = deps.value("vam")->value(true);
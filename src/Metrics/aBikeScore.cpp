@@ -36,7 +36,7 @@
 // The weighting factors for the exponentially weighted average are taken from
 // a spreadsheet provided by Dr. Skiba.
 
-class aXPower : public RideMetric {
+class aXPower : public RideMetricCopyable<aXPower> {
     Q_DECLARE_TR_FUNCTIONS(aXPower)
     double xpower;
     double secs;
@@ -47,6 +47,7 @@ class aXPower : public RideMetric {
     {
         setSymbol("a_skiba_xpower");
         setInternalName("axPower");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::aPower);
     }
     void initialize() {
         setName(tr("axPower"));
@@ -56,7 +57,7 @@ class aXPower : public RideMetric {
         setDescription(tr("Altitude Adjusted xPower is an estimate of the power that you could have maintained for the same physiological 'cost' if your power output had been perfectly constant at altitude, similar to aNP."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
@@ -109,7 +110,7 @@ class aXPower : public RideMetric {
     RideMetric *clone() const { return new aXPower(*this); }
 };
 
-class aVariabilityIndex : public RideMetric {
+class aVariabilityIndex : public RideMetricCopyable<aVariabilityIndex> {
     Q_DECLARE_TR_FUNCTIONS(aVariabilityIndex)
     double vi;
     double secs;
@@ -120,6 +121,7 @@ class aVariabilityIndex : public RideMetric {
     {
         setSymbol("a_skiba_variability_index");
         setInternalName("Skiba aVI");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("Skiba aVI"));
@@ -130,7 +132,7 @@ class aVariabilityIndex : public RideMetric {
         setDescription(tr("Skiba Altitude Adjusted Variability Index is the ratio between axPower and Average aPower."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         assert(deps.contains("a_skiba_xpower"));
         assert(deps.contains("average_power"));
@@ -149,7 +151,7 @@ class aVariabilityIndex : public RideMetric {
     RideMetric *clone() const { return new aVariabilityIndex(*this); }
 };
 
-class aRelativeIntensity : public RideMetric {
+class aRelativeIntensity : public RideMetricCopyable<aRelativeIntensity> {
     Q_DECLARE_TR_FUNCTIONS(aRelativeIntensity)
     double reli;
     double secs;
@@ -160,6 +162,8 @@ class aRelativeIntensity : public RideMetric {
     {
         setSymbol("a_skiba_relative_intensity");
         setInternalName("aPower Relative Intensity");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PowerZonesInput);
     }
     void initialize() {
         setName(tr("aPower Relative Intensity"));
@@ -170,7 +174,7 @@ class aRelativeIntensity : public RideMetric {
         setDescription(tr("Altitude Adjusted Relative Intensity is the ratio between axPower and the Critical Power (CP) configured in Power Zones, similar to aIF."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         if (item->context->athlete->zones(item->isRun) && item->zoneRange >= 0) {
             assert(deps.contains("a_skiba_xpower"));
@@ -190,7 +194,7 @@ class aRelativeIntensity : public RideMetric {
     RideMetric *clone() const { return new aRelativeIntensity(*this); }
 };
 
-class aBikeScore : public RideMetric {
+class aBikeScore : public RideMetricCopyable<aBikeScore> {
     Q_DECLARE_TR_FUNCTIONS(aBikeScore)
     double score;
 
@@ -200,6 +204,8 @@ class aBikeScore : public RideMetric {
     {
         setSymbol("a_skiba_bike_score");
         setInternalName("aBikeScore");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PowerZonesInput);
     }
     void initialize() {
         setName("aBikeScore");  // Don't translate as many places have special coding for the "TM" sign
@@ -208,7 +214,7 @@ class aBikeScore : public RideMetric {
         setDescription(tr("Skiba's altitude adjusted stress score taking into account both the intensity and the duration of the training session plus the altitude effect, similar to aTSS it can be computed as 100 * hours * (aPower Relative Intensity)^2"));
     }
 
-   void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+   void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         if (!item->context->athlete->zones(item->isRun) || item->zoneRange < 0) {
             setValue(RideFile::NIL);
@@ -236,7 +242,7 @@ class aBikeScore : public RideMetric {
     RideMetric *clone() const { return new aBikeScore(*this); }
 };
 
-class aResponseIndex : public RideMetric {
+class aResponseIndex : public RideMetricCopyable<aResponseIndex> {
     Q_DECLARE_TR_FUNCTIONS(aResponseIndex)
     double ri;
 
@@ -246,6 +252,7 @@ class aResponseIndex : public RideMetric {
     {
         setSymbol("a_skiba_response_index");
         setInternalName("aPower Response Index");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("aPower Response Index"));
@@ -256,7 +263,7 @@ class aResponseIndex : public RideMetric {
         setDescription(tr("The ratio between axPower and Average HR, similar to aPower Efficiency Factor"));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         assert(deps.contains("a_skiba_xpower"));
         assert(deps.contains("average_hr"));
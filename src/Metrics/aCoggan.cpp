@@ -26,7 +26,7 @@
 #include <assert.h>
 #include <QApplication>
 
-class aNP : public RideMetric {
+class aNP : public RideMetricCopyable<aNP> {
     Q_DECLARE_TR_FUNCTIONS(aNP)
     double np;
     double secs;
@@ -37,6 +37,7 @@ class aNP : public RideMetric {
     {
         setSymbol("a_coggan_np");
         setInternalName("aNP");
+        setInputs(QList<RideFile::SeriesType>() << RideFile::aPower);
     }
     void initialize() {
         setName("aNP");
@@ -47,7 +48,7 @@ class aNP : public RideMetric {
         setDescription(tr("Altitude Adjusted Normalized Power is an estimate of the power that you could have maintained for the same physiological 'cost' if your power output had been perfectly constant accounting for altitude."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    void compute(RideItem *item, Specification spec, const RideMetricDeps &) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) || item->ride()->recIntSecs() == 0) {
@@ -108,7 +109,7 @@ class aNP : public RideMetric {
     RideMetric *clone() const { return new aNP(*this); }
 };
 
-class aVI : public RideMetric {
+class aVI : public RideMetricCopyable<aVI> {
     Q_DECLARE_TR_FUNCTIONS(aVI)
     double vi;
     double secs;
@@ -119,6 +120,7 @@ class aVI : public RideMetric {
     {
         setSymbol("a_coggam_variability_index");
         setInternalName("aVI");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName("aVI");
@@ -127,7 +129,7 @@ class aVI : public RideMetric {
         setDescription(tr("Altitude Adjusted Variability Index is the ratio between aNP and Average aPower."));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         assert(deps.contains("a_coggan_np"));
         assert(deps.contains("average_power"));
@@ -150,7 +152,7 @@ class aVI : public RideMetric {
     RideMetric *clone() const { return new aVI(*this); }
 };
 
-class aIntensityFactor : public RideMetric {
+class aIntensityFactor : public RideMetricCopyable<aIntensityFactor> {
     Q_DECLARE_TR_FUNCTIONS(aIntensityFactor)
     double rif;
     double secs;
@@ -161,6 +163,8 @@ class aIntensityFactor : public RideMetric {
     {
         setSymbol("a_coggan_if");
         setInternalName("aIF");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PowerZonesInput);
     }
     void initialize() {
         setName("aIF");
@@ -169,7 +173,7 @@ class aIntensityFactor : public RideMetric {
         setDescription(tr("Altitude Adjusted Intensity Factor is the ratio between aNP and the Critical Power (CP) configured in Power Zones."));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // no ride or no samples
         if (item->zoneRange < 0 || item->context->athlete->zones(item->isRun) == NULL) {
@@ -198,7 +202,7 @@ class aIntensityFactor : public RideMetric {
     RideMetric *clone() const { return new aIntensityFactor(*this); }
 };
 
-class aTSS : public RideMetric {
+class aTSS : public RideMetricCopyable<aTSS> {
     Q_DECLARE_TR_FUNCTIONS(aTSS)
     double score;
 
@@ -208,6 +212,8 @@ class aTSS : public RideMetric {
     {
         setSymbol("a_coggan_tss");
         setInternalName("aTSS");
+        setInputs(QList<RideFile::SeriesType>());
+        setConfigInputs(PowerZonesInput);
     }
     void initialize() {
         setName("aTSS");
@@ -215,7 +221,7 @@ class aTSS : public RideMetric {
         setDescription(tr("Altitude Adjusted Training Stress Score takes into account both the intensity and the duration of the training session plus the altitude effect, it can be computed as 100 * hours * aIF^2"));
     }
 
-    void compute(RideItem *item, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *item, Specification, const RideMetricDeps &deps) {
 
         // no ride or no samples
         if (item->zoneRange < 0 || item->context->athlete->zones(item->isRun) == NULL) {
@@ -247,7 +253,7 @@ class aTSS : public RideMetric {
     RideMetric *clone() const { return new aTSS(*this); }
 };
 
-class aTSSPerHour : public RideMetric {
+class aTSSPerHour : public RideMetricCopyable<aTSSPerHour> {
     Q_DECLARE_TR_FUNCTIONS(aTSSPerHour)
     double points;
     double hours;
@@ -258,6 +264,7 @@ class aTSSPerHour : public RideMetric {
     {
         setSymbol("a_coggan_tssperhour");
         setInternalName("aTSS per hour");
+        setInputs(QList<RideFile::SeriesType>());
     }
 
     void initialize() {
@@ -267,7 +274,7 @@ class aTSSPerHour : public RideMetric {
         setDescription(tr("Altitude Adjusted Training Stress Score divided by Duration in hours"));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         // tss
         assert(deps.contains("a_coggan_tss"));
@@ -297,7 +304,7 @@ class aTSSPerHour : public RideMetric {
     RideMetric *clone() const { return new aTSSPerHour(*this); }
 };
 
-class aEfficiencyFactor : public RideMetric {
+class aEfficiencyFactor : public RideMetricCopyable<aEfficiencyFactor> {
     Q_DECLARE_TR_FUNCTIONS(aEfficiencyFactor)
     double ef;
 
@@ -307,6 +314,7 @@ class aEfficiencyFactor : public RideMetric {
     {
         setSymbol("a_friel_efficiency_factor");
         setInternalName("aPower Efficiency Factor");
+        setInputs(QList<RideFile::SeriesType>());
     }
     void initialize() {
         setName(tr("aPower Efficiency Factor"));
@@ -317,7 +325,7 @@ class aEfficiencyFactor : public RideMetric {
         setDescription(tr("The ratio between aNP and Average HR"));
     }
 
-    void compute(RideItem *, Specification, const QHash<QString,RideMetric*> &deps) {
+    void compute(RideItem *, Specification, const RideMetricDeps &deps) {
 
         assert(deps.contains("a_coggan_np"));
         assert(deps.contains("average_hr"));
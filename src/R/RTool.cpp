@@ -21,6 +21,7 @@
 #include "GcUpgrade.h"
 
 #include "RideCache.h"
+#include "RideCacheColumns.h"
 #include "RideItem.h"
 #include "IntervalItem.h"
 #include "RideFile.h"
@@ -1124,11 +1125,10 @@ RTool::dfForDateRange(bool all, DateRange range, SEXP filter)
     UNPROTECT(1);
 
     // we need to count rides that are in range...
-    rides = 0;
-    foreach(RideItem *ride, rtool->context->athlete->rideCache->rides()) {
-        if (!specification.pass(ride)) continue;
-        if (all || range.pass(ride->dateTime.date())) rides++;
-    }
+    RideCache *cache = rtool->context->athlete->rideCache;
+    if (!all) specification.setDateRange(range);
+    QBitArray selected = cache->columns()->select(specification);
+    rides = selected.count(true);
 
     // get a listAllocated
     SEXP ans;
@@ -1155,10 +1155,9 @@ RTool::dfForDateRange(bool all, DateRange range, SEXP filter)
 
     int k=0;
     QDate d1970(1970,01,01);
-    foreach(RideItem *ride, rtool->context->athlete->rideCache->rides()) {
-        if (!specification.pass(ride)) continue;
-        if (all || range.pass(ride->dateTime.date()))
-            INTEGER(date)[k++] = d1970.daysTo(ride->dateTime.date());
+    for(int i=0; i<selected.count(); i++) {
+        if (selected.testBit(i))
+            INTEGER(date)[k++] = d1970.daysTo(cache->rides()[i]->dateTime.date());
     }
 
     SEXP dclas;
@@ -1176,10 +1175,9 @@ RTool::dfForDateRange(bool all, DateRange range, SEXP filter)
 
     // fill with values for date and class if its one we need to return
     k=0;
-    foreach(RideItem *ride, rtool->context->athlete->rideCache->rides()) {
-        if (!specification.pass(ride)) continue;
-        if (all || range.pass(ride->dateTime.date()))
-            REAL(time)[k++] = ride->dateTime.toUTC().toTime_t();
+    for(int i=0; i<selected.count(); i++) {
+        if (selected.testBit(i))
+            REAL(time)[k++] = cache->rides()[i]->dateTime.toUTC().toTime_t();
     }
 
     // POSIXct class
@@ -1216,12 +1214,14 @@ RTool::dfForDateRange(bool all, DateRange range, SEXP filter)
 
         bool useMetricUnits = rtool->context->athlete->useMetricUnits;
 
+        // a column at a time
+        QVector<double> values = cache->columns()->values(i);
+
         int index=0;
-        foreach(RideItem *item, rtool->context->athlete->rideCache->rides()) {
-            if (!specification.pass(item)) continue;
-            if (all || range.pass(item->dateTime.date())) {
-                REAL(m)[index++] = item->metrics()[i] * (useMetricUnits ? 1.0f : metric->conversion())
-                                                      + (useMetricUnits ? 0.0f : metric->conversionSum());
+        for(int j=0; j<selected.count() && j<values.count(); j++) {
+            if (selected.testBit(j)) {
+                REAL(m)[index++] = values[j] * (useMetricUnits ? 1.0f : metric->conversion())
+                                             + (useMetricUnits ? 0.0f : metric->conversionSum());
             }
         }
 
@@ -1251,9 +1251,9 @@ RTool::dfForDateRange(bool all, DateRange range, SEXP filter)
         PROTECT(m=Rf_allocVector(STRSXP, rides));
 
         int index=0;
-        foreach(RideItem *item, rtool->context->athlete->rideCache->rides()) {
-            if (!specification.pass(item)) continue;
-            if (all || range.pass(item->dateTime.date())) {
+        for(int i=0; i<selected.count(); i++) {
+            if (selected.testBit(i)) {
+                RideItem *item = cache->rides()[i];
                 SET_STRING_ELT(m, index++, Rf_mkChar(item->getText(field.name, "").toLatin1().constData()));
             }
         }
@@ -1275,9 +1275,9 @@ RTool::dfForDateRange(bool all, DateRange range, SEXP filter)
     PROTECT(color=Rf_allocVector(STRSXP, rides));
 
     int index=0;
-    foreach(RideItem *item, rtool->context->athlete->rideCache->rides()) {
-        if (!specification.pass(item)) continue;
-        if (all || range.pass(item->dateTime.date())) {
+    for(int i=0; i<selected.count(); i++) {
+        if (selected.testBit(i)) {
+            RideItem *item = cache->rides()[i];
 
             // apply item color, remembering that 1,1,1 means use default (reverse in this case)
             if (item->color == QColor(1,1,1,1)) {
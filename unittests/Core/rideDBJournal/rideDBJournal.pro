@@ -0,0 +1,5 @@
+include(../../unittests.pri)
+
+TARGET = testRideDBJournal
+SOURCES += testRideDBJournal.cpp $${GC_SRC}/Core/RideDBJournal.cpp
+HEADERS += $${GC_SRC}/Core/RideDBJournal.h
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideDBJournal.h"
+
+#include <QtTest>
+#include <QFile>
+#include <QTemporaryFile>
+
+//
+// Writing records to the rideDB journal and reading them back, and
+// what is recovered when the journal is cut short or damaged, as it
+// would be by a crash part way through a save.
+//
+
+class TestRideDBJournal : public QObject
+{
+    Q_OBJECT
+
+    private:
+        QString name; // of the journal, removed before each test
+        QList<QByteArray> records;
+
+        static QByteArray readAll(const QString &name) {
+            QFile file(name);
+            file.open(QFile::ReadOnly);
+            return file.readAll();
+        }
+
+        static void writeAll(const QString &name, const QByteArray &data) {
+            QFile file(name);
+            file.open(QFile::WriteOnly | QFile::Truncate);
+            file.write(data);
+        }
+
+        // the records we can read back
+        static QList<QByteArray> replay(const QString &name, quint64 generation, bool &opened, bool &damaged) {
+            QList<QByteArray> returning;
+            RideDBJournal journal(name);
+            opened = journal.open(generation);
+
+            const uchar *record;
+            quint32 length;
+            while (journal.next(record, length)) returning << QByteArray((const char*)record, length);
+            damaged = journal.damaged();
+            return returning;
+        }
+
+        void journal(quint64 generation, const QList<QByteArray> &add) {
+            RideDBJournal journal(name);
+            foreach(QByteArray record, add) QVERIFY(journal.append(generation, record));
+        }
+
+    private slots:
+
+        void initTestCase() {
+            QTemporaryFile temp;
+            QVERIFY(temp.open());
+            name = temp.fileName() + ".journal";
+
+            // including an empty record and one bigger than a page
+            records << QByteArray("first") << QByteArray() << QByteArray(10000, 'x') << QByteArray("last");
+        }
+
+        void init() { QFile::remove(name); }
+        void cleanupTestCase() { QFile::remove(name); }
+
+        void missing() {
+            bool opened, damaged;
+            QVERIFY(replay(name, 1, opened, damaged).isEmpty());
+            QVERIFY(!opened);
+            QVERIFY(!damaged);
+        }
+
+        void roundTrip() {
+            journal(5, records);
+
+            bool opened, damaged;
+            QCOMPARE(replay(name, 5, opened, damaged), records);
+            QVERIFY(opened);
+            QVERIFY(!damaged);
+        }
+
+        // appending to an existing journal keeps its header
+        void reopened() {
+            journal(5, records.mid(0, 2));
+            journal(7, records.mid(2));
+
+            bool opened, damaged;
+            QCOMPARE(replay(name, 5, opened, damaged), records);
+            QVERIFY(!damaged);
+        }
+
+        // a journal for an older rideDB.bin has been compacted into
+        // the one we have, one for a newer one is still wanted
+        void generations() {
+            journal(5, records);
+
+            bool opened, damaged;
+            QVERIFY(replay(name, 6, opened, damaged).isEmpty());
+            QVERIFY(!opened);
+
+            QCOMPARE(replay(name, 4, opened, damaged), records);
+            QVERIFY(opened);
+        }
+
+        // cut off at every length, the whole records before the cut
+        // come back, never the one it cuts, and that's reported
+        void truncated() {
+            journal(5, records);
+            QByteArray whole = readAll(name);
+
+            // where each record ends
+            QList<int> ends;
+            int end = 16; // header
+            foreach(QByteArray record, records) ends << (end += 8 + record.size());
+            QCOMPARE(ends.last(), whole.size());
+
+            for (int length=0; length<whole.size(); length++) {
+                writeAll(name, whole.left(length));
+
+                bool opened, damaged;
+                QList<QByteArray> back = replay(name, 5, opened, damaged);
+
+                if (length < 16) {
+                    QVERIFY(!opened);
+                    continue;
+                }
+
+                int complete = 0;
+                while (complete < ends.count() && ends[complete] <= length) complete++;
+
+                QCOMPARE(back, records.mid(0, complete));
+                QCOMPARE(damaged, length != 16 && !ends.contains(length));
+            }
+        }
+
+        // a record that was overwritten stops the replay there
+        void corrupted() {
+            journal(5, records);
+            QByteArray whole = readAll(name);
+
+            // a byte in the middle of the big record
+            int at = 16 + 8 + records[0].size() + 8 + records[1].size() + 8 + 5000;
+            whole[at] = char(whole[at] ^ 0x55);
+            writeAll(name, whole);
+
+            bool opened, damaged;
+            QCOMPARE(replay(name, 5, opened, damaged), records.mid(0, 2));
+            QVERIFY(damaged);
+        }
+
+        // a length that runs past the end of the file
+        void badLength() {
+            journal(5, records.mid(0, 1));
+            QByteArray whole = readAll(name);
+            whole[16] = char(0xff);
+            whole[17] = char(0xff);
+            writeAll(name, whole);
+
+            bool opened, damaged;
+            QVERIFY(replay(name, 5, opened, damaged).isEmpty());
+            QVERIFY(opened);
+            QVERIFY(damaged);
+        }
+};
+
+QTEST_APPLESS_MAIN(TestRideDBJournal)
+#include "testRideDBJournal.moc"
@@ -0,0 +1,5 @@
+include(../../unittests.pri)
+
+TARGET = testSeriesKernels
+SOURCES += testSeriesKernels.cpp $${GC_SRC}/Core/SeriesKernels.cpp
+HEADERS += $${GC_SRC}/Core/SeriesKernels.h
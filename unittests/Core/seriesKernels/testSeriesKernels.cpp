@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "SeriesKernels.h"
+
+#include <QtTest>
+#include <QVector>
+#include <cmath>
+
+//
+// The kernels are checked against the sample by sample loops RideFile
+// used before, and benchmarked against them walking the samples through
+// pointers, as RideFilePoint is, which is what the kernels replaced.
+//
+
+// just the fields the old loops read, padded out to about the
+// size of a RideFilePoint so the samples are as far apart
+struct Sample {
+    double secs, watts, alt, km;
+    double other[60];
+};
+
+class TestSeriesKernels : public QObject
+{
+    Q_OBJECT
+
+    private:
+        // a 4 hour ride recorded every second
+        enum { Samples = 4 * 3600 };
+
+        QVector<double> secs, watts, alt, km;
+        QVector<Sample> storage;
+        QVector<Sample*> points;
+
+        // old style rolling mean, as deriveNP did it
+        static void pointsRollingMean(const QVector<Sample*> &points, double *out, int window) {
+            QVector<double> rolling(window, 0);
+            double sum = 0;
+            int index = 0;
+            for (int i=0; i<points.count(); i++) {
+                sum += points[i]->watts;
+                sum -= rolling[index];
+                rolling[index] = points[i]->watts;
+                out[i] = sum / window;
+                index = (index + 1) % window;
+            }
+        }
+
+        static bool near(double a, double b) { return fabs(a - b) <= 1e-9 * qMax(1.0, fabs(a)); }
+
+    private slots:
+
+        void initTestCase() {
+
+            // repeatable and a bit lumpy, with a few gaps in the power
+            quint32 seed = 42;
+            double altitude = 100, distance = 0;
+            for (int i=0; i<Samples; i++) {
+                seed = seed * 1664525u + 1013904223u;
+                double noise = double(seed >> 8) / double(1 << 24);
+
+                secs << i;
+                watts << ((i % 600) < 30 ? 0 : 150 + 200 * noise);
+                altitude += (noise - 0.5) * 2;
+                alt << altitude;
+                distance += noise > 0.1 ? 0.008 * noise : 0; // sometimes stopped
+                km << distance;
+            }
+
+            storage.resize(Samples);
+            for (int i=0; i<Samples; i++) {
+                storage[i].secs = secs[i];
+                storage[i].watts = watts[i];
+                storage[i].alt = alt[i];
+                storage[i].km = km[i];
+                points << &storage[i];
+            }
+        }
+
+        void rollingMean() {
+            const int window = 30;
+            QVector<double> out(Samples), expected(Samples);
+            SeriesKernels::rollingMean(watts.constData(), out.data(), Samples, window);
+            pointsRollingMean(points, expected.data(), window);
+            for (int i=0; i<Samples; i++) QVERIFY2(near(out[i], expected[i]), qPrintable(QString::number(i)));
+
+            // shorter than the window
+            SeriesKernels::rollingMean(watts.constData(), out.data(), 10, window);
+            QVERIFY(near(out[9], (watts[0]+watts[1]+watts[2]+watts[3]+watts[4]+
+                                  watts[5]+watts[6]+watts[7]+watts[8]+watts[9]) / window));
+        }
+
+        void ewma() {
+            const double attenuation = 0.96, weight = 0.04;
+            QVector<double> out(Samples);
+            double last = SeriesKernels::ewma(watts.constData(), out.data(), Samples, attenuation, weight, 0);
+
+            double value = 0;
+            for (int i=0; i<Samples; i++) {
+                value = value * attenuation + watts[i] * weight;
+                QVERIFY(near(out[i], value));
+            }
+            QVERIFY(near(last, value));
+
+            // in pieces, carrying on from where we left off
+            QVector<double> pieces(Samples);
+            double carry = SeriesKernels::ewma(watts.constData(), pieces.data(), 1000, attenuation, weight, 0);
+            SeriesKernels::ewma(watts.constData() + 1000, pieces.data() + 1000, Samples - 1000, attenuation, weight, carry);
+            for (int i=0; i<Samples; i++) QVERIFY(near(pieces[i], out[i]));
+        }
+
+        void firstDifference() {
+            QVector<double> out(Samples);
+
+            // per sample
+            SeriesKernels::firstDifference(alt.constData(), NULL, out.data(), Samples);
+            QCOMPARE(out[0], 0.0);
+            for (int i=1; i<Samples; i++) QVERIFY(near(out[i], alt[i] - alt[i-1]));
+
+            // against distance, zero when stopped
+            SeriesKernels::firstDifference(alt.constData(), km.constData(), out.data(), Samples);
+            for (int i=1; i<Samples; i++) {
+                double dx = km[i] - km[i-1];
+                QVERIFY(near(out[i], dx > 0 ? (alt[i] - alt[i-1]) / dx : 0));
+            }
+        }
+
+        void ratio() {
+            const double num[] = { 1, 2, 3, -4, 5 };
+            const double den[] = { 2, 0, -1, 8, 0.5 };
+            double out[5];
+            SeriesKernels::ratio(num, den, out, 5, 100);
+            QCOMPARE(out[0], 50.0);
+            QCOMPARE(out[1], 0.0);
+            QCOMPARE(out[2], 0.0);
+            QCOMPARE(out[3], -50.0);
+            QCOMPARE(out[4], 1000.0);
+        }
+
+        void bandPass() {
+            double data[] = { -1, 0, 1, 5, 10, 11 };
+            SeriesKernels::bandPass(data, 6, 0, 10);
+            QCOMPARE(data[0], 0.0);
+            QCOMPARE(data[1], 0.0);
+            QCOMPARE(data[2], 1.0);
+            QCOMPARE(data[3], 5.0);
+            QCOMPARE(data[4], 0.0);
+            QCOMPARE(data[5], 0.0);
+        }
+
+        // the benchmarks, kernel against the old per sample loop
+
+        void benchmarkRollingMean() {
+            QVector<double> out(Samples);
+            QBENCHMARK { SeriesKernels::rollingMean(watts.constData(), out.data(), Samples, 30); }
+        }
+
+        void benchmarkRollingMeanPoints() {
+            QVector<double> out(Samples);
+            QBENCHMARK { pointsRollingMean(points, out.data(), 30); }
+        }
+
+        void benchmarkEwma() {
+            QVector<double> out(Samples);
+            QBENCHMARK { SeriesKernels::ewma(watts.constData(), out.data(), Samples, 0.96, 0.04, 0); }
+        }
+
+        void benchmarkEwmaPoints() {
+            QVector<double> out(Samples);
+            QBENCHMARK {
+                double value = 0;
+                for (int i=0; i<points.count(); i++) out[i] = value = value * 0.96 + points[i]->watts * 0.04;
+            }
+        }
+
+        void benchmarkSlope() {
+            QVector<double> rise(Samples), run(Samples), slope(Samples);
+            QBENCHMARK {
+                SeriesKernels::firstDifference(alt.constData(), NULL, rise.data(), Samples);
+                SeriesKernels::firstDifference(km.constData(), NULL, run.data(), Samples);
+                for (int i=0; i<Samples; i++) run[i] *= 1000;
+                SeriesKernels::ratio(rise.constData(), run.constData(), slope.data(), Samples, 100);
+            }
+        }
+
+        void benchmarkSlopePoints() {
+            QVector<double> slope(Samples);
+            QBENCHMARK {
+                slope[0] = 0;
+                for (int i=1; i<points.count(); i++) {
+                    double rise = points[i]->alt - points[i-1]->alt;
+                    double run = 1000 * (points[i]->km - points[i-1]->km);
+                    slope[i] = run > 0 ? (rise / run) * 100 : 0;
+                }
+            }
+        }
+};
+
+QTEST_APPLESS_MAIN(TestSeriesKernels)
+#include "testSeriesKernels.moc"
@@ -0,0 +1,5 @@
+include(../../unittests.pri)
+
+TARGET = testCpxCodec
+SOURCES += testCpxCodec.cpp $${GC_SRC}/FileIO/CpxCodec.cpp
+HEADERS += $${GC_SRC}/FileIO/CpxCodec.h
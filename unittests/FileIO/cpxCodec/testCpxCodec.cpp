@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "CpxCodec.h"
+
+#include <QtTest>
+#include <cmath>
+#include <string.h>
+
+//
+// Round trips of the .cpx mean max and distribution encodings, and
+// that a block cut short or with nonsense lengths is rejected.
+//
+
+class TestCpxCodec : public QObject
+{
+    Q_OBJECT
+
+    private:
+
+        // a power curve for a ride of secs seconds, bests fall
+        // away with duration, as they should
+        static QVector<float> curve(int secs) {
+            QVector<float> array(secs + 1);
+            for (int i=1; i<=secs; i++) array[i] = 250.0 + 900.0 / (1.0 + i / 20.0) + 50.0 * exp(-i / 3600.0);
+            return array;
+        }
+
+        static bool sameBits(float a, float b) { return memcmp(&a, &b, sizeof(float)) == 0; }
+
+        static const uchar *begin(const QByteArray &block) { return (const uchar*)block.constData(); }
+        static const uchar *end(const QByteArray &block) { return (const uchar*)block.constData() + block.size(); }
+
+    private slots:
+
+        void meanMaxRoundTrip_data() {
+            QTest::addColumn<int>("secs");
+            QTest::newRow("no time") << 0;
+            QTest::newRow("one") << 1;
+            QTest::newRow("hour") << 3600;
+            QTest::newRow("just over an hour") << 3602;
+            QTest::newRow("three hours") << 3 * 3600;
+            QTest::newRow("two days") << 2 * 24 * 3600;
+        }
+
+        void meanMaxRoundTrip() {
+            QFETCH(int, secs);
+            QVector<float> array = curve(secs);
+            int count = array.size();
+
+            QByteArray block = CpxCodec::encodeMeanMax(array);
+            QVector<float> back(count);
+            QVERIFY(CpxCodec::decodeMeanMax(begin(block), end(block), count, count-1, back.data()));
+
+            for (int i=0; i<count; i++) {
+
+                // kept values come back exactly
+                if (CpxCodec::isKept(i, count)) {
+                    QVERIFY2(sameBits(back[i], array[i]), qPrintable(QString("duration %1").arg(i)));
+                    continue;
+                }
+
+                // the rest lie between their neighbours, so the curve
+                // still never rises, and are close to what they were
+                QVERIFY(back[i] <= back[i-1]);
+                QVERIFY(fabs(back[i] - array[i]) < 0.01 * array[i]);
+            }
+
+            // first and last are always kept
+            if (count) {
+                QVERIFY(CpxCodec::isKept(0, count));
+                QVERIFY(CpxCodec::isKept(count-1, count));
+            }
+        }
+
+        // 1-3 bytes a value, so a 3 hour curve is a lot less than
+        // the 4 bytes a second it took before
+        void meanMaxSize() {
+            QByteArray block = CpxCodec::encodeMeanMax(curve(3 * 3600));
+            QVERIFY(block.size() < 8 * 1024);
+        }
+
+        // differences both ways and of every size, negative values
+        // too (the delta series) and the largest floats, so zigzag
+        // and varints of 1 to 10 bytes are used
+        void meanMaxAnyValues() {
+            QVector<float> array;
+            array << 0 << 1 << 0.5 << -0.5 << 100 << -100 << 1e-30f << -1e30f << 3.4e38f << -3.4e38f << 0 << 7;
+            quint32 seed = 7;
+            for (int i=0; i<1000; i++) {
+                seed = seed * 1664525u + 1013904223u;
+                float value;
+                quint32 bits = seed & 0x7f7fffff; // no nans or infs, either sign
+                memcpy(&value, &bits, sizeof(value));
+                array << value;
+            }
+
+            QByteArray block = CpxCodec::encodeMeanMax(array);
+            QVector<float> back(array.size());
+            QVERIFY(CpxCodec::decodeMeanMax(begin(block), end(block), array.size(), array.size()-1, back.data()));
+            for (int i=0; i<array.size(); i++) QVERIFY(sameBits(back[i], array[i]));
+        }
+
+        // a single best only decodes as far as it needs
+        void meanMaxUpto() {
+            QVector<float> array = curve(3 * 3600);
+            QByteArray block = CpxCodec::encodeMeanMax(array);
+
+            int durations[] = { 1, 60, 1200, 3600, 3601, 5000, 3 * 3600 };
+            for (unsigned int d=0; d<sizeof(durations)/sizeof(int); d++) {
+
+                int upto = durations[d];
+                QVector<float> back(upto + 2, -1);
+                QVERIFY(CpxCodec::decodeMeanMax(begin(block), end(block), array.size(), upto, back.data()));
+
+                QCOMPARE(back[upto+1], -1.0f); // left alone
+                if (CpxCodec::isKept(upto, array.size())) QVERIFY(sameBits(back[upto], array[upto]));
+                else QVERIFY(fabs(back[upto] - array[upto]) < 0.01 * array[upto]);
+            }
+        }
+
+        void distributionRoundTrip_data() {
+            QTest::addColumn<int>("zeros"); // in each run, around the varint boundaries
+            QTest::newRow("none") << 0;
+            QTest::newRow("one") << 1;
+            QTest::newRow("127") << 127;
+            QTest::newRow("128") << 128;
+            QTest::newRow("16383") << 16383;
+            QTest::newRow("16384") << 16384;
+        }
+
+        void distributionRoundTrip() {
+            QFETCH(int, zeros);
+
+            // runs of values and zeros, ending on either
+            for (int ending=0; ending<2; ending++) {
+                QVector<float> array;
+                for (int run=0; run<3; run++) {
+                    for (int i=0; i<zeros; i++) array << 0;
+                    for (int i=0; i<=run*130; i++) array << float(i + 1) * 0.5f;
+                }
+                if (ending) array << 0 << 0;
+
+                QByteArray block = CpxCodec::encodeDistribution(array);
+                QVector<float> back(array.size(), -1);
+                QVERIFY(CpxCodec::decodeDistribution(begin(block), end(block), array.size(), back.data()));
+                for (int i=0; i<array.size(); i++) QVERIFY(sameBits(back[i], array[i]));
+            }
+        }
+
+        // every way of cutting a block short fails, and
+        // never reads past the end of what is there
+        void truncated() {
+            QVector<float> meanmax = curve(4000);
+            QByteArray block = CpxCodec::encodeMeanMax(meanmax);
+            QVector<float> back(meanmax.size());
+            for (int length=0; length<block.size(); length++) {
+                QByteArray cut(block.constData(), length); // its own copy, so overruns are caught by tools
+                QVERIFY(!CpxCodec::decodeMeanMax(begin(cut), end(cut), meanmax.size(), meanmax.size()-1, back.data()));
+            }
+
+            QVector<float> dist;
+            for (int i=0; i<500; i++) dist << ((i / 50) % 2 ? 0.0f : float(i));
+            block = CpxCodec::encodeDistribution(dist);
+            back.resize(dist.size());
+            for (int length=0; length<block.size(); length++) {
+                QByteArray cut(block.constData(), length);
+                QVERIFY(!CpxCodec::decodeDistribution(begin(cut), end(cut), dist.size(), back.data()));
+            }
+        }
+
+        // lengths that would run past the array are rejected
+        void badLengths() {
+            float into[10];
+
+            // 5 zeros then 20 values, in an array of 10
+            QByteArray tooMany;
+            tooMany.append(char(5));
+            tooMany.append(char(20));
+            tooMany.append(QByteArray(20 * sizeof(float), char(0)));
+            QVERIFY(!CpxCodec::decodeDistribution(begin(tooMany), end(tooMany), 10, into));
+
+            // a varint that never ends
+            QByteArray endless(16, char(0xff));
+            QVERIFY(!CpxCodec::decodeDistribution(begin(endless), end(endless), 10, into));
+            QVERIFY(!CpxCodec::decodeMeanMax(begin(endless), end(endless), 10, 9, into));
+        }
+};
+
+QTEST_APPLESS_MAIN(TestCpxCodec)
+#include "testCpxCodec.moc"
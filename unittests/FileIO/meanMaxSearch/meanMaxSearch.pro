@@ -0,0 +1,5 @@
+include(../../unittests.pri)
+
+TARGET = testMeanMaxSearch
+SOURCES += testMeanMaxSearch.cpp $${GC_SRC}/FileIO/MeanMaxSearch.cpp
+HEADERS += $${GC_SRC}/FileIO/MeanMaxSearch.h
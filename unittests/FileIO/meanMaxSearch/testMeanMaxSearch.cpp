@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2017 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MeanMaxSearch.h"
+
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QMap>
+#include <QRegExp>
+#include <cmath>
+
+//
+// The exact search must give the same bests as the original for every
+// series that is never negative, and the true bests for those that can
+// be (the delta series). They are compared, and timed, on the power
+// recorded in the rides in test/rides, as it is and as the 4th power of
+// the 30s rolling average the NP bests are searched over.
+//
+
+class TestMeanMaxSearch : public QObject
+{
+    Q_OBJECT
+
+    private:
+        QMap<QString, QVector<double> > series;
+
+        // one sample per power reading, near enough 1s recording
+        static QVector<double> readPower(const QString &filename) {
+            QVector<double> data;
+            QFile file(filename);
+            if (!file.open(QFile::ReadOnly)) return data;
+
+            QString text = QString::fromUtf8(file.readAll());
+            QRegExp power("<(?:\\w+:)?(?:Watts|pwr)>\\s*([-0-9.]+)\\s*<");
+            int pos = 0;
+            while ((pos = power.indexIn(text, pos)) != -1) {
+                data << qMax(0.0, double(qRound(power.cap(1).toDouble())));
+                pos += power.matchedLength();
+            }
+            return data;
+        }
+
+        // as MeanMaxComputer does for NP
+        static QVector<double> rollingFourth(const QVector<double> &data) {
+            QVector<double> out(data.size());
+            QVector<double> rolling(30);
+            double sum = 0;
+            for (int i=0, index=0; i<data.size(); i++, index = (index + 1) % 30) {
+                sum += data[i] - rolling[index];
+                rolling[index] = data[i];
+                out[i] = pow(sum / 30.0, 4.0);
+            }
+            return out;
+        }
+
+        static QVector<double> delta(const QVector<double> &data) {
+            QVector<double> out(data.size());
+            for (int i=1; i<data.size(); i++) out[i] = data[i] - data[i-1];
+            return out;
+        }
+
+        void rows(bool negative) {
+            QTest::addColumn<QString>("name");
+            foreach(QString name, series.keys()) {
+                if (name.endsWith(" delta") != negative) continue;
+                QTest::newRow(name.toLatin1().constData()) << name;
+            }
+        }
+
+    private slots:
+
+        void initTestCase() {
+            QDir rides(GC_TEST_DATA "/rides");
+            QStringList files = rides.entryList(QStringList() << "*.tcx" << "*.pwx", QDir::Files, QDir::Name);
+
+            foreach(QString file, files) {
+                QVector<double> watts = readPower(rides.absoluteFilePath(file));
+                if (watts.size() < 600) continue; // not much of a search
+
+                series.insert(file + " watts", watts);
+                series.insert(file + " np", rollingFourth(watts));
+                series.insert(file + " delta", delta(watts));
+            }
+            QVERIFY2(series.count(), "no rides with power found in test/rides");
+        }
+
+        // bit identical to the original
+        void matchesLegacy_data() { rows(false); }
+        void matchesLegacy() {
+            QFETCH(QString, name);
+            const QVector<double> &data = series[name];
+
+            QVector<double> legacy(data.size()), exact(data.size());
+            MeanMaxSearch::legacy(data, legacy);
+            MeanMaxSearch::exact(data, exact);
+
+            for (int i=1; i<data.size(); i=MeanMaxSearch::nextLength(i))
+                QVERIFY2(exact[i] == legacy[i], qPrintable(QString("length %1: %2 not %3")
+                         .arg(i).arg(exact[i], 0, 'g', 17).arg(legacy[i], 0, 'g', 17)));
+        }
+
+        // the true maximums, looking at every window, for the
+        // first 3 minutes as only they are kept for the deltas
+        void matchesBruteForce_data() { rows(true); }
+        void matchesBruteForce() {
+            QFETCH(QString, name);
+            const QVector<double> &data = series[name];
+
+            QVector<double> exact(data.size());
+            MeanMaxSearch::exact(data, exact);
+
+            for (int length=1; length<=180 && length<data.size(); length=MeanMaxSearch::nextLength(length)) {
+                double sum = 0, best = 0;
+                for (int i=0; i<data.size(); i++) {
+                    sum += data[i];
+                    if (i >= length) sum -= data[i-length];
+                    if (i >= length-1 && sum > best) best = sum;
+                }
+                QCOMPARE(exact[length], best);
+            }
+        }
+
+        // how long each takes
+        void benchmarkLegacy_data() { rows(false); }
+        void benchmarkLegacy() {
+            QFETCH(QString, name);
+            const QVector<double> &data = series[name];
+            QVector<double> energy(data.size());
+            QBENCHMARK { MeanMaxSearch::legacy(data, energy); }
+        }
+
+        void benchmarkExact_data() { rows(false); }
+        void benchmarkExact() {
+            QFETCH(QString, name);
+            const QVector<double> &data = series[name];
+            QVector<double> energy(data.size());
+            QBENCHMARK { MeanMaxSearch::exact(data, energy); }
+        }
+};
+
+QTEST_APPLESS_MAIN(TestMeanMaxSearch)
+#include "testMeanMaxSearch.moc"
@@ -0,0 +1,14 @@
+#
+# Common settings for the unit tests, include from each test's .pro
+#
+QT += testlib
+QT -= gui
+CONFIG += qt console warn_on testcase
+CONFIG -= app_bundle
+
+GC_SRC = $$PWD/../src
+INCLUDEPATH += $${GC_SRC}/Core $${GC_SRC}/FileIO $${GC_SRC}/Metrics $${GC_SRC}/Charts
+DEPENDPATH += $${INCLUDEPATH}
+
+# the sample data shipped in test/, e.g. test/rides
+DEFINES += GC_TEST_DATA=\\\"$$PWD/../test\\\"
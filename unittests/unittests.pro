@@ -0,0 +1,15 @@
+#
+# Unit tests and micro-benchmarks, each builds just the sources it
+# needs from src/ so they don't need the whole application.
+#
+#   qmake unittests.pro && make && make check
+#
+# Benchmarks are run in the same way, pass QTest options with
+# TESTARGS, e.g. make check TESTARGS="-iterations 10"
+#
+TEMPLATE = subdirs
+
+SUBDIRS += Core/rideDBJournal \
+           Core/seriesKernels \
+           FileIO/cpxCodec \
+           FileIO/meanMaxSearch